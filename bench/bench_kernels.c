@@ -0,0 +1,109 @@
+/* Compara el Dijkstra con callback contra los kernels especializados y mide el flujo maximo */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "grafos.h"
+#include "dijkstra.h"
+#include "flujo.h"
+
+static double costo_latencia(const GRAFO *grafo, int arista)
+{
+    return (double)grafo->aristas.latencia_ms[arista];
+}
+
+static double ahora_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    int n, grado, consultas, i, j, q, num_corte, *anterior, *corte;
+    double *distancia, t0, t_callback, t_vista, t_kernel, t_red, t_flujo, suma_a, suma_b;
+    long long flujo, capacidad_corte;
+    int corte_ok;
+    RED_FLUJO red;
+    char nombre[32], ip[16];
+    GRAFO *grafo;
+    VISTA_latencia vista;
+    MONTICULO m;
+
+    n = argc > 1 ? atoi(argv[1]) : 2000;
+    grado = argc > 2 ? atoi(argv[2]) : 8;
+    consultas = argc > 3 ? atoi(argv[3]) : 20;
+    srand(42);
+
+    grafo = crear_grafo(n);
+    for (i = 0; i < n; ++i)
+    {
+        snprintf(nombre, sizeof(nombre), "N%d", i);
+        snprintf(ip, sizeof(ip), "10.%d.%d.%d", (i >> 16) & 255, (i >> 8) & 255, i & 255);
+        agregar_vertice(grafo, nombre, ip, D_ROUTER, 100);
+    }
+    for (i = 0; i < n; ++i)
+        for (j = 0; j < grado; ++j)
+            agregar_arista(grafo, i, rand() % n, 1 + rand() % 50, 10 + rand() % 991, 0.99, 1);
+
+    anterior = malloc(sizeof(int) * n);
+    distancia = malloc(sizeof(double) * n);
+    monticulo_iniciar(&m, n * grado + 1);
+
+    suma_a = 0.0;
+    t0 = ahora_ms();
+    for (q = 0; q < consultas; ++q)
+    {
+        dijkstra_camino_minimo(grafo, q % n, (q * 7919) % n, costo_latencia, anterior, distancia);
+        suma_a += distancia[(q * 7919) % n];
+    }
+    t_callback = ahora_ms() - t0;
+
+    t0 = ahora_ms();
+    construir_vista_latencia(grafo, &vista);
+    t_vista = ahora_ms() - t0;
+
+    suma_b = 0.0;
+    t0 = ahora_ms();
+    for (q = 0; q < consultas; ++q)
+    {
+        dijkstra_latencia(&vista, q % n, (q * 7919) % n, &m, anterior, distancia);
+        suma_b += distancia[(q * 7919) % n];
+    }
+    t_kernel = ahora_ms() - t0;
+
+    /* flujo maximo: una red, varias consultas; el flujo debe igualar la capacidad del corte */
+    t0 = ahora_ms();
+    construir_red_flujo(grafo, &red);
+    t_red = ahora_ms() - t0;
+    corte = malloc(sizeof(int) * n * grado);
+    corte_ok = 1;
+    t_flujo = 0.0;
+    for (q = 0; q < consultas; ++q)
+    {
+        t0 = ahora_ms();
+        flujo = flujo_maximo(&red, q % n, (q * 7919 + 1) % n);
+        t_flujo += ahora_ms() - t0;
+        num_corte = aristas_corte_minimo(&red, q % n, corte, n * grado);
+        capacidad_corte = 0;
+        for (i = 0; i < num_corte; ++i)
+            capacidad_corte += grafo->aristas.ancho_banda_mbps[corte[i]];
+        if (capacidad_corte != flujo)
+            corte_ok = 0;
+    }
+
+    printf("vertices=%d aristas=%d consultas=%d\n", n, n * grado, consultas);
+    printf("callback: %.3f ms/consulta\n", t_callback / consultas);
+    printf("kernel:   %.3f ms/consulta (+%.3f ms construir vista)\n", t_kernel / consultas, t_vista);
+    printf("resultados %s\n", suma_a == suma_b ? "iguales" : "DISTINTOS");
+    printf("flujo:    %.3f ms/consulta (+%.3f ms construir red), corte %s\n", t_flujo / consultas, t_red, corte_ok ? "= flujo" : "DISTINTO");
+
+    liberar_red_flujo(&red);
+    free(corte);
+    liberar_vista_latencia(&vista);
+    monticulo_liberar(&m);
+    free(anterior);
+    free(distancia);
+    liberar_grafo(grafo);
+    return suma_a == suma_b && corte_ok ? 0 : 1;
+}
@@ -0,0 +1,402 @@
+/*
+ * Suite de rendimiento: mide las operaciones de la CLI sobre topologias
+ * generadas de varias formas y tamanos y escribe una tabla TSV (una fila por
+ * topologia y operacion) con mediana, maximo, throughput y RSS maximo (con a
+ * lo sumo MAX_MUESTRAS repeticiones un p99 coincidiria con el maximo).
+ *
+ *   bench_suite [salida.tsv] [rapido]      mide y escribe la tabla
+ *   bench_suite comparar <base> <actual> [umbral_%]
+ *                                          marca regresiones de la mediana
+ *                                          (sale con 1 si hay alguna)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <float.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "grafos.h"
+#include "dijkstra.h"
+#include "generador.h"
+#include "resiliencia.h"
+
+#define MAX_MUESTRAS 64
+#define PRESUPUESTO_MS 1500.0 /* por operacion; siempre al menos 3 muestras */
+#define MIN_MUESTRAS 3
+#define UMBRAL_POR_DEFECTO 25.0
+#define RUIDO_MS 0.05 /* diferencias menores no cuentan como regresion */
+
+typedef struct CASO
+{
+    const char *tipo;
+    int tamano;
+    int grado;
+    int rapido; /* se incluye en el modo rapido */
+} CASO;
+
+static const CASO casos[] = {
+    {"fat-tree", 8, 0, 1},
+    {"fat-tree", 24, 0, 0},
+    {"hoja-espina", 32, 0, 1},
+    {"waxman", 1000, 0, 1},
+    {"waxman", 5000, 0, 0},
+    {"barabasi", 2000, 0, 1},
+    {"barabasi", 10000, 0, 0},
+    {"anillo", 2000, 4, 0},
+};
+
+typedef struct MEDICION
+{
+    char grafo[48];
+    int vertices;
+    int aristas;
+    char operacion[32];
+    int repeticiones;
+    double mediana_ms;
+    double max_ms;
+    double ops_s;
+    long rss_kb;
+} MEDICION;
+
+static double costo_latencia(const GRAFO *grafo, int arista)
+{
+    return (double)grafo->aristas.latencia_ms[arista];
+}
+
+static double ahora_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* Pico de RSS del proceso; cada caso corre en un hijo propio, asi que es el del caso */
+static long rss_maximo_kb(void)
+{
+    struct rusage uso;
+    getrusage(RUSAGE_SELF, &uso);
+    return uso.ru_maxrss;
+}
+
+static int comparar_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Estado compartido por las operaciones de un caso */
+typedef struct CONTEXTO
+{
+    GRAFO *grafo;
+    const char *archivo;
+    int *anterior;
+    double *distancia;
+    int *impacto;
+    int consulta;
+    MOTOR_BFS motor; /* se conserva entre repeticiones: la CSR se construye en la primera */
+} CONTEXTO;
+
+typedef void (*Operacion)(CONTEXTO *);
+
+static void par_consulta(CONTEXTO *c, int *origen, int *destino)
+{
+    int n = c->grafo->num_vertices;
+    *origen = (c->consulta * 7919) % n;
+    *destino = (c->consulta * 104729 + n / 2) % n;
+    c->consulta++;
+}
+
+static void op_guardar(CONTEXTO *c)
+{
+    guardar_grafo(c->grafo, c->archivo);
+}
+
+static void op_cargar(CONTEXTO *c)
+{
+    GRAFO *g = crear_grafo(c->grafo->num_vertices);
+    cargar_grafo(g, c->archivo);
+    liberar_grafo(g);
+}
+
+static void op_dijkstra(CONTEXTO *c)
+{
+    int o, d;
+    par_consulta(c, &o, &d);
+    dijkstra_camino_minimo(c->grafo, o, d, costo_latencia, c->anterior, c->distancia);
+}
+
+static void op_k_rutas(CONTEXTO *c)
+{
+    static int caminos[3][256];
+    int longitudes[3], o, d;
+    par_consulta(c, &o, &d);
+    encontrar_k_rutas_aproximadas(c->grafo, o, d, costo_latencia, 3, caminos, longitudes, 256);
+}
+
+static void op_alcanzables(CONTEXTO *c)
+{
+    int o, d;
+    par_consulta(c, &o, &d);
+    contar_alcanzables(c->grafo, o);
+}
+
+static void op_alcanzables_bfs(CONTEXTO *c)
+{
+    int o, d;
+    par_consulta(c, &o, &d);
+    recorrer_bfs(c->grafo, &c->motor, o, -1, NULL);
+}
+
+static void op_resiliencia(CONTEXTO *c)
+{
+    analizar_impacto_fallos(c->grafo, 0, c->impacto);
+}
+
+/* Lo que hace ping: vista, Dijkstra por latencia, ruta y cuatro sondas */
+static void op_ping(CONTEXTO *c)
+{
+    VISTA_latencia vista;
+    int camino[256], longitud, o, d, prueba;
+    double latencia;
+
+    par_consulta(c, &o, &d);
+    if (construir_vista_latencia(c->grafo, &vista) != 0)
+        return;
+    dijkstra_latencia(&vista, o, d, NULL, c->anterior, c->distancia);
+    liberar_vista_latencia(&vista);
+    if (c->distancia[d] >= DBL_MAX / 2)
+        return;
+    longitud = reconstruir_camino(c->anterior, d, camino, 256);
+    for (prueba = 0; prueba < 4; ++prueba)
+        sondear_camino(c->grafo, camino, longitud, &latencia);
+}
+
+static void medir(CONTEXTO *c, const char *grafo, const char *nombre, Operacion op, MEDICION *m)
+{
+    double muestras[MAX_MUESTRAS], t0, total;
+    int k;
+
+    total = 0.0;
+    for (k = 0; k < MAX_MUESTRAS && (k < MIN_MUESTRAS || total < PRESUPUESTO_MS); ++k)
+    {
+        t0 = ahora_ms();
+        op(c);
+        muestras[k] = ahora_ms() - t0;
+        total += muestras[k];
+    }
+    qsort(muestras, k, sizeof(double), comparar_double);
+
+    snprintf(m->grafo, sizeof(m->grafo), "%s", grafo);
+    snprintf(m->operacion, sizeof(m->operacion), "%s", nombre);
+    m->vertices = c->grafo->num_vertices;
+    m->aristas = c->grafo->aristas.num;
+    m->repeticiones = k;
+    m->mediana_ms = muestras[k / 2];
+    m->max_ms = muestras[k - 1];
+    m->ops_s = m->mediana_ms > 0.0 ? 1e3 / m->mediana_ms : 0.0;
+    m->rss_kb = rss_maximo_kb();
+}
+
+static void escribir_medicion(FILE *f, const MEDICION *m)
+{
+    fprintf(f, "%s\t%d\t%d\t%s\t%d\t%.4f\t%.4f\t%.1f\t%ld\n", m->grafo, m->vertices, m->aristas, m->operacion,
+            m->repeticiones, m->mediana_ms, m->max_ms, m->ops_s, m->rss_kb);
+}
+
+/* Genera la topologia del caso y mide todas las operaciones sobre ella */
+static void medir_caso(const CASO *caso, FILE *f, const char *archivo)
+{
+    static const struct
+    {
+        const char *nombre;
+        Operacion op;
+    } operaciones[] = {
+        {"guardar_grafo", op_guardar},
+        {"cargar_grafo", op_cargar},
+        {"dijkstra", op_dijkstra},
+        {"k_rutas", op_k_rutas},
+        {"contar_alcanzables", op_alcanzables},
+        {"alcanzables_bfs", op_alcanzables_bfs},
+        {"resiliencia", op_resiliencia},
+        {"ping", op_ping},
+    };
+    char etiqueta[48];
+    PARAMETROS_GENERADOR p;
+    CONTEXTO c;
+    MEDICION m;
+    size_t j;
+    int n;
+
+    p.tipo = generador_desde_cadena(caso->tipo);
+    p.tamano = caso->tamano;
+    p.grado = caso->grado;
+    p.semilla = 42;
+    c.grafo = generar_topologia(&p);
+    if (!c.grafo)
+    {
+        fprintf(stderr, "No se pudo generar %s %d\n", caso->tipo, caso->tamano);
+        return;
+    }
+    n = c.grafo->num_vertices;
+    c.archivo = archivo;
+    c.anterior = malloc(sizeof(int) * n);
+    c.distancia = malloc(sizeof(double) * n);
+    c.impacto = malloc(sizeof(int) * n);
+    c.consulta = 1;
+    iniciar_motor_bfs(&c.motor, 0);
+    snprintf(etiqueta, sizeof(etiqueta), "%s-%d", caso->tipo, caso->tamano);
+    guardar_grafo(c.grafo, archivo);
+
+    for (j = 0; j < sizeof(operaciones) / sizeof(operaciones[0]); ++j)
+    {
+        srand(42);
+        medir(&c, etiqueta, operaciones[j].nombre, operaciones[j].op, &m);
+        escribir_medicion(f, &m);
+        printf("%-18s %-19s mediana %10.3f ms  max %10.3f ms  %10.1f op/s  rss %ld kB\n", etiqueta,
+               m.operacion, m.mediana_ms, m.max_ms, m.ops_s, m.rss_kb);
+        fflush(stdout);
+    }
+
+    free(c.anterior);
+    free(c.distancia);
+    free(c.impacto);
+    liberar_motor_bfs(&c.motor);
+    liberar_grafo(c.grafo);
+}
+
+static int ejecutar_suite(const char *salida, int rapido)
+{
+    char archivo[64];
+    FILE *f;
+    size_t i;
+    pid_t pid;
+    int estado;
+
+    f = fopen(salida, "w");
+    if (!f)
+    {
+        fprintf(stderr, "No se puede escribir %s\n", salida);
+        return 1;
+    }
+    fprintf(f, "grafo\tvertices\taristas\toperacion\trepeticiones\tmediana_ms\tmax_ms\tops_s\trss_kb\n");
+    snprintf(archivo, sizeof(archivo), "/tmp/bench_suite_%d.bin", (int)getpid());
+
+    for (i = 0; i < sizeof(casos) / sizeof(casos[0]); ++i)
+    {
+        if (rapido && !casos[i].rapido)
+            continue;
+        /* un hijo por caso: ru_maxrss no arrastra el pico de los casos anteriores */
+        fflush(f);
+        fflush(stdout);
+        pid = fork();
+        if (pid == 0)
+        {
+            medir_caso(&casos[i], f, archivo);
+            fflush(f);
+            fflush(stdout);
+            _exit(0);
+        }
+        if (pid < 0)
+        {
+            fprintf(stderr, "fork fallo; %s %d se mide en el proceso principal\n", casos[i].tipo, casos[i].tamano);
+            medir_caso(&casos[i], f, archivo);
+            continue;
+        }
+        if (waitpid(pid, &estado, 0) < 0 || !WIFEXITED(estado) || WEXITSTATUS(estado) != 0)
+            fprintf(stderr, "El caso %s %d termino de forma anormal\n", casos[i].tipo, casos[i].tamano);
+    }
+    remove(archivo);
+    fclose(f);
+    printf("Resultados en %s\n", salida);
+    return 0;
+}
+
+static int leer_mediciones(const char *archivo, MEDICION **salida)
+{
+    char linea[512];
+    MEDICION *v = NULL, *tmp, m;
+    int num = 0, capacidad = 0;
+    FILE *f = fopen(archivo, "r");
+
+    if (!f)
+        return -1;
+    while (fgets(linea, sizeof(linea), f))
+    {
+        if (sscanf(linea, "%47s %d %d %31s %d %lf %lf %lf %ld", m.grafo, &m.vertices, &m.aristas, m.operacion,
+                   &m.repeticiones, &m.mediana_ms, &m.max_ms, &m.ops_s, &m.rss_kb) != 9)
+            continue; /* cabecera o linea invalida */
+        if (num == capacidad)
+        {
+            capacidad = capacidad ? capacidad * 2 : 64;
+            tmp = realloc(v, sizeof(MEDICION) * capacidad);
+            if (!tmp)
+                break;
+            v = tmp;
+        }
+        v[num++] = m;
+    }
+    fclose(f);
+    *salida = v;
+    return num;
+}
+
+static int comparar_resultados(const char *base, const char *actual, double umbral)
+{
+    MEDICION *b, *a;
+    int nb, na, i, j, regresiones, comparadas;
+    double cambio;
+
+    nb = leer_mediciones(base, &b);
+    na = leer_mediciones(actual, &a);
+    if (nb < 0 || na < 0)
+    {
+        fprintf(stderr, "No se puede leer %s\n", nb < 0 ? base : actual);
+        if (nb >= 0)
+            free(b);
+        if (na >= 0)
+            free(a);
+        return 2;
+    }
+
+    regresiones = 0;
+    comparadas = 0;
+    for (i = 0; i < na; ++i)
+    {
+        for (j = 0; j < nb; ++j)
+            if (strcmp(a[i].grafo, b[j].grafo) == 0 && strcmp(a[i].operacion, b[j].operacion) == 0)
+                break;
+        if (j == nb)
+            continue;
+        comparadas++;
+        cambio = b[j].mediana_ms > 0.0 ? (a[i].mediana_ms - b[j].mediana_ms) * 100.0 / b[j].mediana_ms : 0.0;
+        if (cambio > umbral && a[i].mediana_ms - b[j].mediana_ms > RUIDO_MS)
+        {
+            regresiones++;
+            printf("REGRESION %-18s %-19s %10.3f -> %10.3f ms (%+.1f%%)\n", a[i].grafo, a[i].operacion,
+                   b[j].mediana_ms, a[i].mediana_ms, cambio);
+        }
+        else if (cambio < -umbral)
+            printf("mejora    %-18s %-19s %10.3f -> %10.3f ms (%+.1f%%)\n", a[i].grafo, a[i].operacion,
+                   b[j].mediana_ms, a[i].mediana_ms, cambio);
+    }
+    printf("%d mediciones comparadas, %d regresiones (umbral %.1f%%)\n", comparadas, regresiones, umbral);
+    free(a);
+    free(b);
+    return regresiones ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "comparar") == 0)
+    {
+        if (argc < 4)
+        {
+            fprintf(stderr, "Uso: %s comparar <base.tsv> <actual.tsv> [umbral_%%]\n", argv[0]);
+            return 2;
+        }
+        return comparar_resultados(argv[2], argv[3], argc > 4 ? atof(argv[4]) : UMBRAL_POR_DEFECTO);
+    }
+    return ejecutar_suite(argc > 1 ? argv[1] : "bench_suite.tsv", argc > 2 && strcmp(argv[2], "rapido") == 0);
+}
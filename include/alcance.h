@@ -0,0 +1,460 @@
+#ifndef ALCANCE_H
+#define ALCANCE_H
+
+#include "grafos.h"
+
+/*
+ * Alcanzabilidad dirigida: componentes fuertemente conexas e índice sobre la
+ * condensación.
+ *
+ * Las componentes salen de un Tarjan iterativo (pila explícita con la arista
+ * por la que sigue cada vértice, sin recursión). Tarjan cierra una componente
+ * solo después de todas las que alcanza, así que su número es un orden
+ * topológico inverso de la condensación: si cu alcanza cv, cv <= cu. Eso
+ * descarta en O(1) la mitad de las consultas negativas.
+ *
+ * El resto se responde con etiquetas 2-hop (pruned landmark labeling) sobre
+ * el DAG de componentes: se recorren las componentes por grado, de mayor a
+ * menor, y desde cada una (la "marca" de rango r) se hace un BFS hacia delante
+ * que añade r a la etiqueta de entrada de lo que alcanza y otro hacia atrás
+ * que la añade a la de salida. Un BFS no sigue por un vértice al que las
+ * etiquetas ya le dan la respuesta, así que las etiquetas quedan pequeñas. u
+ * alcanza v si salida(u) y entrada(v) comparten alguna marca; ambas listas
+ * están ordenadas por rango y se cruzan con una mezcla lineal.
+ *
+ * El índice guarda la versión del grafo con la que se construyó y se rehace,
+ * al consultarlo, solo si el grafo cambió desde entonces.
+ */
+typedef struct INDICE_ALCANCE
+{
+    int num_vertices;
+    int num_componentes;
+    int *componente;    /* de cada vértice, -1 si está fallido */
+    int *tam;           /* vértices de cada componente */
+    int *representante; /* un vértice de cada componente */
+    /* condensación (con repetidos) hacia delante y hacia atrás */
+    int *inicio;
+    int *sucesor;
+    int *inicio_inv;
+    int *predecesor;
+    /* etiquetas 2-hop por componente: marcas en orden creciente de rango */
+    int *inicio_salida;
+    int *salida;
+    int *inicio_entrada;
+    int *entrada;
+    unsigned version;   /* grafo->version al construirlo */
+    int valido;
+} INDICE_ALCANCE;
+
+int construir_indice_alcance(GRAFO *grafo, INDICE_ALCANCE *ind);
+void liberar_indice_alcance(INDICE_ALCANCE *ind);
+/* Rehace el índice si el grafo cambió desde que se construyó; -1 sin memoria */
+int actualizar_indice_alcance(GRAFO *grafo, INDICE_ALCANCE *ind);
+/* 1 si hay camino u -> v por vértices y enlaces activos, 0 si no, -1 sin memoria */
+int alcanza(GRAFO *grafo, INDICE_ALCANCE *ind, int u, int v);
+/* Componentes sin entradas (fuentes) y sin salidas (sumideros) en la condensación */
+void extremos_condensacion(const INDICE_ALCANCE *ind, int *fuentes, int *sumideros);
+
+// Implementaciones
+
+void liberar_indice_alcance(INDICE_ALCANCE *ind)
+{
+    if (!ind)
+        return;
+    free(ind->componente);
+    free(ind->tam);
+    free(ind->representante);
+    free(ind->inicio);
+    free(ind->sucesor);
+    free(ind->inicio_inv);
+    free(ind->predecesor);
+    free(ind->inicio_salida);
+    free(ind->salida);
+    free(ind->inicio_entrada);
+    free(ind->entrada);
+    memset(ind, 0, sizeof(*ind));
+}
+
+/* Tarjan iterativo sobre vértices y aristas activos; devuelve el número de componentes o -1 */
+static int componentes_tarjan(GRAFO *grafo, int *componente)
+{
+    int n, s, u, v, e, cima, tope, contador, num, *indice, *bajo, *pila, *llamadas, *arista;
+    unsigned char *en_pila;
+
+    n = grafo->num_vertices;
+    indice = malloc(sizeof(int) * (n + 1));
+    bajo = malloc(sizeof(int) * (n + 1));
+    pila = malloc(sizeof(int) * (n + 1));
+    llamadas = malloc(sizeof(int) * (n + 1));
+    arista = malloc(sizeof(int) * (n + 1));
+    en_pila = calloc(n + 1, 1);
+    if (!indice || !bajo || !pila || !llamadas || !arista || !en_pila)
+    {
+        free(indice);
+        free(bajo);
+        free(pila);
+        free(llamadas);
+        free(arista);
+        free(en_pila);
+        return -1;
+    }
+    for (u = 0; u < n; ++u)
+    {
+        indice[u] = -1;
+        componente[u] = -1;
+    }
+    contador = 0;
+    num = 0;
+    tope = 0;
+    for (s = 0; s < n; ++s)
+    {
+        if (indice[s] != -1 || !grafo->vertices[s].activo)
+            continue;
+        /* llamadas[] hace de pila de recursión; arista[u] es la siguiente saliente por mirar */
+        cima = 0;
+        llamadas[cima++] = s;
+        indice[s] = bajo[s] = contador++;
+        arista[s] = grafo->vertices[s].primera_arista;
+        pila[tope++] = s;
+        en_pila[s] = 1;
+        while (cima > 0)
+        {
+            u = llamadas[cima - 1];
+            e = arista[u];
+            if (e != -1)
+            {
+                arista[u] = grafo->aristas.siguiente[e];
+                v = grafo->aristas.destino[e];
+                if (!ARISTA_ACTIVA(grafo, e) || !grafo->vertices[v].activo)
+                    continue;
+                if (indice[v] == -1)
+                {
+                    indice[v] = bajo[v] = contador++;
+                    arista[v] = grafo->vertices[v].primera_arista;
+                    pila[tope++] = v;
+                    en_pila[v] = 1;
+                    llamadas[cima++] = v;
+                }
+                else if (en_pila[v] && indice[v] < bajo[u])
+                    bajo[u] = indice[v];
+                continue;
+            }
+            /* u terminado: cierra su componente si es raíz y pasa su bajo al padre */
+            if (bajo[u] == indice[u])
+            {
+                do
+                {
+                    v = pila[--tope];
+                    en_pila[v] = 0;
+                    componente[v] = num;
+                } while (v != u);
+                num++;
+            }
+            cima--;
+            if (cima > 0 && bajo[u] < bajo[llamadas[cima - 1]])
+                bajo[llamadas[cima - 1]] = bajo[u];
+        }
+    }
+    free(indice);
+    free(bajo);
+    free(pila);
+    free(llamadas);
+    free(arista);
+    free(en_pila);
+    return num;
+}
+
+/* CSR de la condensación en ambos sentidos; -1 sin memoria */
+static int construir_condensacion(GRAFO *grafo, INDICE_ALCANCE *ind)
+{
+    int c, e, cu, cv, m, *pos, *pos_inv;
+
+    c = ind->num_componentes;
+    ind->inicio = calloc(c + 2, sizeof(int));
+    ind->inicio_inv = calloc(c + 2, sizeof(int));
+    if (!ind->inicio || !ind->inicio_inv)
+        return -1;
+    m = 0;
+    for (e = 0; e < grafo->aristas.num; ++e)
+    {
+        if (grafo->aristas.destino[e] < 0 || !ARISTA_ACTIVA(grafo, e))
+            continue;
+        cu = ind->componente[grafo->aristas.origen[e]];
+        cv = ind->componente[grafo->aristas.destino[e]];
+        if (cu < 0 || cv < 0 || cu == cv)
+            continue;
+        ind->inicio[cu + 1]++;
+        ind->inicio_inv[cv + 1]++;
+        m++;
+    }
+    for (cu = 0; cu < c; ++cu)
+    {
+        ind->inicio[cu + 1] += ind->inicio[cu];
+        ind->inicio_inv[cu + 1] += ind->inicio_inv[cu];
+    }
+    ind->sucesor = malloc(sizeof(int) * (m + 1));
+    ind->predecesor = malloc(sizeof(int) * (m + 1));
+    pos = malloc(sizeof(int) * (c + 1));
+    pos_inv = malloc(sizeof(int) * (c + 1));
+    if (!ind->sucesor || !ind->predecesor || !pos || !pos_inv)
+    {
+        free(pos);
+        free(pos_inv);
+        return -1;
+    }
+    memcpy(pos, ind->inicio, sizeof(int) * (c + 1));
+    memcpy(pos_inv, ind->inicio_inv, sizeof(int) * (c + 1));
+    for (e = 0; e < grafo->aristas.num; ++e)
+    {
+        if (grafo->aristas.destino[e] < 0 || !ARISTA_ACTIVA(grafo, e))
+            continue;
+        cu = ind->componente[grafo->aristas.origen[e]];
+        cv = ind->componente[grafo->aristas.destino[e]];
+        if (cu < 0 || cv < 0 || cu == cv)
+            continue;
+        ind->sucesor[pos[cu]++] = cv;
+        ind->predecesor[pos_inv[cv]++] = cu;
+    }
+    free(pos);
+    free(pos_inv);
+    return 0;
+}
+
+/* Lista dinámica de marcas mientras se construyen las etiquetas */
+typedef struct LISTA_MARCAS
+{
+    int *marca;
+    int num;
+    int capacidad;
+} LISTA_MARCAS;
+
+static int anotar_marca(LISTA_MARCAS *l, int marca)
+{
+    void *tmp;
+
+    if (l->num == l->capacidad)
+    {
+        l->capacidad = l->capacidad ? l->capacidad * 2 : 4;
+        tmp = realloc(l->marca, sizeof(int) * l->capacidad);
+        if (!tmp)
+            return -1;
+        l->marca = tmp;
+    }
+    l->marca[l->num++] = marca;
+    return 0;
+}
+
+static const INDICE_ALCANCE *indice_orden_alcance;
+
+/* Más grado primero: (entradas + 1) * (salidas + 1), desempate por número */
+static int comparar_grado_componente(const void *pa, const void *pb)
+{
+    const INDICE_ALCANCE *ind = indice_orden_alcance;
+    int a = *(const int *)pa, b = *(const int *)pb;
+    long long ga = (long long)(ind->inicio[a + 1] - ind->inicio[a] + 1) * (ind->inicio_inv[a + 1] - ind->inicio_inv[a] + 1);
+    long long gb = (long long)(ind->inicio[b + 1] - ind->inicio[b] + 1) * (ind->inicio_inv[b + 1] - ind->inicio_inv[b] + 1);
+
+    if (ga != gb)
+        return ga > gb ? -1 : 1;
+    return (a > b) - (a < b);
+}
+
+/*
+ * BFS de la marca de rango r desde la componente w por sucesores (hacia
+ * delante, anota en entrada) o predecesores (anota en salida). Poda x si
+ * alguna marca de su lista ya está en visto (las de la lista opuesta de w).
+ */
+static int propagar_marca(const INDICE_ALCANCE *ind, int w, int r, int adelante, LISTA_MARCAS *lista, const unsigned *visto,
+                          unsigned *marcado, unsigned sello, int *cola)
+{
+    const int *inicio = adelante ? ind->inicio : ind->inicio_inv;
+    const int *vecino = adelante ? ind->sucesor : ind->predecesor;
+    int cabeza, fin, x, y, k, podar;
+
+    cabeza = fin = 0;
+    cola[fin++] = w;
+    marcado[w] = sello;
+    while (cabeza < fin)
+    {
+        x = cola[cabeza++];
+        podar = 0;
+        for (k = 0; x != w && k < lista[x].num && !podar; ++k)
+            podar = visto[lista[x].marca[k]] == sello;
+        if (podar)
+            continue;
+        if (anotar_marca(&lista[x], r) != 0)
+            return -1;
+        for (k = inicio[x]; k < inicio[x + 1]; ++k)
+        {
+            y = vecino[k];
+            if (marcado[y] == sello)
+                continue;
+            marcado[y] = sello;
+            cola[fin++] = y;
+        }
+    }
+    return 0;
+}
+
+/* Aplana las listas en CSR; -1 sin memoria */
+static int aplanar_marcas(LISTA_MARCAS *lista, int c, int **inicio, int **marcas)
+{
+    int i, total;
+
+    total = 0;
+    for (i = 0; i < c; ++i)
+        total += lista[i].num;
+    *inicio = malloc(sizeof(int) * (c + 1));
+    *marcas = malloc(sizeof(int) * (total + 1));
+    if (!*inicio || !*marcas)
+        return -1;
+    total = 0;
+    for (i = 0; i < c; ++i)
+    {
+        (*inicio)[i] = total;
+        if (lista[i].num)
+            memcpy(*marcas + total, lista[i].marca, sizeof(int) * lista[i].num);
+        total += lista[i].num;
+    }
+    (*inicio)[c] = total;
+    return 0;
+}
+
+static int etiquetas_2hop(INDICE_ALCANCE *ind)
+{
+    LISTA_MARCAS *salida, *entrada;
+    int c, i, k, w, ok, *orden, *cola;
+    unsigned *visto, *marcado, sello;
+
+    c = ind->num_componentes;
+    salida = calloc(c + 1, sizeof(LISTA_MARCAS));
+    entrada = calloc(c + 1, sizeof(LISTA_MARCAS));
+    orden = malloc(sizeof(int) * (c + 1));
+    cola = malloc(sizeof(int) * (c + 1));
+    visto = calloc(c + 1, sizeof(unsigned));
+    marcado = calloc(c + 1, sizeof(unsigned));
+    ok = salida && entrada && orden && cola && visto && marcado;
+    if (ok)
+    {
+        for (i = 0; i < c; ++i)
+            orden[i] = i;
+        indice_orden_alcance = ind;
+        qsort(orden, c, sizeof(int), comparar_grado_componente);
+        /* dos sellos por marca: uno para el BFS hacia delante y otro hacia atrás */
+        sello = 0;
+        for (i = 0; ok && i < c; ++i)
+        {
+            w = orden[i];
+            ++sello;
+            for (k = 0; k < salida[w].num; ++k)
+                visto[salida[w].marca[k]] = sello;
+            ok = propagar_marca(ind, w, i, 1, entrada, visto, marcado, sello, cola) == 0;
+            ++sello;
+            for (k = 0; ok && k < entrada[w].num; ++k)
+                visto[entrada[w].marca[k]] = sello;
+            ok = ok && propagar_marca(ind, w, i, 0, salida, visto, marcado, sello, cola) == 0;
+        }
+        ok = ok && aplanar_marcas(salida, c, &ind->inicio_salida, &ind->salida) == 0 &&
+             aplanar_marcas(entrada, c, &ind->inicio_entrada, &ind->entrada) == 0;
+    }
+    for (i = 0; i < c; ++i)
+    {
+        if (salida)
+            free(salida[i].marca);
+        if (entrada)
+            free(entrada[i].marca);
+    }
+    free(salida);
+    free(entrada);
+    free(orden);
+    free(cola);
+    free(visto);
+    free(marcado);
+    return ok ? 0 : -1;
+}
+
+int construir_indice_alcance(GRAFO *grafo, INDICE_ALCANCE *ind)
+{
+    int n, v;
+
+    if (!grafo || !ind)
+        return -1;
+    memset(ind, 0, sizeof(*ind));
+    n = grafo->num_vertices;
+    ind->num_vertices = n;
+    ind->version = grafo->version;
+    ind->componente = malloc(sizeof(int) * (n + 1));
+    if (!ind->componente || (ind->num_componentes = componentes_tarjan(grafo, ind->componente)) < 0)
+    {
+        liberar_indice_alcance(ind);
+        return -1;
+    }
+    ind->tam = calloc(ind->num_componentes + 1, sizeof(int));
+    ind->representante = malloc(sizeof(int) * (ind->num_componentes + 1));
+    if (!ind->tam || !ind->representante || construir_condensacion(grafo, ind) != 0 || etiquetas_2hop(ind) != 0)
+    {
+        liberar_indice_alcance(ind);
+        return -1;
+    }
+    for (v = 0; v < n; ++v)
+        if (ind->componente[v] >= 0 && ind->tam[ind->componente[v]]++ == 0)
+            ind->representante[ind->componente[v]] = v;
+    ind->valido = 1;
+    return 0;
+}
+
+int actualizar_indice_alcance(GRAFO *grafo, INDICE_ALCANCE *ind)
+{
+    if (ind->valido && ind->version == grafo->version && ind->num_vertices == grafo->num_vertices)
+        return 0;
+    liberar_indice_alcance(ind);
+    return construir_indice_alcance(grafo, ind);
+}
+
+int alcanza(GRAFO *grafo, INDICE_ALCANCE *ind, int u, int v)
+{
+    int cu, cv, i, j, fi, fj;
+
+    if (u < 0 || v < 0 || u >= grafo->num_vertices || v >= grafo->num_vertices)
+        return 0;
+    if (actualizar_indice_alcance(grafo, ind) != 0)
+        return -1;
+    cu = ind->componente[u];
+    cv = ind->componente[v];
+    if (cu < 0 || cv < 0)
+        return 0;
+    if (cu == cv)
+        return 1;
+    if (cv > cu)
+        return 0;
+    /* mezcla de dos listas ordenadas por rango */
+    i = ind->inicio_salida[cu];
+    fi = ind->inicio_salida[cu + 1];
+    j = ind->inicio_entrada[cv];
+    fj = ind->inicio_entrada[cv + 1];
+    while (i < fi && j < fj)
+    {
+        if (ind->salida[i] == ind->entrada[j])
+            return 1;
+        if (ind->salida[i] < ind->entrada[j])
+            i++;
+        else
+            j++;
+    }
+    return 0;
+}
+
+void extremos_condensacion(const INDICE_ALCANCE *ind, int *fuentes, int *sumideros)
+{
+    int c;
+
+    *fuentes = 0;
+    *sumideros = 0;
+    for (c = 0; c < ind->num_componentes; ++c)
+    {
+        *fuentes += ind->inicio_inv[c + 1] == ind->inicio_inv[c];
+        *sumideros += ind->inicio[c + 1] == ind->inicio[c];
+    }
+}
+
+#endif
@@ -0,0 +1,614 @@
+#ifndef BFS_H
+#define BFS_H
+
+#include <pthread.h>
+#include <unistd.h>
+#include "grafos.h"
+
+#define MAX_HILOS_BFS 8
+/* por debajo de tantas aristas un recorrido no compensa lanzar hilos */
+#define MIN_ARISTAS_PARALELO_BFS (1 << 17)
+#define ALFA_BFS 15          /* arriba-abajo -> abajo-arriba si aristas de la frontera > sin explorar / ALFA */
+#define BETA_BFS 18          /* abajo-arriba -> arriba-abajo si la frontera < n / BETA y encoge */
+#define BLOQUE_BFS 64        /* vértices de la frontera que toma un hilo de cada vez */
+#define PALABRAS_BLOQUE_BFS 16 /* palabras del mapa (x 64 vértices) en los pasos abajo-arriba */
+#define TAM_BUFFER_BFS 256   /* descubiertos que un hilo junta antes de pasarlos a la cola común */
+#define FALLOS_BLOQUE_BFS 16 /* vértices del barrido de fallos por bloque */
+#define FACTOR_CARO_BFS 2    /* abajo-arriba caro: revisa más de tantas veces las salientes de la frontera */
+#define PAUSA_ABAJO_BFS 63   /* recorridos siguientes que no lo vuelven a probar */
+
+/*
+ * BFS por niveles que elige el sentido de cada paso (Beamer). Arriba-abajo
+ * recorre las salientes de la frontera, que va en una lista. Abajo-arriba
+ * recorre los vértices sin visitar y mira si alguna entrante viene de la
+ * frontera, que va en un mapa de bits. Para en la primera que encuentra, así
+ * que cuando la frontera es grande examina muchas menos aristas. Pasa a
+ * abajo-arriba cuando las aristas que saldrían de la frontera superan a las
+ * que quedan por explorar / ALFA_BFS. Vuelve cuando la frontera cae por
+ * debajo de n / BETA_BFS y encoge. En redes de diámetro grande (Waxman,
+ * anillos) pocos vértices sin visitar tienen un padre en la frontera y
+ * abajo-arriba no para pronto. El primer paso abajo-arriba siempre revisa
+ * muchas entrantes; en redes de mundo pequeño el siguiente ya revisa pocas.
+ * Si dos pasos seguidos revisan más de FACTOR_CARO_BFS veces las salientes
+ * de la frontera, el recorrido sigue arriba-abajo hasta el final, y los
+ * PAUSA_ABAJO_BFS recorridos siguientes con los mismos buffers (el barrido
+ * de fallos hace n sobre casi el mismo grafo) ni lo prueban.
+ *
+ * Dentro de un nivel los hilos se reparten la frontera (o las palabras del
+ * mapa) con un contador común. Arriba-abajo marca el visitado con un OR
+ * atómico y solo encola quien pone el bit. Abajo-arriba no necesita
+ * atómicos: cada palabra del mapa es de un solo hilo. Entre niveles hay una
+ * barrera y un único hilo decide el sentido del siguiente paso.
+ *
+ * El motor guarda, por versión del grafo, una CSR de salientes y otra de
+ * entrantes con solo los enlaces activos entre vértices activos, y el mapa
+ * de vértices inactivos, que cada recorrido toma como ya visitados. Recorrer
+ * las listas enlazadas del GRAFO cuesta unas cuatro veces más por arista que
+ * la CSR, así que la construcción se paga una vez y los recorridos
+ * siguientes, hasta el próximo cambio del grafo, solo leen arreglos.
+ *
+ * El barrido de fallos reparte los vértices entre hilos y cada uno hace sus
+ * recorridos en un solo hilo, porque n recorridos independientes se reparten
+ * mejor que los niveles de uno.
+ */
+typedef struct RECORRIDO_BFS
+{
+    const struct MOTOR_BFS *motor;
+    int palabras;
+    uint64_t *visitado;
+    uint64_t *frontera;  /* frontera en mapa de bits (pasos abajo-arriba) */
+    uint64_t *siguiente;
+    int *cola;           /* frontera en lista (pasos arriba-abajo) */
+    int *cola_sig;
+    int *distancia;      /* saltos desde el origen, -1 sin alcanzar; NULL si no se piden */
+    int hilos;
+    /* nivel en curso; lo cierra un solo hilo entre dos barreras */
+    int nivel;
+    int en_bits;
+    int caros;           /* pasos abajo-arriba caros seguidos */
+    int solo_arriba;     /* abajo-arriba ya salió más caro en este recorrido */
+    int pausa_abajo;     /* recorridos que aún empiezan con solo_arriba */
+    int tam_cola;
+    int tam_sig;
+    int reparto;
+    int alcanzados;
+    long long aristas_frontera; /* salientes de la frontera actual */
+    long long aristas_sig;
+    long long revisadas;        /* entrantes revisadas en el paso abajo-arriba */
+    long long sin_explorar;
+    pthread_barrier_t barrera;
+    pthread_mutex_t arranque;
+} RECORRIDO_BFS;
+
+typedef struct MOTOR_BFS
+{
+    int num_vertices;
+    int palabras;
+    int hilos;
+    unsigned version; /* versión del grafo con la que se construyó la CSR */
+    int valido;
+    int num_arcos;
+    int *inicio;      /* arcos salientes de u */
+    int *destino;
+    int *inicio_inv;  /* arcos entrantes de v */
+    int *origen_inv;
+    uint64_t *base;   /* vértices inactivos y bits de relleno: visitados desde el principio */
+    RECORRIDO_BFS recorrido;
+} MOTOR_BFS;
+
+/* hilos <= 0 usa los procesadores disponibles */
+int iniciar_motor_bfs(MOTOR_BFS *motor, int hilos);
+void liberar_motor_bfs(MOTOR_BFS *motor);
+/*
+ * Vértices alcanzables desde origen (incluido) sin pasar por excluido (-1:
+ * ninguno); 0 si el origen está fallido o es el excluido, -1 sin memoria.
+ * Si distancia no es NULL recibe los saltos desde el origen (-1 sin alcanzar).
+ */
+int recorrer_bfs(GRAFO *grafo, MOTOR_BFS *motor, int origen, int excluido, int *distancia);
+/* Como analizar_impacto_fallos (resiliencia.h) */
+int barrido_fallos_bfs(GRAFO *grafo, MOTOR_BFS *motor, int inicio, int *impacto);
+
+// Implementaciones
+
+static void liberar_recorrido_bfs(RECORRIDO_BFS *r)
+{
+    free(r->visitado);
+    free(r->frontera);
+    free(r->siguiente);
+    free(r->cola);
+    free(r->cola_sig);
+    memset(r, 0, sizeof(*r));
+}
+
+static int reservar_recorrido_bfs(RECORRIDO_BFS *r, int n, int palabras)
+{
+    memset(r, 0, sizeof(*r));
+    r->palabras = palabras;
+    r->visitado = malloc(sizeof(uint64_t) * (palabras + 1));
+    r->frontera = malloc(sizeof(uint64_t) * (palabras + 1));
+    r->siguiente = malloc(sizeof(uint64_t) * (palabras + 1));
+    r->cola = malloc(sizeof(int) * (n + 1));
+    r->cola_sig = malloc(sizeof(int) * (n + 1));
+    if (!r->visitado || !r->frontera || !r->siguiente || !r->cola || !r->cola_sig)
+    {
+        liberar_recorrido_bfs(r);
+        return -1;
+    }
+    return 0;
+}
+
+int iniciar_motor_bfs(MOTOR_BFS *motor, int hilos)
+{
+    long procesadores;
+
+    memset(motor, 0, sizeof(*motor));
+    if (hilos <= 0)
+    {
+        procesadores = sysconf(_SC_NPROCESSORS_ONLN);
+        hilos = procesadores > 0 ? (int)procesadores : 1;
+    }
+    motor->hilos = hilos > MAX_HILOS_BFS ? MAX_HILOS_BFS : hilos;
+    return 0;
+}
+
+void liberar_motor_bfs(MOTOR_BFS *motor)
+{
+    if (!motor)
+        return;
+    free(motor->inicio);
+    free(motor->destino);
+    free(motor->inicio_inv);
+    free(motor->origen_inv);
+    free(motor->base);
+    liberar_recorrido_bfs(&motor->recorrido);
+    motor->inicio = NULL;
+    motor->destino = NULL;
+    motor->inicio_inv = NULL;
+    motor->origen_inv = NULL;
+    motor->base = NULL;
+    motor->valido = 0;
+    motor->num_vertices = 0;
+}
+
+/* CSR y mapa de inactivos para la versión actual del grafo */
+static int preparar_motor_bfs(GRAFO *grafo, MOTOR_BFS *motor)
+{
+    int n, m, v, e, u, hilos, *pos, *pos_inv;
+
+    n = grafo->num_vertices;
+    if (motor->valido && motor->version == grafo->version && motor->num_vertices == n)
+        return 0;
+    hilos = motor->hilos;
+    liberar_motor_bfs(motor);
+    motor->hilos = hilos;
+    motor->num_vertices = n;
+    motor->palabras = (n + 63) / 64;
+    motor->inicio = calloc(n + 2, sizeof(int));
+    motor->inicio_inv = calloc(n + 2, sizeof(int));
+    motor->base = calloc(motor->palabras + 1, sizeof(uint64_t));
+    if (!motor->inicio || !motor->inicio_inv || !motor->base || reservar_recorrido_bfs(&motor->recorrido, n, motor->palabras) != 0)
+    {
+        liberar_motor_bfs(motor);
+        return -1;
+    }
+    for (v = 0; v < n; ++v)
+        if (!grafo->vertices[v].activo)
+            motor->base[v >> 6] |= UINT64_C(1) << (v & 63);
+    if (n & 63)
+        motor->base[n >> 6] |= ~UINT64_C(0) << (n & 63);
+    /* conteo desplazado dos posiciones: tras la suma, inicio[u + 1] es la posición de escritura de u */
+    m = 0;
+    for (e = 0; e < grafo->aristas.num; ++e)
+    {
+        v = grafo->aristas.destino[e];
+        if (v < 0 || !ARISTA_ACTIVA(grafo, e))
+            continue;
+        u = grafo->aristas.origen[e];
+        if ((motor->base[u >> 6] >> (u & 63) & 1) || (motor->base[v >> 6] >> (v & 63) & 1))
+            continue;
+        motor->inicio[u + 2]++;
+        motor->inicio_inv[v + 2]++;
+        m++;
+    }
+    for (v = 2; v <= n + 1; ++v)
+    {
+        motor->inicio[v] += motor->inicio[v - 1];
+        motor->inicio_inv[v] += motor->inicio_inv[v - 1];
+    }
+    motor->num_arcos = m;
+    motor->destino = malloc(sizeof(int) * (m + 1));
+    motor->origen_inv = malloc(sizeof(int) * (m + 1));
+    if (!motor->destino || !motor->origen_inv)
+    {
+        liberar_motor_bfs(motor);
+        return -1;
+    }
+    pos = motor->inicio + 1;
+    pos_inv = motor->inicio_inv + 1;
+    for (e = 0; e < grafo->aristas.num; ++e)
+    {
+        v = grafo->aristas.destino[e];
+        if (v < 0 || !ARISTA_ACTIVA(grafo, e))
+            continue;
+        u = grafo->aristas.origen[e];
+        if ((motor->base[u >> 6] >> (u & 63) & 1) || (motor->base[v >> 6] >> (v & 63) & 1))
+            continue;
+        motor->destino[pos[u]++] = v;
+        motor->origen_inv[pos_inv[v]++] = u;
+    }
+    motor->version = grafo->version;
+    motor->valido = 1;
+    return 0;
+}
+
+static void empezar_bfs(RECORRIDO_BFS *r, const MOTOR_BFS *motor, int origen, int excluido, int *distancia)
+{
+    int v;
+
+    r->motor = motor;
+    memcpy(r->visitado, motor->base, sizeof(uint64_t) * r->palabras);
+    if (excluido >= 0)
+        r->visitado[excluido >> 6] |= UINT64_C(1) << (excluido & 63);
+    r->distancia = distancia;
+    if (distancia)
+    {
+        for (v = 0; v < motor->num_vertices; ++v)
+            distancia[v] = -1;
+    }
+    r->nivel = 0;
+    r->en_bits = 0;
+    r->caros = 0;
+    r->solo_arriba = r->pausa_abajo > 0;
+    if (r->pausa_abajo > 0)
+        r->pausa_abajo--;
+    r->tam_cola = 0;
+    r->tam_sig = 0;
+    r->reparto = 0;
+    r->alcanzados = 0;
+    r->aristas_sig = 0;
+    r->revisadas = 0;
+    r->sin_explorar = motor->num_arcos;
+    if (origen < 0 || origen >= motor->num_vertices || (r->visitado[origen >> 6] >> (origen & 63) & 1))
+        return;
+    r->visitado[origen >> 6] |= UINT64_C(1) << (origen & 63);
+    if (distancia)
+        distancia[origen] = 0;
+    r->cola[r->tam_cola++] = origen;
+    r->alcanzados = 1;
+    r->aristas_frontera = motor->inicio[origen + 1] - motor->inicio[origen];
+    r->sin_explorar -= r->aristas_frontera;
+}
+
+static void volcar_cola_bfs(RECORRIDO_BFS *r, const int *buffer, int num)
+{
+    int pos = __atomic_fetch_add(&r->tam_sig, num, __ATOMIC_RELAXED);
+    memcpy(r->cola_sig + pos, buffer, sizeof(int) * num);
+}
+
+static void paso_arriba_abajo(RECORRIDO_BFS *r, int *buffer)
+{
+    const int *inicio = r->motor->inicio, *destino = r->motor->destino, *cola = r->cola;
+    uint64_t *visitado = r->visitado, bit;
+    int *distancia = r->distancia, *salida, i, k, fin, u, v, a, lleno, limite, nivel, compartida;
+    long long grados;
+
+    /* con un solo hilo los descubiertos van directos a la cola siguiente */
+    compartida = r->hilos > 1;
+    salida = compartida ? buffer : r->cola_sig;
+    limite = compartida ? TAM_BUFFER_BFS : r->motor->num_vertices + 1;
+    nivel = r->nivel + 1;
+    lleno = 0;
+    grados = 0;
+    while ((i = __atomic_fetch_add(&r->reparto, BLOQUE_BFS, __ATOMIC_RELAXED)) < r->tam_cola)
+    {
+        fin = i + BLOQUE_BFS < r->tam_cola ? i + BLOQUE_BFS : r->tam_cola;
+        for (k = i; k < fin; ++k)
+        {
+            u = cola[k];
+            for (a = inicio[u]; a < inicio[u + 1]; ++a)
+            {
+                v = destino[a];
+                bit = UINT64_C(1) << (v & 63);
+                if (__atomic_load_n(&visitado[v >> 6], __ATOMIC_RELAXED) & bit)
+                    continue;
+                if (!compartida)
+                    visitado[v >> 6] |= bit;
+                else if (__atomic_fetch_or(&visitado[v >> 6], bit, __ATOMIC_RELAXED) & bit)
+                    continue;
+                if (distancia)
+                    distancia[v] = nivel;
+                grados += inicio[v + 1] - inicio[v];
+                salida[lleno++] = v;
+                if (lleno == limite)
+                {
+                    volcar_cola_bfs(r, buffer, lleno);
+                    lleno = 0;
+                }
+            }
+        }
+    }
+    if (!compartida)
+        r->tam_sig = lleno;
+    else if (lleno)
+        volcar_cola_bfs(r, buffer, lleno);
+    __atomic_fetch_add(&r->aristas_sig, grados, __ATOMIC_RELAXED);
+}
+
+static void paso_abajo_arriba(RECORRIDO_BFS *r)
+{
+    const MOTOR_BFS *mo = r->motor;
+    int i, w, fin, b, v, u, a, nuevos;
+    uint64_t pendientes, nuevo;
+    long long grados, revisadas;
+
+    nuevos = 0;
+    grados = 0;
+    revisadas = 0;
+    while ((i = __atomic_fetch_add(&r->reparto, PALABRAS_BLOQUE_BFS, __ATOMIC_RELAXED)) < r->palabras)
+    {
+        fin = i + PALABRAS_BLOQUE_BFS < r->palabras ? i + PALABRAS_BLOQUE_BFS : r->palabras;
+        for (w = i; w < fin; ++w)
+        {
+            nuevo = 0;
+            for (pendientes = ~r->visitado[w]; pendientes; pendientes &= pendientes - 1)
+            {
+                b = __builtin_ctzll(pendientes);
+                v = (w << 6) | b;
+                for (a = mo->inicio_inv[v]; a < mo->inicio_inv[v + 1]; ++a)
+                {
+                    u = mo->origen_inv[a];
+                    if (!(r->frontera[u >> 6] >> (u & 63) & 1))
+                        continue;
+                    nuevo |= UINT64_C(1) << b;
+                    if (r->distancia)
+                        r->distancia[v] = r->nivel + 1;
+                    grados += mo->inicio[v + 1] - mo->inicio[v];
+                    break;
+                }
+                revisadas += a - mo->inicio_inv[v];
+            }
+            /* la palabra w solo la toca este hilo */
+            r->visitado[w] |= nuevo;
+            r->siguiente[w] = nuevo;
+            nuevos += __builtin_popcountll(nuevo);
+        }
+    }
+    __atomic_fetch_add(&r->tam_sig, nuevos, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&r->aristas_sig, grados, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&r->revisadas, revisadas, __ATOMIC_RELAXED);
+}
+
+/* Entre dos niveles: cuenta los nuevos y elige el sentido del siguiente paso */
+static void cerrar_nivel_bfs(RECORRIDO_BFS *r)
+{
+    int *cola, w, k;
+    uint64_t *mapa, bits;
+
+    r->alcanzados += r->tam_sig;
+    r->sin_explorar -= r->aristas_sig;
+    if (r->en_bits)
+    {
+        r->caros = r->revisadas > FACTOR_CARO_BFS * r->aristas_frontera ? r->caros + 1 : 0;
+        if (r->caros >= 2)
+        {
+            r->solo_arriba = 1;
+            r->pausa_abajo = PAUSA_ABAJO_BFS;
+        }
+    }
+    if (!r->en_bits)
+    {
+        if (!r->solo_arriba && r->aristas_sig > r->sin_explorar / ALFA_BFS)
+        {
+            memset(r->frontera, 0, sizeof(uint64_t) * r->palabras);
+            for (k = 0; k < r->tam_sig; ++k)
+                r->frontera[r->cola_sig[k] >> 6] |= UINT64_C(1) << (r->cola_sig[k] & 63);
+            r->en_bits = 1;
+        }
+        else
+        {
+            cola = r->cola;
+            r->cola = r->cola_sig;
+            r->cola_sig = cola;
+        }
+    }
+    else if (r->solo_arriba || (r->tam_sig < r->tam_cola && r->tam_sig < (r->palabras << 6) / BETA_BFS))
+    {
+        k = 0;
+        for (w = 0; w < r->palabras; ++w)
+            for (bits = r->siguiente[w]; bits; bits &= bits - 1)
+                r->cola[k++] = (w << 6) | __builtin_ctzll(bits);
+        r->en_bits = 0;
+    }
+    else
+    {
+        mapa = r->frontera;
+        r->frontera = r->siguiente;
+        r->siguiente = mapa;
+    }
+    r->tam_cola = r->tam_sig;
+    r->tam_sig = 0;
+    r->aristas_frontera = r->aristas_sig;
+    r->aristas_sig = 0;
+    r->revisadas = 0;
+    r->reparto = 0;
+    r->nivel++;
+}
+
+static void *trabajar_bfs(void *arg)
+{
+    RECORRIDO_BFS *r = arg;
+    int buffer[TAM_BUFFER_BFS];
+
+    while (r->tam_cola > 0)
+    {
+        if (r->en_bits)
+            paso_abajo_arriba(r);
+        else
+            paso_arriba_abajo(r, buffer);
+        if (r->hilos == 1)
+            cerrar_nivel_bfs(r);
+        else
+        {
+            if (pthread_barrier_wait(&r->barrera) == PTHREAD_BARRIER_SERIAL_THREAD)
+                cerrar_nivel_bfs(r);
+            pthread_barrier_wait(&r->barrera);
+        }
+    }
+    return NULL;
+}
+
+/* Los hilos lanzados esperan a que se sepa cuántos arrancaron para fijar la barrera */
+static void *hilo_bfs(void *arg)
+{
+    RECORRIDO_BFS *r = arg;
+
+    pthread_mutex_lock(&r->arranque);
+    pthread_mutex_unlock(&r->arranque);
+    return trabajar_bfs(r);
+}
+
+int recorrer_bfs(GRAFO *grafo, MOTOR_BFS *motor, int origen, int excluido, int *distancia)
+{
+    RECORRIDO_BFS *r;
+    pthread_t hilo[MAX_HILOS_BFS];
+    int h, lanzados;
+
+    if (!grafo || !motor || preparar_motor_bfs(grafo, motor) != 0)
+        return -1;
+    r = &motor->recorrido;
+    empezar_bfs(r, motor, origen, excluido, distancia);
+    r->hilos = motor->num_arcos >= MIN_ARISTAS_PARALELO_BFS ? motor->hilos : 1;
+    if (r->hilos == 1)
+        trabajar_bfs(r);
+    else
+    {
+        pthread_mutex_init(&r->arranque, NULL);
+        pthread_mutex_lock(&r->arranque);
+        lanzados = 0;
+        for (h = 1; h < r->hilos; ++h)
+            if (pthread_create(&hilo[lanzados], NULL, hilo_bfs, r) == 0)
+                lanzados++;
+        /* si un hilo no arranca, la barrera se fija con los que sí */
+        r->hilos = lanzados + 1;
+        pthread_barrier_init(&r->barrera, NULL, r->hilos);
+        pthread_mutex_unlock(&r->arranque);
+        trabajar_bfs(r);
+        for (h = 0; h < lanzados; ++h)
+            pthread_join(hilo[h], NULL);
+        pthread_barrier_destroy(&r->barrera);
+        pthread_mutex_destroy(&r->arranque);
+    }
+    INSTR_SUMAR(visitas_bfs, r->alcanzados);
+    return r->alcanzados;
+}
+
+typedef struct TRABAJO_BARRIDO_BFS
+{
+    const MOTOR_BFS *motor;
+    const int *candidatos; /* alcanzables desde el inicio, sin él */
+    int num_candidatos;
+    int *siguiente;        /* contador común de candidatos */
+    int *error;
+    int inicio;
+    int alcanzables;
+    int *impacto;
+} TRABAJO_BARRIDO_BFS;
+
+static void *resolver_barrido_bfs(void *arg)
+{
+    TRABAJO_BARRIDO_BFS *t = arg;
+    RECORRIDO_BFS r;
+    int i, fin, v;
+
+    if (reservar_recorrido_bfs(&r, t->motor->num_vertices, t->motor->palabras) != 0)
+    {
+        __atomic_store_n(t->error, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    r.hilos = 1;
+    while (!__atomic_load_n(t->error, __ATOMIC_RELAXED))
+    {
+        i = __atomic_fetch_add(t->siguiente, FALLOS_BLOQUE_BFS, __ATOMIC_RELAXED);
+        if (i >= t->num_candidatos)
+            break;
+        fin = i + FALLOS_BLOQUE_BFS < t->num_candidatos ? i + FALLOS_BLOQUE_BFS : t->num_candidatos;
+        for (; i < fin; ++i)
+        {
+            v = t->candidatos[i];
+            /* sin salidas solo se pierde él mismo */
+            if (t->motor->inicio[v + 1] == t->motor->inicio[v])
+            {
+                t->impacto[v] = 1;
+                continue;
+            }
+            empezar_bfs(&r, t->motor, t->inicio, v, NULL);
+            trabajar_bfs(&r);
+            INSTR_SUMAR(visitas_bfs, r.alcanzados);
+            t->impacto[v] = t->alcanzables - r.alcanzados;
+        }
+    }
+    liberar_recorrido_bfs(&r);
+    return NULL;
+}
+
+int barrido_fallos_bfs(GRAFO *grafo, MOTOR_BFS *motor, int inicio, int *impacto)
+{
+    TRABAJO_BARRIDO_BFS tr[MAX_HILOS_BFS];
+    pthread_t hilo[MAX_HILOS_BFS];
+    unsigned char lanzado[MAX_HILOS_BFS];
+    int *distancia, *candidatos, n, v, h, hilos, num, alcanzables, siguiente, error;
+
+    n = grafo->num_vertices;
+    distancia = malloc(sizeof(int) * (n + 1));
+    candidatos = malloc(sizeof(int) * (n + 1));
+    if (!distancia || !candidatos || (alcanzables = recorrer_bfs(grafo, motor, inicio, -1, distancia)) < 0)
+    {
+        free(distancia);
+        free(candidatos);
+        return -1;
+    }
+    /* un vértice que no se alcanza no quita nada al fallar */
+    num = 0;
+    for (v = 0; v < n; ++v)
+    {
+        impacto[v] = 0;
+        if (distancia[v] > 0)
+            candidatos[num++] = v;
+    }
+    if (inicio >= 0 && inicio < n)
+    {
+        /* si falla el propio inicio se cuenta desde otro vértice */
+        v = recorrer_bfs(grafo, motor, (inicio == 0 && n > 1) ? 1 : 0, inicio, NULL);
+        impacto[inicio] = alcanzables - (v > 0 ? v : 0);
+    }
+    free(distancia);
+
+    hilos = motor->hilos;
+    if (hilos > (num + FALLOS_BLOQUE_BFS - 1) / FALLOS_BLOQUE_BFS)
+        hilos = num > 0 ? (num + FALLOS_BLOQUE_BFS - 1) / FALLOS_BLOQUE_BFS : 1;
+    siguiente = 0;
+    error = 0;
+    for (h = 0; h < hilos; ++h)
+    {
+        tr[h].motor = motor;
+        tr[h].candidatos = candidatos;
+        tr[h].num_candidatos = num;
+        tr[h].siguiente = &siguiente;
+        tr[h].error = &error;
+        tr[h].inicio = inicio;
+        tr[h].alcanzables = alcanzables;
+        tr[h].impacto = impacto;
+        lanzado[h] = 0;
+    }
+    for (h = 1; h < hilos; ++h)
+        lanzado[h] = pthread_create(&hilo[h], NULL, resolver_barrido_bfs, &tr[h]) == 0;
+    /* si un hilo no arranca, los demás se quedan sus vértices */
+    resolver_barrido_bfs(&tr[0]);
+    for (h = 1; h < hilos; ++h)
+        if (lanzado[h])
+            pthread_join(hilo[h], NULL);
+    free(candidatos);
+    return error ? -1 : alcanzables;
+}
+
+#endif
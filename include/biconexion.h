@@ -0,0 +1,475 @@
+#ifndef BICONEXION_H
+#define BICONEXION_H
+
+#include "grafos.h"
+
+/*
+ * Planificador de aumento para 2-conexion.
+ * Trabaja sobre el grafo no dirigido subyacente (nodos y enlaces activos, un
+ * solo enlace por par). Con un DFS iterativo de Tarjan obtiene los bloques
+ * (modo vertices) o las componentes 2-arista-conexas (modo aristas), toma las
+ * hojas del arbol bloque-corte y las empareja en orden DFS: hoja i con hoja
+ * i + L/2. En cada hoja se elige el extremo de menor coste estimado que no toque
+ * el punto de corte o el puente. Si tras una ronda aun quedan puntos de corte o
+ * puentes, se repite sobre el grafo aumentado (en la practica una o dos rondas);
+ * al final se analiza el resultado y se anota lo que quede sin resolver (p. ej.
+ * dos nodos sueltos, que sin enlaces paralelos no admiten 2-arista-conexion).
+ */
+typedef enum
+{
+    BICONEXION_VERTICES, /* sin puntos de articulacion */
+    BICONEXION_ARISTAS   /* sin puentes */
+} ModoBiconexion;
+
+typedef struct GRAFO_NO_DIRIGIDO
+{
+    int num_vertices;
+    int *inicio; /* n + 1 */
+    int *vecino;
+} GRAFO_NO_DIRIGIDO;
+
+typedef struct PLAN_AUMENTO
+{
+    int num_enlaces;
+    int (*enlaces)[2];
+    double coste_total;
+    int puntos_corte;       /* del grafo original */
+    int puentes;            /* del grafo original */
+    int componentes;        /* del grafo original */
+    int cortes_restantes;   /* tras aplicar el plan */
+    int puentes_restantes;  /* tras aplicar el plan */
+} PLAN_AUMENTO;
+
+int construir_no_dirigido(GRAFO *grafo, const int (*extra)[2], int num_extra, GRAFO_NO_DIRIGIDO *g);
+void liberar_no_dirigido(GRAFO_NO_DIRIGIDO *g);
+double coste_estimado_extremo(GRAFO *grafo, int v);
+int planificar_aumento(GRAFO *grafo, ModoBiconexion modo, PLAN_AUMENTO *plan);
+void liberar_plan_aumento(PLAN_AUMENTO *plan);
+
+// Implementaciones
+
+static int comparar_enteros(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/* CSR no dirigido, ordenado y sin duplicados; los vertices fallidos quedan aislados */
+int construir_no_dirigido(GRAFO *grafo, const int (*extra)[2], int num_extra, GRAFO_NO_DIRIGIDO *g)
+{
+    int n, u, v, e, i, k, *grado, *pos, escritos;
+
+    memset(g, 0, sizeof(*g));
+    n = grafo->num_vertices;
+    grado = calloc(n + 1, sizeof(int));
+    g->inicio = malloc(sizeof(int) * (n + 1));
+    if (!grado || !g->inicio)
+    {
+        free(grado);
+        free(g->inicio);
+        return -1;
+    }
+    for (u = 0; u < n; ++u)
+    {
+        if (!grafo->vertices[u].activo)
+            continue;
+        for (e = grafo->vertices[u].primera_arista; e != -1; e = grafo->aristas.siguiente[e])
+        {
+            v = grafo->aristas.destino[e];
+            if (v == u || !ARISTA_ACTIVA(grafo, e) || !grafo->vertices[v].activo)
+                continue;
+            grado[u]++;
+            grado[v]++;
+        }
+    }
+    for (i = 0; i < num_extra; ++i)
+    {
+        grado[extra[i][0]]++;
+        grado[extra[i][1]]++;
+    }
+    g->inicio[0] = 0;
+    for (u = 0; u < n; ++u)
+        g->inicio[u + 1] = g->inicio[u] + grado[u];
+    g->vecino = malloc(sizeof(int) * (g->inicio[n] > 0 ? g->inicio[n] : 1));
+    pos = grado;
+    if (!g->vecino)
+    {
+        free(grado);
+        liberar_no_dirigido(g);
+        return -1;
+    }
+    memcpy(pos, g->inicio, sizeof(int) * n);
+    for (u = 0; u < n; ++u)
+    {
+        if (!grafo->vertices[u].activo)
+            continue;
+        for (e = grafo->vertices[u].primera_arista; e != -1; e = grafo->aristas.siguiente[e])
+        {
+            v = grafo->aristas.destino[e];
+            if (v == u || !ARISTA_ACTIVA(grafo, e) || !grafo->vertices[v].activo)
+                continue;
+            g->vecino[pos[u]++] = v;
+            g->vecino[pos[v]++] = u;
+        }
+    }
+    for (i = 0; i < num_extra; ++i)
+    {
+        g->vecino[pos[extra[i][0]]++] = extra[i][1];
+        g->vecino[pos[extra[i][1]]++] = extra[i][0];
+    }
+    /* ordenar y compactar cada fila */
+    escritos = 0;
+    for (u = 0; u < n; ++u)
+    {
+        k = g->inicio[u];
+        qsort(g->vecino + k, g->inicio[u + 1] - k, sizeof(int), comparar_enteros);
+        g->inicio[u] = escritos;
+        for (i = k; i < pos[u]; ++i)
+            if (escritos == g->inicio[u] || g->vecino[i] != g->vecino[escritos - 1])
+                g->vecino[escritos++] = g->vecino[i];
+    }
+    g->inicio[n] = escritos;
+    g->num_vertices = n;
+    free(grado);
+    return 0;
+}
+
+void liberar_no_dirigido(GRAFO_NO_DIRIGIDO *g)
+{
+    if (!g)
+        return;
+    free(g->inicio);
+    free(g->vecino);
+    memset(g, 0, sizeof(*g));
+}
+
+/* Coste relativo de abrir un puerto nuevo en el dispositivo */
+double coste_estimado_extremo(GRAFO *grafo, int v)
+{
+    switch ((Tipo_Dispositivo)grafo->vertices[v].tipo)
+    {
+    case D_ROUTER:
+    case D_SWITCH:
+        return 1.0;
+    case D_SERVIDOR:
+        return 2.0;
+    default:
+        return 3.0;
+    }
+}
+
+/*
+ * Una ronda: DFS de Tarjan y lista de extremos hoja en orden DFS.
+ * Devuelve el numero de extremos (0 = ya es 2-conexo). Rellena estadisticas si no son NULL.
+ */
+static int hojas_arbol_bloques(GRAFO *grafo, const GRAFO_NO_DIRIGIDO *g, ModoBiconexion modo, int *extremos, int *cortes_out, int *puentes_out, int *componentes_out)
+{
+    int n, u, v, raiz, tiempo, tope, tope_v, hijos_raiz, num_ext, componentes, cortes, puentes;
+    int *disc, *low, *padre, *it, *pila, *pila_v, *es_corte, *marca, *miembros;
+    int i, k, tam, num_cortes_bloque, mejor, activos_comp, bloques_comp, inicio_comp;
+    double c, mejor_c;
+
+    n = g->num_vertices;
+    disc = malloc(sizeof(int) * n);
+    low = malloc(sizeof(int) * n);
+    padre = malloc(sizeof(int) * n);
+    it = malloc(sizeof(int) * n);
+    pila = malloc(sizeof(int) * n);
+    pila_v = malloc(sizeof(int) * n);
+    es_corte = calloc(n, sizeof(int));
+    marca = calloc(n, sizeof(int));
+    miembros = malloc(sizeof(int) * (n + 1));
+    if (!disc || !low || !padre || !it || !pila || !pila_v || !es_corte || !marca || !miembros)
+    {
+        num_ext = -1;
+        goto salir;
+    }
+    for (u = 0; u < n; ++u)
+        disc[u] = -1;
+
+    /* primera pasada: puntos de corte y puentes */
+    tiempo = 0;
+    cortes = 0;
+    puentes = 0;
+    componentes = 0;
+    for (raiz = 0; raiz < n; ++raiz)
+    {
+        if (disc[raiz] != -1 || !grafo->vertices[raiz].activo)
+            continue;
+        componentes++;
+        hijos_raiz = 0;
+        tope = 0;
+        pila[tope++] = raiz;
+        disc[raiz] = low[raiz] = tiempo++;
+        padre[raiz] = -1;
+        it[raiz] = g->inicio[raiz];
+        while (tope > 0)
+        {
+            u = pila[tope - 1];
+            if (it[u] < g->inicio[u + 1])
+            {
+                v = g->vecino[it[u]++];
+                if (disc[v] == -1)
+                {
+                    padre[v] = u;
+                    disc[v] = low[v] = tiempo++;
+                    it[v] = g->inicio[v];
+                    pila[tope++] = v;
+                    if (u == raiz)
+                        hijos_raiz++;
+                }
+                else if (v != padre[u] && disc[v] < low[u])
+                    low[u] = disc[v];
+                continue;
+            }
+            --tope;
+            v = u;
+            u = padre[v];
+            if (u == -1)
+                continue;
+            if (low[v] < low[u])
+                low[u] = low[v];
+            if (low[v] > disc[u])
+                puentes++;
+            if (u != raiz && low[v] >= disc[u] && !es_corte[u])
+            {
+                es_corte[u] = 1;
+                cortes++;
+            }
+        }
+        if (hijos_raiz >= 2)
+        {
+            es_corte[raiz] = 1;
+            cortes++;
+        }
+    }
+    if (cortes_out)
+        *cortes_out = cortes;
+    if (puentes_out)
+        *puentes_out = puentes;
+    if (componentes_out)
+        *componentes_out = componentes;
+
+    /* segunda pasada: emitir bloques (o componentes 2-arista) y quedarse con las hojas */
+    for (u = 0; u < n; ++u)
+        disc[u] = -1;
+    tiempo = 0;
+    num_ext = 0;
+    for (raiz = 0; raiz < n; ++raiz)
+    {
+        if (disc[raiz] != -1 || !grafo->vertices[raiz].activo)
+            continue;
+        inicio_comp = num_ext;
+        bloques_comp = 0;
+        activos_comp = 0;
+        tope = 0;
+        tope_v = 0;
+        pila[tope++] = raiz;
+        pila_v[tope_v++] = raiz;
+        disc[raiz] = low[raiz] = tiempo++;
+        padre[raiz] = -1;
+        it[raiz] = g->inicio[raiz];
+        while (tope > 0)
+        {
+            u = pila[tope - 1];
+            if (it[u] < g->inicio[u + 1])
+            {
+                v = g->vecino[it[u]++];
+                if (disc[v] == -1)
+                {
+                    padre[v] = u;
+                    disc[v] = low[v] = tiempo++;
+                    it[v] = g->inicio[v];
+                    pila[tope++] = v;
+                    pila_v[tope_v++] = v;
+                }
+                else if (v != padre[u] && disc[v] < low[u])
+                    low[u] = disc[v];
+                continue;
+            }
+            --tope;
+            activos_comp++;
+            v = u;
+            u = padre[v];
+            if (u != -1 && low[v] < low[u])
+                low[u] = low[v];
+
+            tam = 0;
+            if (modo == BICONEXION_VERTICES && u != -1 && low[v] >= disc[u])
+            {
+                /* bloque = subarbol de v en la pila + u */
+                do
+                {
+                    k = pila_v[--tope_v];
+                    miembros[tam++] = k;
+                } while (k != v);
+                miembros[tam++] = u;
+            }
+            else if (modo == BICONEXION_ARISTAS && low[v] == disc[v])
+            {
+                /* componente 2-arista-conexa con raiz v */
+                do
+                {
+                    k = pila_v[--tope_v];
+                    miembros[tam++] = k;
+                } while (k != v);
+            }
+            if (tam == 0)
+                continue;
+            bloques_comp++;
+
+            /* grado del bloque en el arbol: cortes (modo vertices) o puentes (modo aristas) */
+            num_cortes_bloque = 0;
+            if (modo == BICONEXION_VERTICES)
+            {
+                for (i = 0; i < tam; ++i)
+                    num_cortes_bloque += es_corte[miembros[i]];
+            }
+            else
+            {
+                for (i = 0; i < tam; ++i)
+                    marca[miembros[i]] = raiz + 1;
+                for (i = 0; i < tam; ++i)
+                    for (k = g->inicio[miembros[i]]; k < g->inicio[miembros[i] + 1]; ++k)
+                        if (marca[g->vecino[k]] != raiz + 1)
+                            num_cortes_bloque++;
+            }
+            /*
+             * hoja: extremo de menor coste que no sea el punto de corte ni, en modo
+             * aristas, el extremo del puente (si no, el enlace nuevo podria unir dos
+             * nodos ya vecinos y no eliminar el puente)
+             */
+            mejor = -1;
+            mejor_c = 0.0;
+            for (i = 0; num_cortes_bloque == 1 && i < tam; ++i)
+            {
+                if (modo == BICONEXION_VERTICES && es_corte[miembros[i]])
+                    continue;
+                if (modo == BICONEXION_ARISTAS && tam > 1)
+                {
+                    for (k = g->inicio[miembros[i]]; k < g->inicio[miembros[i] + 1]; ++k)
+                        if (marca[g->vecino[k]] != raiz + 1)
+                            break;
+                    if (k < g->inicio[miembros[i] + 1])
+                        continue;
+                }
+                c = coste_estimado_extremo(grafo, miembros[i]);
+                if (mejor == -1 || c < mejor_c)
+                {
+                    mejor = miembros[i];
+                    mejor_c = c;
+                }
+            }
+            if (modo == BICONEXION_ARISTAS)
+                for (i = 0; i < tam; ++i)
+                    marca[miembros[i]] = 0;
+            if (mejor != -1)
+                extremos[num_ext++] = mejor;
+        }
+        /* la componente entera es un solo bloque: aporta dos extremos para unirla al resto */
+        if (num_ext == inicio_comp && bloques_comp <= 1 && componentes > 1)
+        {
+            extremos[num_ext++] = raiz;
+            extremos[num_ext++] = activos_comp > 1 ? g->vecino[g->inicio[raiz]] : raiz;
+        }
+    }
+
+salir:
+    free(disc);
+    free(low);
+    free(padre);
+    free(it);
+    free(pila);
+    free(pila_v);
+    free(es_corte);
+    free(marca);
+    free(miembros);
+    return num_ext;
+}
+
+int planificar_aumento(GRAFO *grafo, ModoBiconexion modo, PLAN_AUMENTO *plan)
+{
+    GRAFO_NO_DIRIGIDO g;
+    int n, num_ext, ronda, i, a, b, mitad, capacidad, nuevos;
+    int *extremos, (*tmp)[2];
+
+    if (!grafo || !plan)
+        return -1;
+    memset(plan, 0, sizeof(*plan));
+    n = grafo->num_vertices;
+    extremos = malloc(sizeof(int) * (2 * n + 2));
+    if (!extremos)
+        return -1;
+    capacidad = 0;
+
+    for (ronda = 0; ronda < 8; ++ronda)
+    {
+        if (construir_no_dirigido(grafo, (const int(*)[2])plan->enlaces, plan->num_enlaces, &g) != 0)
+        {
+            free(extremos);
+            return -1;
+        }
+        if (ronda == 0)
+            num_ext = hojas_arbol_bloques(grafo, &g, modo, extremos, &plan->puntos_corte, &plan->puentes, &plan->componentes);
+        else
+            num_ext = hojas_arbol_bloques(grafo, &g, modo, extremos, NULL, NULL, NULL);
+        liberar_no_dirigido(&g);
+        if (num_ext < 0)
+        {
+            free(extremos);
+            return -1;
+        }
+        if (num_ext < 2)
+            break;
+
+        /* emparejar hoja i con hoja i + ceil(L/2) en orden DFS */
+        mitad = (num_ext + 1) / 2;
+        nuevos = 0;
+        for (i = 0; i < mitad; ++i)
+        {
+            a = extremos[i];
+            b = extremos[(i + mitad) % num_ext];
+            if (a == b || buscar_arista(grafo, a, b) != -1 || buscar_arista(grafo, b, a) != -1)
+                continue;
+            if (plan->num_enlaces == capacidad)
+            {
+                capacidad = capacidad ? capacidad * 2 : 16;
+                tmp = realloc(plan->enlaces, sizeof(*plan->enlaces) * capacidad);
+                if (!tmp)
+                {
+                    free(extremos);
+                    return -1;
+                }
+                plan->enlaces = tmp;
+            }
+            plan->enlaces[plan->num_enlaces][0] = a;
+            plan->enlaces[plan->num_enlaces][1] = b;
+            plan->num_enlaces++;
+            plan->coste_total += coste_estimado_extremo(grafo, a) + coste_estimado_extremo(grafo, b);
+            nuevos++;
+        }
+        if (nuevos == 0)
+            break;
+    }
+
+    /* comprobar sobre el grafo aumentado lo que el plan deja sin resolver */
+    if (construir_no_dirigido(grafo, (const int(*)[2])plan->enlaces, plan->num_enlaces, &g) != 0)
+    {
+        free(extremos);
+        return -1;
+    }
+    num_ext = hojas_arbol_bloques(grafo, &g, modo, extremos, &plan->cortes_restantes, &plan->puentes_restantes, NULL);
+    liberar_no_dirigido(&g);
+    free(extremos);
+    return num_ext < 0 ? -1 : 0;
+}
+
+void liberar_plan_aumento(PLAN_AUMENTO *plan)
+{
+    if (!plan)
+        return;
+    free(plan->enlaces);
+    memset(plan, 0, sizeof(*plan));
+}
+
+#endif
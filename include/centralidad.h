@@ -0,0 +1,459 @@
+#ifndef CENTRALIDAD_H
+#define CENTRALIDAD_H
+
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "grafos.h"
+#include "dijkstra.h"
+#include "trafico.h"
+#include "generador.h"
+
+#define MAX_HILOS_CENTRALIDAD 8
+#define FUENTES_BLOQUE_CENTRALIDAD 16
+#define CONFIANZA_CENTRALIDAD 0.05 /* probabilidad de que algún valor se salga de la cota */
+/* analizar-resiliencia: por encima de tantos vértices activos usa muestreo */
+#define MAX_FUENTES_EXACTAS_CENTRALIDAD 5000
+#define MUESTRAS_CENTRALIDAD 1000
+
+/*
+ * Intermediación (betweenness) de nodos y aristas con la latencia como coste,
+ * por el algoritmo de Brandes: un Dijkstra por origen s que cuenta los caminos
+ * mínimos sigma[v] (todos los empates, no uno solo) y, recorriendo los
+ * vértices en orden inverso de asentamiento, la dependencia
+ * delta[v] = suma sobre sucesores w de sigma[v] / sigma[w] * (1 + delta[w]).
+ * La contribución de cada término va también a la arista v -> w. Los
+ * predecesores no se guardan: se reconocen en las entrantes de w porque
+ * dist[v] + lat(v, w) == dist[w] (latencias enteras, la suma es exacta).
+ * Con enlaces de latencia 0 el orden de asentamiento no basta (un vértice
+ * puede recibir caminos después de asentarse): los vértices a igual
+ * distancia se reordenan topológicamente sobre los arcos de latencia 0 y
+ * sigma se recuenta en ese orden. Solo se cuentan como predecesores los
+ * vértices anteriores en el orden, así que en un ciclo de latencia 0 se
+ * descarta el arco que lo cerraría.
+ *
+ * Los orígenes se reparten en bloques entre hilos que los toman de un
+ * contador común; cada hilo acumula en sus propios arreglos de nodos y
+ * aristas (sin atómicos en el bucle) y al final se suman.
+ *
+ * Con muestras > 0 solo se recorren k orígenes elegidos al azar sin
+ * reemplazo y el total se escala por N / k. Cada origen aporta a un nodo
+ * entre 0 y N - 2 (a una arista, entre 0 y N - 1), así que por Hoeffding y
+ * la unión sobre todos los valores, con probabilidad 1 - CONFIANZA_CENTRALIDAD
+ * ningún valor normalizado se aleja del exacto más de
+ * sqrt(ln(2 n / CONFIANZA_CENTRALIDAD) / (2 k)), con n = nodos o aristas (en
+ * nodos, multiplicado por N / (N - 1)).
+ */
+typedef struct CENTRALIDAD
+{
+    int num_vertices;
+    int num_aristas;    /* igual a grafo->aristas.num */
+    double *nodo;       /* pares ordenados (s, t), s != v != t, cuyos caminos mínimos pasan por v (fracción si hay empates) */
+    double *arista;     /* igual para cada arista */
+    int activos;        /* N: vértices activos */
+    int fuentes;        /* orígenes recorridos */
+    int muestreada;
+    double error_nodo;  /* cota del error de nodo / ((N - 1)(N - 2)); 0 si es exacta */
+    double error_arista; /* cota del error de arista / (N (N - 1)) */
+} CENTRALIDAD;
+
+/* muestras <= 0 o >= vértices activos: exacta; hilos <= 0 usa los procesadores disponibles */
+int calcular_centralidad(GRAFO *grafo, int muestras, int hilos, uint64_t semilla, CENTRALIDAD *c);
+void liberar_centralidad(CENTRALIDAD *c);
+/* Valores normalizados a [0, 1] (fracción de pares) */
+double centralidad_nodo(const CENTRALIDAD *c, int v);
+double centralidad_arista(const CENTRALIDAD *c, int e);
+/* Los top índices de mayor valor, de mayor a menor; devuelve cuántos (solo valores > 0) */
+int mas_centrales(const double *valor, int num, int *indices, int top);
+
+// Implementaciones
+
+void liberar_centralidad(CENTRALIDAD *c)
+{
+    if (!c)
+        return;
+    free(c->nodo);
+    free(c->arista);
+    memset(c, 0, sizeof(*c));
+}
+
+double centralidad_nodo(const CENTRALIDAD *c, int v)
+{
+    double pares = (double)(c->activos - 1) * (double)(c->activos - 2);
+    return pares > 0.0 ? c->nodo[v] / pares : 0.0;
+}
+
+double centralidad_arista(const CENTRALIDAD *c, int e)
+{
+    double pares = (double)c->activos * (double)(c->activos - 1);
+    return pares > 0.0 ? c->arista[e] / pares : 0.0;
+}
+
+int mas_centrales(const double *valor, int num, int *indices, int top)
+{
+    int i, p, usados;
+
+    usados = 0;
+    for (i = 0; i < num && top > 0; ++i)
+    {
+        if (valor[i] <= 0.0 || (usados == top && valor[i] <= valor[indices[top - 1]]))
+            continue;
+        if (usados < top)
+            usados++;
+        for (p = usados - 1; p > 0 && valor[i] > valor[indices[p - 1]]; --p)
+            indices[p] = indices[p - 1];
+        indices[p] = i;
+    }
+    return usados;
+}
+
+/* Estado compartido del pool */
+typedef struct POOL_CENTRALIDAD
+{
+    const RED_TRAFICO *red;
+    const int *peso;     /* latencia de cada arco de red */
+    const int *peso_inv; /* latencia de cada arco entrante */
+    const int *fuentes;
+    int num_fuentes;
+    int latencia_cero;   /* algún arco con latencia 0 */
+    int siguiente;       /* contador común de fuentes */
+    int error;
+} POOL_CENTRALIDAD;
+
+typedef struct TRABAJO_CENTRALIDAD
+{
+    POOL_CENTRALIDAD *pool;
+    double *nodo;   /* acumuladores propios del hilo */
+    double *arista;
+} TRABAJO_CENTRALIDAD;
+
+/*
+ * Reordena por Kahn cada grupo de vértices de orden[] con la misma distancia
+ * sobre los arcos de latencia 0 entre ellos (los que quedan en un ciclo van
+ * al final en su orden de asentamiento), deja en pos[] la posición de cada
+ * vértice y recuenta sigma en el nuevo orden.
+ */
+static void ordenar_empates_cero(const POOL_CENTRALIDAD *pool, int s, const double *dist, double *sigma, int *orden, int asentados,
+                                 int *pos, int *cola)
+{
+    const RED_TRAFICO *red = pool->red;
+    int a, b, i, k, u, v, w, cab, fin;
+
+    for (a = 0; a < asentados; a = b)
+    {
+        for (b = a + 1; b < asentados && dist[orden[b]] == dist[orden[a]]; ++b)
+            ;
+        if (b - a == 1)
+            continue;
+        /* pos hace de grado de entrada dentro del grupo */
+        for (i = a; i < b; ++i)
+        {
+            w = orden[i];
+            pos[w] = 0;
+            for (k = red->inicio_inv[w]; w != s && k < red->inicio_inv[w + 1]; ++k)
+                if (pool->peso_inv[k] == 0 && red->origen_inv[k] != w && dist[red->origen_inv[k]] == dist[w])
+                    pos[w]++;
+        }
+        fin = 0;
+        for (i = a; i < b; ++i)
+            if (pos[orden[i]] == 0)
+                cola[fin++] = orden[i];
+        for (cab = 0; cab < fin; ++cab)
+        {
+            u = cola[cab];
+            for (k = red->inicio[u]; k < red->inicio[u + 1]; ++k)
+            {
+                v = red->destino[k];
+                if (pool->peso[k] == 0 && v != u && v != s && dist[v] == dist[u] && --pos[v] == 0)
+                    cola[fin++] = v;
+            }
+        }
+        for (i = a; fin < b - a && i < b; ++i)
+            if (pos[orden[i]] > 0)
+                cola[fin++] = orden[i];
+        memcpy(orden + a, cola, sizeof(int) * (b - a));
+    }
+    for (i = 0; i < asentados; ++i)
+        pos[orden[i]] = i;
+
+    for (i = 1; i < asentados; ++i)
+    {
+        w = orden[i];
+        sigma[w] = 0.0;
+        for (k = red->inicio_inv[w]; k < red->inicio_inv[w + 1]; ++k)
+        {
+            v = red->origen_inv[k];
+            if (dist[v] + pool->peso_inv[k] == dist[w] && pos[v] < i)
+                sigma[w] += sigma[v];
+        }
+    }
+}
+
+/* Dependencias del origen s sumadas a los acumuladores; dist, sigma y delta quedan como al entrar */
+static void dependencias_origen(const POOL_CENTRALIDAD *pool, int s, MONTICULO *m, double *dist, double *sigma, double *delta,
+                                int *orden, int *pos, int *cola, double *nodo, double *arista)
+{
+    const RED_TRAFICO *red = pool->red;
+    int u, v, w, k, i, asentados;
+    double d, nd, coef;
+    INSTR_LOCAL(relajadas);
+    INSTR_LOCAL(ops_monticulo);
+
+    m->tam = 0;
+    dist[s] = 0.0;
+    sigma[s] = 1.0;
+    monticulo_insertar(m, 0.0, s);
+    asentados = 0;
+    while (monticulo_extraer(m, &d, &u) == 0)
+    {
+        INSTR_CONTAR(ops_monticulo, 1);
+        if (d > dist[u])
+            continue;
+        orden[asentados++] = u;
+        INSTR_CONTAR(relajadas, red->inicio[u + 1] - red->inicio[u]);
+        for (k = red->inicio[u]; k < red->inicio[u + 1]; ++k)
+        {
+            v = red->destino[k];
+            nd = d + pool->peso[k];
+            if (nd < dist[v])
+            {
+                dist[v] = nd;
+                sigma[v] = sigma[u];
+                monticulo_insertar(m, nd, v);
+                INSTR_CONTAR(ops_monticulo, 1);
+            }
+            else if (nd == dist[v])
+                sigma[v] += sigma[u];
+        }
+    }
+
+    if (pool->latencia_cero)
+        ordenar_empates_cero(pool, s, dist, sigma, orden, asentados, pos, cola);
+
+    for (i = asentados - 1; i >= 0; --i)
+    {
+        w = orden[i];
+        coef = (1.0 + delta[w]) / sigma[w];
+        for (k = red->inicio_inv[w]; k < red->inicio_inv[w + 1]; ++k)
+        {
+            v = red->origen_inv[k];
+            if (dist[v] + pool->peso_inv[k] != dist[w] || (pool->latencia_cero && pos[v] >= i))
+                continue;
+            arista[red->arista_inv[k]] += sigma[v] * coef;
+            delta[v] += sigma[v] * coef;
+        }
+        if (w != s)
+            nodo[w] += delta[w];
+    }
+    for (i = 0; i < asentados; ++i)
+    {
+        u = orden[i];
+        dist[u] = DBL_MAX;
+        sigma[u] = 0.0;
+        delta[u] = 0.0;
+    }
+    INSTR_SUMAR(vertices_asentados, asentados);
+    INSTR_SUMAR(aristas_relajadas, relajadas);
+    INSTR_SUMAR(operaciones_monticulo, ops_monticulo + 1);
+}
+
+static void *resolver_trabajo_centralidad(void *arg)
+{
+    TRABAJO_CENTRALIDAD *t = arg;
+    POOL_CENTRALIDAD *pool = t->pool;
+    int n, i, inicio, fin, *orden, *pos, *cola;
+    double *dist, *sigma, *delta;
+    MONTICULO m;
+
+    n = pool->red->num_vertices;
+    dist = malloc(sizeof(double) * (n + 1));
+    sigma = calloc(n + 1, sizeof(double));
+    delta = calloc(n + 1, sizeof(double));
+    orden = malloc(sizeof(int) * (n + 1));
+    pos = pool->latencia_cero ? malloc(sizeof(int) * (n + 1)) : NULL;
+    cola = pool->latencia_cero ? malloc(sizeof(int) * (n + 1)) : NULL;
+    if (!dist || !sigma || !delta || !orden || (pool->latencia_cero && (!pos || !cola)) ||
+        monticulo_iniciar(&m, pool->red->num_arcos + 1) != 0)
+    {
+        __atomic_store_n(&pool->error, 1, __ATOMIC_RELAXED);
+        free(dist);
+        free(sigma);
+        free(delta);
+        free(orden);
+        free(pos);
+        free(cola);
+        return NULL;
+    }
+    for (i = 0; i < n; ++i)
+        dist[i] = DBL_MAX;
+
+    while (!__atomic_load_n(&pool->error, __ATOMIC_RELAXED))
+    {
+        inicio = __atomic_fetch_add(&pool->siguiente, FUENTES_BLOQUE_CENTRALIDAD, __ATOMIC_RELAXED);
+        if (inicio >= pool->num_fuentes)
+            break;
+        fin = inicio + FUENTES_BLOQUE_CENTRALIDAD < pool->num_fuentes ? inicio + FUENTES_BLOQUE_CENTRALIDAD : pool->num_fuentes;
+        for (i = inicio; i < fin; ++i)
+            dependencias_origen(pool, pool->fuentes[i], &m, dist, sigma, delta, orden, pos, cola, t->nodo, t->arista);
+    }
+
+    monticulo_liberar(&m);
+    free(dist);
+    free(sigma);
+    free(delta);
+    free(orden);
+    free(pos);
+    free(cola);
+    return NULL;
+}
+
+/* Orígenes: todos los activos o k de ellos al azar (Fisher-Yates parcial); devuelve cuántos */
+static int elegir_fuentes_centralidad(GRAFO *grafo, int muestras, uint64_t semilla, int *fuentes, int *activos)
+{
+    GEN_AZAR azar;
+    int v, i, j, tmp, n;
+
+    n = 0;
+    for (v = 0; v < grafo->num_vertices; ++v)
+        if (grafo->vertices[v].activo)
+            fuentes[n++] = v;
+    *activos = n;
+    if (muestras <= 0 || muestras >= n)
+        return n;
+    gen_sembrar(&azar, semilla);
+    for (i = 0; i < muestras; ++i)
+    {
+        j = i + gen_entero(&azar, n - i);
+        tmp = fuentes[i];
+        fuentes[i] = fuentes[j];
+        fuentes[j] = tmp;
+    }
+    return muestras;
+}
+
+int calcular_centralidad(GRAFO *grafo, int muestras, int hilos, uint64_t semilla, CENTRALIDAD *c)
+{
+    RED_TRAFICO red;
+    POOL_CENTRALIDAD pool;
+    TRABAJO_CENTRALIDAD *tr;
+    pthread_t *hilo;
+    unsigned char *lanzado;
+    int *fuentes, *peso, *peso_inv, n, m, h, k, e, v;
+    long procesadores;
+    double escala;
+
+    if (!grafo || !c)
+        return -1;
+    memset(c, 0, sizeof(*c));
+    n = grafo->num_vertices;
+    m = grafo->aristas.num;
+    c->num_vertices = n;
+    c->num_aristas = m;
+    c->nodo = calloc(n + 1, sizeof(double));
+    c->arista = calloc(m + 1, sizeof(double));
+    fuentes = malloc(sizeof(int) * (n + 1));
+    if (!c->nodo || !c->arista || !fuentes || construir_red_trafico(grafo, &red) != 0)
+    {
+        free(fuentes);
+        liberar_centralidad(c);
+        return -1;
+    }
+    peso = malloc(sizeof(int) * (red.num_arcos + 1));
+    peso_inv = malloc(sizeof(int) * (red.num_arcos + 1));
+    if (!peso || !peso_inv)
+    {
+        free(peso);
+        free(peso_inv);
+        free(fuentes);
+        liberar_red_trafico(&red);
+        liberar_centralidad(c);
+        return -1;
+    }
+    for (k = 0; k < red.num_arcos; ++k)
+    {
+        peso[k] = grafo->aristas.latencia_ms[red.arista[k]];
+        peso_inv[k] = grafo->aristas.latencia_ms[red.arista_inv[k]];
+    }
+    memset(&pool, 0, sizeof(pool));
+    for (k = 0; k < red.num_arcos && !pool.latencia_cero; ++k)
+        pool.latencia_cero = peso[k] == 0;
+    pool.red = &red;
+    pool.peso = peso;
+    pool.peso_inv = peso_inv;
+    pool.fuentes = fuentes;
+    pool.num_fuentes = elegir_fuentes_centralidad(grafo, muestras, semilla, fuentes, &c->activos);
+    c->fuentes = pool.num_fuentes;
+    c->muestreada = pool.num_fuentes < c->activos;
+
+    if (hilos <= 0)
+    {
+        procesadores = sysconf(_SC_NPROCESSORS_ONLN);
+        hilos = procesadores > 0 ? (int)procesadores : 1;
+    }
+    if (hilos > MAX_HILOS_CENTRALIDAD)
+        hilos = MAX_HILOS_CENTRALIDAD;
+    if (hilos > (pool.num_fuentes + FUENTES_BLOQUE_CENTRALIDAD - 1) / FUENTES_BLOQUE_CENTRALIDAD)
+        hilos = pool.num_fuentes > 0 ? (pool.num_fuentes + FUENTES_BLOQUE_CENTRALIDAD - 1) / FUENTES_BLOQUE_CENTRALIDAD : 1;
+
+    tr = calloc(hilos, sizeof(TRABAJO_CENTRALIDAD));
+    hilo = malloc(sizeof(pthread_t) * hilos);
+    lanzado = calloc(hilos, 1);
+    if (!tr || !hilo || !lanzado)
+        pool.error = 1;
+    for (h = 0; tr && h < hilos; ++h)
+    {
+        tr[h].pool = &pool;
+        /* el hilo 0 acumula directamente en el resultado */
+        tr[h].nodo = h == 0 ? c->nodo : calloc(n + 1, sizeof(double));
+        tr[h].arista = h == 0 ? c->arista : calloc(m + 1, sizeof(double));
+        if (!tr[h].nodo || !tr[h].arista)
+            pool.error = 1;
+    }
+    if (!pool.error)
+    {
+        for (h = 1; h < hilos; ++h)
+            lanzado[h] = pthread_create(&hilo[h], NULL, resolver_trabajo_centralidad, &tr[h]) == 0;
+        /* si un hilo no arranca, los demás se quedan sus orígenes */
+        resolver_trabajo_centralidad(&tr[0]);
+        for (h = 1; h < hilos; ++h)
+            if (lanzado[h])
+                pthread_join(hilo[h], NULL);
+    }
+    for (h = 1; tr && h < hilos; ++h)
+    {
+        for (v = 0; tr[h].nodo && !pool.error && v < n; ++v)
+            c->nodo[v] += tr[h].nodo[v];
+        for (e = 0; tr[h].arista && !pool.error && e < m; ++e)
+            c->arista[e] += tr[h].arista[e];
+        free(tr[h].nodo);
+        free(tr[h].arista);
+    }
+    free(tr);
+    free(hilo);
+    free(lanzado);
+    free(peso);
+    free(peso_inv);
+    free(fuentes);
+    liberar_red_trafico(&red);
+    if (pool.error)
+    {
+        liberar_centralidad(c);
+        return -1;
+    }
+
+    if (c->muestreada)
+    {
+        escala = (double)c->activos / (double)c->fuentes;
+        for (v = 0; v < n; ++v)
+            c->nodo[v] *= escala;
+        for (e = 0; e < m; ++e)
+            c->arista[e] *= escala;
+        /* cota del valor normalizado; el rango por origen es N - 2 (nodo) y N - 1 (arista) sobre N - 1 y N pares */
+        c->error_nodo = sqrt(log(2.0 * (n > 0 ? n : 1) / CONFIANZA_CENTRALIDAD) / (2.0 * c->fuentes)) * c->activos / (c->activos - 1.0);
+        c->error_arista = sqrt(log(2.0 * (m > 0 ? m : 1) / CONFIANZA_CENTRALIDAD) / (2.0 * c->fuentes));
+    }
+    return 0;
+}
+
+#endif
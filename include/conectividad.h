@@ -0,0 +1,496 @@
+#ifndef CONECTIVIDAD_H
+#define CONECTIVIDAD_H
+
+#include <pthread.h>
+#include <unistd.h>
+#include "grafos.h"
+#include "biconexion.h"
+#include "flujo.h"
+
+#define MAX_HILOS_CORTES 8
+
+/*
+ * Motor de conectividad por enlaces.
+ * Sobre el grafo no dirigido de enlaces activos (capacidad 1 por enlace) se
+ * construye un arbol de cortes de Gomory-Hu con el metodo de Gusfield: n - 1
+ * flujos maximos, sin contraer vertices. El corte minimo entre u y v es el
+ * peso minimo en el camino u-v del arbol, y el corte minimo global es la
+ * arista mas ligera del arbol (no hace falta un Stoer-Wagner aparte).
+ *
+ * Para responder en O(1) el arbol se reordena como arbol de Kruskal (aristas
+ * de mayor a menor peso, cada union crea un nodo interno con ese peso); el
+ * corte u-v es el peso del LCA, que se obtiene con recorrido de Euler y tabla
+ * dispersa de minimos.
+ *
+ * Los flujos de Gusfield se lanzan en paralelo de forma especulativa: cada
+ * hilo resuelve (s, padre[s]) con el padre vigente; al confirmar en orden, si
+ * un flujo anterior cambio el padre de s, ese resultado se descarta y se
+ * recalcula en el siguiente lote. El resultado es identico al secuencial.
+ */
+typedef struct ARBOL_CORTES
+{
+    int num_vertices;
+    int num_activos;
+    int *padre;          /* arbol de Gusfield, -1 = raiz o vertice fallido */
+    int *peso;           /* corte minimo entre v y padre[v] */
+    int corte_global;    /* -1 si hay menos de dos vertices activos */
+    int extremo_global;  /* v tal que (v, padre[v]) es la arista mas ligera */
+    /* arbol de Kruskal: nodos 0..n-1 hojas, n + k nodos internos */
+    int *valor;          /* peso del nodo interno k */
+    long long *pares;    /* pares de vertices cuyo corte es valor[k] */
+    int *hijo;           /* hijo[2k], hijo[2k + 1] */
+    /* LCA en O(1) */
+    int *primera;        /* primera aparicion en el recorrido de Euler, -1 = fuera del arbol */
+    int *profundidad;
+    int *euler;
+    int num_euler;
+    int *log2_tabla;
+    int *tabla;          /* tabla[j * num_euler + i] = nodo menos profundo en [i, i + 2^j) */
+} ARBOL_CORTES;
+
+int construir_arbol_cortes(GRAFO *grafo, ARBOL_CORTES *arbol, int hilos);
+void liberar_arbol_cortes(ARBOL_CORTES *arbol);
+/* Enlaces que hay que cortar para separar u y v; 0 si no estan conectados */
+int conectividad_par(const ARBOL_CORTES *arbol, int u, int v);
+/* Enlaces (no dirigidos) del corte minimo global; devuelve cuantos */
+int enlaces_corte_global(GRAFO *grafo, const ARBOL_CORTES *arbol, int (*enlaces)[2], int max_enlaces);
+
+// Implementaciones
+
+/* Red de flujo no dirigida: cada enlace da dos arcos de capacidad 1, uno pareja del otro */
+static int red_no_dirigida(const GRAFO_NO_DIRIGIDO *g, RED_FLUJO *red)
+{
+    int n, m, u, a, b, v;
+
+    memset(red, 0, sizeof(*red));
+    n = g->num_vertices;
+    m = g->inicio[n];
+    red->num_vertices = n;
+    red->num_arcos = m;
+    red->inicio = malloc(sizeof(int) * (n + 1));
+    red->cabeza = malloc(sizeof(int) * (m + 1));
+    red->pareja = malloc(sizeof(int) * (m + 1));
+    red->arista = malloc(sizeof(int) * (m + 1));
+    red->capacidad = malloc(sizeof(int) * (m + 1));
+    red->residual = malloc(sizeof(int) * (m + 1));
+    red->nivel = malloc(sizeof(int) * (n + 1));
+    red->iter = malloc(sizeof(int) * (n + 1));
+    red->cola = malloc(sizeof(int) * (n + 1));
+    if (!red->inicio || !red->cabeza || !red->pareja || !red->arista || !red->capacidad || !red->residual || !red->nivel || !red->iter || !red->cola)
+    {
+        liberar_red_flujo(red);
+        return -1;
+    }
+    memcpy(red->inicio, g->inicio, sizeof(int) * (n + 1));
+    memcpy(red->cabeza, g->vecino, sizeof(int) * m);
+    for (u = 0; u < n; ++u)
+    {
+        for (a = g->inicio[u]; a < g->inicio[u + 1]; ++a)
+        {
+            v = g->vecino[a];
+            red->capacidad[a] = 1;
+            red->arista[a] = -1;
+            if (v < u)
+                continue;
+            /* filas ordenadas: el arco v -> u se busca por biseccion */
+            b = (int)((const int *)bsearch(&u, g->vecino + g->inicio[v], g->inicio[v + 1] - g->inicio[v], sizeof(int), comparar_enteros) - g->vecino);
+            red->pareja[a] = b;
+            red->pareja[b] = a;
+        }
+    }
+    return 0;
+}
+
+typedef struct TRABAJO_CORTE
+{
+    RED_FLUJO red;
+    int s, t;
+    long long flujo;
+    unsigned char *lado;
+} TRABAJO_CORTE;
+
+static void *resolver_trabajo_corte(void *arg)
+{
+    TRABAJO_CORTE *tr = arg;
+
+    tr->flujo = flujo_maximo(&tr->red, tr->s, tr->t);
+    lado_corte_minimo(&tr->red, tr->s, tr->lado);
+    return NULL;
+}
+
+/* Gusfield con lotes especulativos; devuelve -1 si falta memoria */
+static int gusfield_paralelo(const GRAFO_NO_DIRIGIDO *g, const int *activos, int num_activos, int hilos, int *padre, int *peso)
+{
+    int n, i, j, k, h, lanzados, s, t, confirmados;
+    TRABAJO_CORTE *tr;
+    pthread_t *hilo;
+    unsigned char *lanzado;
+
+    n = g->num_vertices;
+    tr = calloc(hilos, sizeof(TRABAJO_CORTE));
+    hilo = malloc(sizeof(pthread_t) * hilos);
+    lanzado = malloc(hilos);
+    if (!tr || !hilo || !lanzado)
+    {
+        free(tr);
+        free(hilo);
+        free(lanzado);
+        return -1;
+    }
+    for (h = 0; h < hilos; ++h)
+    {
+        tr[h].lado = malloc(n + 1);
+        if (!tr[h].lado || red_no_dirigida(g, &tr[h].red) != 0)
+        {
+            for (k = 0; k <= h; ++k)
+            {
+                liberar_red_flujo(&tr[k].red);
+                free(tr[k].lado);
+            }
+            free(tr);
+            free(hilo);
+            free(lanzado);
+            return -1;
+        }
+    }
+
+    i = 1;
+    while (i < num_activos)
+    {
+        lanzados = num_activos - i < hilos ? num_activos - i : hilos;
+        for (h = 0; h < lanzados; ++h)
+        {
+            tr[h].s = activos[i + h];
+            tr[h].t = padre[activos[i + h]];
+            /* con un solo trabajo no compensa crear un hilo */
+            lanzado[h] = lanzados > 1 && pthread_create(&hilo[h], NULL, resolver_trabajo_corte, &tr[h]) == 0;
+            if (!lanzado[h])
+                resolver_trabajo_corte(&tr[h]);
+        }
+        for (h = 0; h < lanzados; ++h)
+            if (lanzado[h])
+                pthread_join(hilo[h], NULL);
+
+        /* confirmar en orden mientras el padre usado siga vigente */
+        confirmados = 0;
+        for (h = 0; h < lanzados; ++h)
+        {
+            s = tr[h].s;
+            t = tr[h].t;
+            if (padre[s] != t)
+                break;
+            peso[s] = (int)tr[h].flujo;
+            for (j = i + h + 1; j < num_activos; ++j)
+                if (tr[h].lado[activos[j]] && padre[activos[j]] == t)
+                    padre[activos[j]] = s;
+            confirmados++;
+        }
+        i += confirmados;
+    }
+
+    for (h = 0; h < hilos; ++h)
+    {
+        liberar_red_flujo(&tr[h].red);
+        free(tr[h].lado);
+    }
+    free(tr);
+    free(hilo);
+    free(lanzado);
+    return 0;
+}
+
+static const int *peso_orden_kruskal;
+
+static int comparar_peso_descendente(const void *a, const void *b)
+{
+    int x = peso_orden_kruskal[*(const int *)a], y = peso_orden_kruskal[*(const int *)b];
+    return (y > x) - (y < x);
+}
+
+static int raiz_conjunto(int *conjunto, int x)
+{
+    while (conjunto[x] != x)
+    {
+        conjunto[x] = conjunto[conjunto[x]];
+        x = conjunto[x];
+    }
+    return x;
+}
+
+/* Arbol de Kruskal sobre las aristas de Gusfield, recorrido de Euler y tabla dispersa */
+static int preparar_consultas(ARBOL_CORTES *arbol, const int *activos, int num_activos)
+{
+    int n, k, i, j, v, a, b, ra, rb, x, c, raiz, total, niveles, top, *orden, *conjunto, *nodo, *tam, *pila;
+    unsigned char *paso;
+
+    n = arbol->num_vertices;
+    total = n + num_activos - 1;
+    orden = malloc(sizeof(int) * num_activos);
+    conjunto = malloc(sizeof(int) * n);
+    nodo = malloc(sizeof(int) * n);
+    tam = malloc(sizeof(int) * n);
+    pila = malloc(sizeof(int) * total);
+    paso = calloc(total, 1);
+    arbol->valor = malloc(sizeof(int) * num_activos);
+    arbol->pares = malloc(sizeof(long long) * num_activos);
+    arbol->hijo = malloc(sizeof(int) * 2 * num_activos);
+    arbol->primera = malloc(sizeof(int) * total);
+    arbol->profundidad = malloc(sizeof(int) * total);
+    arbol->euler = malloc(sizeof(int) * 4 * num_activos);
+    if (!orden || !conjunto || !nodo || !tam || !pila || !paso || !arbol->valor || !arbol->pares || !arbol->hijo || !arbol->primera || !arbol->profundidad || !arbol->euler)
+    {
+        free(orden);
+        free(conjunto);
+        free(nodo);
+        free(tam);
+        free(pila);
+        free(paso);
+        return -1;
+    }
+
+    /* aristas (v, padre[v]) de mayor a menor peso */
+    for (i = 1; i < num_activos; ++i)
+        orden[i - 1] = activos[i];
+    peso_orden_kruskal = arbol->peso;
+    qsort(orden, num_activos - 1, sizeof(int), comparar_peso_descendente);
+    for (v = 0; v < n; ++v)
+    {
+        conjunto[v] = v;
+        nodo[v] = v;
+        tam[v] = 1;
+    }
+    for (k = 0; k < num_activos - 1; ++k)
+    {
+        a = orden[k];
+        b = arbol->padre[a];
+        ra = raiz_conjunto(conjunto, a);
+        rb = raiz_conjunto(conjunto, b);
+        arbol->valor[k] = arbol->peso[a];
+        arbol->pares[k] = (long long)tam[ra] * tam[rb];
+        arbol->hijo[2 * k] = nodo[ra];
+        arbol->hijo[2 * k + 1] = nodo[rb];
+        conjunto[ra] = rb;
+        tam[rb] += tam[ra];
+        nodo[rb] = n + k;
+    }
+    raiz = nodo[raiz_conjunto(conjunto, activos[0])];
+
+    /* recorrido de Euler iterativo: un nodo interno aparece al entrar y tras cada hijo */
+    for (x = 0; x < total; ++x)
+        arbol->primera[x] = -1;
+    arbol->num_euler = 0;
+    arbol->profundidad[raiz] = 0;
+    pila[0] = raiz;
+    top = 1;
+    while (top > 0)
+    {
+        x = pila[top - 1];
+        if (paso[x] == 0)
+            arbol->primera[x] = arbol->num_euler;
+        arbol->euler[arbol->num_euler++] = x;
+        if (x >= n && paso[x] < 2)
+        {
+            c = arbol->hijo[2 * (x - n) + paso[x]];
+            paso[x]++;
+            arbol->profundidad[c] = arbol->profundidad[x] + 1;
+            pila[top++] = c;
+        }
+        else
+        {
+            top--;
+        }
+    }
+    free(orden);
+    free(conjunto);
+    free(nodo);
+    free(tam);
+    free(pila);
+    free(paso);
+
+    /* tabla dispersa de minimos de profundidad */
+    total = arbol->num_euler;
+    arbol->log2_tabla = malloc(sizeof(int) * (total + 1));
+    if (!arbol->log2_tabla)
+        return -1;
+    arbol->log2_tabla[0] = 0;
+    arbol->log2_tabla[1] = 0;
+    for (i = 2; i <= total; ++i)
+        arbol->log2_tabla[i] = arbol->log2_tabla[i / 2] + 1;
+    niveles = arbol->log2_tabla[total] + 1;
+    arbol->tabla = malloc(sizeof(int) * (size_t)niveles * total);
+    if (!arbol->tabla)
+        return -1;
+    memcpy(arbol->tabla, arbol->euler, sizeof(int) * total);
+    for (j = 1; j < niveles; ++j)
+    {
+        for (i = 0; i + (1 << j) <= total; ++i)
+        {
+            a = arbol->tabla[(size_t)(j - 1) * total + i];
+            b = arbol->tabla[(size_t)(j - 1) * total + i + (1 << (j - 1))];
+            arbol->tabla[(size_t)j * total + i] = arbol->profundidad[a] <= arbol->profundidad[b] ? a : b;
+        }
+    }
+    return 0;
+}
+
+int construir_arbol_cortes(GRAFO *grafo, ARBOL_CORTES *arbol, int hilos)
+{
+    int n, v, num_activos, *activos;
+    long procesadores;
+    GRAFO_NO_DIRIGIDO g;
+
+    if (!grafo || !arbol)
+        return -1;
+    memset(arbol, 0, sizeof(*arbol));
+    n = grafo->num_vertices;
+    arbol->num_vertices = n;
+    arbol->corte_global = -1;
+    arbol->extremo_global = -1;
+    arbol->padre = malloc(sizeof(int) * (n + 1));
+    arbol->peso = malloc(sizeof(int) * (n + 1));
+    activos = malloc(sizeof(int) * (n + 1));
+    if (!arbol->padre || !arbol->peso || !activos)
+    {
+        free(activos);
+        liberar_arbol_cortes(arbol);
+        return -1;
+    }
+    num_activos = 0;
+    for (v = 0; v < n; ++v)
+    {
+        arbol->padre[v] = -1;
+        arbol->peso[v] = 0;
+        if (grafo->vertices[v].activo)
+            activos[num_activos++] = v;
+    }
+    arbol->num_activos = num_activos;
+    if (num_activos < 2)
+    {
+        free(activos);
+        return 0;
+    }
+    for (v = 1; v < num_activos; ++v)
+        arbol->padre[activos[v]] = activos[0];
+
+    if (hilos <= 0)
+    {
+        procesadores = sysconf(_SC_NPROCESSORS_ONLN);
+        hilos = procesadores > 0 ? (int)procesadores : 1;
+    }
+    if (hilos > MAX_HILOS_CORTES)
+        hilos = MAX_HILOS_CORTES;
+    if (hilos > num_activos - 1)
+        hilos = num_activos - 1;
+
+    if (construir_no_dirigido(grafo, NULL, 0, &g) != 0)
+    {
+        free(activos);
+        liberar_arbol_cortes(arbol);
+        return -1;
+    }
+    if (gusfield_paralelo(&g, activos, num_activos, hilos, arbol->padre, arbol->peso) != 0 || preparar_consultas(arbol, activos, num_activos) != 0)
+    {
+        liberar_no_dirigido(&g);
+        free(activos);
+        liberar_arbol_cortes(arbol);
+        return -1;
+    }
+    liberar_no_dirigido(&g);
+
+    for (v = 1; v < num_activos; ++v)
+    {
+        if (arbol->extremo_global == -1 || arbol->peso[activos[v]] < arbol->corte_global)
+        {
+            arbol->corte_global = arbol->peso[activos[v]];
+            arbol->extremo_global = activos[v];
+        }
+    }
+    free(activos);
+    return 0;
+}
+
+void liberar_arbol_cortes(ARBOL_CORTES *arbol)
+{
+    if (!arbol)
+        return;
+    free(arbol->padre);
+    free(arbol->peso);
+    free(arbol->valor);
+    free(arbol->pares);
+    free(arbol->hijo);
+    free(arbol->primera);
+    free(arbol->profundidad);
+    free(arbol->euler);
+    free(arbol->log2_tabla);
+    free(arbol->tabla);
+    memset(arbol, 0, sizeof(*arbol));
+}
+
+int conectividad_par(const ARBOL_CORTES *arbol, int u, int v)
+{
+    int l, r, j, a, b, lca;
+
+    if (!arbol || !arbol->tabla || u < 0 || v < 0 || u >= arbol->num_vertices || v >= arbol->num_vertices || u == v)
+        return 0;
+    l = arbol->primera[u];
+    r = arbol->primera[v];
+    if (l < 0 || r < 0)
+        return 0;
+    if (l > r)
+    {
+        j = l;
+        l = r;
+        r = j;
+    }
+    j = arbol->log2_tabla[r - l + 1];
+    a = arbol->tabla[(size_t)j * arbol->num_euler + l];
+    b = arbol->tabla[(size_t)j * arbol->num_euler + r - (1 << j) + 1];
+    lca = arbol->profundidad[a] <= arbol->profundidad[b] ? a : b;
+    return arbol->valor[lca - arbol->num_vertices];
+}
+
+int enlaces_corte_global(GRAFO *grafo, const ARBOL_CORTES *arbol, int (*enlaces)[2], int max_enlaces)
+{
+    int u, a, v, num;
+    unsigned char *lado;
+    GRAFO_NO_DIRIGIDO g;
+    RED_FLUJO red;
+
+    if (!grafo || !arbol || arbol->extremo_global < 0)
+        return 0;
+    if (construir_no_dirigido(grafo, NULL, 0, &g) != 0)
+        return -1;
+    lado = malloc(g.num_vertices + 1);
+    if (!lado || red_no_dirigida(&g, &red) != 0)
+    {
+        free(lado);
+        liberar_no_dirigido(&g);
+        return -1;
+    }
+    flujo_maximo(&red, arbol->extremo_global, arbol->padre[arbol->extremo_global]);
+    lado_corte_minimo(&red, arbol->extremo_global, lado);
+    num = 0;
+    for (u = 0; u < g.num_vertices; ++u)
+    {
+        if (!lado[u])
+            continue;
+        for (a = g.inicio[u]; a < g.inicio[u + 1]; ++a)
+        {
+            v = g.vecino[a];
+            if (lado[v])
+                continue;
+            if (num < max_enlaces)
+            {
+                enlaces[num][0] = u;
+                enlaces[num][1] = v;
+            }
+            num++;
+        }
+    }
+    free(lado);
+    liberar_red_flujo(&red);
+    liberar_no_dirigido(&g);
+    return num;
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include "grafos.h"
 #include <float.h>
 #include <limits.h>
+#include <math.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -18,24 +19,352 @@ typedef enum
 } Metrica;
 
 /* Funcion que evalua costo de arista */
-typedef double (*FuncionCostoArista)(const ARISTA *arista);
+typedef double (*FuncionCostoArista)(const GRAFO *grafo, int arista);
 /* Dijkstra básico*/
 int dijkstra_camino_minimo(GRAFO *, int, int, FuncionCostoArista, int *, double *);
 /* Reconstruye un camino desde anterior[]: devuelve longitud y rellena camino[] */
 int reconstruir_camino(const int *, int, int *, int);
+/* Primer salto desde el origen hacia cada vertice del arbol anterior[] (-1 si inalcanzable); pila: n enteros de trabajo */
+void primeros_saltos(const int *anterior, const double *distancia, int n, int origen, int *primero, int *pila);
 /* Calcula metricas agregadas sobre una ruta dada */
 int calcular_metricas_ruta(GRAFO *, const int *, int, double *, int *, double *);
+/* Una sonda de ping por la ruta: 1 si llega (latencia acumulada en *latencia), 0 si se pierde; usa rand() */
+int sondear_camino(const GRAFO *grafo, const int *camino, int longitud_camino, double *latencia);
 /* Encuentra hasta K rutas distintas (aprox) */
 int encontrar_k_rutas_aproximadas(GRAFO *, int, int, FuncionCostoArista, int, int[][256], int[], int);
 
 int caminos_iguales(const int *a, int alen, const int *b, int blen);
 
+/* Funciones de coste para las metricas no aditivas */
+double costo_por_ancho_banda(const GRAFO *grafo, int arista);
+double costo_por_fiabilidad(const GRAFO *grafo, int arista);
+
+/* Monticulo binario (clave, vertice) con borrado perezoso */
+typedef struct MONTICULO
+{
+    int tam;
+    int capacidad;
+    double *clave;
+    int *vertice;
+} MONTICULO;
+
+int monticulo_iniciar(MONTICULO *m, int capacidad);
+void monticulo_liberar(MONTICULO *m);
+int monticulo_insertar(MONTICULO *m, double clave, int vertice);
+int monticulo_extraer(MONTICULO *m, double *clave, int *vertice);
+
+/*
+ * Kernels especializados por metrica.
+ * Cada metrica genera (via macro) una vista CSR con los pesos ya extraidos en
+ * un arreglo contiguo de su tipo natural y un Dijkstra sin llamadas indirectas.
+ * Las aristas caidas, las que salen de vertices fallidos y las que la metrica
+ * descarta se filtran al construir la vista, de modo que el bucle de relajacion
+ * no tiene ramas extra. La vista es una foto: hay que reconstruirla tras
+ * cambiar estados o agregar aristas. Sobre la vista inversa, anterior[] da el
+ * siguiente salto hacia el destino.
+ */
+#define DEFINIR_KERNEL_METRICA(SUFIJO, TIPO, EXTRAER)                                                      \
+    typedef struct VISTA_##SUFIJO                                                                          \
+    {                                                                                                      \
+        int num_vertices;                                                                                  \
+        int num_aristas;                                                                                   \
+        int *inicio;  /* n + 1 desplazamientos */                                                          \
+        int *destino; /* destino de cada arista */                                                         \
+        TIPO *peso;   /* coste de cada arista */                                                           \
+    } VISTA_##SUFIJO;                                                                                      \
+                                                                                                           \
+    void liberar_vista_##SUFIJO(VISTA_##SUFIJO *vista)                                                     \
+    {                                                                                                      \
+        if (!vista)                                                                                        \
+            return;                                                                                        \
+        free(vista->inicio);                                                                               \
+        free(vista->destino);                                                                              \
+        free(vista->peso);                                                                                 \
+        memset(vista, 0, sizeof(*vista));                                                                  \
+    }                                                                                                      \
+                                                                                                           \
+    int construir_vista_##SUFIJO(GRAFO *grafo, VISTA_##SUFIJO *vista)                                      \
+    {                                                                                                      \
+        int n, m, u, k, e;                                                                                 \
+        TIPO w;                                                                                            \
+        const ARISTAS *a;                                                                                  \
+                                                                                                           \
+        if (!grafo || !vista)                                                                              \
+            return -1;                                                                                     \
+        memset(vista, 0, sizeof(*vista));                                                                  \
+        n = grafo->num_vertices;                                                                           \
+        a = &grafo->aristas;                                                                               \
+        m = a->num;                                                                                        \
+        vista->inicio = malloc(sizeof(int) * (n + 1));                                                     \
+        vista->destino = malloc(sizeof(int) * (m > 0 ? m : 1));                                            \
+        vista->peso = malloc(sizeof(TIPO) * (m > 0 ? m : 1));                                              \
+        if (!vista->inicio || !vista->destino || !vista->peso)                                             \
+        {                                                                                                  \
+            liberar_vista_##SUFIJO(vista);                                                                 \
+            return -1;                                                                                     \
+        }                                                                                                  \
+        k = 0;                                                                                             \
+        for (u = 0; u < n; ++u)                                                                            \
+        {                                                                                                  \
+            vista->inicio[u] = k;                                                                          \
+            if (grafo->vertices[u].activo == 0)                                                            \
+                continue;                                                                                  \
+            for (e = grafo->vertices[u].primera_arista; e != -1; e = a->siguiente[e])                      \
+            {                                                                                              \
+                if (!ARISTA_ACTIVA(grafo, e) || !EXTRAER(a, e, w))                                         \
+                    continue;                                                                              \
+                vista->destino[k] = a->destino[e];                                                         \
+                vista->peso[k] = w;                                                                        \
+                ++k;                                                                                       \
+            }                                                                                              \
+        }                                                                                                  \
+        vista->inicio[n] = k;                                                                              \
+        vista->num_vertices = n;                                                                           \
+        vista->num_aristas = k;                                                                            \
+        return 0;                                                                                          \
+    }                                                                                                      \
+                                                                                                           \
+    /* Vista inversa (aristas entrantes): con ella el mismo kernel da distancias HACIA un destino */       \
+    int construir_vista_inversa_##SUFIJO(GRAFO *grafo, VISTA_##SUFIJO *vista)                              \
+    {                                                                                                      \
+        int n, m, v, k, e;                                                                                 \
+        TIPO w;                                                                                            \
+        const ARISTAS *a;                                                                                  \
+                                                                                                           \
+        if (!grafo || !vista)                                                                              \
+            return -1;                                                                                     \
+        memset(vista, 0, sizeof(*vista));                                                                  \
+        n = grafo->num_vertices;                                                                           \
+        a = &grafo->aristas;                                                                               \
+        m = a->num;                                                                                        \
+        vista->inicio = malloc(sizeof(int) * (n + 1));                                                     \
+        vista->destino = malloc(sizeof(int) * (m > 0 ? m : 1));                                            \
+        vista->peso = malloc(sizeof(TIPO) * (m > 0 ? m : 1));                                              \
+        if (!vista->inicio || !vista->destino || !vista->peso)                                             \
+        {                                                                                                  \
+            liberar_vista_##SUFIJO(vista);                                                                 \
+            return -1;                                                                                     \
+        }                                                                                                  \
+        k = 0;                                                                                             \
+        for (v = 0; v < n; ++v)                                                                            \
+        {                                                                                                  \
+            vista->inicio[v] = k;                                                                          \
+            for (e = grafo->vertices[v].primera_entrante; e != -1; e = a->siguiente_entrante[e])           \
+            {                                                                                              \
+                if (!ARISTA_ACTIVA(grafo, e) || grafo->vertices[a->origen[e]].activo == 0 ||               \
+                    !EXTRAER(a, e, w))                                                                     \
+                    continue;                                                                              \
+                vista->destino[k] = a->origen[e];                                                          \
+                vista->peso[k] = w;                                                                        \
+                ++k;                                                                                       \
+            }                                                                                              \
+        }                                                                                                  \
+        vista->inicio[n] = k;                                                                              \
+        vista->num_vertices = n;                                                                           \
+        vista->num_aristas = k;                                                                            \
+        return 0;                                                                                          \
+    }                                                                                                      \
+                                                                                                           \
+    /* indice_destino = -1 calcula el arbol completo; m puede ser NULL */                                  \
+    int dijkstra_##SUFIJO(const VISTA_##SUFIJO *vista, int indice_origen, int indice_destino,              \
+                          MONTICULO *m, int *anterior, double *distancia)                                  \
+    {                                                                                                      \
+        int n, i, u, v, fin;                                                                               \
+        double d, nd;                                                                                      \
+        MONTICULO local, *h;                                                                               \
+        const int *inicio, *destino;                                                                       \
+        const TIPO *peso;                                                                                  \
+        INSTR_LOCAL(asentados);                                                                            \
+        INSTR_LOCAL(relajadas);                                                                            \
+        INSTR_LOCAL(ops_monticulo);                                                                        \
+                                                                                                           \
+        if (!vista || !anterior || !distancia)                                                             \
+            return -1;                                                                                     \
+        n = vista->num_vertices;                                                                           \
+        if (indice_origen < 0 || indice_origen >= n || indice_destino >= n)                                \
+            return -1;                                                                                     \
+        h = m;                                                                                             \
+        if (!h)                                                                                            \
+        {                                                                                                  \
+            if (monticulo_iniciar(&local, vista->num_aristas + 1) != 0)                                    \
+                return -1;                                                                                 \
+            h = &local;                                                                                    \
+        }                                                                                                  \
+        h->tam = 0;                                                                                        \
+        for (i = 0; i < n; ++i)                                                                            \
+        {                                                                                                  \
+            distancia[i] = DBL_MAX;                                                                        \
+            anterior[i] = -1;                                                                              \
+        }                                                                                                  \
+        inicio = vista->inicio;                                                                            \
+        destino = vista->destino;                                                                          \
+        peso = vista->peso;                                                                                \
+        distancia[indice_origen] = 0.0;                                                                    \
+        monticulo_insertar(h, 0.0, indice_origen);                                                         \
+        while (monticulo_extraer(h, &d, &u) == 0)                                                          \
+        {                                                                                                  \
+            INSTR_CONTAR(ops_monticulo, 1);                                                                \
+            if (d > distancia[u])                                                                          \
+                continue;                                                                                  \
+            if (u == indice_destino)                                                                       \
+                break;                                                                                     \
+            fin = inicio[u + 1];                                                                           \
+            INSTR_CONTAR(asentados, 1);                                                                    \
+            INSTR_CONTAR(relajadas, fin - inicio[u]);                                                      \
+            for (i = inicio[u]; i < fin; ++i)                                                              \
+            {                                                                                              \
+                v = destino[i];                                                                            \
+                nd = d + (double)peso[i];                                                                  \
+                if (nd < distancia[v])                                                                     \
+                {                                                                                          \
+                    distancia[v] = nd;                                                                     \
+                    anterior[v] = u;                                                                       \
+                    monticulo_insertar(h, nd, v);                                                          \
+                    INSTR_CONTAR(ops_monticulo, 1);                                                        \
+                }                                                                                          \
+            }                                                                                              \
+        }                                                                                                  \
+        if (!m)                                                                                            \
+            monticulo_liberar(h);                                                                          \
+        INSTR_SUMAR(vertices_asentados, asentados);                                                        \
+        INSTR_SUMAR(aristas_relajadas, relajadas);                                                         \
+        INSTR_SUMAR(operaciones_monticulo, ops_monticulo + 1);                                             \
+        return 0;                                                                                          \
+    }
+
+/* Extractores: devuelven 0 si la metrica descarta la arista */
+#define EXTRAER_LATENCIA(a, e, w) (((w) = (a)->latencia_ms[e]), 1)
+#define EXTRAER_ANCHO_BANDA(a, e, w) ((a)->ancho_banda_mbps[e] > 0 ? (((w) = 1000.0f / (float)(a)->ancho_banda_mbps[e]), 1) : 0)
+#define EXTRAER_FIABILIDAD(a, e, w) ((a)->fiabilidad[e] > 0.0f ? (((w) = -log((double)(a)->fiabilidad[e])), 1) : 0)
+
+/* Coste por ancho de banda: ms para serializar 1 Mbit (se descarta bw = 0) */
+double costo_por_ancho_banda(const GRAFO *grafo, int e)
+{
+    if (grafo->aristas.ancho_banda_mbps[e] <= 0)
+        return -1.0;
+    return 1000.0 / (double)grafo->aristas.ancho_banda_mbps[e];
+}
+
+/* Coste por fiabilidad: -log(p) convierte el producto en suma */
+double costo_por_fiabilidad(const GRAFO *grafo, int e)
+{
+    if (grafo->aristas.fiabilidad[e] <= 0.0f)
+        return -1.0;
+    return -log((double)grafo->aristas.fiabilidad[e]);
+}
+
+/* Monticulo */
+int monticulo_iniciar(MONTICULO *m, int capacidad)
+{
+    if (!m)
+        return -1;
+    if (capacidad < 16)
+        capacidad = 16;
+    m->tam = 0;
+    m->capacidad = capacidad;
+    m->clave = malloc(sizeof(double) * capacidad);
+    m->vertice = malloc(sizeof(int) * capacidad);
+    if (!m->clave || !m->vertice)
+    {
+        monticulo_liberar(m);
+        return -1;
+    }
+    return 0;
+}
+
+void monticulo_liberar(MONTICULO *m)
+{
+    if (!m)
+        return;
+    free(m->clave);
+    free(m->vertice);
+    m->clave = NULL;
+    m->vertice = NULL;
+    m->tam = 0;
+    m->capacidad = 0;
+}
+
+int monticulo_insertar(MONTICULO *m, double clave, int vertice)
+{
+    int i, p, nueva;
+    double *tc;
+    int *tv;
+
+    if (m->tam == m->capacidad)
+    {
+        nueva = m->capacidad * 2;
+        tc = realloc(m->clave, sizeof(double) * nueva);
+        if (!tc)
+            return -1;
+        m->clave = tc;
+        tv = realloc(m->vertice, sizeof(int) * nueva);
+        if (!tv)
+            return -1;
+        m->vertice = tv;
+        m->capacidad = nueva;
+    }
+    i = m->tam++;
+    while (i > 0)
+    {
+        p = (i - 1) / 2;
+        if (m->clave[p] <= clave)
+            break;
+        m->clave[i] = m->clave[p];
+        m->vertice[i] = m->vertice[p];
+        i = p;
+    }
+    m->clave[i] = clave;
+    m->vertice[i] = vertice;
+    return 0;
+}
+
+int monticulo_extraer(MONTICULO *m, double *clave, int *vertice)
+{
+    int i, h, n;
+    double k;
+    int v;
+
+    if (m->tam == 0)
+        return -1;
+    *clave = m->clave[0];
+    *vertice = m->vertice[0];
+    n = --m->tam;
+    if (n == 0)
+        return 0;
+    k = m->clave[n];
+    v = m->vertice[n];
+    i = 0;
+    for (;;)
+    {
+        h = 2 * i + 1;
+        if (h >= n)
+            break;
+        if (h + 1 < n && m->clave[h + 1] < m->clave[h])
+            ++h;
+        if (k <= m->clave[h])
+            break;
+        m->clave[i] = m->clave[h];
+        m->vertice[i] = m->vertice[h];
+        i = h;
+    }
+    m->clave[i] = k;
+    m->vertice[i] = v;
+    return 0;
+}
+
+/* Kernels: latencia (int), ancho de banda y fiabilidad (float/double) */
+DEFINIR_KERNEL_METRICA(latencia, int, EXTRAER_LATENCIA)
+DEFINIR_KERNEL_METRICA(ancho_banda, float, EXTRAER_ANCHO_BANDA)
+DEFINIR_KERNEL_METRICA(fiabilidad, double, EXTRAER_FIABILIDAD)
+
 /* Dijkstra*/
 int dijkstra_camino_minimo(GRAFO *grafo, int indice_origen, int indice_destino, FuncionCostoArista funcion_coste, int *anterior, double *distancia)
 {
-    int n, i, u;
+    int n, i, u, e, v;
     double mejor, c;
-    ARISTA *ar;
+    const ARISTAS *a;
+    INSTR_LOCAL(asentados);
+    INSTR_LOCAL(relajadas);
 
     if (!grafo || !funcion_coste || !anterior || !distancia)
         return -1;
@@ -82,27 +411,33 @@ int dijkstra_camino_minimo(GRAFO *grafo, int indice_origen, int indice_destino,
         visitado[u] = true;
         if (grafo->vertices[u].activo == 0)
             continue;
+        INSTR_CONTAR(asentados, 1);
 
-        ar = grafo->vertices[u].lista_adyacencia;
-        while (ar)
+        a = &grafo->aristas;
+        e = grafo->vertices[u].primera_arista;
+        while (e != -1)
         {
-            if (ar->activo)
+            if (ARISTA_ACTIVA(grafo, e))
             {
-                c = funcion_coste(ar);
+                INSTR_CONTAR(relajadas, 1);
+                c = funcion_coste(grafo, e);
                 if (c < 0)
                 {
-                    ar = ar->siguiente;
+                    e = a->siguiente[e];
                     continue;
                 }
-                if (distancia[u] + c < distancia[ar->destino])
+                v = a->destino[e];
+                if (distancia[u] + c < distancia[v])
                 {
-                    distancia[ar->destino] = distancia[u] + c;
-                    anterior[ar->destino] = u;
+                    distancia[v] = distancia[u] + c;
+                    anterior[v] = u;
                 }
             }
-            ar = ar->siguiente;
+            e = a->siguiente[e];
         }
     }
+    INSTR_SUMAR(vertices_asentados, asentados);
+    INSTR_SUMAR(aristas_relajadas, relajadas);
     return 0;
 }
 
@@ -134,14 +469,41 @@ int reconstruir_camino(const int *anterior, int indice_destino, int *camino, int
     return contador;
 }
 
+/* Sube por anterior[] hasta un vertice ya resuelto y rellena el camino recorrido: O(n) en total */
+void primeros_saltos(const int *anterior, const double *distancia, int n, int origen, int *primero, int *pila)
+{
+    int v, w, alto;
+
+    for (v = 0; v < n; ++v)
+        primero[v] = -2;
+    primero[origen] = origen;
+    for (v = 0; v < n; ++v)
+    {
+        if (primero[v] != -2)
+            continue;
+        if (distancia[v] >= DBL_MAX / 2)
+        {
+            primero[v] = -1;
+            continue;
+        }
+        alto = 0;
+        for (w = v; primero[w] == -2 && anterior[w] != origen; w = anterior[w])
+            pila[alto++] = w;
+        if (primero[w] == -2)
+            primero[w] = w;
+        while (alto > 0)
+            primero[pila[--alto]] = primero[w];
+    }
+}
+
 /* Calcular métricas de ruta */
 int calcular_metricas_ruta(GRAFO *grafo, const int *camino, int longitud_camino, double *latencia_out, int *bw_min_out, double *fiab_out)
 {
 
     double lat;
-    int bwmin, i, u, v, encontrado;
+    int bwmin, i, u, v, e;
     double prod;
-    ARISTA *ar;
+    const ARISTAS *a;
 
     if (!grafo || !camino || longitud_camino <= 0)
         return -1;
@@ -155,24 +517,14 @@ int calcular_metricas_ruta(GRAFO *grafo, const int *camino, int longitud_camino,
     {
         u = camino[i];
         v = camino[i + 1];
-        ar = grafo->vertices[u].lista_adyacencia;
-        encontrado = 0;
-
-        while (ar)
-        {
-            if (ar->destino == v && ar->activo)
-            {
-                lat += (double)ar->latencia_ms;
-                if (ar->ancho_banda_mbps < bwmin)
-                    bwmin = ar->ancho_banda_mbps;
-                prod *= ar->fiabilidad;
-                encontrado = 1;
-                break;
-            }
-            ar = ar->siguiente;
-        }
-        if (!encontrado)
+        a = &grafo->aristas;
+        e = buscar_arista_activa(grafo, u, v);
+        if (e == -1)
             return -1;
+        lat += (double)a->latencia_ms[e];
+        if (a->ancho_banda_mbps[e] < bwmin)
+            bwmin = a->ancho_banda_mbps[e];
+        prod *= (double)a->fiabilidad[e];
     }
     if (bwmin == INT_MAX)
         bwmin = 0;
@@ -185,6 +537,25 @@ int calcular_metricas_ruta(GRAFO *grafo, const int *camino, int longitud_camino,
     return 0;
 }
 
+int sondear_camino(const GRAFO *grafo, const int *camino, int longitud_camino, double *latencia)
+{
+    int i, e;
+    double acumulada = 0.0;
+
+    for (i = 0; i < longitud_camino - 1; ++i)
+    {
+        e = buscar_arista_activa(grafo, camino[i], camino[i + 1]);
+        if (e == -1)
+            return 0;
+        if (((double)rand()) / ((double)RAND_MAX) > (double)grafo->aristas.fiabilidad[e])
+            return 0;
+        acumulada += (double)grafo->aristas.latencia_ms[e];
+    }
+    if (latencia)
+        *latencia = acumulada;
+    return 1;
+}
+
 /* Compara caminos */
 int caminos_iguales(const int *a, int alen, const int *b, int blen)
 {
@@ -205,25 +576,36 @@ int caminos_iguales(const int *a, int alen, const int *b, int blen)
 /* Aproximación simple a K-shortest basada en desactivar aristas del mejor camino */
 int encontrar_k_rutas_aproximadas(GRAFO *grafo, int indice_origen, int indice_destino, FuncionCostoArista funcion_coste, int K, int caminos[][256], int longitudes[], int longitud_maxima)
 {
-    int len, n, anterior[256], encontrados, iter, mejor_camino_len, base_count, p, *camino_base, base_len, e, u, v, i, unico, q, l;
-    double distancia[256], mejor_coste;
+    int len, n, *anterior, encontrados, iter, mejor_camino_len, base_count, p, *camino_base, base_len, e, u, v, i, unico, q, l;
+    double *distancia, mejor_coste;
     int mejor_camino_buf[256];
-    ARISTA *ar, *ar_encontrada;
+    int ar_encontrada;
     int tmp[256];
 
     if (!grafo || !funcion_coste || K <= 0 || longitud_maxima <= 2)
         return 0;
     n = grafo->num_vertices;
+    anterior = malloc(sizeof(int) * n);
+    distancia = malloc(sizeof(double) * n);
+    if (!anterior || !distancia)
+    {
+        free(anterior);
+        free(distancia);
+        return 0;
+    }
 
     encontrados = 0;
     dijkstra_camino_minimo(grafo, indice_origen, indice_destino, funcion_coste, anterior, distancia);
 
-    if (distancia[indice_destino] >= DBL_MAX / 2)
-        return 0;
-    len = reconstruir_camino(anterior, indice_destino, caminos[encontrados], longitud_maxima);
-
+    len = 0;
+    if (distancia[indice_destino] < DBL_MAX / 2)
+        len = reconstruir_camino(anterior, indice_destino, caminos[encontrados], longitud_maxima);
     if (len <= 0)
+    {
+        free(anterior);
+        free(distancia);
         return 0;
+    }
 
     longitudes[encontrados] = len;
     encontrados++;
@@ -245,21 +627,11 @@ int encontrar_k_rutas_aproximadas(GRAFO *grafo, int indice_origen, int indice_de
             {
                 u = camino_base[e];
                 v = camino_base[e + 1];
-                ar_encontrada = NULL;
-                ar = grafo->vertices[u].lista_adyacencia;
-                while (ar)
-                {
-                    if (ar->destino == v && ar->activo)
-                    {
-                        ar_encontrada = ar;
-                        break;
-                    }
-                    ar = ar->siguiente;
-                }
-                if (!ar_encontrada)
+                ar_encontrada = buscar_arista_activa(grafo, u, v);
+                if (ar_encontrada == -1)
                     continue;
                 /* desactivar */
-                ar_encontrada->activo = 0;
+                ARISTA_DESACTIVAR(grafo, ar_encontrada);
 
                 i = 0;
                 for (i = 0; i < n; ++i)
@@ -291,7 +663,7 @@ int encontrar_k_rutas_aproximadas(GRAFO *grafo, int indice_origen, int indice_de
                     }
                 }
                 /* restaurar */
-                ar_encontrada->activo = 1;
+                ARISTA_ACTIVAR(grafo, ar_encontrada);
             }
         }
         if (mejor_coste < DBL_MAX)
@@ -303,6 +675,8 @@ int encontrar_k_rutas_aproximadas(GRAFO *grafo, int indice_origen, int indice_de
         else
             break;
     }
+    free(anterior);
+    free(distancia);
     return encontrados;
 }
 
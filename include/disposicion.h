@@ -0,0 +1,554 @@
+#ifndef DISPOSICION_H
+#define DISPOSICION_H
+
+#include "grafos.h"
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/*
+ * Disposicion dirigida por fuerzas (Fruchterman-Reingold) con Barnes-Hut.
+ * Cada iteracion construye un quadtree sobre las posiciones actuales; la
+ * repulsion de un grupo lejano de vertices (lado / distancia < theta) se
+ * aproxima con su centro de masas, asi que una iteracion es O(n log n) en
+ * lugar de O(n^2). La repulsion, que es casi todo el coste, se reparte entre
+ * hilos por bloques de vertices tomados de un contador comun (cada hilo solo
+ * escribe la fuerza de sus vertices); la atraccion por aristas y el
+ * desplazamiento son lineales y se hacen en el hilo principal.
+ *
+ * Las coordenadas son abstractas: la distancia ideal entre vecinos es 1 y el
+ * visor las escala a la ventana. La disposicion es incremental: los
+ * vertices ya colocados conservan su posicion, los nuevos se ponen junto a
+ * sus vecinos colocados y solo se mueven ellos, sus vecinos y los vertices
+ * marcados (p. ej. extremos de un enlace nuevo), con pocas iteraciones a baja
+ * temperatura: el dibujo no salta entero al anadir un dispositivo y el
+ * reajuste cuesta poco mas que construir el arbol.
+ */
+#define MAX_HILOS_DISPOSICION 8
+#define DISPOSICION_THETA 1.0f
+#define DISPOSICION_REPULSION 0.2f /* C de C k^2 / d, como en Hu (2005) */
+#define DISPOSICION_ITERACIONES 300
+#define DISPOSICION_ITERACIONES_INCREMENTAL 40
+#define QUAD_MAX_PROFUNDIDAD 32
+
+typedef struct DISPOSICION
+{
+    int num_vertices; /* vertices ya colocados (los primeros del grafo) */
+    int capacidad;
+    float *x, *y;
+    int *movidos;  /* vertices que ha movido el ultimo calculo */
+    int num_movidos;
+    int *marcados; /* vertices que se moveran en el proximo reajuste */
+    int num_marcados, capacidad_marcados;
+} DISPOSICION;
+
+void iniciar_disposicion(DISPOSICION *disp);
+void liberar_disposicion(DISPOSICION *disp);
+/*
+ * Coloca los vertices del grafo. Si ya hay una disposicion solo se colocan
+ * los nuevos y se reajusta; iteraciones = 0 elige segun el caso, hilos = 0
+ * usa los procesadores disponibles.
+ */
+int calcular_disposicion(GRAFO *grafo, DISPOSICION *disp, int iteraciones, int hilos);
+/* El vertice (ya colocado) se movera en el proximo reajuste, con sus vecinos */
+int marcar_disposicion(DISPOSICION *disp, int indice);
+/* Lineas "P <nombre> <x> <y>" */
+int guardar_disposicion(const DISPOSICION *disp, GRAFO *grafo, const char *archivo);
+
+// Implementaciones
+
+void iniciar_disposicion(DISPOSICION *disp)
+{
+    memset(disp, 0, sizeof(*disp));
+}
+
+void liberar_disposicion(DISPOSICION *disp)
+{
+    if (!disp)
+        return;
+    free(disp->x);
+    free(disp->y);
+    free(disp->movidos);
+    free(disp->marcados);
+    memset(disp, 0, sizeof(*disp));
+}
+
+int marcar_disposicion(DISPOSICION *disp, int indice)
+{
+    int *tmp, nueva;
+
+    if (indice < 0 || indice >= disp->num_vertices)
+        return 0; /* los vertices nuevos ya se mueven */
+    if (disp->num_marcados == disp->capacidad_marcados)
+    {
+        nueva = disp->capacidad_marcados ? disp->capacidad_marcados * 2 : 8;
+        tmp = realloc(disp->marcados, sizeof(int) * nueva);
+        if (!tmp)
+            return -1;
+        disp->marcados = tmp;
+        disp->capacidad_marcados = nueva;
+    }
+    disp->marcados[disp->num_marcados++] = indice;
+    return 0;
+}
+
+/* Nodo del quadtree: los cuerpos de un nodo son orden[primero .. primero + masa) */
+typedef struct NODO_QUAD
+{
+    float cx, cy; /* centro de masas */
+    float lado;
+    int masa;
+    int primero;
+    int hijo; /* indice del primero de 4 hijos consecutivos, -1 en las hojas */
+} NODO_QUAD;
+
+typedef struct QUADTREE
+{
+    NODO_QUAD *nodos;
+    int num, capacidad;
+    int *orden; /* permutacion de vertices agrupada por nodo */
+} QUADTREE;
+
+static int quad_reservar(QUADTREE *q, int cuantos)
+{
+    NODO_QUAD *tmp;
+    int nueva;
+
+    if (q->num + cuantos <= q->capacidad)
+        return 0;
+    nueva = q->capacidad ? q->capacidad * 2 : 1024;
+    while (nueva < q->num + cuantos)
+        nueva *= 2;
+    tmp = realloc(q->nodos, sizeof(NODO_QUAD) * (size_t)nueva);
+    if (!tmp)
+        return -1;
+    q->nodos = tmp;
+    q->capacidad = nueva;
+    return 0;
+}
+
+/* Deja al principio del tramo los vertices que cumplen la condicion; devuelve cuantos */
+static int quad_partir(int *orden, int num, const float *c, float corte)
+{
+    int i = 0, j = num - 1, t;
+
+    while (i <= j)
+    {
+        if (c[orden[i]] < corte)
+            i++;
+        else
+        {
+            t = orden[i];
+            orden[i] = orden[j];
+            orden[j--] = t;
+        }
+    }
+    return i;
+}
+
+/* Rellena el nodo ya reservado con los cuerpos orden[primero .. primero + num) */
+static int quad_construir(QUADTREE *q, int nodo, int primero, int num, float x0, float y0, float lado, int profundidad,
+                          const float *x, const float *y)
+{
+    int i, base, corte[5];
+    float sx = 0.0f, sy = 0.0f, mitad;
+    NODO_QUAD *nd;
+
+    for (i = 0; i < num; ++i)
+    {
+        sx += x[q->orden[primero + i]];
+        sy += y[q->orden[primero + i]];
+    }
+    nd = &q->nodos[nodo];
+    nd->masa = num;
+    nd->primero = primero;
+    nd->lado = lado;
+    nd->cx = num ? sx / num : 0.0f;
+    nd->cy = num ? sy / num : 0.0f;
+    nd->hijo = -1;
+    /* varios cuerpos en el mismo punto acaban juntos en una hoja */
+    if (num <= 1 || profundidad >= QUAD_MAX_PROFUNDIDAD)
+        return 0;
+
+    if (quad_reservar(q, 4) != 0)
+        return -1;
+    base = q->num;
+    q->num += 4;
+    q->nodos[nodo].hijo = base;
+    mitad = lado * 0.5f;
+    /* primero por y (mitad superior / inferior) y luego cada mitad por x */
+    corte[0] = 0;
+    corte[2] = quad_partir(q->orden + primero, num, y, y0 + mitad);
+    corte[1] = quad_partir(q->orden + primero, corte[2], x, x0 + mitad);
+    corte[3] = corte[2] + quad_partir(q->orden + primero + corte[2], num - corte[2], x, x0 + mitad);
+    corte[4] = num;
+    for (i = 0; i < 4; ++i)
+        if (quad_construir(q, base + i, primero + corte[i], corte[i + 1] - corte[i], x0 + (i & 1) * mitad, y0 + (i >> 1) * mitad, mitad,
+                           profundidad + 1, x, y) != 0)
+            return -1;
+    return 0;
+}
+
+static int construir_quadtree(QUADTREE *q, int n, const float *x, const float *y)
+{
+    int i;
+    float minx, miny, maxx, maxy, lado;
+
+    q->num = 0;
+    if (quad_reservar(q, 1) != 0)
+        return -1;
+    q->num = 1;
+    minx = maxx = n ? x[0] : 0.0f;
+    miny = maxy = n ? y[0] : 0.0f;
+    for (i = 0; i < n; ++i)
+    {
+        q->orden[i] = i;
+        minx = x[i] < minx ? x[i] : minx;
+        maxx = x[i] > maxx ? x[i] : maxx;
+        miny = y[i] < miny ? y[i] : miny;
+        maxy = y[i] > maxy ? y[i] : maxy;
+    }
+    lado = fmaxf(maxx - minx, maxy - miny) * 1.0001f + 1e-3f;
+    return quad_construir(q, 0, 0, n, minx, miny, lado, 0, x, y);
+}
+
+typedef struct TRABAJO_DISPOSICION
+{
+    const QUADTREE *q;
+    const float *x, *y;
+    float *fx, *fy;
+    const int *lista; /* vertices a los que se calcula fuerza */
+    int n;
+    int siguiente; /* siguiente posicion de lista por repartir */
+} TRABAJO_DISPOSICION;
+
+#define BLOQUE_DISPOSICION 256
+
+/* Repulsion k^2 / d (k = 1) sobre el vertice v recorriendo el arbol */
+static void repulsion_vertice(const TRABAJO_DISPOSICION *t, int v)
+{
+    int pila[4 * QUAD_MAX_PROFUNDIDAD + 8], cima, j, k;
+    float px = t->x[v], py = t->y[v], fx = 0.0f, fy = 0.0f, dx, dy, d2, escala;
+    const NODO_QUAD *nd;
+
+    cima = 0;
+    pila[cima++] = 0;
+    while (cima > 0)
+    {
+        nd = &t->q->nodos[pila[--cima]];
+        if (nd->masa == 0)
+            continue;
+        dx = px - nd->cx;
+        dy = py - nd->cy;
+        d2 = dx * dx + dy * dy;
+        if (nd->hijo < 0)
+        {
+            for (k = 0; k < nd->masa; ++k)
+            {
+                j = t->q->orden[nd->primero + k];
+                if (j == v)
+                    continue;
+                dx = px - t->x[j];
+                dy = py - t->y[j];
+                d2 = dx * dx + dy * dy;
+                if (d2 < 1e-4f)
+                {
+                    /* puntos coincidentes: se separan en una direccion fija segun el par */
+                    dx = (float)((v * 7 + j) % 13) - 6.0f;
+                    dy = (float)((v + j * 5) % 11) - 5.0f;
+                    d2 = dx * dx + dy * dy + 1.0f;
+                }
+                fx += DISPOSICION_REPULSION * dx / d2;
+                fy += DISPOSICION_REPULSION * dy / d2;
+            }
+        }
+        else if (nd->lado * nd->lado < DISPOSICION_THETA * DISPOSICION_THETA * d2)
+        {
+            escala = DISPOSICION_REPULSION * (float)nd->masa / d2;
+            fx += dx * escala;
+            fy += dy * escala;
+        }
+        else
+        {
+            pila[cima++] = nd->hijo;
+            pila[cima++] = nd->hijo + 1;
+            pila[cima++] = nd->hijo + 2;
+            pila[cima++] = nd->hijo + 3;
+        }
+    }
+    t->fx[v] = fx;
+    t->fy[v] = fy;
+}
+
+static void *resolver_trabajo_disposicion(void *arg)
+{
+    TRABAJO_DISPOSICION *t = arg;
+    int inicio, fin, i;
+
+    for (;;)
+    {
+        inicio = __atomic_fetch_add(&t->siguiente, BLOQUE_DISPOSICION, __ATOMIC_RELAXED);
+        if (inicio >= t->n)
+            break;
+        fin = inicio + BLOQUE_DISPOSICION < t->n ? inicio + BLOQUE_DISPOSICION : t->n;
+        for (i = inicio; i < fin; ++i)
+            repulsion_vertice(t, t->lista[i]);
+    }
+    return NULL;
+}
+
+static int hilos_disposicion(int hilos, int n)
+{
+    long procesadores;
+
+    if (hilos <= 0)
+    {
+        procesadores = sysconf(_SC_NPROCESSORS_ONLN);
+        hilos = procesadores > 0 ? (int)procesadores : 1;
+    }
+    if (hilos > MAX_HILOS_DISPOSICION)
+        hilos = MAX_HILOS_DISPOSICION;
+    /* por debajo de unos pocos bloques no compensa lanzar hilos */
+    if (hilos > n / BLOQUE_DISPOSICION + 1)
+        hilos = n / BLOQUE_DISPOSICION + 1;
+    return hilos;
+}
+
+static void repulsion_paralela(TRABAJO_DISPOSICION *t, int hilos)
+{
+    pthread_t hilo[MAX_HILOS_DISPOSICION];
+    int lanzado[MAX_HILOS_DISPOSICION] = {0};
+    int h;
+
+    t->siguiente = 0;
+    for (h = 1; h < hilos; ++h)
+        lanzado[h] = pthread_create(&hilo[h], NULL, resolver_trabajo_disposicion, t) == 0;
+    /* si no se pudo lanzar algun hilo, sus bloques los toman los demas */
+    resolver_trabajo_disposicion(t);
+    for (h = 1; h < hilos; ++h)
+        if (lanzado[h])
+            pthread_join(hilo[h], NULL);
+}
+
+static uint32_t aleatorio_disposicion(uint32_t *estado)
+{
+    uint32_t s = *estado;
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return *estado = s;
+}
+
+/* Posicion inicial de los vertices nuevos: media de sus vecinos ya colocados, o al azar */
+static void colocar_nuevos(GRAFO *grafo, DISPOSICION *disp, int desde, float lado)
+{
+    int v, e, w, vecinos;
+    float sx, sy, cx = 0.0f, cy = 0.0f;
+    uint32_t semilla = 0x9E3779B9u ^ (uint32_t)desde;
+    ARISTAS *a = &grafo->aristas;
+
+    /* los sueltos van al azar dentro del dibujo que ya hay */
+    if (desde > 0)
+    {
+        float minx = disp->x[0], maxx = disp->x[0], miny = disp->y[0], maxy = disp->y[0];
+        for (v = 1; v < desde; ++v)
+        {
+            minx = fminf(minx, disp->x[v]);
+            maxx = fmaxf(maxx, disp->x[v]);
+            miny = fminf(miny, disp->y[v]);
+            maxy = fmaxf(maxy, disp->y[v]);
+        }
+        cx = (minx + maxx) * 0.5f;
+        cy = (miny + maxy) * 0.5f;
+        lado = fmaxf(fmaxf(maxx - minx, maxy - miny), lado);
+    }
+    for (v = desde; v < grafo->num_vertices; ++v)
+    {
+        sx = sy = 0.0f;
+        vecinos = 0;
+        for (e = grafo->vertices[v].primera_arista; e != -1; e = a->siguiente[e])
+        {
+            w = a->destino[e];
+            if (w < v)
+            {
+                sx += disp->x[w];
+                sy += disp->y[w];
+                vecinos++;
+            }
+        }
+        if (vecinos > 0)
+        {
+            disp->x[v] = sx / vecinos + ((float)(aleatorio_disposicion(&semilla) % 1000) / 1000.0f - 0.5f);
+            disp->y[v] = sy / vecinos + ((float)(aleatorio_disposicion(&semilla) % 1000) / 1000.0f - 0.5f);
+        }
+        else
+        {
+            disp->x[v] = cx + ((float)(aleatorio_disposicion(&semilla) % 100000) / 100000.0f - 0.5f) * lado;
+            disp->y[v] = cy + ((float)(aleatorio_disposicion(&semilla) % 100000) / 100000.0f - 0.5f) * lado;
+        }
+    }
+}
+
+int calcular_disposicion(GRAFO *grafo, DISPOSICION *disp, int iteraciones, int hilos)
+{
+    int n, v, e, w, i, it, colocados, reajuste, num_moviles, *moviles;
+    float *fx, *fy, *tmp, lado, temperatura, t0, dx, dy, d, f, gravedad;
+    unsigned char *movil;
+    QUADTREE q;
+    TRABAJO_DISPOSICION trabajo;
+    ARISTAS *a;
+
+    if (!grafo || !disp)
+        return -1;
+    n = grafo->num_vertices;
+    if (disp->num_vertices > n)
+        liberar_disposicion(disp); /* otro grafo: se empieza de cero */
+    if (n == 0)
+        return 0;
+    if (n > disp->capacidad)
+    {
+        tmp = realloc(disp->x, sizeof(float) * n);
+        if (!tmp)
+            return -1;
+        disp->x = tmp;
+        tmp = realloc(disp->y, sizeof(float) * n);
+        if (!tmp)
+            return -1;
+        disp->y = tmp;
+        moviles = realloc(disp->movidos, sizeof(int) * n);
+        if (!moviles)
+            return -1;
+        disp->movidos = moviles;
+        disp->capacidad = n;
+    }
+    moviles = disp->movidos;
+    colocados = disp->num_vertices;
+    lado = sqrtf((float)n);
+    colocar_nuevos(grafo, disp, colocados, lado);
+
+    memset(&q, 0, sizeof(q));
+    fx = malloc(sizeof(float) * n);
+    fy = malloc(sizeof(float) * n);
+    q.orden = malloc(sizeof(int) * n);
+    movil = calloc(n, 1);
+    if (!fx || !fy || !q.orden || !movil)
+    {
+        free(fx);
+        free(fy);
+        free(q.orden);
+        free(movil);
+        return -1;
+    }
+    a = &grafo->aristas;
+
+    /*
+     * Reajuste: solo se mueven los vertices nuevos y marcados y sus
+     * vecinos; el resto sigue en el arbol (repele) pero no se le calcula
+     * fuerza. Sin disposicion previa, o sin nada nuevo ni marcado, se
+     * mueve todo.
+     */
+    reajuste = colocados > 0 && (colocados < n || disp->num_marcados > 0);
+    num_moviles = 0;
+    if (reajuste)
+    {
+        for (v = colocados; v < n; ++v)
+            movil[v] = 2;
+        for (i = 0; i < disp->num_marcados; ++i)
+            movil[disp->marcados[i]] = 2;
+        for (v = 0; v < n; ++v)
+            for (e = grafo->vertices[v].primera_arista; e != -1; e = a->siguiente[e])
+                if (movil[v] == 2 || movil[a->destino[e]] == 2)
+                {
+                    movil[v] = movil[v] ? movil[v] : 1;
+                    movil[a->destino[e]] = movil[a->destino[e]] ? movil[a->destino[e]] : 1;
+                }
+        for (v = 0; v < n; ++v)
+            if (movil[v])
+                moviles[num_moviles++] = v;
+    }
+    else
+        memset(movil, 1, n);
+    disp->num_marcados = 0;
+    if (iteraciones <= 0)
+        iteraciones = colocados > 0 ? DISPOSICION_ITERACIONES_INCREMENTAL : DISPOSICION_ITERACIONES;
+    t0 = colocados > 0 ? 2.0f : lado * 0.1f + 1.0f;
+    /* atraccion debil hacia el origen para que las componentes sueltas no se alejen */
+    gravedad = 1.0f / lado;
+    hilos = hilos_disposicion(hilos, num_moviles ? num_moviles : n);
+
+    for (it = 0; it < iteraciones; ++it)
+    {
+        if (construir_quadtree(&q, n, disp->x, disp->y) != 0)
+            break;
+        trabajo.q = &q;
+        trabajo.x = disp->x;
+        trabajo.y = disp->y;
+        trabajo.fx = fx;
+        trabajo.fy = fy;
+        /* en el orden del arbol: vertices vecinos en el plano recorren los mismos nodos */
+        trabajo.lista = num_moviles ? moviles : q.orden;
+        trabajo.n = num_moviles ? num_moviles : n;
+        repulsion_paralela(&trabajo, hilos);
+
+        /* atraccion d^2 / k en ambos extremos de cada enlace */
+        for (v = 0; v < n; ++v)
+            for (e = grafo->vertices[v].primera_arista; e != -1; e = a->siguiente[e])
+            {
+                w = a->destino[e];
+                if (w == v || (!movil[v] && !movil[w]))
+                    continue;
+                dx = disp->x[w] - disp->x[v];
+                dy = disp->y[w] - disp->y[v];
+                d = sqrtf(dx * dx + dy * dy);
+                fx[v] += dx * d;
+                fy[v] += dy * d;
+                fx[w] -= dx * d;
+                fy[w] -= dy * d;
+            }
+
+        /* enfriamiento lineal: el desplazamiento de cada paso se limita a la temperatura */
+        temperatura = t0 * (1.0f - (float)it / (float)iteraciones) + 0.01f;
+        for (i = 0; i < trabajo.n; ++i)
+        {
+            v = trabajo.lista[i];
+            fx[v] -= disp->x[v] * gravedad;
+            fy[v] -= disp->y[v] * gravedad;
+            d = sqrtf(fx[v] * fx[v] + fy[v] * fy[v]);
+            if (d <= 0.0f)
+                continue;
+            f = d < temperatura ? 1.0f : temperatura / d;
+            disp->x[v] += fx[v] * f;
+            disp->y[v] += fy[v] * f;
+        }
+    }
+
+    free(q.nodos);
+    free(q.orden);
+    free(fx);
+    free(fy);
+    free(movil);
+    if (it < iteraciones)
+        return -1;
+    disp->num_vertices = n;
+    disp->num_movidos = num_moviles ? num_moviles : n;
+    if (!num_moviles)
+        for (v = 0; v < n; ++v)
+            moviles[v] = v;
+    return 0;
+}
+
+int guardar_disposicion(const DISPOSICION *disp, GRAFO *grafo, const char *archivo)
+{
+    FILE *f;
+    int i;
+
+    f = fopen(archivo, "w");
+    if (!f)
+        return -1;
+    fprintf(f, "# disposicion de %d vertices: P <nombre> <x> <y>\n", disp->num_vertices);
+    for (i = 0; i < disp->num_vertices && i < grafo->num_vertices; ++i)
+        fprintf(f, "P %s %.3f %.3f\n", grafo->datos[i].nombre, disp->x[i], disp->y[i]);
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+#endif
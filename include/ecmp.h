@@ -0,0 +1,235 @@
+#ifndef ECMP_H
+#define ECMP_H
+
+#include "grafos.h"
+#include "dijkstra.h"
+#include "trafico.h"
+
+/*
+ * DAG de caminos minimos hacia un destino (modo multicamino).
+ * En lugar de un solo anterior[] se conservan todos los arcos de igual coste
+ * (los mismos que usa el reparto ECMP de trafico.h). Sobre el DAG:
+ *   - caminos[v] = numero de caminos minimos de v al destino, por programacion
+ *     dinamica en orden topologico: O(V + E) aunque haya millones de caminos
+ *     (en double; exacto hasta 2^53).
+ *   - muestreo uniforme: desde el origen se elige cada arco u -> v con
+ *     probabilidad caminos[v] / caminos[u].
+ *   - simulacion de hash: cada flujo tiene un hash de 5-tupla y cada router
+ *     elige siguiente salto con hash(flujo, router) mod salidas, como un ECMP
+ *     real; asi se ve cuanto se aleja el reparto del uniforme por caminos.
+ */
+typedef struct DAG_CAMINOS
+{
+    int num_vertices;
+    int destino;
+    double *coste;       /* coste por arista con el que se construyo */
+    double *distancia;   /* hacia el destino */
+    int *arco_siguiente; /* arista del arbol de caminos minimos */
+    int *orden;          /* alcanzables, del destino hacia fuera (topologico inverso) */
+    int num_orden;
+    double *caminos;     /* caminos minimos de v al destino, 0 = inalcanzable */
+} DAG_CAMINOS;
+
+/* Arco u -> v (arista e) del DAG */
+#define ARCO_DAG(dag, u, v, e) ARCO_AJUSTADO((dag)->distancia, (dag)->coste, u, v, e, (dag)->arco_siguiente[u])
+
+/* coste = NULL usa latencia_ms */
+int construir_dag_caminos(GRAFO *grafo, const RED_TRAFICO *red, const double *coste, int destino, DAG_CAMINOS *dag);
+void liberar_dag_caminos(DAG_CAMINOS *dag);
+/* Camino uniforme entre los de coste minimo; devuelve su longitud en vertices (0 si no hay) */
+int muestrear_camino(const RED_TRAFICO *red, const DAG_CAMINOS *dag, int origen, int *camino, int max_camino);
+/* Fraccion por arista del trafico origen -> destino si todos los caminos minimos fueran igual de probables */
+int reparto_uniforme_caminos(const RED_TRAFICO *red, const DAG_CAMINOS *dag, int origen, double *reparto);
+/* Fraccion por arista con num_flujos flujos repartidos por hash en cada salto */
+int simular_hash_ecmp(GRAFO *grafo, const RED_TRAFICO *red, const DAG_CAMINOS *dag, int origen, int num_flujos, uint64_t semilla, double *reparto);
+
+// Implementaciones
+
+int construir_dag_caminos(GRAFO *grafo, const RED_TRAFICO *red, const double *coste, int destino, DAG_CAMINOS *dag)
+{
+    int n, m, e, u, v, a, cab, fin, *salidas;
+    MONTICULO h;
+
+    if (!grafo || !red || !dag || destino < 0 || destino >= red->num_vertices)
+        return -1;
+    memset(dag, 0, sizeof(*dag));
+    n = red->num_vertices;
+    m = grafo->aristas.num;
+    dag->num_vertices = n;
+    dag->destino = destino;
+    dag->coste = malloc(sizeof(double) * (m + 1));
+    dag->distancia = malloc(sizeof(double) * n);
+    dag->arco_siguiente = malloc(sizeof(int) * n);
+    dag->orden = malloc(sizeof(int) * n);
+    dag->caminos = calloc(n, sizeof(double));
+    salidas = calloc(n, sizeof(int));
+    if (!dag->coste || !dag->distancia || !dag->arco_siguiente || !dag->orden || !dag->caminos || !salidas || monticulo_iniciar(&h, red->num_arcos + 1) != 0)
+    {
+        free(salidas);
+        liberar_dag_caminos(dag);
+        return -1;
+    }
+    for (e = 0; e < m; ++e)
+        dag->coste[e] = coste ? coste[e] : (double)grafo->aristas.latencia_ms[e];
+    distancias_hacia(red, dag->coste, destino, &h, dag->distancia, dag->arco_siguiente);
+    monticulo_liberar(&h);
+
+    /* arcos del DAG que salen de cada vertice */
+    for (u = 0; u < n; ++u)
+    {
+        if (dag->distancia[u] >= DBL_MAX / 2 || u == destino)
+            continue;
+        for (a = red->inicio[u]; a < red->inicio[u + 1]; ++a)
+            if (ARCO_DAG(dag, u, red->destino[a], red->arista[a]))
+                salidas[u]++;
+    }
+    /* Kahn desde el destino sobre los arcos invertidos: cada vertice sale cuando todos sus sucesores estan contados */
+    dag->caminos[destino] = 1.0;
+    dag->orden[0] = destino;
+    cab = 0;
+    fin = 1;
+    while (cab < fin)
+    {
+        v = dag->orden[cab++];
+        for (a = red->inicio_inv[v]; a < red->inicio_inv[v + 1]; ++a)
+        {
+            u = red->origen_inv[a];
+            e = red->arista_inv[a];
+            if (u == destino || dag->distancia[u] >= DBL_MAX / 2 || !ARCO_DAG(dag, u, v, e))
+                continue;
+            dag->caminos[u] += dag->caminos[v];
+            if (--salidas[u] == 0)
+                dag->orden[fin++] = u;
+        }
+    }
+    dag->num_orden = fin;
+    free(salidas);
+    return 0;
+}
+
+void liberar_dag_caminos(DAG_CAMINOS *dag)
+{
+    if (!dag)
+        return;
+    free(dag->coste);
+    free(dag->distancia);
+    free(dag->arco_siguiente);
+    free(dag->orden);
+    free(dag->caminos);
+    memset(dag, 0, sizeof(*dag));
+}
+
+int muestrear_camino(const RED_TRAFICO *red, const DAG_CAMINOS *dag, int origen, int *camino, int max_camino)
+{
+    int u, v, e, a, len;
+    double r;
+
+    if (!red || !dag || !camino || max_camino <= 0 || origen < 0 || origen >= dag->num_vertices || dag->caminos[origen] <= 0.0)
+        return 0;
+    u = origen;
+    len = 0;
+    camino[len++] = u;
+    while (u != dag->destino && len < max_camino)
+    {
+        r = ((double)rand() / ((double)RAND_MAX + 1.0)) * dag->caminos[u];
+        v = -1;
+        for (a = red->inicio[u]; a < red->inicio[u + 1]; ++a)
+        {
+            e = red->arista[a];
+            if (!ARCO_DAG(dag, u, red->destino[a], e))
+                continue;
+            v = red->destino[a];
+            r -= dag->caminos[v];
+            if (r < 0.0)
+                break;
+        }
+        if (v < 0)
+            return 0;
+        u = v;
+        camino[len++] = u;
+    }
+    return u == dag->destino ? len : 0;
+}
+
+int reparto_uniforme_caminos(const RED_TRAFICO *red, const DAG_CAMINOS *dag, int origen, double *reparto)
+{
+    int i, u, v, e, a;
+    double *desde, total;
+
+    if (!red || !dag || !reparto || origen < 0 || origen >= dag->num_vertices || dag->caminos[origen] <= 0.0)
+        return -1;
+    desde = calloc(dag->num_vertices, sizeof(double));
+    if (!desde)
+        return -1;
+    /* caminos minimos desde el origen hasta cada vertice del DAG: orden topologico directo */
+    total = dag->caminos[origen];
+    desde[origen] = 1.0;
+    for (i = dag->num_orden - 1; i >= 0; --i)
+    {
+        u = dag->orden[i];
+        if (desde[u] == 0.0 || u == dag->destino)
+            continue;
+        for (a = red->inicio[u]; a < red->inicio[u + 1]; ++a)
+        {
+            v = red->destino[a];
+            e = red->arista[a];
+            if (!ARCO_DAG(dag, u, v, e))
+                continue;
+            desde[v] += desde[u];
+            /* caminos que usan u -> v: (origen ~> u) * (v ~> destino) */
+            reparto[e] += desde[u] * dag->caminos[v] / total;
+        }
+    }
+    free(desde);
+    return 0;
+}
+
+/* splitmix64: mezcla barata con buena difusion de bits */
+static uint64_t mezclar_hash(uint64_t x)
+{
+    x += UINT64_C(0x9E3779B97F4A7C15);
+    x = (x ^ (x >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return x ^ (x >> 31);
+}
+
+int simular_hash_ecmp(GRAFO *grafo, const RED_TRAFICO *red, const DAG_CAMINOS *dag, int origen, int num_flujos, uint64_t semilla, double *reparto)
+{
+    int f, u, a, e, salidas, elegido, saltos;
+    uint64_t tupla, h;
+
+    if (!grafo || !red || !dag || !reparto || num_flujos <= 0 || origen < 0 || origen >= dag->num_vertices || dag->caminos[origen] <= 0.0)
+        return -1;
+    for (f = 0; f < num_flujos; ++f)
+    {
+        /* 5-tupla sintetica: ips de los extremos, puerto origen efimero, puerto destino y protocolo fijos */
+        tupla = mezclar_hash((((uint64_t)grafo->datos[origen].ip << 32) | grafo->datos[dag->destino].ip) ^ semilla);
+        tupla = mezclar_hash(tupla ^ ((uint64_t)(49152 + f % 16384) << 16) ^ (uint64_t)(f / 16384) ^ (UINT64_C(443) << 40) ^ (UINT64_C(6) << 56));
+        u = origen;
+        saltos = 0;
+        while (u != dag->destino && saltos++ < dag->num_vertices)
+        {
+            salidas = 0;
+            for (a = red->inicio[u]; a < red->inicio[u + 1]; ++a)
+                if (ARCO_DAG(dag, u, red->destino[a], red->arista[a]))
+                    salidas++;
+            /* cada router mezcla con su propia ip para no polarizar */
+            h = mezclar_hash(tupla ^ grafo->datos[u].ip);
+            elegido = (int)(h % (uint64_t)salidas);
+            e = -1;
+            for (a = red->inicio[u]; a < red->inicio[u + 1]; ++a)
+            {
+                e = red->arista[a];
+                if (!ARCO_DAG(dag, u, red->destino[a], e))
+                    continue;
+                if (elegido-- == 0)
+                    break;
+            }
+            reparto[e] += 1.0 / num_flujos;
+            u = red->destino[a];
+        }
+    }
+    return 0;
+}
+
+#endif
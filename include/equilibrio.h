@@ -0,0 +1,303 @@
+#ifndef EQUILIBRIO_H
+#define EQUILIBRIO_H
+
+#include <time.h>
+#include "grafos.h"
+#include "trafico.h"
+
+/*
+ * Equilibrio de usuario (Wardrop) con Frank-Wolfe conjugado.
+ * Coste de un enlace con carga x (funcion BPR):
+ *     lat * (1 + alfa * (x / ancho_banda)^beta)
+ * mas el retardo de procesado del dispositivo al que llega, con su carga y
+ * (todo lo que entra en el):
+ *     retardo_nodo * (1 + alfa * (y / capacidad_procesamiento)^beta)
+ * Cada iteracion hace una asignacion todo-o-nada con el motor de trafico
+ * (misma red CSR y misma agrupacion de demandas en todas las iteraciones),
+ * combina la direccion con la anterior (conjugada respecto a la hessiana
+ * diagonal) y busca el paso por biseccion sobre la derivada del objetivo de
+ * Beckmann. La convergencia se mide con el gap relativo.
+ */
+typedef struct PARAMETROS_EQUILIBRIO
+{
+    int max_iteraciones;
+    double gap_objetivo;    /* gap relativo para parar */
+    double alfa;            /* BPR */
+    double beta;            /* BPR */
+    double retardo_nodo_ms; /* retardo de procesado sin carga */
+} PARAMETROS_EQUILIBRIO;
+
+typedef struct RESULTADO_EQUILIBRIO
+{
+    int iteraciones;
+    double gap;
+    double latencia_media;  /* ms por Mbps enrutado */
+    double latencia_libre;  /* la misma medida con la red vacia */
+    double tiempo_ms;
+    double *flujo;          /* Mbps por arista */
+    double *coste;          /* latencia cargada por arista (incluye el nodo destino) */
+    double *carga_nodo;     /* Mbps que entran en cada vertice */
+    double enrutado;
+    double sin_camino;
+} RESULTADO_EQUILIBRIO;
+
+/* Se llama tras cada iteracion con el gap, la latencia media y los ms que tardo */
+typedef void (*InformeIteracion)(int iteracion, double gap, double latencia_media, double ms, void *contexto);
+
+void parametros_equilibrio_por_defecto(PARAMETROS_EQUILIBRIO *p);
+int resolver_equilibrio(GRAFO *grafo, MATRIZ_DEMANDAS *dem, const PARAMETROS_EQUILIBRIO *p, InformeIteracion informe, void *contexto, RESULTADO_EQUILIBRIO *res);
+void liberar_resultado_equilibrio(RESULTADO_EQUILIBRIO *res);
+
+// Implementaciones
+
+void parametros_equilibrio_por_defecto(PARAMETROS_EQUILIBRIO *p)
+{
+    p->max_iteraciones = 50;
+    p->gap_objetivo = 1e-4;
+    p->alfa = 0.15;
+    p->beta = 4.0;
+    p->retardo_nodo_ms = 1.0;
+}
+
+static double ms_actuales(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* BPR y su derivada; capacidad <= 0 no congestiona */
+static double bpr(const PARAMETROS_EQUILIBRIO *p, double libre, double x, double capacidad)
+{
+    if (capacidad <= 0.0)
+        return libre;
+    return libre * (1.0 + p->alfa * pow(x / capacidad, p->beta));
+}
+
+static double bpr_derivada(const PARAMETROS_EQUILIBRIO *p, double libre, double x, double capacidad)
+{
+    if (capacidad <= 0.0 || x <= 0.0)
+        return 0.0;
+    return libre * p->alfa * p->beta * pow(x / capacidad, p->beta - 1.0) / capacidad;
+}
+
+static void cargas_nodo(GRAFO *grafo, const double *flujo, double *carga_nodo)
+{
+    int e;
+
+    memset(carga_nodo, 0, sizeof(double) * grafo->num_vertices);
+    for (e = 0; e < grafo->aristas.num; ++e)
+        if (grafo->aristas.destino[e] >= 0)
+            carga_nodo[grafo->aristas.destino[e]] += flujo[e];
+}
+
+/* Coste de cada arista con las cargas dadas; si derivada no es NULL, tambien la hessiana diagonal aproximada */
+static void costes_cargados(GRAFO *grafo, const PARAMETROS_EQUILIBRIO *p, const double *flujo, const double *carga_nodo, double *coste, double *derivada)
+{
+    int e, v;
+
+    for (e = 0; e < grafo->aristas.num; ++e)
+    {
+        v = grafo->aristas.destino[e];
+        if (v < 0)
+        {
+            coste[e] = 0.0;
+            if (derivada)
+                derivada[e] = 0.0;
+            continue;
+        }
+        coste[e] = bpr(p, grafo->aristas.latencia_ms[e], flujo[e], grafo->aristas.ancho_banda_mbps[e]) +
+                   bpr(p, p->retardo_nodo_ms, carga_nodo[v], grafo->datos[v].capacidad_procesamiento);
+        if (derivada)
+            derivada[e] = bpr_derivada(p, grafo->aristas.latencia_ms[e], flujo[e], grafo->aristas.ancho_banda_mbps[e]) +
+                          bpr_derivada(p, p->retardo_nodo_ms, carga_nodo[v], grafo->datos[v].capacidad_procesamiento);
+    }
+}
+
+/* Derivada del objetivo de Beckmann en x + l * d */
+static double derivada_paso(GRAFO *grafo, const PARAMETROS_EQUILIBRIO *p, const double *x, const double *d, const double *nodo_x, const double *nodo_d, double l)
+{
+    int e, v;
+    double total = 0.0;
+
+    for (e = 0; e < grafo->aristas.num; ++e)
+    {
+        if (d[e] == 0.0 || grafo->aristas.destino[e] < 0)
+            continue;
+        total += d[e] * bpr(p, grafo->aristas.latencia_ms[e], x[e] + l * d[e], grafo->aristas.ancho_banda_mbps[e]);
+    }
+    for (v = 0; v < grafo->num_vertices; ++v)
+    {
+        if (nodo_d[v] == 0.0)
+            continue;
+        total += nodo_d[v] * bpr(p, p->retardo_nodo_ms, nodo_x[v] + l * nodo_d[v], grafo->datos[v].capacidad_procesamiento);
+    }
+    return total;
+}
+
+int resolver_equilibrio(GRAFO *grafo, MATRIZ_DEMANDAS *dem, const PARAMETROS_EQUILIBRIO *p, InformeIteracion informe, void *contexto, RESULTADO_EQUILIBRIO *res)
+{
+    int m, n, e, k, b;
+    double *conjugado, *direccion, *hessiana, *nodo_d, t0, t_iter, lo, hi, l, num, den, a, xc, yc;
+    RED_TRAFICO red;
+    CARGA_ENLACES aon;
+
+    if (!grafo || !dem || !p || !res || dem->num == 0)
+        return -1;
+    memset(res, 0, sizeof(*res));
+    m = grafo->aristas.num;
+    n = grafo->num_vertices;
+    res->flujo = calloc(m + 1, sizeof(double));
+    res->coste = malloc(sizeof(double) * (m + 1));
+    res->carga_nodo = calloc(n + 1, sizeof(double));
+    conjugado = calloc(m + 1, sizeof(double));
+    direccion = malloc(sizeof(double) * (m + 1));
+    hessiana = malloc(sizeof(double) * (m + 1));
+    nodo_d = malloc(sizeof(double) * (n + 1));
+    if (!res->flujo || !res->coste || !res->carga_nodo || !conjugado || !direccion || !hessiana || !nodo_d || construir_red_trafico(grafo, &red) != 0)
+    {
+        free(conjugado);
+        free(direccion);
+        free(hessiana);
+        free(nodo_d);
+        liberar_resultado_equilibrio(res);
+        return -1;
+    }
+    t0 = ms_actuales();
+
+    /* punto inicial: todo-o-nada con la red vacia */
+    costes_cargados(grafo, p, res->flujo, res->carga_nodo, res->coste, NULL);
+    if (enrutar_demandas(grafo, &red, dem, res->coste, REPARTO_CAMINO_UNICO, 0, &aon) != 0)
+        goto error;
+    memcpy(res->flujo, aon.mbps, sizeof(double) * m);
+    res->enrutado = aon.enrutado;
+    res->sin_camino = aon.sin_camino;
+    yc = 0.0;
+    for (e = 0; e < m; ++e)
+        yc += aon.mbps[e] * res->coste[e];
+    res->latencia_libre = res->enrutado > 0.0 ? yc / res->enrutado : 0.0;
+    liberar_carga_enlaces(&aon);
+
+    for (k = 1; k <= p->max_iteraciones; ++k)
+    {
+        t_iter = ms_actuales();
+        cargas_nodo(grafo, res->flujo, res->carga_nodo);
+        costes_cargados(grafo, p, res->flujo, res->carga_nodo, res->coste, hessiana);
+        if (enrutar_demandas(grafo, &red, dem, res->coste, REPARTO_CAMINO_UNICO, 0, &aon) != 0)
+            goto error;
+
+        xc = 0.0;
+        yc = 0.0;
+        for (e = 0; e < m; ++e)
+        {
+            xc += res->flujo[e] * res->coste[e];
+            yc += aon.mbps[e] * res->coste[e];
+        }
+        res->gap = xc > 0.0 ? (xc - yc) / xc : 0.0;
+        res->latencia_media = res->enrutado > 0.0 ? xc / res->enrutado : 0.0;
+        res->iteraciones = k;
+        if (res->gap <= p->gap_objetivo)
+        {
+            liberar_carga_enlaces(&aon);
+            if (informe)
+                informe(k, res->gap, res->latencia_media, ms_actuales() - t_iter, contexto);
+            break;
+        }
+
+        /* punto conjugado: combinacion del anterior y la nueva solucion todo-o-nada */
+        a = 0.0;
+        if (k > 1)
+        {
+            num = 0.0;
+            den = 0.0;
+            for (e = 0; e < m; ++e)
+            {
+                num += (conjugado[e] - res->flujo[e]) * hessiana[e] * (aon.mbps[e] - res->flujo[e]);
+                den += (conjugado[e] - res->flujo[e]) * hessiana[e] * (aon.mbps[e] - conjugado[e]);
+            }
+            if (den != 0.0)
+                a = num / den;
+            if (a < 0.0)
+                a = 0.0;
+            if (a > 0.99)
+                a = 0.99;
+        }
+        num = 0.0;
+        for (e = 0; e < m; ++e)
+        {
+            conjugado[e] = a * conjugado[e] + (1.0 - a) * aon.mbps[e];
+            direccion[e] = conjugado[e] - res->flujo[e];
+            num += direccion[e] * res->coste[e];
+        }
+        /* si la combinacion no desciende, se vuelve a Frank-Wolfe puro */
+        if (num >= 0.0)
+        {
+            for (e = 0; e < m; ++e)
+            {
+                conjugado[e] = aon.mbps[e];
+                direccion[e] = conjugado[e] - res->flujo[e];
+            }
+        }
+        liberar_carga_enlaces(&aon);
+
+        /* paso optimo en [0, 1] por biseccion */
+        cargas_nodo(grafo, direccion, nodo_d);
+        lo = 0.0;
+        hi = 1.0;
+        if (derivada_paso(grafo, p, res->flujo, direccion, res->carga_nodo, nodo_d, 1.0) <= 0.0)
+        {
+            lo = 1.0;
+        }
+        else
+        {
+            for (b = 0; b < 30; ++b)
+            {
+                l = 0.5 * (lo + hi);
+                if (derivada_paso(grafo, p, res->flujo, direccion, res->carga_nodo, nodo_d, l) > 0.0)
+                    hi = l;
+                else
+                    lo = l;
+            }
+        }
+        for (e = 0; e < m; ++e)
+            res->flujo[e] += lo * direccion[e];
+
+        if (informe)
+            informe(k, res->gap, res->latencia_media, ms_actuales() - t_iter, contexto);
+    }
+
+    cargas_nodo(grafo, res->flujo, res->carga_nodo);
+    costes_cargados(grafo, p, res->flujo, res->carga_nodo, res->coste, NULL);
+    xc = 0.0;
+    for (e = 0; e < m; ++e)
+        xc += res->flujo[e] * res->coste[e];
+    res->latencia_media = res->enrutado > 0.0 ? xc / res->enrutado : 0.0;
+    res->tiempo_ms = ms_actuales() - t0;
+    liberar_red_trafico(&red);
+    free(conjugado);
+    free(direccion);
+    free(hessiana);
+    free(nodo_d);
+    return 0;
+
+error:
+    liberar_red_trafico(&red);
+    free(conjugado);
+    free(direccion);
+    free(hessiana);
+    free(nodo_d);
+    liberar_resultado_equilibrio(res);
+    return -1;
+}
+
+void liberar_resultado_equilibrio(RESULTADO_EQUILIBRIO *res)
+{
+    if (!res)
+        return;
+    free(res->flujo);
+    free(res->coste);
+    free(res->carga_nodo);
+    memset(res, 0, sizeof(*res));
+}
+
+#endif
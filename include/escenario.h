@@ -0,0 +1,1065 @@
+#ifndef ESCENARIO_H
+#define ESCENARIO_H
+
+#include <stdint.h>
+#include <time.h>
+#include "grafos.h"
+#include "dijkstra.h"
+#include "resiliencia.h"
+#include "visor.h"
+
+#define MAX_CAMINO_SONDA 256
+#define MAX_MEMORIA_COTAS (256u << 20) /* bytes para las cotas de las rutas */
+
+/*
+ * Reproduccion de escenarios de fallo: una lista de eventos con marca de
+ * tiempo (caidas y restauraciones de enlaces y nodos, cambios de metricas)
+ * que se aplican en orden, y sondas (rutas, alcance, resiliencia) que se
+ * reevaluan en cada punto de control.
+ *
+ * Los eventos se resuelven a indices de vertice y de arista al cargar el
+ * archivo, asi que aplicar uno es cambiar un bit o un campo. Entre dos puntos
+ * de control solo se anota que toco cada evento (sellos por control, sin
+ * limpiar nada); en el control:
+ *   - la vista de latencia se construye una vez para todas las rutas;
+ *   - una ruta que no pasa por nada que empeoro (caidas, latencias mayores)
+ *     sigue siendo minima salvo que alguna mejora (restauracion, latencia
+ *     menor) permita un camino mas corto. Para descartarlo se usa el "grafo
+ *     suelo": todo activo y cada latencia en su minimo del escenario (los
+ *     eventos se conocen de antemano), cuyas distancias son cotas inferiores
+ *     validas durante toda la reproduccion. Con una distancia suelo desde el
+ *     origen y otra hacia el destino por ruta (dos Dijkstra al empezar), la
+ *     mejora u -> v solo puede afectar a la ruta si
+ *     suelo(o, u) + w_min(u, v) + suelo(v, d) < coste actual;
+ *   - las rutas con el mismo origen comparten un Dijkstra completo;
+ *   - alcance y resiliencia solo se recalculan si cambio algun estado.
+ * Un enlace en un evento son sus dos sentidos (los que existan).
+ */
+typedef enum
+{
+    EV_ENLACE_CAIDO,
+    EV_ENLACE_RESTAURADO,
+    EV_NODO_CAIDO,
+    EV_NODO_RESTAURADO,
+    EV_METRICA,
+    EV_CONTROL
+} Tipo_Evento;
+
+typedef struct EVENTO
+{
+    double tiempo; /* segundos desde el inicio del escenario */
+    int orden;     /* posicion en el archivo: desempata eventos simultaneos */
+    Tipo_Evento tipo;
+    int vertice;   /* eventos de nodo */
+    int arista[2]; /* u -> v y v -> u, -1 si no existe */
+    int latencia_ms, ancho_banda_mbps; /* EV_METRICA; -1 = sin cambio */
+    float fiabilidad;                  /* EV_METRICA; < 0 = sin cambio */
+} EVENTO;
+
+typedef enum
+{
+    SONDA_RUTA,
+    SONDA_ALCANCE,
+    SONDA_RESILIENCIA
+} Tipo_Sonda;
+
+typedef struct SONDA
+{
+    Tipo_Sonda tipo;
+    int origen, destino;
+    /* ultimo resultado */
+    int longitud; /* SONDA_RUTA: 0 = sin camino */
+    int camino[MAX_CAMINO_SONDA];
+    int aristas[MAX_CAMINO_SONDA]; /* arista usada en cada salto */
+    double latencia;
+    int alcanzables; /* SONDA_ALCANCE y SONDA_RESILIENCIA (desde el primer nodo activo) */
+    int critico, impacto; /* SONDA_RESILIENCIA; critico = -1 si ningun fallo desconecta */
+    int pendiente;        /* hay que recalcularla en este control */
+} SONDA;
+
+typedef struct ESCENARIO
+{
+    EVENTO *eventos;
+    int num_eventos;
+    int capacidad_eventos;
+    SONDA *sondas;
+    int num_sondas;
+    int capacidad_sondas;
+} ESCENARIO;
+
+typedef struct RESUMEN_ESCENARIO
+{
+    int eventos;
+    int controles;        /* con algun cambio */
+    int rutas_evaluadas;  /* recalculos de sondas de ruta */
+    int dijkstras;
+    int cambios_ruta;
+    double ms;
+} RESUMEN_ESCENARIO;
+
+void iniciar_escenario(ESCENARIO *esc);
+void liberar_escenario(ESCENARIO *esc);
+/* Devuelve 0 o -1 si no se puede abrir; las lineas invalidas se cuentan en *descartadas */
+int cargar_escenario(GRAFO *grafo, const char *archivo, ESCENARIO *esc, int *descartadas);
+/*
+ * Aplica todos los eventos. intervalo > 0 agrega un control cada intervalo
+ * segundos (ademas de los eventos "control" y del final). Con mantener = 0
+ * el grafo vuelve al estado inicial al terminar. canal puede ser NULL.
+ */
+int reproducir_escenario(GRAFO *grafo, ESCENARIO *esc, double intervalo, int mantener, CANAL_VISOR *canal, FILE *salida, RESUMEN_ESCENARIO *resumen);
+
+// Implementaciones
+
+void iniciar_escenario(ESCENARIO *esc)
+{
+    memset(esc, 0, sizeof(*esc));
+}
+
+void liberar_escenario(ESCENARIO *esc)
+{
+    if (!esc)
+        return;
+    free(esc->eventos);
+    free(esc->sondas);
+    memset(esc, 0, sizeof(*esc));
+}
+
+static EVENTO *nuevo_evento(ESCENARIO *esc)
+{
+    EVENTO *tmp;
+    int nueva;
+
+    if (esc->num_eventos == esc->capacidad_eventos)
+    {
+        nueva = esc->capacidad_eventos ? esc->capacidad_eventos * 2 : 256;
+        tmp = realloc(esc->eventos, sizeof(EVENTO) * nueva);
+        if (!tmp)
+            return NULL;
+        esc->eventos = tmp;
+        esc->capacidad_eventos = nueva;
+    }
+    memset(&esc->eventos[esc->num_eventos], 0, sizeof(EVENTO));
+    esc->eventos[esc->num_eventos].orden = esc->num_eventos;
+    esc->eventos[esc->num_eventos].vertice = -1;
+    esc->eventos[esc->num_eventos].arista[0] = -1;
+    esc->eventos[esc->num_eventos].arista[1] = -1;
+    return &esc->eventos[esc->num_eventos++];
+}
+
+static SONDA *nueva_sonda(ESCENARIO *esc)
+{
+    SONDA *tmp;
+    int nueva;
+
+    if (esc->num_sondas == esc->capacidad_sondas)
+    {
+        nueva = esc->capacidad_sondas ? esc->capacidad_sondas * 2 : 16;
+        tmp = realloc(esc->sondas, sizeof(SONDA) * nueva);
+        if (!tmp)
+            return NULL;
+        esc->sondas = tmp;
+        esc->capacidad_sondas = nueva;
+    }
+    memset(&esc->sondas[esc->num_sondas], 0, sizeof(SONDA));
+    esc->sondas[esc->num_sondas].critico = -1;
+    return &esc->sondas[esc->num_sondas++];
+}
+
+/* Segundos ("90", "90.5") o hh:mm:ss[.fff]; devuelve -1 si no es valido */
+static double tiempo_escenario(const char *s)
+{
+    double partes[3], v;
+    char *fin;
+    int num;
+
+    num = 0;
+    for (;;)
+    {
+        v = strtod(s, &fin);
+        if (fin == s || v < 0 || num == 3)
+            return -1;
+        partes[num++] = v;
+        if (*fin == '\0')
+            break;
+        if (*fin != ':')
+            return -1;
+        s = fin + 1;
+    }
+    if (num == 1)
+        return partes[0];
+    if (num == 2)
+        return partes[0] * 60.0 + partes[1];
+    return partes[0] * 3600.0 + partes[1] * 60.0 + partes[2];
+}
+
+static int entero_o_guion(const char *s, int *valor)
+{
+    char *fin;
+    long v;
+
+    if (!s || strcmp(s, "-") == 0)
+    {
+        *valor = -1;
+        return 1;
+    }
+    v = strtol(s, &fin, 10);
+    if (*fin != '\0' || v < 0)
+        return 0;
+    *valor = (int)v;
+    return 1;
+}
+
+int cargar_escenario(GRAFO *grafo, const char *archivo, ESCENARIO *esc, int *descartadas)
+{
+    FILE *f;
+    char linea[MAX_LINEA], *campo[6], *fin;
+    int num, malas, a, b, ok;
+    double t, fi;
+    EVENTO *ev;
+    SONDA *so;
+
+    f = fopen(archivo, "r");
+    if (!f)
+        return -1;
+    malas = 0;
+    while (fgets(linea, sizeof(linea), f))
+    {
+        memset(campo, 0, sizeof(campo));
+        num = 0;
+        campo[0] = strtok(linea, " \t\r\n");
+        if (!campo[0] || campo[0][0] == '#')
+            continue;
+        while (num < 5 && campo[num])
+            campo[++num] = strtok(NULL, " \t\r\n");
+
+        if (strcmp(campo[0], "sonda") == 0)
+        {
+            a = campo[1] && campo[2] ? indice_por_nombre(grafo, campo[2]) : -1;
+            b = campo[1] && campo[2] && campo[3] ? indice_por_nombre(grafo, campo[3]) : -1;
+            so = NULL;
+            if (campo[1] && strcmp(campo[1], "ruta") == 0 && a != -1 && b != -1 && a != b && (so = nueva_sonda(esc)))
+                so->tipo = SONDA_RUTA;
+            else if (campo[1] && strcmp(campo[1], "alcance") == 0 && a != -1 && (so = nueva_sonda(esc)))
+                so->tipo = SONDA_ALCANCE;
+            else if (campo[1] && strcmp(campo[1], "resiliencia") == 0 && (so = nueva_sonda(esc)))
+                so->tipo = SONDA_RESILIENCIA;
+            if (!so)
+            {
+                malas++;
+                continue;
+            }
+            so->origen = a;
+            so->destino = b;
+            continue;
+        }
+
+        t = tiempo_escenario(campo[0]);
+        if (t < 0 || !campo[1])
+        {
+            malas++;
+            continue;
+        }
+        a = campo[2] ? indice_por_nombre(grafo, campo[2]) : -1;
+        b = campo[2] && campo[3] ? indice_por_nombre(grafo, campo[3]) : -1;
+        if (!(ev = nuevo_evento(esc)))
+        {
+            malas++;
+            continue;
+        }
+        ev->tiempo = t;
+        ok = 1;
+        if (strcmp(campo[1], "control") == 0)
+            ev->tipo = EV_CONTROL;
+        else if (strcmp(campo[1], "nodo-caido") == 0 || strcmp(campo[1], "nodo-restaurado") == 0)
+        {
+            ev->tipo = campo[1][5] == 'c' ? EV_NODO_CAIDO : EV_NODO_RESTAURADO;
+            ev->vertice = a;
+            ok = a != -1;
+        }
+        else if (strcmp(campo[1], "enlace-caido") == 0 || strcmp(campo[1], "enlace-restaurado") == 0 ||
+                 strcmp(campo[1], "metrica") == 0)
+        {
+            ev->tipo = campo[1][0] == 'm' ? EV_METRICA : (campo[1][7] == 'c' ? EV_ENLACE_CAIDO : EV_ENLACE_RESTAURADO);
+            if (a != -1 && b != -1)
+            {
+                ev->arista[0] = buscar_arista(grafo, a, b);
+                ev->arista[1] = buscar_arista(grafo, b, a);
+            }
+            ok = ev->arista[0] != -1 || ev->arista[1] != -1;
+            if (ok && ev->tipo == EV_METRICA)
+            {
+                /* metrica <o> <d> <lat|-> [bw|-] [fiab|-] */
+                ev->fiabilidad = -1.0f;
+                ok = campo[4] && entero_o_guion(campo[4], &ev->latencia_ms) &&
+                     entero_o_guion(campo[4] ? campo[5] : NULL, &ev->ancho_banda_mbps);
+                if (ok && campo[5] && (fin = strtok(NULL, " \t\r\n")) && strcmp(fin, "-") != 0)
+                {
+                    fi = strtod(fin, &fin);
+                    ok = *fin == '\0' && fi >= 0.0 && fi <= 1.0;
+                    ev->fiabilidad = (float)fi;
+                }
+            }
+        }
+        else
+            ok = 0;
+        if (!ok)
+        {
+            esc->num_eventos--;
+            malas++;
+        }
+    }
+    fclose(f);
+    if (descartadas)
+        *descartadas = malas;
+    return 0;
+}
+
+static int comparar_eventos(const void *pa, const void *pb)
+{
+    const EVENTO *a = pa, *b = pb;
+
+    if (a->tiempo != b->tiempo)
+        return a->tiempo < b->tiempo ? -1 : 1;
+    return a->orden - b->orden;
+}
+
+/* Estado de la reproduccion: lo que toco el lote actual, buffers y la foto inicial para restaurar */
+typedef struct REPRODUCCION
+{
+    GRAFO *grafo;
+    CANAL_VISOR *canal;
+    FILE *salida;
+    unsigned sello;          /* numero de control en curso */
+    unsigned *marca_arista;  /* == sello si la arista empeoro en este lote */
+    unsigned *marca_vertice; /* == sello si el vertice cayo en este lote */
+    int mejoras;             /* el lote tiene restauraciones o latencias menores */
+    int cambios_estado;      /* caidas o restauraciones en el lote */
+    int eventos_lote;
+    int *mejoradas; /* aristas restauradas o abaratadas en el lote */
+    int num_mejoradas, capacidad_mejoradas;
+    int sin_lista;  /* no hubo memoria para la lista: se recalcula todo si hay mejoras */
+    int *latencia_minima; /* pesos del grafo suelo */
+    float **cota_desde, **cota_hacia; /* por sonda de ruta, NULL si no hay cotas */
+    int num_sondas;
+    int cabecera;            /* ya se imprimio la cabecera de este control */
+    double tiempo;           /* instante del control en curso */
+    SONDA **pendientes;
+    int *anterior;
+    double *distancia;
+    int *impacto;
+    RECORRIDO recorrido;
+    uint64_t *activo_inicial;
+    unsigned char *vertice_inicial;
+    int *latencia_inicial, *ancho_banda_inicial;
+    float *fiabilidad_inicial;
+} REPRODUCCION;
+
+static void anotar_mejora(REPRODUCCION *r, int e)
+{
+    int *tmp, nueva;
+
+    if (r->sin_lista)
+        return;
+    if (r->num_mejoradas == r->capacidad_mejoradas)
+    {
+        nueva = r->capacidad_mejoradas ? r->capacidad_mejoradas * 2 : 64;
+        tmp = realloc(r->mejoradas, sizeof(int) * nueva);
+        if (!tmp)
+        {
+            r->sin_lista = 1;
+            return;
+        }
+        r->mejoradas = tmp;
+        r->capacidad_mejoradas = nueva;
+    }
+    r->mejoradas[r->num_mejoradas++] = e;
+}
+
+static void aplicar_evento(REPRODUCCION *r, const EVENTO *ev)
+{
+    GRAFO *g = r->grafo;
+    ARISTAS *a = &g->aristas;
+    int k, e;
+
+    r->eventos_lote++;
+    if (ev->tipo == EV_NODO_CAIDO || ev->tipo == EV_NODO_RESTAURADO)
+    {
+        if (ev->tipo == EV_NODO_CAIDO)
+            r->marca_vertice[ev->vertice] = r->sello;
+        else
+        {
+            /* un nodo que vuelve mejora todos sus enlaces */
+            r->mejoras = 1;
+            for (e = g->vertices[ev->vertice].primera_arista; e != -1; e = a->siguiente[e])
+                anotar_mejora(r, e);
+            for (e = g->vertices[ev->vertice].primera_entrante; e != -1; e = a->siguiente_entrante[e])
+                anotar_mejora(r, e);
+        }
+        r->cambios_estado++;
+        establecer_estado_vertice(g, ev->vertice, ev->tipo == EV_NODO_RESTAURADO);
+        if (r->canal)
+            visor_estado_vertice(r->canal, g, ev->vertice);
+        return;
+    }
+    for (k = 0; k < 2; ++k)
+    {
+        e = ev->arista[k];
+        if (e == -1)
+            continue;
+        if (ev->tipo == EV_ENLACE_CAIDO)
+        {
+            ARISTA_DESACTIVAR(g, e);
+            r->marca_arista[e] = r->sello;
+            r->cambios_estado++;
+        }
+        else if (ev->tipo == EV_ENLACE_RESTAURADO)
+        {
+            ARISTA_ACTIVAR(g, e);
+            r->mejoras = 1;
+            anotar_mejora(r, e);
+            r->cambios_estado++;
+        }
+        else
+        {
+            if (ev->latencia_ms >= 0)
+            {
+                if (ev->latencia_ms < a->latencia_ms[e])
+                {
+                    r->mejoras = 1;
+                    anotar_mejora(r, e);
+                }
+                else if (ev->latencia_ms > a->latencia_ms[e])
+                    r->marca_arista[e] = r->sello;
+                if (ev->latencia_ms != a->latencia_ms[e])
+                    g->version++; /* las tablas de reenvio dependen de la latencia */
+                a->latencia_ms[e] = ev->latencia_ms;
+            }
+            if (ev->ancho_banda_mbps >= 0)
+                a->ancho_banda_mbps[e] = ev->ancho_banda_mbps;
+            if (ev->fiabilidad >= 0.0f)
+                a->fiabilidad[e] = ev->fiabilidad;
+        }
+        if (r->canal)
+        {
+            if (ev->tipo == EV_METRICA)
+                visor_arista(r->canal, g, e);
+            else
+                visor_estado_arista(r->canal, g, e);
+        }
+    }
+}
+
+static void imprimir_ruta_sonda(FILE *salida, const GRAFO *grafo, const SONDA *s)
+{
+    int i;
+
+    if (s->longitud == 0)
+    {
+        fprintf(salida, "sin camino");
+        return;
+    }
+    for (i = 0; i < s->longitud; ++i)
+        fprintf(salida, "%s%s", i ? " -> " : "", grafo->datos[s->camino[i]].nombre);
+    fprintf(salida, " (%.1f ms)", s->latencia);
+}
+
+/* La cabecera del control solo sale si hay algo que contar */
+static void cabecera_control(REPRODUCCION *r, int inicial, int control)
+{
+    int h, mi;
+    double seg;
+
+    if (r->cabecera)
+        return;
+    r->cabecera = 1;
+    if (inicial)
+    {
+        fprintf(r->salida, "[ESCENARIO] Estado inicial:\n");
+        return;
+    }
+    h = (int)(r->tiempo / 3600.0);
+    mi = (int)((r->tiempo - h * 3600.0) / 60.0);
+    seg = r->tiempo - h * 3600.0 - mi * 60.0;
+    fprintf(r->salida, "[t=%02d:%02d:%06.3f] control %d: %d eventos\n", h, mi, seg, control, r->eventos_lote);
+}
+
+/* Con un lote que solo empeora, una ruta minima que no pasa por nada tocado sigue siendo minima */
+static int ruta_tocada(const REPRODUCCION *r, const SONDA *s)
+{
+    int i;
+
+    if (s->longitud == 0)
+        return 0; /* sin mejoras no puede aparecer un camino */
+    for (i = 0; i < s->longitud; ++i)
+        if (r->marca_vertice[s->camino[i]] == r->sello)
+            return 1;
+    for (i = 0; i < s->longitud - 1; ++i)
+        if (s->aristas[i] == -1 || r->marca_arista[s->aristas[i]] == r->sello)
+            return 1;
+    return 0;
+}
+
+/* Alguna mejora del lote puede dar a la sonda (indice i) un camino mas corto que el actual */
+static int mejora_posible(const REPRODUCCION *r, int i, const SONDA *s)
+{
+    const GRAFO *g = r->grafo;
+    const float *desde, *hacia;
+    double coste;
+    int k, e;
+
+    if (!r->mejoras)
+        return 0;
+    if (r->sin_lista || !r->cota_desde)
+        return 1;
+    desde = r->cota_desde[i];
+    hacia = r->cota_hacia[i];
+    coste = s->longitud ? s->latencia : DBL_MAX;
+    for (k = 0; k < r->num_mejoradas; ++k)
+    {
+        e = r->mejoradas[k];
+        if (!ARISTA_ACTIVA(g, e) || !g->vertices[g->aristas.origen[e]].activo || !g->vertices[g->aristas.destino[e]].activo)
+            continue;
+        if ((double)desde[g->aristas.origen[e]] + r->latencia_minima[e] + (double)hacia[g->aristas.destino[e]] < coste)
+            return 1;
+    }
+    return 0;
+}
+
+/*
+ * Dijkstra con objetivo (A*) para una sola ruta: la cota hacia el destino en
+ * el grafo suelo es consistente (ninguna latencia baja de su minimo), asi que
+ * al extraer el destino su distancia es la optima. Los vertices sin camino
+ * al destino ni en el suelo no se exploran. Deja distancia/anterior como
+ * dijkstra_latencia para los vertices asentados.
+ */
+static void dijkstra_dirigido(const VISTA_latencia *vista, int origen, int destino, const float *hacia, MONTICULO *m, int *anterior, double *distancia)
+{
+    int i, u, v, fin;
+    double clave, d, nd;
+    INSTR_LOCAL(asentados);
+    INSTR_LOCAL(relajadas);
+
+    for (i = 0; i < vista->num_vertices; ++i)
+    {
+        distancia[i] = DBL_MAX;
+        anterior[i] = -1;
+    }
+    m->tam = 0;
+    if (isinf(hacia[origen]))
+        return;
+    distancia[origen] = 0.0;
+    monticulo_insertar(m, hacia[origen], origen);
+    while (monticulo_extraer(m, &clave, &u) == 0)
+    {
+        d = distancia[u];
+        if (clave > d + hacia[u])
+            continue;
+        if (u == destino)
+            break;
+        fin = vista->inicio[u + 1];
+        INSTR_CONTAR(asentados, 1);
+        INSTR_CONTAR(relajadas, fin - vista->inicio[u]);
+        for (i = vista->inicio[u]; i < fin; ++i)
+        {
+            v = vista->destino[i];
+            nd = d + (double)vista->peso[i];
+            if (nd < distancia[v] && !isinf(hacia[v]))
+            {
+                distancia[v] = nd;
+                anterior[v] = u;
+                monticulo_insertar(m, nd + hacia[v], v);
+            }
+        }
+    }
+    INSTR_SUMAR(vertices_asentados, asentados);
+    INSTR_SUMAR(aristas_relajadas, relajadas);
+}
+
+static int comparar_sondas_origen(const void *pa, const void *pb)
+{
+    const SONDA *a = *(SONDA *const *)pa, *b = *(SONDA *const *)pb;
+    return a->origen - b->origen;
+}
+
+/*
+ * Arista que usa la ruta entre dos saltos: con enlaces paralelos Dijkstra
+ * relaja todos y se queda con el de menor latencia, que es el que hay que
+ * vigilar en ruta_tocada (el primero activo podria ser otro).
+ */
+static int arista_mas_rapida(const GRAFO *g, int u, int v)
+{
+    int e, mejor;
+
+    mejor = -1;
+    for (e = g->vertices[u].primera_arista; e != -1; e = g->aristas.siguiente[e])
+        if (g->aristas.destino[e] == v && ARISTA_ACTIVA(g, e) &&
+            (mejor == -1 || g->aristas.latencia_ms[e] < g->aristas.latencia_ms[mejor]))
+            mejor = e;
+    return mejor;
+}
+
+static void recalcular_ruta(REPRODUCCION *r, SONDA *s, int inicial, int control, RESUMEN_ESCENARIO *resumen)
+{
+    GRAFO *g = r->grafo;
+    int previa[MAX_CAMINO_SONDA], longitud_previa, i;
+    double latencia_previa;
+
+    longitud_previa = s->longitud;
+    memcpy(previa, s->camino, sizeof(int) * longitud_previa);
+    latencia_previa = s->latencia;
+
+    s->longitud = 0;
+    if (g->vertices[s->origen].activo && g->vertices[s->destino].activo && r->distancia[s->destino] < DBL_MAX / 2)
+    {
+        s->longitud = reconstruir_camino(r->anterior, s->destino, s->camino, MAX_CAMINO_SONDA);
+        if (s->longitud < 0)
+            s->longitud = 0;
+    }
+    s->latencia = s->longitud ? r->distancia[s->destino] : 0.0;
+    for (i = 0; i < s->longitud - 1; ++i)
+        s->aristas[i] = arista_mas_rapida(g, s->camino[i], s->camino[i + 1]);
+    resumen->rutas_evaluadas++;
+
+    if (!inicial && caminos_iguales(previa, longitud_previa, s->camino, s->longitud))
+        return;
+    cabecera_control(r, inicial, control);
+    fprintf(r->salida, "  ruta %s -> %s: ", g->datos[s->origen].nombre, g->datos[s->destino].nombre);
+    if (!inicial)
+    {
+        resumen->cambios_ruta++;
+        if (longitud_previa == 0)
+            fprintf(r->salida, "sin camino");
+        else
+        {
+            for (i = 0; i < longitud_previa; ++i)
+                fprintf(r->salida, "%s%s", i ? " -> " : "", g->datos[previa[i]].nombre);
+            fprintf(r->salida, " (%.1f ms)", latencia_previa);
+        }
+        fprintf(r->salida, " => ");
+    }
+    imprimir_ruta_sonda(r->salida, g, s);
+    fprintf(r->salida, "\n");
+}
+
+static void recalcular_resiliencia(REPRODUCCION *r, SONDA *s, int inicial, int control)
+{
+    GRAFO *g = r->grafo;
+    int i, inicio, alcanzables, critico;
+
+    inicio = -1;
+    for (i = 0; i < g->num_vertices && inicio == -1; ++i)
+        if (g->vertices[i].activo)
+            inicio = i;
+    alcanzables = 0;
+    critico = -1;
+    if (inicio != -1 && (alcanzables = analizar_impacto_fallos(g, inicio, r->impacto)) > 0)
+        for (i = 0; i < g->num_vertices; ++i)
+            if (r->impacto[i] > 0 && (critico == -1 || r->impacto[i] > r->impacto[critico]))
+                critico = i;
+    if (!inicial && alcanzables == s->alcanzables && critico == s->critico &&
+        (critico == -1 || r->impacto[critico] == s->impacto))
+        return;
+    cabecera_control(r, inicial, control);
+    fprintf(r->salida, "  resiliencia: %d alcanzables", alcanzables);
+    if (critico != -1)
+        fprintf(r->salida, ", critico %s (impacto %d)", g->datos[critico].nombre, r->impacto[critico]);
+    else
+        fprintf(r->salida, ", sin nodo critico");
+    if (!inicial)
+        fprintf(r->salida, " (antes %d alcanzables, critico %s)", s->alcanzables,
+                s->critico != -1 ? g->datos[s->critico].nombre : "ninguno");
+    fprintf(r->salida, "\n");
+    s->alcanzables = alcanzables;
+    s->critico = critico;
+    s->impacto = critico != -1 ? r->impacto[critico] : 0;
+}
+
+/* Punto de control: reevalua las sondas afectadas por el lote e informa de lo que cambio */
+static int evaluar_sondas(REPRODUCCION *r, ESCENARIO *esc, int inicial, int control, RESUMEN_ESCENARIO *resumen)
+{
+    GRAFO *g = r->grafo;
+    VISTA_latencia vista;
+    MONTICULO m;
+    SONDA *s;
+    int i, j, k, num, alcanzables;
+
+    r->cabecera = 0;
+    num = 0;
+    for (i = 0; i < esc->num_sondas; ++i)
+    {
+        s = &esc->sondas[i];
+        if (s->tipo == SONDA_RUTA)
+            s->pendiente = inicial || ruta_tocada(r, s) || mejora_posible(r, i, s);
+        else
+            s->pendiente = inicial || r->cambios_estado > 0;
+        if (s->tipo == SONDA_RUTA && s->pendiente)
+            r->pendientes[num++] = s;
+    }
+
+    /* rutas: una vista por control y un Dijkstra por origen distinto */
+    if (num > 0)
+    {
+        if (construir_vista_latencia(g, &vista) != 0)
+            return -1;
+        if (monticulo_iniciar(&m, vista.num_aristas + 1) != 0)
+        {
+            liberar_vista_latencia(&vista);
+            return -1;
+        }
+        qsort(r->pendientes, num, sizeof(SONDA *), comparar_sondas_origen);
+        for (i = 0; i < num; i = j)
+        {
+            for (j = i; j < num && r->pendientes[j]->origen == r->pendientes[i]->origen; ++j)
+                ;
+            /* una sola ruta desde este origen: busqueda dirigida al destino */
+            s = r->pendientes[i];
+            if (j - i == 1 && r->cota_hacia)
+                dijkstra_dirigido(&vista, s->origen, s->destino, r->cota_hacia[s - esc->sondas], &m, r->anterior, r->distancia);
+            else
+                dijkstra_latencia(&vista, s->origen, j - i == 1 ? s->destino : -1, &m, r->anterior, r->distancia);
+            resumen->dijkstras++;
+            for (k = i; k < j; ++k)
+                recalcular_ruta(r, r->pendientes[k], inicial, control, resumen);
+        }
+        monticulo_liberar(&m);
+        liberar_vista_latencia(&vista);
+    }
+
+    for (i = 0; i < esc->num_sondas; ++i)
+    {
+        s = &esc->sondas[i];
+        if (!s->pendiente || s->tipo == SONDA_RUTA)
+            continue;
+        if (s->tipo == SONDA_RESILIENCIA)
+        {
+            recalcular_resiliencia(r, s, inicial, control);
+            continue;
+        }
+        alcanzables = contar_alcanzables_desde(g, &r->recorrido, s->origen);
+        if (!inicial && alcanzables == s->alcanzables)
+            continue;
+        cabecera_control(r, inicial, control);
+        fprintf(r->salida, "  alcance %s: ", g->datos[s->origen].nombre);
+        if (!inicial)
+            fprintf(r->salida, "%d -> ", s->alcanzables);
+        fprintf(r->salida, "%d nodos\n", alcanzables);
+        s->alcanzables = alcanzables;
+    }
+    return 0;
+}
+
+static void cerrar_lote(REPRODUCCION *r)
+{
+    r->sello++;
+    r->mejoras = 0;
+    r->cambios_estado = 0;
+    r->eventos_lote = 0;
+    r->num_mejoradas = 0;
+    r->sin_lista = 0;
+    if (r->canal)
+        visor_fin_lote(r->canal);
+}
+
+static void liberar_reproduccion(REPRODUCCION *r)
+{
+    int i;
+
+    free(r->marca_arista);
+    free(r->marca_vertice);
+    free(r->pendientes);
+    free(r->anterior);
+    free(r->distancia);
+    free(r->impacto);
+    free(r->mejoradas);
+    free(r->latencia_minima);
+    if (r->cota_desde)
+        for (i = 0; i < r->num_sondas; ++i)
+        {
+            free(r->cota_desde[i]);
+            free(r->cota_hacia[i]);
+        }
+    free(r->cota_desde);
+    free(r->cota_hacia);
+    liberar_recorrido(&r->recorrido);
+    free(r->activo_inicial);
+    free(r->vertice_inicial);
+    free(r->latencia_inicial);
+    free(r->ancho_banda_inicial);
+    free(r->fiabilidad_inicial);
+}
+
+/* CSR del grafo suelo (todo activo, pesos dados), directa o inversa, para dijkstra_latencia */
+static int construir_vista_suelo(const GRAFO *g, const int *peso, int inversa, VISTA_latencia *vista)
+{
+    const ARISTAS *a = &g->aristas;
+    int n, u, e, k;
+
+    memset(vista, 0, sizeof(*vista));
+    n = g->num_vertices;
+    vista->inicio = malloc(sizeof(int) * (n + 1));
+    vista->destino = malloc(sizeof(int) * (a->num + 1));
+    vista->peso = malloc(sizeof(int) * (a->num + 1));
+    if (!vista->inicio || !vista->destino || !vista->peso)
+    {
+        liberar_vista_latencia(vista);
+        return -1;
+    }
+    k = 0;
+    for (u = 0; u < n; ++u)
+    {
+        vista->inicio[u] = k;
+        for (e = inversa ? g->vertices[u].primera_entrante : g->vertices[u].primera_arista; e != -1;
+             e = inversa ? a->siguiente_entrante[e] : a->siguiente[e])
+        {
+            vista->destino[k] = inversa ? a->origen[e] : a->destino[e];
+            vista->peso[k] = peso[e];
+            ++k;
+        }
+    }
+    vista->inicio[n] = k;
+    vista->num_vertices = n;
+    vista->num_aristas = k;
+    return 0;
+}
+
+/*
+ * Distancias en el grafo suelo desde el origen y hacia el destino de cada
+ * ruta. Sin memoria (o por encima de MAX_MEMORIA_COTAS) no hay cotas y las
+ * mejoras recalculan todas las rutas.
+ */
+static void calcular_cotas(REPRODUCCION *r, ESCENARIO *esc)
+{
+    GRAFO *g = r->grafo;
+    VISTA_latencia directa, inversa;
+    MONTICULO m;
+    const EVENTO *ev;
+    SONDA *s;
+    int i, j, k, n, rutas, ok;
+
+    n = g->num_vertices;
+    rutas = 0;
+    for (i = 0; i < esc->num_sondas; ++i)
+        rutas += esc->sondas[i].tipo == SONDA_RUTA;
+    if (rutas == 0 || (double)rutas * n * 2 * sizeof(float) > (double)MAX_MEMORIA_COTAS)
+        return;
+
+    r->latencia_minima = malloc(sizeof(int) * (g->aristas.num + 1));
+    if (!r->latencia_minima)
+        return;
+    memcpy(r->latencia_minima, g->aristas.latencia_ms, sizeof(int) * g->aristas.num);
+    for (i = 0; i < esc->num_eventos; ++i)
+    {
+        ev = &esc->eventos[i];
+        if (ev->tipo != EV_METRICA || ev->latencia_ms < 0)
+            continue;
+        for (k = 0; k < 2; ++k)
+            if (ev->arista[k] != -1 && ev->latencia_ms < r->latencia_minima[ev->arista[k]])
+                r->latencia_minima[ev->arista[k]] = ev->latencia_ms;
+    }
+
+    r->cota_desde = calloc(esc->num_sondas, sizeof(float *));
+    r->cota_hacia = calloc(esc->num_sondas, sizeof(float *));
+    ok = r->cota_desde && r->cota_hacia;
+    if (ok && construir_vista_suelo(g, r->latencia_minima, 0, &directa) != 0)
+        ok = 0;
+    else if (ok && construir_vista_suelo(g, r->latencia_minima, 1, &inversa) != 0)
+    {
+        liberar_vista_latencia(&directa);
+        ok = 0;
+    }
+    else if (ok && monticulo_iniciar(&m, directa.num_aristas + 1) != 0)
+    {
+        liberar_vista_latencia(&directa);
+        liberar_vista_latencia(&inversa);
+        ok = 0;
+    }
+    if (ok)
+    {
+        for (i = 0; ok && i < esc->num_sondas; ++i)
+        {
+            s = &esc->sondas[i];
+            if (s->tipo != SONDA_RUTA)
+                continue;
+            r->cota_desde[i] = malloc(sizeof(float) * n);
+            r->cota_hacia[i] = malloc(sizeof(float) * n);
+            ok = r->cota_desde[i] && r->cota_hacia[i];
+            if (!ok)
+                break;
+            /* las distancias son sumas de enteros: exactas en float hasta 2^24 ms */
+            dijkstra_latencia(&directa, s->origen, -1, &m, r->anterior, r->distancia);
+            for (j = 0; j < n; ++j)
+                r->cota_desde[i][j] = r->distancia[j] < DBL_MAX / 2 ? (float)r->distancia[j] : INFINITY;
+            dijkstra_latencia(&inversa, s->destino, -1, &m, r->anterior, r->distancia);
+            for (j = 0; j < n; ++j)
+                r->cota_hacia[i][j] = r->distancia[j] < DBL_MAX / 2 ? (float)r->distancia[j] : INFINITY;
+        }
+        monticulo_liberar(&m);
+        liberar_vista_latencia(&directa);
+        liberar_vista_latencia(&inversa);
+    }
+    if (!ok)
+    {
+        /* con cotas incompletas se trabaja sin ninguna */
+        for (i = 0; r->cota_desde && r->cota_hacia && i < esc->num_sondas; ++i)
+        {
+            free(r->cota_desde[i]);
+            free(r->cota_hacia[i]);
+        }
+        free(r->cota_desde);
+        free(r->cota_hacia);
+        r->cota_desde = NULL;
+        r->cota_hacia = NULL;
+    }
+}
+
+/* Vuelve al estado previo al escenario; solo se envia al visor lo que difiere */
+static void restaurar_estado(REPRODUCCION *r)
+{
+    GRAFO *g = r->grafo;
+    ARISTAS *a = &g->aristas;
+    int i, e;
+
+    for (i = 0; i < g->num_vertices; ++i)
+    {
+        if (g->vertices[i].activo == r->vertice_inicial[i])
+            continue;
+        establecer_estado_vertice(g, i, r->vertice_inicial[i]);
+        if (r->canal)
+            visor_estado_vertice(r->canal, g, i);
+    }
+    for (e = 0; e < a->num; ++e)
+    {
+        if (((a->activo[e >> 6] ^ r->activo_inicial[e >> 6]) >> (e & 63)) & 1u)
+        {
+            a->activo[e >> 6] ^= UINT64_C(1) << (e & 63);
+            g->version++;
+            if (r->canal)
+                visor_estado_arista(r->canal, g, e);
+        }
+        if (r->latencia_inicial &&
+            (a->latencia_ms[e] != r->latencia_inicial[e] || a->ancho_banda_mbps[e] != r->ancho_banda_inicial[e] ||
+             a->fiabilidad[e] != r->fiabilidad_inicial[e]))
+        {
+            if (a->latencia_ms[e] != r->latencia_inicial[e])
+                g->version++;
+            a->latencia_ms[e] = r->latencia_inicial[e];
+            a->ancho_banda_mbps[e] = r->ancho_banda_inicial[e];
+            a->fiabilidad[e] = r->fiabilidad_inicial[e];
+            if (r->canal)
+                visor_arista(r->canal, g, e);
+        }
+    }
+    if (r->canal)
+        visor_fin_lote(r->canal);
+}
+
+int reproducir_escenario(GRAFO *grafo, ESCENARIO *esc, double intervalo, int mantener, CANAL_VISOR *canal, FILE *salida, RESUMEN_ESCENARIO *resumen)
+{
+    REPRODUCCION r;
+    struct timespec t0, t1;
+    EVENTO *ev;
+    int i, n, m, palabras, hay_metricas, ok;
+    double proximo;
+
+    memset(resumen, 0, sizeof(*resumen));
+    memset(&r, 0, sizeof(r));
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    n = grafo->num_vertices;
+    m = grafo->aristas.num;
+    palabras = (m + 63) / 64;
+    hay_metricas = 0;
+    for (i = 0; i < esc->num_eventos; ++i)
+        hay_metricas |= esc->eventos[i].tipo == EV_METRICA;
+
+    r.grafo = grafo;
+    r.canal = canal && visor_activo(canal) ? canal : NULL;
+    r.salida = salida;
+    r.sello = 1;
+    r.num_sondas = esc->num_sondas;
+    r.marca_arista = calloc(m + 1, sizeof(unsigned));
+    r.marca_vertice = calloc(n + 1, sizeof(unsigned));
+    r.pendientes = malloc(sizeof(SONDA *) * (esc->num_sondas + 1));
+    r.anterior = malloc(sizeof(int) * (n + 1));
+    r.distancia = malloc(sizeof(double) * (n + 1));
+    r.impacto = malloc(sizeof(int) * (n + 1));
+    ok = r.marca_arista && r.marca_vertice && r.pendientes && r.anterior && r.distancia && r.impacto &&
+         iniciar_recorrido(&r.recorrido, n) == 0;
+    if (ok && !mantener)
+    {
+        r.activo_inicial = malloc(sizeof(uint64_t) * (palabras + 1));
+        r.vertice_inicial = malloc(n + 1);
+        ok = r.activo_inicial && r.vertice_inicial;
+        if (ok && hay_metricas)
+        {
+            r.latencia_inicial = malloc(sizeof(int) * (m + 1));
+            r.ancho_banda_inicial = malloc(sizeof(int) * (m + 1));
+            r.fiabilidad_inicial = malloc(sizeof(float) * (m + 1));
+            ok = r.latencia_inicial && r.ancho_banda_inicial && r.fiabilidad_inicial;
+            if (ok && m > 0)
+            {
+                memcpy(r.latencia_inicial, grafo->aristas.latencia_ms, sizeof(int) * m);
+                memcpy(r.ancho_banda_inicial, grafo->aristas.ancho_banda_mbps, sizeof(int) * m);
+                memcpy(r.fiabilidad_inicial, grafo->aristas.fiabilidad, sizeof(float) * m);
+            }
+        }
+        if (ok)
+        {
+            if (palabras > 0)
+                memcpy(r.activo_inicial, grafo->aristas.activo, sizeof(uint64_t) * palabras);
+            for (i = 0; i < n; ++i)
+                r.vertice_inicial[i] = grafo->vertices[i].activo;
+        }
+    }
+    if (ok)
+        calcular_cotas(&r, esc);
+    if (!ok || evaluar_sondas(&r, esc, 1, 0, resumen) != 0)
+    {
+        liberar_reproduccion(&r);
+        return -1;
+    }
+    cerrar_lote(&r);
+
+    qsort(esc->eventos, esc->num_eventos, sizeof(EVENTO), comparar_eventos);
+    proximo = intervalo > 0 ? intervalo : DBL_MAX;
+    for (i = 0; ok && i < esc->num_eventos; ++i)
+    {
+        ev = &esc->eventos[i];
+        if (ev->tiempo >= proximo)
+        {
+            /* el control de las hh:mm cubre lo anterior; los intervalos vacios no cuestan nada */
+            if (r.eventos_lote > 0)
+            {
+                r.tiempo = proximo;
+                ok = evaluar_sondas(&r, esc, 0, ++resumen->controles, resumen) == 0;
+                cerrar_lote(&r);
+            }
+            proximo = (floor(ev->tiempo / intervalo) + 1.0) * intervalo;
+        }
+        if (ev->tipo == EV_CONTROL)
+        {
+            if (r.eventos_lote > 0)
+            {
+                r.tiempo = ev->tiempo;
+                ok = evaluar_sondas(&r, esc, 0, ++resumen->controles, resumen) == 0;
+                cerrar_lote(&r);
+            }
+            continue;
+        }
+        aplicar_evento(&r, ev);
+        resumen->eventos++;
+    }
+    if (ok && r.eventos_lote > 0)
+    {
+        r.tiempo = esc->eventos[esc->num_eventos - 1].tiempo;
+        ok = evaluar_sondas(&r, esc, 0, ++resumen->controles, resumen) == 0;
+        cerrar_lote(&r);
+    }
+    if (!mantener)
+        restaurar_estado(&r);
+    liberar_reproduccion(&r);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    resumen->ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+    return ok ? 0 : -1;
+}
+
+#endif
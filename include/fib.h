@@ -0,0 +1,321 @@
+#ifndef FIB_H
+#define FIB_H
+
+#include "grafos.h"
+#include "dijkstra.h"
+
+/*
+ * Tablas de reenvio (FIB) por dispositivo con busqueda de prefijo mas largo.
+ * Cada tabla sale del arbol de caminos minimos (latencia) del propio
+ * dispositivo: una ruta /32 por destino alcanzable con su primer salto, y la
+ * propia IP como entrega local. Los prefijos hermanos con el mismo siguiente
+ * salto se agregan (dos /32 alineados -> un /31, etc.) sin cambiar el
+ * resultado de ninguna busqueda.
+ *
+ * Estructura: trie multibit de paso 8 (DIR-8-8-8-8) con empuje a hojas.
+ * Cada nodo son 256 entradas de 32 bits; una entrada es un hijo (bit alto) o
+ * un siguiente salto ya resuelto, asi que una busqueda son como mucho cuatro
+ * lecturas y ninguna comparacion de prefijos. Los nodos solo se crean donde
+ * hay prefijos mas largos que el nivel, por lo que una tabla tipica ocupa
+ * unos pocos KB (un DIR-24-8 completo serian 32 MB por dispositivo).
+ */
+#define FIB_HIJO 0x80000000u
+#define FIB_SIN_RUTA 0u
+
+typedef struct FIB
+{
+    uint32_t *nodos;   /* num_nodos * 256 entradas; el nodo 0 es la raiz */
+    int num_nodos;
+    int capacidad_nodos;
+    int num_prefijos;  /* prefijos tras la agregacion */
+    int num_rutas;     /* rutas /32 antes de agregar */
+} FIB;
+
+typedef struct TABLAS_REENVIO
+{
+    int num_vertices;
+    FIB *fib;         /* una por vertice; vacia si el vertice esta fallido */
+    unsigned version; /* grafo->version al construirlas */
+    int valido;
+} TABLAS_REENVIO;
+
+int fib_iniciar(FIB *fib);
+void fib_liberar(FIB *fib);
+/* Inserta prefijo/longitud -> siguiente salto; hay que insertar de menor a mayor longitud */
+int fib_insertar(FIB *fib, uint32_t prefijo, int longitud, int siguiente);
+/* Siguiente salto para ip, -1 si no hay ruta */
+static inline int fib_buscar(const FIB *fib, uint32_t ip);
+
+int construir_tablas_reenvio(GRAFO *grafo, TABLAS_REENVIO *tablas);
+void liberar_tablas_reenvio(TABLAS_REENVIO *tablas);
+/* Rehace las tablas si el grafo cambio desde que se construyeron; -1 sin memoria */
+int actualizar_tablas_reenvio(GRAFO *grafo, TABLAS_REENVIO *tablas);
+
+// Implementaciones
+
+static inline int fib_buscar(const FIB *fib, uint32_t ip)
+{
+    uint32_t e;
+
+    e = fib->nodos[ip >> 24];
+    if (e & FIB_HIJO)
+    {
+        e = fib->nodos[(size_t)(e & ~FIB_HIJO) * 256 + ((ip >> 16) & 255)];
+        if (e & FIB_HIJO)
+        {
+            e = fib->nodos[(size_t)(e & ~FIB_HIJO) * 256 + ((ip >> 8) & 255)];
+            if (e & FIB_HIJO)
+                e = fib->nodos[(size_t)(e & ~FIB_HIJO) * 256 + (ip & 255)];
+        }
+    }
+    return (int)e - 1;
+}
+
+static int fib_nuevo_nodo(FIB *fib, uint32_t relleno)
+{
+    int i, nueva;
+    uint32_t *tmp;
+
+    if (fib->num_nodos == fib->capacidad_nodos)
+    {
+        nueva = fib->capacidad_nodos ? fib->capacidad_nodos * 2 : 4;
+        tmp = realloc(fib->nodos, sizeof(uint32_t) * 256 * (size_t)nueva);
+        if (!tmp)
+            return -1;
+        fib->nodos = tmp;
+        fib->capacidad_nodos = nueva;
+    }
+    for (i = 0; i < 256; ++i)
+        fib->nodos[(size_t)fib->num_nodos * 256 + i] = relleno;
+    return fib->num_nodos++;
+}
+
+int fib_iniciar(FIB *fib)
+{
+    memset(fib, 0, sizeof(*fib));
+    return fib_nuevo_nodo(fib, FIB_SIN_RUTA) == 0 ? 0 : -1;
+}
+
+void fib_liberar(FIB *fib)
+{
+    if (!fib)
+        return;
+    free(fib->nodos);
+    memset(fib, 0, sizeof(*fib));
+}
+
+/* Rellena una entrada; si es un hijo, todo su subarbol (empuje a hojas) */
+static void fib_rellenar(FIB *fib, size_t posicion, uint32_t valor)
+{
+    int i;
+    uint32_t e = fib->nodos[posicion];
+
+    if (!(e & FIB_HIJO))
+    {
+        fib->nodos[posicion] = valor;
+        return;
+    }
+    for (i = 0; i < 256; ++i)
+        fib_rellenar(fib, (size_t)(e & ~FIB_HIJO) * 256 + i, valor);
+}
+
+int fib_insertar(FIB *fib, uint32_t prefijo, int longitud, int siguiente)
+{
+    int nivel, nodo, hijo, desplazamiento;
+    uint32_t byte, span, base, i, valor;
+    size_t pos;
+
+    if (longitud < 0 || longitud > 32 || siguiente < 0)
+        return -1;
+    valor = (uint32_t)siguiente + 1;
+    nodo = 0;
+    nivel = 0;
+    while (longitud > 8 * (nivel + 1))
+    {
+        byte = (prefijo >> (24 - 8 * nivel)) & 255;
+        pos = (size_t)nodo * 256 + byte;
+        if (!(fib->nodos[pos] & FIB_HIJO))
+        {
+            hijo = fib_nuevo_nodo(fib, fib->nodos[pos]);
+            if (hijo < 0)
+                return -1;
+            fib->nodos[pos] = FIB_HIJO | (uint32_t)hijo;
+        }
+        nodo = (int)(fib->nodos[pos] & ~FIB_HIJO);
+        nivel++;
+    }
+    desplazamiento = 8 * (nivel + 1) - longitud;
+    span = UINT32_C(1) << desplazamiento;
+    byte = (prefijo >> (24 - 8 * nivel)) & 255;
+    base = byte & ~(span - 1);
+    for (i = base; i < base + span; ++i)
+        fib_rellenar(fib, (size_t)nodo * 256 + i, valor);
+    return 0;
+}
+
+typedef struct RUTA_FIB
+{
+    uint32_t prefijo;
+    int longitud;
+    int siguiente;
+} RUTA_FIB;
+
+static int comparar_rutas_fib(const void *a, const void *b)
+{
+    const RUTA_FIB *x = a, *y = b;
+    if (x->prefijo != y->prefijo)
+        return x->prefijo < y->prefijo ? -1 : 1;
+    return x->longitud - y->longitud;
+}
+
+static int comparar_rutas_longitud(const void *a, const void *b)
+{
+    const RUTA_FIB *x = a, *y = b;
+    if (x->longitud != y->longitud)
+        return x->longitud - y->longitud;
+    return x->prefijo < y->prefijo ? -1 : (x->prefijo > y->prefijo);
+}
+
+/*
+ * Agregacion estricta con una pila: las rutas llegan ordenadas por direccion;
+ * mientras las dos de la cima sean hermanas (misma longitud, mismo padre) con
+ * el mismo siguiente salto, se sustituyen por el padre.
+ */
+static int agregar_rutas(RUTA_FIB *rutas, int num)
+{
+    int i, cima;
+    uint32_t mascara;
+
+    cima = 0;
+    for (i = 0; i < num; ++i)
+    {
+        /* la misma IP en dos dispositivos: se queda la primera */
+        if (cima > 0 && rutas[cima - 1].prefijo == rutas[i].prefijo && rutas[cima - 1].longitud == rutas[i].longitud)
+            continue;
+        rutas[cima++] = rutas[i];
+        while (cima >= 2)
+        {
+            RUTA_FIB *a = &rutas[cima - 2], *b = &rutas[cima - 1];
+            if (a->longitud != b->longitud || a->longitud == 0 || a->siguiente != b->siguiente)
+                break;
+            mascara = UINT32_C(1) << (32 - a->longitud);
+            if ((a->prefijo & mascara) != 0 || (a->prefijo | mascara) != b->prefijo)
+                break;
+            a->longitud--;
+            cima--;
+        }
+    }
+    return cima;
+}
+
+int construir_tablas_reenvio(GRAFO *grafo, TABLAS_REENVIO *tablas)
+{
+    int n, r, v, num, i, *anterior, *primero, *pila;
+    double *distancia;
+    RUTA_FIB *rutas;
+    VISTA_latencia vista;
+    MONTICULO m;
+
+    if (!grafo || !tablas)
+        return -1;
+    memset(tablas, 0, sizeof(*tablas));
+    n = grafo->num_vertices;
+    tablas->num_vertices = n;
+    tablas->fib = calloc(n + 1, sizeof(FIB));
+    anterior = malloc(sizeof(int) * (n + 1));
+    primero = malloc(sizeof(int) * (n + 1));
+    pila = malloc(sizeof(int) * (n + 1));
+    distancia = malloc(sizeof(double) * (n + 1));
+    rutas = malloc(sizeof(RUTA_FIB) * (n + 1));
+    if (!tablas->fib || !anterior || !primero || !pila || !distancia || !rutas || construir_vista_latencia(grafo, &vista) != 0)
+    {
+        free(anterior);
+        free(primero);
+        free(pila);
+        free(distancia);
+        free(rutas);
+        liberar_tablas_reenvio(tablas);
+        return -1;
+    }
+    if (monticulo_iniciar(&m, vista.num_aristas + 1) != 0)
+    {
+        liberar_vista_latencia(&vista);
+        free(anterior);
+        free(primero);
+        free(pila);
+        free(distancia);
+        free(rutas);
+        liberar_tablas_reenvio(tablas);
+        return -1;
+    }
+
+    for (r = 0; r < n; ++r)
+    {
+        if (!grafo->vertices[r].activo)
+            continue;
+        dijkstra_latencia(&vista, r, -1, &m, anterior, distancia);
+        primeros_saltos(anterior, distancia, n, r, primero, pila);
+        num = 0;
+        for (v = 0; v < n; ++v)
+        {
+            if (primero[v] < 0 || !grafo->vertices[v].activo)
+                continue;
+            rutas[num].prefijo = grafo->datos[v].ip;
+            rutas[num].longitud = 32;
+            rutas[num].siguiente = primero[v];
+            num++;
+        }
+        if (fib_iniciar(&tablas->fib[r]) != 0)
+            break;
+        tablas->fib[r].num_rutas = num;
+        qsort(rutas, num, sizeof(RUTA_FIB), comparar_rutas_fib);
+        num = agregar_rutas(rutas, num);
+        tablas->fib[r].num_prefijos = num;
+        /* el trie exige insertar de menos a mas especifico */
+        qsort(rutas, num, sizeof(RUTA_FIB), comparar_rutas_longitud);
+        for (i = 0; i < num; ++i)
+            if (fib_insertar(&tablas->fib[r], rutas[i].prefijo, rutas[i].longitud, rutas[i].siguiente) != 0)
+                break;
+        if (i < num)
+            break;
+    }
+
+    monticulo_liberar(&m);
+    liberar_vista_latencia(&vista);
+    free(anterior);
+    free(primero);
+    free(pila);
+    free(distancia);
+    free(rutas);
+    if (r < n)
+    {
+        liberar_tablas_reenvio(tablas);
+        return -1;
+    }
+    tablas->version = grafo->version;
+    tablas->valido = 1;
+    return 0;
+}
+
+void liberar_tablas_reenvio(TABLAS_REENVIO *tablas)
+{
+    int i;
+
+    if (!tablas)
+        return;
+    if (tablas->fib)
+        for (i = 0; i < tablas->num_vertices; ++i)
+            fib_liberar(&tablas->fib[i]);
+    free(tablas->fib);
+    memset(tablas, 0, sizeof(*tablas));
+}
+
+int actualizar_tablas_reenvio(GRAFO *grafo, TABLAS_REENVIO *tablas)
+{
+    if (tablas->valido && tablas->version == grafo->version && tablas->num_vertices == grafo->num_vertices)
+        return 0;
+    liberar_tablas_reenvio(tablas);
+    return construir_tablas_reenvio(grafo, tablas);
+}
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef FLUJO_H
+#define FLUJO_H
+
+#include "grafos.h"
+
+/*
+ * Red residual para flujo maximo (Dinic).
+ * Cada arista activa u -> v (con ambos extremos activos y ancho de banda > 0)
+ * da un arco u -> v de capacidad ancho_banda_mbps y su arco inverso v -> u de
+ * capacidad 0, guardados en CSR por vertice de salida. La red se construye una
+ * vez y flujo_maximo() solo reinicia el residual, asi que se pueden lanzar
+ * muchas consultas (s, t) seguidas sin volver a recorrer el grafo.
+ */
+typedef struct RED_FLUJO
+{
+    int num_vertices;
+    int num_arcos;
+    int *inicio;    /* n + 1 */
+    int *cabeza;    /* vertice al que llega el arco */
+    int *pareja;    /* arco inverso */
+    int *arista;    /* arista del grafo, -1 en los arcos inversos */
+    int *capacidad; /* capacidad original */
+    int *residual;
+    int *nivel;     /* distancia BFS en el grafo de niveles, -1 = no alcanzado */
+    int *iter;      /* siguiente arco a probar por vertice */
+    int *cola;      /* cola BFS / pila de arcos del DFS */
+} RED_FLUJO;
+
+int construir_red_flujo(GRAFO *grafo, RED_FLUJO *red);
+void liberar_red_flujo(RED_FLUJO *red);
+long long flujo_maximo(RED_FLUJO *red, int s, int t);
+/* Tras flujo_maximo: lado[v] = 1 si v queda del lado de s en el corte minimo */
+void lado_corte_minimo(RED_FLUJO *red, int s, unsigned char *lado);
+/* Tras flujo_maximo: aristas del grafo que cruzan el corte minimo; devuelve cuantas */
+int aristas_corte_minimo(RED_FLUJO *red, int s, int *aristas, int max_aristas);
+
+// Implementaciones
+
+int construir_red_flujo(GRAFO *grafo, RED_FLUJO *red)
+{
+    int n, m, e, u, v, a, b, *pos;
+
+    if (!grafo || !red)
+        return -1;
+    memset(red, 0, sizeof(*red));
+    n = grafo->num_vertices;
+    red->num_vertices = n;
+    red->inicio = calloc(n + 1, sizeof(int));
+    pos = malloc(sizeof(int) * (n + 1));
+    if (!red->inicio || !pos)
+    {
+        free(pos);
+        liberar_red_flujo(red);
+        return -1;
+    }
+
+    m = 0;
+    for (e = 0; e < grafo->aristas.num; ++e)
+    {
+        v = grafo->aristas.destino[e];
+        if (v < 0 || !ARISTA_ACTIVA(grafo, e) || grafo->aristas.ancho_banda_mbps[e] <= 0)
+            continue;
+        u = grafo->aristas.origen[e];
+        if (u == v || !grafo->vertices[u].activo || !grafo->vertices[v].activo)
+            continue;
+        red->inicio[u + 1]++;
+        red->inicio[v + 1]++;
+        m += 2;
+    }
+    for (u = 0; u < n; ++u)
+        red->inicio[u + 1] += red->inicio[u];
+    red->num_arcos = m;
+
+    red->cabeza = malloc(sizeof(int) * (m + 1));
+    red->pareja = malloc(sizeof(int) * (m + 1));
+    red->arista = malloc(sizeof(int) * (m + 1));
+    red->capacidad = malloc(sizeof(int) * (m + 1));
+    red->residual = malloc(sizeof(int) * (m + 1));
+    red->nivel = malloc(sizeof(int) * (n + 1));
+    red->iter = malloc(sizeof(int) * (n + 1));
+    red->cola = malloc(sizeof(int) * (n + 1));
+    if (!red->cabeza || !red->pareja || !red->arista || !red->capacidad || !red->residual || !red->nivel || !red->iter || !red->cola)
+    {
+        free(pos);
+        liberar_red_flujo(red);
+        return -1;
+    }
+
+    memcpy(pos, red->inicio, sizeof(int) * (n + 1));
+    for (e = 0; e < grafo->aristas.num; ++e)
+    {
+        v = grafo->aristas.destino[e];
+        if (v < 0 || !ARISTA_ACTIVA(grafo, e) || grafo->aristas.ancho_banda_mbps[e] <= 0)
+            continue;
+        u = grafo->aristas.origen[e];
+        if (u == v || !grafo->vertices[u].activo || !grafo->vertices[v].activo)
+            continue;
+        a = pos[u]++;
+        b = pos[v]++;
+        red->cabeza[a] = v;
+        red->pareja[a] = b;
+        red->arista[a] = e;
+        red->capacidad[a] = grafo->aristas.ancho_banda_mbps[e];
+        red->cabeza[b] = u;
+        red->pareja[b] = a;
+        red->arista[b] = -1;
+        red->capacidad[b] = 0;
+    }
+    free(pos);
+    return 0;
+}
+
+void liberar_red_flujo(RED_FLUJO *red)
+{
+    if (!red)
+        return;
+    free(red->inicio);
+    free(red->cabeza);
+    free(red->pareja);
+    free(red->arista);
+    free(red->capacidad);
+    free(red->residual);
+    free(red->nivel);
+    free(red->iter);
+    free(red->cola);
+    memset(red, 0, sizeof(*red));
+}
+
+/* Grafo de niveles desde s; devuelve 1 si t es alcanzable */
+static int dinic_niveles(RED_FLUJO *red, int s, int t)
+{
+    int cab, fin, u, a, v;
+
+    for (u = 0; u < red->num_vertices; ++u)
+        red->nivel[u] = -1;
+    red->nivel[s] = 0;
+    red->cola[0] = s;
+    cab = 0;
+    fin = 1;
+    while (cab < fin)
+    {
+        u = red->cola[cab++];
+        for (a = red->inicio[u]; a < red->inicio[u + 1]; ++a)
+        {
+            v = red->cabeza[a];
+            if (red->residual[a] > 0 && red->nivel[v] < 0)
+            {
+                red->nivel[v] = red->nivel[u] + 1;
+                if (v == t)
+                    return 1;
+                red->cola[fin++] = v;
+            }
+        }
+    }
+    return 0;
+}
+
+/* Flujo bloqueante con DFS iterativo: la pila guarda los arcos del camino actual */
+static long long dinic_bloqueante(RED_FLUJO *red, int s, int t)
+{
+    int u, v, a, prof, k, corte, minimo;
+    int *camino = red->cola;
+    long long total = 0;
+
+    for (u = 0; u < red->num_vertices; ++u)
+        red->iter[u] = red->inicio[u];
+    u = s;
+    prof = 0;
+    for (;;)
+    {
+        if (u == t)
+        {
+            minimo = red->residual[camino[0]];
+            corte = 0;
+            for (k = 1; k < prof; ++k)
+            {
+                if (red->residual[camino[k]] < minimo)
+                {
+                    minimo = red->residual[camino[k]];
+                    corte = k;
+                }
+            }
+            for (k = 0; k < prof; ++k)
+            {
+                red->residual[camino[k]] -= minimo;
+                red->residual[red->pareja[camino[k]]] += minimo;
+            }
+            total += minimo;
+            /* retroceder hasta el primer arco saturado */
+            prof = corte;
+            u = red->cabeza[red->pareja[camino[corte]]];
+            continue;
+        }
+        for (; red->iter[u] < red->inicio[u + 1]; ++red->iter[u])
+        {
+            a = red->iter[u];
+            v = red->cabeza[a];
+            if (red->residual[a] > 0 && red->nivel[v] == red->nivel[u] + 1)
+                break;
+        }
+        if (red->iter[u] < red->inicio[u + 1])
+        {
+            camino[prof++] = red->iter[u];
+            u = red->cabeza[red->iter[u]];
+            continue;
+        }
+        /* callejon sin salida: se poda el vertice y se retrocede */
+        if (u == s)
+            break;
+        red->nivel[u] = -1;
+        a = camino[--prof];
+        u = red->cabeza[red->pareja[a]];
+        red->iter[u]++;
+    }
+    return total;
+}
+
+long long flujo_maximo(RED_FLUJO *red, int s, int t)
+{
+    long long total = 0;
+
+    if (!red || s < 0 || t < 0 || s >= red->num_vertices || t >= red->num_vertices || s == t)
+        return 0;
+    memcpy(red->residual, red->capacidad, sizeof(int) * red->num_arcos);
+    while (dinic_niveles(red, s, t))
+        total += dinic_bloqueante(red, s, t);
+    return total;
+}
+
+void lado_corte_minimo(RED_FLUJO *red, int s, unsigned char *lado)
+{
+    int cab, fin, u, a, v;
+
+    memset(lado, 0, red->num_vertices);
+    lado[s] = 1;
+    red->cola[0] = s;
+    cab = 0;
+    fin = 1;
+    while (cab < fin)
+    {
+        u = red->cola[cab++];
+        for (a = red->inicio[u]; a < red->inicio[u + 1]; ++a)
+        {
+            v = red->cabeza[a];
+            if (red->residual[a] > 0 && !lado[v])
+            {
+                lado[v] = 1;
+                red->cola[fin++] = v;
+            }
+        }
+    }
+}
+
+int aristas_corte_minimo(RED_FLUJO *red, int s, int *aristas, int max_aristas)
+{
+    int u, a, num;
+    unsigned char *lado;
+
+    lado = malloc(red->num_vertices + 1);
+    if (!lado)
+        return -1;
+    lado_corte_minimo(red, s, lado);
+    num = 0;
+    for (u = 0; u < red->num_vertices; ++u)
+    {
+        if (!lado[u])
+            continue;
+        for (a = red->inicio[u]; a < red->inicio[u + 1]; ++a)
+        {
+            if (red->arista[a] < 0 || lado[red->cabeza[a]])
+                continue;
+            if (num < max_aristas)
+                aristas[num] = red->arista[a];
+            num++;
+        }
+    }
+    free(lado);
+    return num;
+}
+
+#endif
@@ -0,0 +1,579 @@
+#ifndef GENERADOR_H
+#define GENERADOR_H
+
+#include "grafos.h"
+#include <math.h>
+
+/*
+ * Generador de topologias sinteticas para pruebas de escala.
+ * Cada enlace se crea en los dos sentidos con los mismos atributos. Todo sale
+ * de una semilla (splitmix64 + xorshift), asi que la misma orden da siempre
+ * la misma red.
+ *
+ *   fat-tree k     k pods de k/2 switches de borde y k/2 de agregacion,
+ *                  (k/2)^2 nucleos y k^3/4 servidores (Al-Fares et al.);
+ *                  IPs 10.pod.switch.id como en el articulo (k par, <= 254).
+ *   hoja-espina L  L hojas con GEN_HOSTS_POR_HOJA servidores cada una y
+ *                  'grado' espinas (todas las hojas con todas las espinas).
+ *   waxman n       n routers al azar en un cuadrado de GEN_LADO_WAN_KM; el
+ *                  enlace u-v existe con probabilidad beta*exp(-d/(alfa*L)).
+ *                  alfa y beta se ajustan para un grado medio 'grado', y solo
+ *                  se prueban pares de celdas vecinas de una rejilla (la
+ *                  probabilidad fuera del radio de corte es < 1e-3) con
+ *                  saltos geometricos, asi que cuesta O(n * grado). Los
+ *                  vertices aislados se unen al vecino mas cercano.
+ *   barabasi n     enganche preferencial: cada vertice nuevo se une a
+ *                  'grado' vertices existentes con probabilidad proporcional
+ *                  a su grado (arreglo de extremos repetidos, O(n * grado)).
+ *                  Los de mas grado son routers, luego switches y hosts.
+ *   anillo n       anillo WAN de n routers mas 'grado' cuerdas al azar por
+ *                  vertice (malla parcial).
+ *   malla n        malla completa de n routers WAN.
+ *
+ * Latencias: en los centros de datos 1 ms (la minima representable); en WAN
+ * la de propagacion por fibra segun la distancia mas 1 ms de equipos, y en
+ * barabasi exponencial de media GEN_LATENCIA_MEDIA_MS. Ancho de banda por
+ * nivel (servidor 10G, agregacion 40G, nucleo 100G) o por sorteo entre
+ * velocidades comerciales en WAN; fiabilidad alta en el centro de datos y
+ * decreciente con la distancia en WAN.
+ */
+#define GEN_HOSTS_POR_HOJA 32
+#define GEN_LADO_WAN_KM 4000.0
+#define GEN_KM_POR_MS 200.0 /* luz en fibra */
+#define GEN_LATENCIA_MEDIA_MS 8.0
+
+typedef enum
+{
+    GEN_FAT_TREE,
+    GEN_HOJA_ESPINA,
+    GEN_WAXMAN,
+    GEN_BARABASI,
+    GEN_ANILLO,
+    GEN_MALLA,
+    GEN_DESCONOCIDO
+} Tipo_Generador;
+
+typedef struct PARAMETROS_GENERADOR
+{
+    Tipo_Generador tipo;
+    int tamano;        /* k, hojas o vertices segun el tipo */
+    int grado;         /* espinas, grado medio, enlaces por vertice o cuerdas; 0 = por defecto */
+    uint64_t semilla;
+} PARAMETROS_GENERADOR;
+
+Tipo_Generador generador_desde_cadena(const char *nombre);
+const char *generador_a_cadena(Tipo_Generador tipo);
+int grado_por_defecto(Tipo_Generador tipo);
+/* NULL si los parametros no son validos o falta memoria */
+GRAFO *generar_topologia(const PARAMETROS_GENERADOR *parametros);
+
+// Implementaciones
+
+static const char *nombres_generador[] = {"fat-tree", "hoja-espina", "waxman", "barabasi", "anillo", "malla"};
+
+Tipo_Generador generador_desde_cadena(const char *nombre)
+{
+    int i;
+
+    for (i = 0; i < GEN_DESCONOCIDO; ++i)
+        if (strcmp(nombre, nombres_generador[i]) == 0)
+            return (Tipo_Generador)i;
+    return GEN_DESCONOCIDO;
+}
+
+const char *generador_a_cadena(Tipo_Generador tipo)
+{
+    return tipo < GEN_DESCONOCIDO ? nombres_generador[tipo] : "desconocido";
+}
+
+int grado_por_defecto(Tipo_Generador tipo)
+{
+    switch (tipo)
+    {
+    case GEN_HOJA_ESPINA:
+        return 4;
+    case GEN_WAXMAN:
+        return 4;
+    case GEN_BARABASI:
+        return 2;
+    case GEN_ANILLO:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+typedef struct GEN_AZAR
+{
+    uint64_t s;
+} GEN_AZAR;
+
+static void gen_sembrar(GEN_AZAR *r, uint64_t semilla)
+{
+    /* splitmix64: cualquier semilla (incluida 0) da un estado xorshift valido */
+    uint64_t z = semilla + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    r->s = (z ^ (z >> 31)) | 1;
+}
+
+static uint64_t gen_siguiente(GEN_AZAR *r)
+{
+    r->s ^= r->s << 13;
+    r->s ^= r->s >> 7;
+    r->s ^= r->s << 17;
+    return r->s;
+}
+
+/* Uniforme en [0, 1) */
+static double gen_uniforme(GEN_AZAR *r)
+{
+    return (double)(gen_siguiente(r) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int gen_entero(GEN_AZAR *r, int n)
+{
+    return (int)(gen_siguiente(r) % (uint64_t)n);
+}
+
+static int gen_vertice(GRAFO *grafo, char prefijo, int numero, uint32_t ip, Tipo_Dispositivo tipo)
+{
+    char nombre[24], cadena[MAX_IP];
+    static const int capacidad[] = {100, 50, 10, 200, 10};
+
+    snprintf(nombre, sizeof(nombre), "%c%d", prefijo, numero);
+    return agregar_vertice(grafo, nombre, ip_a_cadena(ip, cadena), tipo, capacidad[tipo]);
+}
+
+/* Enlace en los dos sentidos */
+static int gen_enlace(GRAFO *grafo, int u, int v, int latencia, int ancho_banda, double fiabilidad)
+{
+    if (agregar_arista(grafo, u, v, latencia, ancho_banda, fiabilidad, 1) != 0)
+        return -1;
+    return agregar_arista(grafo, v, u, latencia, ancho_banda, fiabilidad, 1);
+}
+
+static double gen_fiabilidad_cd(GEN_AZAR *r)
+{
+    return 0.999 + 0.00099 * gen_uniforme(r);
+}
+
+/* Enlace WAN: latencia de propagacion, velocidad comercial y fiabilidad segun la distancia */
+static int gen_enlace_wan(GRAFO *grafo, GEN_AZAR *r, int u, int v, double km)
+{
+    static const int velocidades[] = {1000, 10000, 10000, 10000, 40000, 100000};
+    int latencia = 1 + (int)(km / GEN_KM_POR_MS + 0.5);
+    double fiabilidad = 0.999 - 0.02 * (km / GEN_LADO_WAN_KM) - 0.005 * gen_uniforme(r);
+
+    return gen_enlace(grafo, u, v, latencia, velocidades[gen_entero(r, 6)], fiabilidad);
+}
+
+#define GEN_IP(a, b, c, d) (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 8) | (uint32_t)(d))
+/* IPs consecutivas a partir de 10.0.0.1 para los tipos sin esquema propio */
+#define GEN_IP_SECUENCIAL(i) (GEN_IP(10, 0, 0, 1) + (uint32_t)(i))
+
+static int generar_fat_tree(GRAFO *grafo, int k, GEN_AZAR *r)
+{
+    int mitad = k / 2, pod, s, h, j, i, nucleo0, pod0, borde, agregacion;
+
+    /* nucleos primero: 10.k.j.i con j, i en 1..k/2 */
+    nucleo0 = grafo->num_vertices;
+    for (j = 0; j < mitad; ++j)
+        for (i = 0; i < mitad; ++i)
+            if (gen_vertice(grafo, 'C', j * mitad + i, GEN_IP(10, k, j + 1, i + 1), D_ROUTER) < 0)
+                return -1;
+    for (pod = 0; pod < k; ++pod)
+    {
+        /* switches del pod: 10.pod.s.1; 0..k/2-1 borde, k/2..k-1 agregacion */
+        pod0 = grafo->num_vertices;
+        for (s = 0; s < k; ++s)
+            if (gen_vertice(grafo, s < mitad ? 'E' : 'A', pod * k + s, GEN_IP(10, pod, s, 1), D_SWITCH) < 0)
+                return -1;
+        for (s = 0; s < mitad; ++s)
+        {
+            borde = pod0 + s;
+            /* servidores 10.pod.s.id con id en 2..k/2+1 */
+            for (h = 0; h < mitad; ++h)
+            {
+                i = gen_vertice(grafo, 'H', (pod * mitad + s) * mitad + h, GEN_IP(10, pod, s, h + 2), D_SERVIDOR);
+                if (i < 0 || gen_enlace(grafo, i, borde, 1, 10000, gen_fiabilidad_cd(r)) != 0)
+                    return -1;
+            }
+            for (j = 0; j < mitad; ++j)
+                if (gen_enlace(grafo, borde, pod0 + mitad + j, 1, 40000, gen_fiabilidad_cd(r)) != 0)
+                    return -1;
+        }
+        /* el switch de agregacion j del pod va a los nucleos j*k/2 .. j*k/2 + k/2-1 */
+        for (j = 0; j < mitad; ++j)
+        {
+            agregacion = pod0 + mitad + j;
+            for (i = 0; i < mitad; ++i)
+                if (gen_enlace(grafo, agregacion, nucleo0 + j * mitad + i, 1, 100000, gen_fiabilidad_cd(r)) != 0)
+                    return -1;
+        }
+    }
+    return 0;
+}
+
+static int generar_hoja_espina(GRAFO *grafo, int hojas, int espinas, GEN_AZAR *r)
+{
+    int e, l, h, i, espina0, hoja, numero = 0;
+
+    espina0 = grafo->num_vertices;
+    for (e = 0; e < espinas; ++e, ++numero)
+        if (gen_vertice(grafo, 'S', e, GEN_IP_SECUENCIAL(numero), D_ROUTER) < 0)
+            return -1;
+    for (l = 0; l < hojas; ++l)
+    {
+        hoja = gen_vertice(grafo, 'L', l, GEN_IP_SECUENCIAL(numero++), D_SWITCH);
+        if (hoja < 0)
+            return -1;
+        for (e = 0; e < espinas; ++e)
+            if (gen_enlace(grafo, hoja, espina0 + e, 1, 100000, gen_fiabilidad_cd(r)) != 0)
+                return -1;
+        for (h = 0; h < GEN_HOSTS_POR_HOJA; ++h)
+        {
+            i = gen_vertice(grafo, 'H', l * GEN_HOSTS_POR_HOJA + h, GEN_IP_SECUENCIAL(numero++), D_SERVIDOR);
+            if (i < 0 || gen_enlace(grafo, i, hoja, 1, 25000, gen_fiabilidad_cd(r)) != 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/* Primera posicion de orden[desde, hasta) (creciente) con valor > u */
+static int primer_mayor(const int *orden, int desde, int hasta, int u)
+{
+    int medio;
+
+    while (desde < hasta)
+    {
+        medio = desde + (hasta - desde) / 2;
+        if (orden[medio] <= u)
+            desde = medio + 1;
+        else
+            hasta = medio;
+    }
+    return desde;
+}
+
+static int generar_waxman(GRAFO *grafo, int n, int grado, GEN_AZAR *r)
+{
+    int i, u, v, c, cx, cy, ax, ay, lado_rejilla, celdas, radio_busqueda, mejor, num_rangos, rango, total, pos, desde[9], hasta[9];
+    int *inicio = NULL, *orden = NULL, *celda = NULL, *grado_v = NULL, res = -1;
+    double *x = NULL, *y = NULL, escala, corte, beta = 0.125, log_no_beta, d, dmin;
+
+    /*
+     * Con escala = alfa * L, el grado esperado es ~ n * beta * 2 pi escala^2;
+     * se fija beta y se despeja la escala. Por encima de 'corte' la
+     * probabilidad es beta * e^-5 < 1e-3 y el par ni se mira.
+     */
+    escala = sqrt(grado / (beta * 2.0 * M_PI * n));
+    corte = 5.0 * escala;
+    lado_rejilla = (int)(1.0 / corte);
+    lado_rejilla = lado_rejilla < 1 ? 1 : lado_rejilla > 4096 ? 4096 : lado_rejilla;
+    celdas = lado_rejilla * lado_rejilla;
+
+    x = malloc(sizeof(double) * n);
+    y = malloc(sizeof(double) * n);
+    celda = malloc(sizeof(int) * n);
+    orden = malloc(sizeof(int) * n);
+    grado_v = calloc(n, sizeof(int));
+    inicio = calloc(celdas + 1, sizeof(int));
+    if (!x || !y || !celda || !orden || !grado_v || !inicio)
+        goto fin;
+
+    for (i = 0; i < n; ++i)
+    {
+        x[i] = gen_uniforme(r);
+        y[i] = gen_uniforme(r);
+        c = (int)(y[i] * lado_rejilla) * lado_rejilla + (int)(x[i] * lado_rejilla);
+        celda[i] = c;
+        inicio[c + 1]++;
+        if (gen_vertice(grafo, 'R', i, GEN_IP_SECUENCIAL(i), D_ROUTER) < 0)
+            goto fin;
+    }
+    /* vertices agrupados por celda (ordenacion por cuentas) */
+    for (c = 0; c < celdas; ++c)
+        inicio[c + 1] += inicio[c];
+    for (i = 0; i < n; ++i)
+        orden[inicio[celda[i]]++] = i;
+    for (c = celdas; c > 0; --c)
+        inicio[c] = inicio[c - 1];
+    inicio[0] = 0;
+
+    /*
+     * Muestreo en dos pasos: entre los candidatos de las 9 celdas vecinas se
+     * eligen los que pasan la cota beta saltando una cantidad geometrica (un
+     * logaritmo por elegido, no uno por par) y cada elegido se acepta con
+     * exp(-d / escala). Cada par sigue teniendo probabilidad
+     * beta * exp(-d / escala) y el coste baja en un factor 1 / beta.
+     */
+    log_no_beta = log(1.0 - beta);
+    for (u = 0; u < n; ++u)
+    {
+        cx = celda[u] % lado_rejilla;
+        cy = celda[u] / lado_rejilla;
+        num_rangos = 0;
+        total = 0;
+        for (ay = cy - 1; ay <= cy + 1; ++ay)
+            for (ax = cx - 1; ax <= cx + 1; ++ax)
+                if (ax >= 0 && ay >= 0 && ax < lado_rejilla && ay < lado_rejilla)
+                {
+                    /* cada celda esta en orden de indice: solo el tramo con v > u */
+                    c = ay * lado_rejilla + ax;
+                    desde[num_rangos] = primer_mayor(orden, inicio[c], inicio[c + 1], u);
+                    hasta[num_rangos] = inicio[c + 1];
+                    total += hasta[num_rangos] - desde[num_rangos];
+                    num_rangos++;
+                }
+        rango = 0;
+        i = 0; /* posicion global donde empieza el rango actual */
+        for (pos = (int)(log(1.0 - gen_uniforme(r)) / log_no_beta); pos < total; pos += 1 + (int)(log(1.0 - gen_uniforme(r)) / log_no_beta))
+        {
+            /* pos solo avanza: se recorren los rangos una vez */
+            while (pos - i >= hasta[rango] - desde[rango])
+            {
+                i += hasta[rango] - desde[rango];
+                rango++;
+            }
+            v = orden[desde[rango] + pos - i];
+            /* dos tercios de las celdas vecinas quedan fuera del radio de corte */
+            d = (x[u] - x[v]) * (x[u] - x[v]) + (y[u] - y[v]) * (y[u] - y[v]);
+            if (d > corte * corte)
+                continue;
+            d = sqrt(d);
+            if (gen_uniforme(r) >= exp(-d / escala))
+                continue;
+            if (gen_enlace_wan(grafo, r, u, v, d * GEN_LADO_WAN_KM) != 0)
+                goto fin;
+            grado_v[u]++;
+            grado_v[v]++;
+        }
+    }
+
+    /* aislados: al vecino mas cercano, ampliando el anillo de celdas hasta encontrar uno */
+    for (u = 0; u < n && n > 1; ++u)
+    {
+        if (grado_v[u] > 0)
+            continue;
+        cx = celda[u] % lado_rejilla;
+        cy = celda[u] / lado_rejilla;
+        mejor = -1;
+        dmin = 0.0;
+        for (radio_busqueda = 1; mejor < 0 && radio_busqueda <= lado_rejilla; ++radio_busqueda)
+            for (ay = cy - radio_busqueda; ay <= cy + radio_busqueda; ++ay)
+                for (ax = cx - radio_busqueda; ax <= cx + radio_busqueda; ++ax)
+                {
+                    if (ax < 0 || ay < 0 || ax >= lado_rejilla || ay >= lado_rejilla)
+                        continue;
+                    c = ay * lado_rejilla + ax;
+                    for (i = inicio[c]; i < inicio[c + 1]; ++i)
+                    {
+                        v = orden[i];
+                        d = hypot(x[u] - x[v], y[u] - y[v]);
+                        if (v != u && (mejor < 0 || d < dmin))
+                        {
+                            mejor = v;
+                            dmin = d;
+                        }
+                    }
+                }
+        if (mejor >= 0)
+        {
+            if (gen_enlace_wan(grafo, r, u, mejor, dmin * GEN_LADO_WAN_KM) != 0)
+                goto fin;
+            grado_v[u]++;
+            grado_v[mejor]++;
+        }
+    }
+    res = 0;
+fin:
+    free(x);
+    free(y);
+    free(celda);
+    free(orden);
+    free(grado_v);
+    free(inicio);
+    return res;
+}
+
+static int generar_barabasi(GRAFO *grafo, int n, int m, GEN_AZAR *r)
+{
+    int *extremos, *grado_v, num_extremos, v, i, j, t, u, elegidos[64], tope, res = -1;
+    size_t max_extremos;
+    Tipo_Dispositivo tipo;
+
+    if (m > 63)
+        m = 63;
+    if (n <= m)
+        n = m + 1;
+    /* cada enlace deja sus dos extremos: elegir uno al azar es elegir por grado */
+    max_extremos = (size_t)2 * ((size_t)m * (m + 1) / 2 + (size_t)(n - m - 1) * m);
+    extremos = malloc(sizeof(int) * max_extremos);
+    grado_v = calloc(n, sizeof(int));
+    if (!extremos || !grado_v)
+        goto fin;
+
+    num_extremos = 0;
+    /* nucleo inicial: clique de m + 1 vertices */
+    for (v = 0; v <= m; ++v)
+        for (u = 0; u < v; ++u)
+        {
+            extremos[num_extremos++] = u;
+            extremos[num_extremos++] = v;
+        }
+    for (v = m + 1; v < n; ++v)
+    {
+        tope = num_extremos;
+        for (i = 0; i < m; ++i)
+        {
+            do
+            {
+                t = extremos[gen_entero(r, tope)];
+                for (j = 0; j < i && elegidos[j] != t; ++j)
+                    ;
+            } while (j < i);
+            elegidos[i] = t;
+            extremos[num_extremos++] = t;
+            extremos[num_extremos++] = v;
+        }
+    }
+    for (i = 0; i < num_extremos; ++i)
+        grado_v[extremos[i]]++;
+
+    /* el tipo sale del grado final: los concentradores son routers */
+    for (v = 0; v < n; ++v)
+    {
+        tipo = grado_v[v] >= 4 * m ? D_ROUTER : grado_v[v] > m ? D_SWITCH : D_HOST;
+        if (gen_vertice(grafo, tipo == D_ROUTER ? 'R' : tipo == D_SWITCH ? 'S' : 'H', v, GEN_IP_SECUENCIAL(v), tipo) < 0)
+            goto fin;
+    }
+    for (i = 0; i < num_extremos; i += 2)
+    {
+        u = extremos[i];
+        v = extremos[i + 1];
+        t = grafo->vertices[u].tipo == D_HOST || grafo->vertices[v].tipo == D_HOST ? 1000 : grafo->vertices[u].tipo == D_ROUTER && grafo->vertices[v].tipo == D_ROUTER ? 100000 : 10000;
+        if (gen_enlace(grafo, u, v, 1 + (int)(-GEN_LATENCIA_MEDIA_MS * log(1.0 - gen_uniforme(r))), t, 0.97 + 0.029 * gen_uniforme(r)) != 0)
+            goto fin;
+    }
+    res = 0;
+fin:
+    free(extremos);
+    free(grado_v);
+    return res;
+}
+
+static int generar_wan(GRAFO *grafo, int n, int cuerdas, int completa, GEN_AZAR *r)
+{
+    int u, v, c, res = -1;
+    double *x, *y, angulo;
+
+    x = malloc(sizeof(double) * n);
+    y = malloc(sizeof(double) * n);
+    if (!x || !y)
+        goto fin;
+    for (u = 0; u < n; ++u)
+    {
+        /* PoPs en un anillo con algo de ruido, o repartidos en el cuadrado para la malla */
+        angulo = 2.0 * M_PI * u / n;
+        x[u] = completa ? gen_uniforme(r) : 0.5 + (0.45 + 0.04 * gen_uniforme(r)) * cos(angulo);
+        y[u] = completa ? gen_uniforme(r) : 0.5 + (0.45 + 0.04 * gen_uniforme(r)) * sin(angulo);
+        if (gen_vertice(grafo, 'R', u, GEN_IP_SECUENCIAL(u), D_ROUTER) < 0)
+            goto fin;
+    }
+    for (u = 0; u < n; ++u)
+    {
+        if (completa)
+        {
+            for (v = u + 1; v < n; ++v)
+                if (gen_enlace_wan(grafo, r, u, v, hypot(x[u] - x[v], y[u] - y[v]) * GEN_LADO_WAN_KM) != 0)
+                    goto fin;
+            continue;
+        }
+        v = (u + 1) % n;
+        if (n > 1 && (n > 2 || u == 0) && gen_enlace_wan(grafo, r, u, v, hypot(x[u] - x[v], y[u] - y[v]) * GEN_LADO_WAN_KM) != 0)
+            goto fin;
+        for (c = 0; c < cuerdas && n > 3; ++c)
+        {
+            v = gen_entero(r, n);
+            /* sin bucles ni repetir el anillo */
+            if (v == u || v == (u + 1) % n || u == (v + 1) % n || buscar_arista(grafo, u, v) >= 0)
+                continue;
+            if (gen_enlace_wan(grafo, r, u, v, hypot(x[u] - x[v], y[u] - y[v]) * GEN_LADO_WAN_KM) != 0)
+                goto fin;
+        }
+    }
+    res = 0;
+fin:
+    free(x);
+    free(y);
+    return res;
+}
+
+GRAFO *generar_topologia(const PARAMETROS_GENERADOR *p)
+{
+    GRAFO *grafo;
+    GEN_AZAR r;
+    int n, grado, res;
+
+    if (!p || p->tamano <= 0)
+        return NULL;
+    grado = p->grado > 0 ? p->grado : grado_por_defecto(p->tipo);
+    switch (p->tipo)
+    {
+    case GEN_FAT_TREE:
+        if (p->tamano % 2 != 0 || p->tamano > 254)
+            return NULL;
+        n = p->tamano * p->tamano * 5 / 4 + p->tamano * p->tamano * p->tamano / 4;
+        break;
+    case GEN_HOJA_ESPINA:
+        n = grado + p->tamano * (1 + GEN_HOSTS_POR_HOJA);
+        break;
+    case GEN_WAXMAN:
+    case GEN_BARABASI:
+    case GEN_ANILLO:
+    case GEN_MALLA:
+        n = p->tamano;
+        break;
+    default:
+        return NULL;
+    }
+    /* las IPs secuenciales salen de 10.0.0.0/8 */
+    if (n <= 0 || n >= (1 << 24) - 2)
+        return NULL;
+
+    grafo = crear_grafo(n);
+    if (!grafo)
+        return NULL;
+    gen_sembrar(&r, p->semilla);
+    switch (p->tipo)
+    {
+    case GEN_FAT_TREE:
+        res = generar_fat_tree(grafo, p->tamano, &r);
+        break;
+    case GEN_HOJA_ESPINA:
+        res = generar_hoja_espina(grafo, p->tamano, grado, &r);
+        break;
+    case GEN_WAXMAN:
+        res = generar_waxman(grafo, n, grado, &r);
+        break;
+    case GEN_BARABASI:
+        res = generar_barabasi(grafo, n, grado, &r);
+        break;
+    case GEN_ANILLO:
+        res = generar_wan(grafo, n, grado, 0, &r);
+        break;
+    default:
+        res = generar_wan(grafo, n, 0, 1, &r);
+        break;
+    }
+    if (res != 0)
+    {
+        liberar_grafo(grafo);
+        return NULL;
+    }
+    return grafo;
+}
+
+#endif
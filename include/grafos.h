@@ -6,9 +6,12 @@
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
+#include <stdint.h>
+#include "instrumentacion.h"
 
-#define MAX_NOMBRE 64
-#define MAX_IP 16
+#define MAX_IP 16       /* "255.255.255.255" + '\0' */
+#define MAX_LINEA 4096  /* línea máxima del archivo de topología */
+#define BLOQUE_NOMBRES 65536
 
 typedef enum
 {
@@ -19,34 +22,100 @@ typedef enum
     D_DEFAULT
 } Tipo_Dispositivo;
 
-/* Arista (lista de adyacencia) */
-typedef struct ARISTA
+/*
+ * Aristas en estructura de arreglos: una columna por campo, indexada por el
+ * identificador de arista. Un recorrido solo toca destino/siguiente, la
+ * columna de la métrica que usa y un bit de estado. En total son 28 bytes y
+ * un bit por arista (siete columnas de 4 bytes); el índice (u, v) añade 12
+ * bytes por ranura con ocupación entre el 25 y el 50 %, es decir de 24 a 48
+ * bytes por par (origen, destino) distinto.
+ */
+typedef struct ARISTAS
 {
-    int destino;              /* índice del vértice destino */
-    int latencia_ms;          /* latencia en ms */
-    int ancho_banda_mbps;     /* ancho de banda en Mbps */
-    double fiabilidad;        /* 0.0 .. 1.0 */
-    int activo;               /* 1 = activo, 0 = caído */
-    struct ARISTA *siguiente; /* siguiente arista */
-} ARISTA;
+    int num;               /* ranuras usadas (incluye las liberadas) */
+    int capacidad;         /* tamaño actual de las columnas */
+    int libre;             /* primera ranura liberada (encadenada por siguiente) */
+    int *destino;          /* índice del vértice destino, -1 = ranura libre */
+    int *latencia_ms;      /* latencia en ms */
+    int *ancho_banda_mbps; /* ancho de banda en Mbps */
+    float *fiabilidad;     /* 0.0 .. 1.0 */
+    int *siguiente;        /* siguiente arista del mismo origen, -1 = fin */
+    uint64_t *activo;      /* bit e: 1 = activo, 0 = caído */
+    /* índice inverso: aristas entrantes de cada vértice */
+    int *origen;             /* vértice origen */
+    int *siguiente_entrante; /* siguiente arista con el mismo destino, -1 = fin */
+} ARISTAS;
 
-/* Vértice */
+/* Estado de una arista: una sola operación de bits (los cambios avanzan la versión del grafo) */
+#define ARISTA_ACTIVA(g, e) ((int)(((g)->aristas.activo[(e) >> 6] >> ((e) & 63)) & 1u))
+#define ARISTA_ACTIVAR(g, e) ((g)->version++, (g)->aristas.activo[(e) >> 6] |= (UINT64_C(1) << ((e) & 63)))
+#define ARISTA_DESACTIVAR(g, e) ((g)->version++, (g)->aristas.activo[(e) >> 6] &= ~(UINT64_C(1) << ((e) & 63)))
+
+/*
+ * Grupos de riesgo compartido (SRLG): aristas que caen juntas porque van por
+ * el mismo conducto o la misma tarjeta. Cada grupo es un bitset sobre los
+ * identificadores de arista, con el mismo tamaño que aristas.activo, así que
+ * tirar un grupo es un AND con su complemento palabra a palabra.
+ */
+typedef struct GRUPOS_RIESGO
+{
+    int num;
+    int capacidad;
+    const char **nombre; /* cadenas internas del pool */
+    uint64_t **miembros; /* miembros[k]: bit e = 1 si la arista e es del grupo k */
+} GRUPOS_RIESGO;
+
+#define ARISTA_EN_GRUPO(g, k, e) ((int)(((g)->srlg.miembros[k][(e) >> 6] >> ((e) & 63)) & 1u))
+
+/* Índice hash (origen, destino) -> arista más reciente, direccionamiento abierto */
+typedef struct INDICE_ARISTAS
+{
+    uint64_t *clave; /* (origen << 32) | destino */
+    int *arista;     /* -1 = vacía */
+    int usadas;
+    int capacidad;   /* potencia de 2 */
+} INDICE_ARISTAS;
+
+/* Vértice: estado caliente que tocan los recorridos (12 bytes) */
 typedef struct VERTICE
 {
-    char nombre[MAX_NOMBRE]; /* "Router 1", "Switch 2", etc. */
-    char ip[MAX_IP];         /* "192.168.1.154" */
-    Tipo_Dispositivo tipo;
-    int capacidad_procesamiento; /* valor arbitrario que simula capacidad */
-    int activo;                  /* 1 = activo, 0 = fallido */
-    ARISTA *lista_adyacencia;    /* lista de adyacencia */
+    int primera_arista;   /* cabeza de la lista de adyacencia, -1 = vacía */
+    int primera_entrante; /* cabeza de la lista de aristas entrantes, -1 = vacía */
+    unsigned char tipo;   /* Tipo_Dispositivo */
+    unsigned char activo; /* 1 = activo, 0 = fallido */
 } VERTICE;
 
+/* Metadatos fríos del vértice, en un array paralelo a vertices */
+typedef struct DATOS_VERTICE
+{
+    const char *nombre;          /* cadena interna del pool, "Router1", "Switch2", etc. */
+    uint32_t ip;                 /* IPv4 en orden de host, 192.168.1.154 = 0xC0A8019A */
+    int capacidad_procesamiento; /* valor arbitrario que simula capacidad */
+} DATOS_VERTICE;
+
+/* Pool de nombres: arena por bloques (las cadenas no se mueven) y tabla hash nombre -> índice */
+typedef struct POOL_NOMBRES
+{
+    char **bloques;
+    int num_bloques;
+    size_t usado;         /* bytes ocupados en el último bloque */
+    size_t tam_ultimo;    /* tamaño del último bloque */
+    int *tabla;           /* direccionamiento abierto, -1 = vacía */
+    int capacidad_tabla;  /* potencia de 2 */
+} POOL_NOMBRES;
+
 /* Grafo por lista de adyacencia */
 typedef struct GRAFO
 {
     int num_vertices;
-    VERTICE *vertices; /* array dinámico de vértices */
-    int capacidad;     /* tamaño actual del array */
+    VERTICE *vertices;    /* array dinámico de vértices */
+    DATOS_VERTICE *datos; /* metadatos de cada vértice */
+    int capacidad;        /* tamaño actual del array */
+    POOL_NOMBRES nombres; /* nombres internos */
+    INDICE_ARISTAS indice; /* búsqueda O(1) de la arista u -> v */
+    ARISTAS aristas;   /* columnas de aristas */
+    GRUPOS_RIESGO srlg; /* grupos de riesgo compartido */
+    unsigned version;   /* avanza con cada alta, baja o cambio de estado de vértices y aristas, y con cada cambio de latencia */
 } GRAFO;
 
 /* Creación / liberación */
@@ -61,15 +130,31 @@ int establecer_estado_vertice(GRAFO *grafo, int indice, int activo);
 /* Aristas */
 int agregar_arista(GRAFO *grafo, int indice_origen, int indice_destino, int latencia_ms, int ancho_banda_mbps, double fiabilidad, int activo);
 int establecer_estado_arista(GRAFO *grafo, int indice_origen, int indice_destino, int activo);
+int eliminar_arista(GRAFO *grafo, int indice_origen, int arista);
+int buscar_arista(const GRAFO *grafo, int indice_origen, int indice_destino);
+int buscar_arista_activa(const GRAFO *grafo, int indice_origen, int indice_destino);
+int grado_entrada(const GRAFO *grafo, int indice);
+
+/* Grupos de riesgo compartido */
+int grupo_por_nombre(const GRAFO *grafo, const char *nombre);
+/* Índice del grupo (lo crea si no existe), -1 sin memoria */
+int agregar_grupo_riesgo(GRAFO *grafo, const char *nombre);
+int asignar_grupo_arista(GRAFO *grafo, int grupo, int arista, int miembro);
 
 /* I/O */
 void imprimir_grafo(GRAFO *grafo);
 int guardar_grafo(GRAFO *grafo, const char *filename);
 int cargar_grafo(GRAFO *grafo, const char *filename);
+int guardar_instantanea(GRAFO *grafo, const char *filename);
+GRAFO *cargar_instantanea(const char *filename);
 
 /* Funciones ayudantes */
 int asegurar_capacidad(GRAFO *grafo);
+int asegurar_capacidad_aristas(GRAFO *grafo);
 int ip_valida(const char *ip);
+int ip_parsear(const char *ip, uint32_t *salida);
+const char *ip_a_cadena(uint32_t ip, char *buf);
+const char *internar_nombre(GRAFO *grafo, const char *nombre);
 
 const char *tipo_dispositivo_a_cadena(Tipo_Dispositivo);
 
@@ -78,6 +163,7 @@ const char *tipo_dispositivo_a_cadena(Tipo_Dispositivo);
 int asegurar_capacidad(GRAFO *grafo)
 {
     VERTICE *tmp;
+    DATOS_VERTICE *tmp_datos;
     int nueva;
 
     if (!grafo)
@@ -93,12 +179,221 @@ int asegurar_capacidad(GRAFO *grafo)
 
     if (!tmp)
         return -1;
-
     grafo->vertices = tmp;
+
+    tmp_datos = realloc(grafo->datos, sizeof(DATOS_VERTICE) * nueva);
+    if (!tmp_datos)
+        return -1;
+
+    grafo->datos = tmp_datos;
     grafo->capacidad = nueva;
     return 0;
 }
 
+/* FNV-1a */
+static uint32_t hash_nombre(const char *nombre)
+{
+    uint32_t h = 2166136261u;
+
+    while (*nombre)
+    {
+        h ^= (unsigned char)*nombre++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* Copia el nombre a la arena; devuelve un puntero estable */
+const char *internar_nombre(GRAFO *grafo, const char *nombre)
+{
+    POOL_NOMBRES *p;
+    size_t len, tam;
+    char **tmp, *dst;
+
+    p = &grafo->nombres;
+    len = strlen(nombre) + 1;
+    if (p->num_bloques == 0 || p->usado + len > p->tam_ultimo)
+    {
+        tam = len > BLOQUE_NOMBRES ? len : BLOQUE_NOMBRES;
+        tmp = realloc(p->bloques, sizeof(char *) * (p->num_bloques + 1));
+        if (!tmp)
+            return NULL;
+        p->bloques = tmp;
+        p->bloques[p->num_bloques] = malloc(tam);
+        if (!p->bloques[p->num_bloques])
+            return NULL;
+        p->num_bloques++;
+        p->usado = 0;
+        p->tam_ultimo = tam;
+    }
+    dst = p->bloques[p->num_bloques - 1] + p->usado;
+    memcpy(dst, nombre, len);
+    p->usado += len;
+    return dst;
+}
+
+/* Mantiene la tabla hash por debajo del 50% de ocupación */
+static int asegurar_tabla_nombres(GRAFO *grafo)
+{
+    POOL_NOMBRES *p;
+    int *tabla, cap, i, j;
+
+    p = &grafo->nombres;
+    if ((grafo->num_vertices + 1) * 2 <= p->capacidad_tabla)
+        return 0;
+    cap = p->capacidad_tabla ? p->capacidad_tabla * 2 : 64;
+    tabla = malloc(sizeof(int) * cap);
+    if (!tabla)
+        return -1;
+    for (i = 0; i < cap; ++i)
+        tabla[i] = -1;
+    for (i = 0; i < grafo->num_vertices; ++i)
+    {
+        j = (int)(hash_nombre(grafo->datos[i].nombre) & (uint32_t)(cap - 1));
+        while (tabla[j] != -1)
+            j = (j + 1) & (cap - 1);
+        tabla[j] = i;
+    }
+    free(p->tabla);
+    p->tabla = tabla;
+    p->capacidad_tabla = cap;
+    return 0;
+}
+
+int asegurar_capacidad_aristas(GRAFO *grafo)
+{
+    ARISTAS *a;
+    int nueva, palabras, palabras_antes, k;
+    void *tmp;
+
+    if (!grafo)
+        return -1;
+    a = &grafo->aristas;
+    if (a->num < a->capacidad)
+        return 0;
+    nueva = (a->capacidad == 0) ? 64 : a->capacidad * 2;
+    palabras_antes = (a->capacidad + 63) / 64;
+    palabras = (nueva + 63) / 64;
+
+#define CRECER_COLUMNA(col)                             \
+    tmp = realloc(a->col, sizeof(*a->col) * nueva);     \
+    if (!tmp)                                           \
+        return -1;                                      \
+    a->col = tmp;
+    CRECER_COLUMNA(destino)
+    CRECER_COLUMNA(latencia_ms)
+    CRECER_COLUMNA(ancho_banda_mbps)
+    CRECER_COLUMNA(fiabilidad)
+    CRECER_COLUMNA(siguiente)
+    CRECER_COLUMNA(origen)
+    CRECER_COLUMNA(siguiente_entrante)
+#undef CRECER_COLUMNA
+
+    tmp = realloc(a->activo, sizeof(uint64_t) * palabras);
+    if (!tmp)
+        return -1;
+    a->activo = tmp;
+    memset(a->activo + palabras_antes, 0, sizeof(uint64_t) * (palabras - palabras_antes));
+    for (k = 0; k < grafo->srlg.num; ++k)
+    {
+        tmp = realloc(grafo->srlg.miembros[k], sizeof(uint64_t) * palabras);
+        if (!tmp)
+            return -1;
+        grafo->srlg.miembros[k] = tmp;
+        memset(grafo->srlg.miembros[k] + palabras_antes, 0, sizeof(uint64_t) * (palabras - palabras_antes));
+    }
+    a->capacidad = nueva;
+    return 0;
+}
+
+static uint32_t hash_par(uint64_t clave)
+{
+    clave ^= clave >> 33;
+    clave *= UINT64_C(0xff51afd7ed558ccd);
+    clave ^= clave >> 33;
+    return (uint32_t)clave;
+}
+
+/* Inserta o reemplaza la arista asociada a clave; mantiene ocupación <= 50% */
+static int indice_aristas_poner(INDICE_ARISTAS *ix, uint64_t clave, int arista)
+{
+    uint64_t *claves_viejas;
+    int *aristas_viejas, cap_vieja, cap, i, j;
+
+    if ((ix->usadas + 1) * 2 > ix->capacidad)
+    {
+        claves_viejas = ix->clave;
+        aristas_viejas = ix->arista;
+        cap_vieja = ix->capacidad;
+        cap = cap_vieja ? cap_vieja * 2 : 64;
+        ix->clave = malloc(sizeof(uint64_t) * cap);
+        ix->arista = malloc(sizeof(int) * cap);
+        if (!ix->clave || !ix->arista)
+        {
+            free(ix->clave);
+            free(ix->arista);
+            ix->clave = claves_viejas;
+            ix->arista = aristas_viejas;
+            return -1;
+        }
+        for (i = 0; i < cap; ++i)
+            ix->arista[i] = -1;
+        ix->capacidad = cap;
+        for (i = 0; i < cap_vieja; ++i)
+        {
+            if (aristas_viejas[i] == -1)
+                continue;
+            j = (int)(hash_par(claves_viejas[i]) & (uint32_t)(cap - 1));
+            while (ix->arista[j] != -1)
+                j = (j + 1) & (cap - 1);
+            ix->clave[j] = claves_viejas[i];
+            ix->arista[j] = aristas_viejas[i];
+        }
+        free(claves_viejas);
+        free(aristas_viejas);
+    }
+    j = (int)(hash_par(clave) & (uint32_t)(ix->capacidad - 1));
+    while (ix->arista[j] != -1 && ix->clave[j] != clave)
+        j = (j + 1) & (ix->capacidad - 1);
+    if (ix->arista[j] == -1)
+        ix->usadas++;
+    ix->clave[j] = clave;
+    ix->arista[j] = arista;
+    return 0;
+}
+
+/* Borra clave desplazando hacia atrás la secuencia de sondeo (sin lápidas) */
+static void indice_aristas_quitar(INDICE_ARISTAS *ix, uint64_t clave)
+{
+    int mascara, i, j, k;
+
+    if (ix->capacidad == 0)
+        return;
+    mascara = ix->capacidad - 1;
+    i = (int)(hash_par(clave) & (uint32_t)mascara);
+    while (ix->arista[i] != -1 && ix->clave[i] != clave)
+        i = (i + 1) & mascara;
+    if (ix->arista[i] == -1)
+        return;
+    ix->arista[i] = -1;
+    ix->usadas--;
+    j = i;
+    for (;;)
+    {
+        j = (j + 1) & mascara;
+        if (ix->arista[j] == -1)
+            break;
+        k = (int)(hash_par(ix->clave[j]) & (uint32_t)mascara);
+        /* mover j a i si su posición ideal k no está en (i, j] */
+        if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+        ix->clave[i] = ix->clave[j];
+        ix->arista[i] = ix->arista[j];
+        ix->arista[j] = -1;
+        i = j;
+    }
+}
+
 GRAFO *crear_grafo(int capacidad_inicial)
 {
     GRAFO *grafo;
@@ -109,11 +404,20 @@ GRAFO *crear_grafo(int capacidad_inicial)
         return NULL;
 
     grafo->num_vertices = 0;
+    grafo->version = 0;
+    memset(&grafo->aristas, 0, sizeof(ARISTAS));
+    grafo->aristas.libre = -1;
     grafo->capacidad = (capacidad_inicial > 0) ? capacidad_inicial : 8;
     grafo->vertices = calloc(grafo->capacidad, sizeof(VERTICE));
+    grafo->datos = calloc(grafo->capacidad, sizeof(DATOS_VERTICE));
+    memset(&grafo->nombres, 0, sizeof(POOL_NOMBRES));
+    memset(&grafo->indice, 0, sizeof(INDICE_ARISTAS));
+    memset(&grafo->srlg, 0, sizeof(GRUPOS_RIESGO));
 
-    if (!grafo->vertices)
+    if (!grafo->vertices || !grafo->datos)
     {
+        free(grafo->vertices);
+        free(grafo->datos);
         free(grafo);
         return NULL;
     }
@@ -122,51 +426,88 @@ GRAFO *crear_grafo(int capacidad_inicial)
 
 void liberar_grafo(GRAFO *grafo)
 {
+    ARISTAS *a;
     int i;
-    ARISTA *ar, *sig;
 
     if (!grafo)
         return;
 
-    i = 0;
-    for (i = 0; i < grafo->num_vertices; ++i)
+    a = &grafo->aristas;
+    free(a->destino);
+    free(a->latencia_ms);
+    free(a->ancho_banda_mbps);
+    free(a->fiabilidad);
+    free(a->siguiente);
+    free(a->activo);
+    free(a->origen);
+    free(a->siguiente_entrante);
+    for (i = 0; i < grafo->srlg.num; ++i)
+        free(grafo->srlg.miembros[i]);
+    free(grafo->srlg.miembros);
+    free(grafo->srlg.nombre);
+    for (i = 0; i < grafo->nombres.num_bloques; ++i)
+        free(grafo->nombres.bloques[i]);
+    free(grafo->nombres.bloques);
+    free(grafo->nombres.tabla);
+    free(grafo->indice.clave);
+    free(grafo->indice.arista);
+    free(grafo->datos);
+    free(grafo->vertices);
+    free(grafo);
+}
+
+/* Convierte a.b.c.d (0-255) a entero; 0 si el formato es inválido */
+int ip_parsear(const char *ip, uint32_t *salida)
+{
+    uint32_t valor, octeto;
+    int partes, digitos;
+
+    if (!ip)
+        return 0;
+    valor = 0;
+    for (partes = 0; partes < 4; ++partes)
     {
-        ar = grafo->vertices[i].lista_adyacencia;
-        while (ar)
+        octeto = 0;
+        digitos = 0;
+        while (*ip >= '0' && *ip <= '9' && digitos < 4)
         {
-            sig = ar->siguiente;
-            free(ar);
-            ar = sig;
+            octeto = octeto * 10 + (uint32_t)(*ip++ - '0');
+            ++digitos;
         }
+        if (digitos == 0 || octeto > 255)
+            return 0;
+        valor = (valor << 8) | octeto;
+        if (partes < 3 && *ip++ != '.')
+            return 0;
     }
-    free(grafo->vertices);
-    free(grafo);
+    if (salida)
+        *salida = valor;
+    return 1;
 }
 
 /* Comprueba formato IPv4 simple: a.b.c.d  (0-255) */
 int ip_valida(const char *ip)
 {
-    int a, b, c, d;
-    char extra[8];
+    return ip_parsear(ip, NULL);
+}
 
-    if (!ip)
-        return 0;
-    if (sscanf(ip, "%d.%d.%d.%d%7s", &a, &b, &c, &d, extra) < 4)
-        return 0;
-    if (a < 0 || a > 255 || b < 0 || b > 255 || c < 0 || c > 255 || d < 0 || d > 255)
-        return 0;
-    return 1;
+const char *ip_a_cadena(uint32_t ip, char *buf)
+{
+    snprintf(buf, MAX_IP, "%u.%u.%u.%u", (ip >> 24) & 255u, (ip >> 16) & 255u, (ip >> 8) & 255u, ip & 255u);
+    return buf;
 }
 
 /* agregar vertice */
 int agregar_vertice(GRAFO *grafo, const char *nombre, const char *ip, Tipo_Dispositivo tipo, int capacidad_proc)
 {
-    int indice;
+    int indice, j;
+    uint32_t ip_bin;
     VERTICE *v;
+    DATOS_VERTICE *d;
 
     if (!grafo || !nombre || !ip)
         return -1;
-    if (!ip_valida(ip))
+    if (!ip_parsear(ip, &ip_bin))
     {
         printf("[ERROR] IP inválida: %s\n", ip);
         return -1;
@@ -176,34 +517,46 @@ int agregar_vertice(GRAFO *grafo, const char *nombre, const char *ip, Tipo_Dispo
         printf("[ERROR] Nodo duplicado: %s\n", nombre);
         return -1;
     }
-    if (asegurar_capacidad(grafo) != 0)
+    if (asegurar_capacidad(grafo) != 0 || asegurar_tabla_nombres(grafo) != 0)
         return -1;
 
-    indice = grafo->num_vertices++;
+    indice = grafo->num_vertices;
+    d = &grafo->datos[indice];
+    d->nombre = internar_nombre(grafo, nombre);
+    if (!d->nombre)
+        return -1;
+    d->ip = ip_bin;
+    d->capacidad_procesamiento = capacidad_proc;
     v = &grafo->vertices[indice];
-    strncpy(v->nombre, nombre, MAX_NOMBRE - 1);
-    v->nombre[MAX_NOMBRE - 1] = '\0';
-    strncpy(v->ip, ip, MAX_IP - 1);
-    v->ip[MAX_IP - 1] = '\0';
-    v->tipo = tipo;
-    v->capacidad_procesamiento = capacidad_proc;
+    v->tipo = (unsigned char)tipo;
     v->activo = 1;
-    v->lista_adyacencia = NULL;
+    v->primera_arista = -1;
+    v->primera_entrante = -1;
+    grafo->num_vertices++;
+    grafo->version++;
+
+    j = (int)(hash_nombre(nombre) & (uint32_t)(grafo->nombres.capacidad_tabla - 1));
+    while (grafo->nombres.tabla[j] != -1)
+        j = (j + 1) & (grafo->nombres.capacidad_tabla - 1);
+    grafo->nombres.tabla[j] = indice;
     return indice;
 }
 
 int indice_por_nombre(GRAFO *grafo, const char *nombre)
 {
-    int i;
+    int j, i, mascara;
 
-    if (!grafo || !nombre)
+    if (!grafo || !nombre || grafo->nombres.capacidad_tabla == 0)
         return -1;
+    INSTR_SUMAR(resoluciones_nombre, 1);
 
-    i = 0;
-    for (i = 0; i < grafo->num_vertices; ++i)
+    mascara = grafo->nombres.capacidad_tabla - 1;
+    j = (int)(hash_nombre(nombre) & (uint32_t)mascara);
+    while ((i = grafo->nombres.tabla[j]) != -1)
     {
-        if (strncmp(grafo->vertices[i].nombre, nombre, MAX_NOMBRE) == 0)
+        if (strcmp(grafo->datos[i].nombre, nombre) == 0)
             return i;
+        j = (j + 1) & mascara;
     }
     return -1;
 }
@@ -215,13 +568,15 @@ int establecer_estado_vertice(GRAFO *grafo, int indice, int activo)
     if (indice < 0 || indice >= grafo->num_vertices)
         return -1;
     grafo->vertices[indice].activo = activo ? 1 : 0;
+    grafo->version++;
     return 0;
 }
 
 /* agraga arista de origen -> dest */
 int agregar_arista(GRAFO *grafo, int indice_origen, int indice_destino, int latencia_ms, int ancho_banda_mbps, double fiabilidad, int activo)
 {
-    ARISTA *ar;
+    ARISTAS *a;
+    int e;
     if (!grafo)
         return -1;
     if (indice_origen < 0 || indice_origen >= grafo->num_vertices)
@@ -238,41 +593,223 @@ int agregar_arista(GRAFO *grafo, int indice_origen, int indice_destino, int late
     if (fiabilidad > 1.0)
         fiabilidad = 1.0;
 
-    ar = malloc(sizeof(ARISTA));
-    if (!ar)
+    a = &grafo->aristas;
+    if (a->libre != -1)
+    {
+        e = a->libre;
+    }
+    else
+    {
+        if (asegurar_capacidad_aristas(grafo) != 0)
+            return -1;
+        e = a->num;
+    }
+    if (indice_aristas_poner(&grafo->indice, ((uint64_t)indice_origen << 32) | (uint32_t)indice_destino, e) != 0)
         return -1;
-    ar->destino = indice_destino;
-    ar->latencia_ms = latencia_ms;
-    ar->ancho_banda_mbps = ancho_banda_mbps;
-    ar->fiabilidad = fiabilidad;
-    ar->activo = activo ? 1 : 0;
-    ar->siguiente = grafo->vertices[indice_origen].lista_adyacencia;
-    grafo->vertices[indice_origen].lista_adyacencia = ar;
+    if (e == a->libre)
+        a->libre = a->siguiente[e];
+    else
+        a->num++;
+    a->destino[e] = indice_destino;
+    a->latencia_ms[e] = latencia_ms;
+    a->ancho_banda_mbps[e] = ancho_banda_mbps;
+    a->fiabilidad[e] = (float)fiabilidad;
+    if (activo)
+        ARISTA_ACTIVAR(grafo, e);
+    else
+        ARISTA_DESACTIVAR(grafo, e);
+    a->siguiente[e] = grafo->vertices[indice_origen].primera_arista;
+    grafo->vertices[indice_origen].primera_arista = e;
+    a->origen[e] = indice_origen;
+    a->siguiente_entrante[e] = grafo->vertices[indice_destino].primera_entrante;
+    grafo->vertices[indice_destino].primera_entrante = e;
     return 0;
 }
 
 int establecer_estado_arista(GRAFO *grafo, int indice_origen, int indice_destino, int activo)
 {
-    ARISTA *ar;
+    int e;
     if (!grafo)
         return -1;
     if (indice_origen < 0 || indice_origen >= grafo->num_vertices)
         return -1;
 
-    ar = grafo->vertices[indice_origen].lista_adyacencia;
+    e = buscar_arista(grafo, indice_origen, indice_destino);
+    if (e == -1)
+        return -1;
+    if (activo)
+        ARISTA_ACTIVAR(grafo, e);
+    else
+        ARISTA_DESACTIVAR(grafo, e);
+    return 0;
+}
+
+/* Arista más reciente origen -> destino, o -1 */
+int buscar_arista(const GRAFO *grafo, int indice_origen, int indice_destino)
+{
+    const INDICE_ARISTAS *ix;
+    uint64_t clave;
+    int j;
+
+    if (!grafo || grafo->indice.capacidad == 0 || indice_origen < 0 || indice_destino < 0)
+        return -1;
+    ix = &grafo->indice;
+    clave = ((uint64_t)indice_origen << 32) | (uint32_t)indice_destino;
+    j = (int)(hash_par(clave) & (uint32_t)(ix->capacidad - 1));
+    while (ix->arista[j] != -1)
+    {
+        if (ix->clave[j] == clave)
+            return ix->arista[j];
+        j = (j + 1) & (ix->capacidad - 1);
+    }
+    return -1;
+}
+
+/* Primera arista activa origen -> destino; solo recorre la lista si hay paralelas y la más reciente está caída */
+int buscar_arista_activa(const GRAFO *grafo, int indice_origen, int indice_destino)
+{
+    int e;
 
-    while (ar)
+    e = buscar_arista(grafo, indice_origen, indice_destino);
+    if (e == -1 || ARISTA_ACTIVA(grafo, e))
+        return e;
+    for (e = grafo->aristas.siguiente[e]; e != -1; e = grafo->aristas.siguiente[e])
     {
-        if (ar->destino == indice_destino)
-        {
-            ar->activo = activo ? 1 : 0;
-            return 0;
-        }
-        ar = ar->siguiente;
+        if (grafo->aristas.destino[e] == indice_destino && ARISTA_ACTIVA(grafo, e))
+            return e;
     }
     return -1;
 }
 
+/* Desenlaza la arista de la lista de su origen y deja la ranura para reutilizar */
+int eliminar_arista(GRAFO *grafo, int indice_origen, int arista)
+{
+    ARISTAS *a;
+    int e, previa, k;
+    uint64_t clave;
+
+    if (!grafo)
+        return -1;
+    if (indice_origen < 0 || indice_origen >= grafo->num_vertices)
+        return -1;
+    a = &grafo->aristas;
+    previa = -1;
+    e = grafo->vertices[indice_origen].primera_arista;
+    while (e != -1 && e != arista)
+    {
+        previa = e;
+        e = a->siguiente[e];
+    }
+    if (e == -1)
+        return -1;
+    if (previa == -1)
+        grafo->vertices[indice_origen].primera_arista = a->siguiente[e];
+    else
+        a->siguiente[previa] = a->siguiente[e];
+    /* si era la indexada, apuntar a la siguiente paralela (si la hay) */
+    if (buscar_arista(grafo, indice_origen, a->destino[e]) == e)
+    {
+        clave = ((uint64_t)indice_origen << 32) | (uint32_t)a->destino[e];
+        for (previa = a->siguiente[e]; previa != -1; previa = a->siguiente[previa])
+            if (a->destino[previa] == a->destino[e])
+                break;
+        if (previa != -1)
+            indice_aristas_poner(&grafo->indice, clave, previa);
+        else
+            indice_aristas_quitar(&grafo->indice, clave);
+    }
+    /* desenlazar también de la lista de entrantes del destino */
+    previa = -1;
+    for (k = grafo->vertices[a->destino[e]].primera_entrante; k != -1 && k != e; k = a->siguiente_entrante[k])
+        previa = k;
+    if (previa == -1)
+        grafo->vertices[a->destino[e]].primera_entrante = a->siguiente_entrante[e];
+    else
+        a->siguiente_entrante[previa] = a->siguiente_entrante[e];
+    a->destino[e] = -1;
+    a->origen[e] = -1;
+    ARISTA_DESACTIVAR(grafo, e);
+    for (k = 0; k < grafo->srlg.num; ++k)
+        asignar_grupo_arista(grafo, k, e, 0);
+    a->siguiente[e] = a->libre;
+    a->libre = e;
+    return 0;
+}
+
+int grado_entrada(const GRAFO *grafo, int indice)
+{
+    int e, grado;
+
+    if (!grafo || indice < 0 || indice >= grafo->num_vertices)
+        return -1;
+    grado = 0;
+    for (e = grafo->vertices[indice].primera_entrante; e != -1; e = grafo->aristas.siguiente_entrante[e])
+        ++grado;
+    return grado;
+}
+
+/* Búsqueda lineal: los grupos son pocos (conductos, tarjetas) frente a las aristas */
+int grupo_por_nombre(const GRAFO *grafo, const char *nombre)
+{
+    int k;
+
+    if (!grafo || !nombre)
+        return -1;
+    for (k = 0; k < grafo->srlg.num; ++k)
+        if (strcmp(grafo->srlg.nombre[k], nombre) == 0)
+            return k;
+    return -1;
+}
+
+int agregar_grupo_riesgo(GRAFO *grafo, const char *nombre)
+{
+    GRUPOS_RIESGO *s;
+    const char *interno;
+    void *tmp;
+    int k, nueva;
+
+    k = grupo_por_nombre(grafo, nombre);
+    if (k != -1 || !grafo || !nombre)
+        return k;
+    s = &grafo->srlg;
+    if (s->num == s->capacidad)
+    {
+        nueva = s->capacidad ? s->capacidad * 2 : 8;
+        tmp = realloc(s->nombre, sizeof(*s->nombre) * nueva);
+        if (!tmp)
+            return -1;
+        s->nombre = tmp;
+        tmp = realloc(s->miembros, sizeof(*s->miembros) * nueva);
+        if (!tmp)
+            return -1;
+        s->miembros = tmp;
+        s->capacidad = nueva;
+    }
+    interno = internar_nombre(grafo, nombre);
+    s->miembros[s->num] = calloc((grafo->aristas.capacidad + 63) / 64 + 1, sizeof(uint64_t));
+    if (!interno || !s->miembros[s->num])
+    {
+        free(s->miembros[s->num]);
+        return -1;
+    }
+    s->nombre[s->num] = interno;
+    return s->num++;
+}
+
+int asignar_grupo_arista(GRAFO *grafo, int grupo, int arista, int miembro)
+{
+    uint64_t bit;
+
+    if (!grafo || grupo < 0 || grupo >= grafo->srlg.num || arista < 0 || arista >= grafo->aristas.num)
+        return -1;
+    bit = UINT64_C(1) << (arista & 63);
+    if (miembro)
+        grafo->srlg.miembros[grupo][arista >> 6] |= bit;
+    else
+        grafo->srlg.miembros[grupo][arista >> 6] &= ~bit;
+    return 0;
+}
+
 const char *tipo_dispositivo_a_cadena(Tipo_Dispositivo t)
 {
     switch (t)
@@ -293,9 +830,12 @@ const char *tipo_dispositivo_a_cadena(Tipo_Dispositivo t)
 /* IMPRIME GRAFO */
 void imprimir_grafo(GRAFO *grafo)
 {
-    int i;
+    int i, e, k;
+    char separador;
     VERTICE *v;
-    ARISTA *ar;
+    DATOS_VERTICE *d;
+    ARISTAS *a;
+    char ip[MAX_IP];
 
     if (!grafo)
     {
@@ -308,12 +848,24 @@ void imprimir_grafo(GRAFO *grafo)
     for (i = 0; i < grafo->num_vertices; ++i)
     {
         v = &grafo->vertices[i];
-        printf(" [%d] %s (%s) - Tipo: %s, Cap: %d, Estado: %s\n", i, v->nombre, v->ip, tipo_dispositivo_a_cadena(v->tipo), v->capacidad_procesamiento, v->activo ? "ACTIVO" : "FALLIDO");
-        ar = v->lista_adyacencia;
-        while (ar)
+        d = &grafo->datos[i];
+        printf(" [%d] %s (%s) - Tipo: %s, Cap: %d, Estado: %s\n", i, d->nombre, ip_a_cadena(d->ip, ip), tipo_dispositivo_a_cadena((Tipo_Dispositivo)v->tipo), d->capacidad_procesamiento, v->activo ? "ACTIVO" : "FALLIDO");
+        a = &grafo->aristas;
+        e = v->primera_arista;
+        while (e != -1)
         {
-            printf("    -> %s (idx %d) | lat=%dms bw=%dMbps conf=%.2f estado=%s\n", ((ar->destino >= 0 && ar->destino < grafo->num_vertices) ? grafo->vertices[ar->destino].nombre : "??"), ar->destino, ar->latencia_ms, ar->ancho_banda_mbps, ar->fiabilidad, ar->activo ? "ACTIVO" : "FALLADO");
-            ar = ar->siguiente;
+            printf("    -> %s (idx %d) | lat=%dms bw=%dMbps conf=%.2f estado=%s", ((a->destino[e] >= 0 && a->destino[e] < grafo->num_vertices) ? grafo->datos[a->destino[e]].nombre : "??"), a->destino[e], a->latencia_ms[e], a->ancho_banda_mbps[e], (double)a->fiabilidad[e], ARISTA_ACTIVA(grafo, e) ? "ACTIVO" : "FALLADO");
+            separador = '=';
+            for (k = 0; k < grafo->srlg.num; ++k)
+            {
+                if (ARISTA_EN_GRUPO(grafo, k, e))
+                {
+                    printf("%s%c%s", separador == '=' ? " srlg" : "", separador, grafo->srlg.nombre[k]);
+                    separador = ',';
+                }
+            }
+            printf("\n");
+            e = a->siguiente[e];
         }
     }
 }
@@ -322,9 +874,11 @@ void imprimir_grafo(GRAFO *grafo)
 int guardar_grafo(GRAFO *grafo, const char *filename)
 {
     FILE *f;
-    int i, contador_aristas;
-    VERTICE *v;
-    ARISTA *ar;
+    int i, e, k, contador_aristas;
+    char separador;
+    DATOS_VERTICE *d;
+    ARISTAS *a;
+    char ip[MAX_IP];
 
     if (!grafo || !filename)
         return -1;
@@ -339,21 +893,22 @@ int guardar_grafo(GRAFO *grafo, const char *filename)
     i = 0;
     for (i = 0; i < grafo->num_vertices; ++i)
     {
-        v = &grafo->vertices[i];
+        d = &grafo->datos[i];
         /* NODE <nombre> <ip> <tipo> <cap> */
-        fprintf(f, "N %s %s %d %d\n", v->nombre, v->ip, (int)v->tipo, v->capacidad_procesamiento);
+        fprintf(f, "N %s %s %d %d\n", d->nombre, ip_a_cadena(d->ip, ip), (int)grafo->vertices[i].tipo, d->capacidad_procesamiento);
     }
     /* contar aristas */
     contador_aristas = 0;
+    a = &grafo->aristas;
 
     i = 0;
     for (i = 0; i < grafo->num_vertices; ++i)
     {
-        ar = grafo->vertices[i].lista_adyacencia;
-        while (ar)
+        e = grafo->vertices[i].primera_arista;
+        while (e != -1)
         {
             ++contador_aristas;
-            ar = ar->siguiente;
+            e = a->siguiente[e];
         }
     }
 
@@ -362,20 +917,35 @@ int guardar_grafo(GRAFO *grafo, const char *filename)
     i = 0;
     for (i = 0; i < grafo->num_vertices; ++i)
     {
-        ar = grafo->vertices[i].lista_adyacencia;
-        while (ar)
+        e = grafo->vertices[i].primera_arista;
+        while (e != -1)
         {
-            /* EDGE <origenName> <destName> <lat> <bw> <fiab> <activo> */
-            fprintf(f, "A %s %s %d %d %.6f %d\n",
-                    grafo->vertices[i].nombre,
-                    grafo->vertices[ar->destino].nombre,
-                    ar->latencia_ms,
-                    ar->ancho_banda_mbps,
-                    ar->fiabilidad,
-                    ar->activo);
-            ar = ar->siguiente;
+            /* EDGE <origenName> <destName> <lat> <bw> <fiab> <activo> [grupo,grupo...] */
+            fprintf(f, "A %s %s %d %d %.6f %d",
+                    grafo->datos[i].nombre,
+                    grafo->datos[a->destino[e]].nombre,
+                    a->latencia_ms[e],
+                    a->ancho_banda_mbps[e],
+                    (double)a->fiabilidad[e],
+                    ARISTA_ACTIVA(grafo, e));
+            separador = ' ';
+            for (k = 0; k < grafo->srlg.num; ++k)
+            {
+                if (ARISTA_EN_GRUPO(grafo, k, e))
+                {
+                    fprintf(f, "%c%s", separador, grafo->srlg.nombre[k]);
+                    separador = ',';
+                }
+            }
+            fputc('\n', f);
+            e = a->siguiente[e];
         }
     }
+    /* VERTEX <nombre> 0: solo los fallidos, el resto se da por activo */
+    for (i = 0; i < grafo->num_vertices; ++i)
+        if (!grafo->vertices[i].activo)
+            fprintf(f, "V %s 0\n", grafo->datos[i].nombre);
+    INSTR_BYTES_ARCHIVO(bytes_escritos, f);
     fclose(f);
     return 0;
 }
@@ -384,10 +954,9 @@ int guardar_grafo(GRAFO *grafo, const char *filename)
 int cargar_grafo(GRAFO *grafo, const char *filename)
 {
     FILE *f;
-    char linea[512], nombre[MAX_NOMBRE], ip[MAX_IP], tag[32], orig[MAX_NOMBRE], dest[MAX_NOMBRE];
-    int nodos_esperados, aristas_esperadas, tipo_int, cap, lat, bw, activo, oi, di;
+    char *linea, *tag, *nombre, *ip, *orig, *dest, *campo[5], *resto;
+    int nodos_esperados, aristas_esperadas, tipo_int, cap, activo, oi, di, k, grupo;
     Tipo_Dispositivo dt;
-    double fi;
 
     if (!grafo || !filename)
         return -1;
@@ -397,62 +966,362 @@ int cargar_grafo(GRAFO *grafo, const char *filename)
     if (!f)
         return -1;
 
+    linea = malloc(MAX_LINEA);
+    if (!linea)
+    {
+        fclose(f);
+        return -1;
+    }
+
     nodos_esperados = -1;
     aristas_esperadas = -1;
 
     /* We'll store node names to map them to indices as they're added */
-    while (fgets(linea, sizeof(linea), f))
+    while (fgets(linea, MAX_LINEA, f))
     {
         if (linea[0] == '#' || isspace((unsigned char)linea[0]))
             continue;
 
-        if (sscanf(linea, "%31s", tag) != 1)
+        tag = strtok(linea, " \t\r\n");
+        if (!tag)
             continue;
 
         if (strcmp(tag, "NS") == 0)
         {
-            sscanf(linea + strlen("NS"), "%d", &nodos_esperados);
+            tag = strtok(NULL, " \t\r\n");
+            if (tag)
+                nodos_esperados = atoi(tag);
         }
         else if (strcmp(tag, "N") == 0)
         {
-            tipo_int = D_DEFAULT;
-            cap = 0;
             /* NODE <nombre> <ip> <tipo> <cap> */
-            if (sscanf(linea, "N %63s %15s %d %d", nombre, ip, &tipo_int, &cap) >= 3)
+            nombre = strtok(NULL, " \t\r\n");
+            ip = strtok(NULL, " \t\r\n");
+            campo[0] = strtok(NULL, " \t\r\n");
+            campo[1] = strtok(NULL, " \t\r\n");
+            if (nombre && ip && campo[0])
             {
+                tipo_int = atoi(campo[0]);
+                cap = campo[1] ? atoi(campo[1]) : 0;
                 dt = (Tipo_Dispositivo)tipo_int;
                 agregar_vertice(grafo, nombre, ip, dt, cap);
             }
         }
         else if (strcmp(tag, "AS") == 0)
         {
-            sscanf(linea + strlen("AS"), "%d", &aristas_esperadas);
+            tag = strtok(NULL, " \t\r\n");
+            if (tag)
+                aristas_esperadas = atoi(tag);
         }
         else if (strcmp(tag, "A") == 0)
         {
-            if (sscanf(linea, "A %63s %63s %d %d %lf %d", orig, dest, &lat, &bw, &fi, &activo) >= 6)
+            orig = strtok(NULL, " \t\r\n");
+            dest = strtok(NULL, " \t\r\n");
+            for (k = 0; k < 5; ++k)
+                campo[k] = strtok(NULL, " \t\r\n");
+            if (orig && dest && campo[3])
             {
                 oi = indice_por_nombre(grafo, orig);
                 di = indice_por_nombre(grafo, dest);
+                activo = atoi(campo[3]);
                 if (oi == -1 || di == -1)
                 {
                     /* ignorar o reportar en cli */
                     printf("[ERROR] A hace referencia a nodo invalido: %s -> %s\n", orig, dest);
                 }
-                else
+                else if (agregar_arista(grafo, oi, di, atoi(campo[0]), atoi(campo[1]), atof(campo[2]), activo) == 0 && campo[4])
                 {
-                    agregar_arista(grafo, oi, di, lat, bw, fi, activo);
+                    /* la arista recién añadida es la cabeza de la lista de oi */
+                    for (nombre = strtok_r(campo[4], ",", &resto); nombre; nombre = strtok_r(NULL, ",", &resto))
+                    {
+                        grupo = agregar_grupo_riesgo(grafo, nombre);
+                        asignar_grupo_arista(grafo, grupo, grafo->vertices[oi].primera_arista, 1);
+                    }
                 }
             }
         }
+        else if (strcmp(tag, "V") == 0)
+        {
+            nombre = strtok(NULL, " \t\r\n");
+            campo[0] = strtok(NULL, " \t\r\n");
+            oi = nombre ? indice_por_nombre(grafo, nombre) : -1;
+            if (oi != -1 && campo[0])
+                establecer_estado_vertice(grafo, oi, atoi(campo[0]));
+        }
         else
         {
             /* ignora todo lo demas */
         }
     }
 
+    (void)nodos_esperados;
+    (void)aristas_esperadas;
+    free(linea);
+    INSTR_BYTES_ARCHIVO(bytes_leidos, f);
     fclose(f);
     return 0;
 }
 
+/*
+ * Instantánea binaria: volcado directo de las columnas, incluidos los índices
+ * de adyacencia directa e inversa, para no reconstruirlos al cargar.
+ * Formato (orden de bytes nativo):
+ *   "SIREDIO\1" | uint32 0x01020304 | int n | int num | int libre
+ *   n x {int primera_arista, int primera_entrante, uchar tipo, uchar activo,
+ *        uint32 ip, int cap, uint32 len, nombre[len]}
+ *   columnas de aristas (num elementos cada una) y bitset de activo
+ *   uint32 grupos | grupos x {uint32 len, nombre[len], bitset de miembros}
+ * Las instantáneas anteriores a los grupos terminan tras el bitset de activo
+ * y se cargan sin grupos.
+ */
+#define INSTANTANEA_MAGIA "SIREDIO\1"
+#define INSTANTANEA_ORDEN 0x01020304u
+
+int guardar_instantanea(GRAFO *grafo, const char *filename)
+{
+    FILE *f;
+    ARISTAS *a;
+    VERTICE *v;
+    DATOS_VERTICE *d;
+    uint32_t orden, len, grupos;
+    int i, ok;
+
+    if (!grafo || !filename)
+        return -1;
+    f = fopen(filename, "wb");
+    if (!f)
+        return -1;
+
+    a = &grafo->aristas;
+    orden = INSTANTANEA_ORDEN;
+    ok = fwrite(INSTANTANEA_MAGIA, 1, 8, f) == 8;
+    ok = ok && fwrite(&orden, sizeof(orden), 1, f) == 1;
+    ok = ok && fwrite(&grafo->num_vertices, sizeof(int), 1, f) == 1;
+    ok = ok && fwrite(&a->num, sizeof(int), 1, f) == 1;
+    ok = ok && fwrite(&a->libre, sizeof(int), 1, f) == 1;
+    for (i = 0; ok && i < grafo->num_vertices; ++i)
+    {
+        v = &grafo->vertices[i];
+        d = &grafo->datos[i];
+        len = (uint32_t)strlen(d->nombre);
+        ok = fwrite(&v->primera_arista, sizeof(int), 1, f) == 1 &&
+             fwrite(&v->primera_entrante, sizeof(int), 1, f) == 1 &&
+             fwrite(&v->tipo, 1, 1, f) == 1 &&
+             fwrite(&v->activo, 1, 1, f) == 1 &&
+             fwrite(&d->ip, sizeof(uint32_t), 1, f) == 1 &&
+             fwrite(&d->capacidad_procesamiento, sizeof(int), 1, f) == 1 &&
+             fwrite(&len, sizeof(len), 1, f) == 1 &&
+             fwrite(d->nombre, 1, len, f) == len;
+    }
+    if (ok && a->num > 0)
+    {
+        ok = fwrite(a->destino, sizeof(int), a->num, f) == (size_t)a->num &&
+             fwrite(a->latencia_ms, sizeof(int), a->num, f) == (size_t)a->num &&
+             fwrite(a->ancho_banda_mbps, sizeof(int), a->num, f) == (size_t)a->num &&
+             fwrite(a->fiabilidad, sizeof(float), a->num, f) == (size_t)a->num &&
+             fwrite(a->siguiente, sizeof(int), a->num, f) == (size_t)a->num &&
+             fwrite(a->origen, sizeof(int), a->num, f) == (size_t)a->num &&
+             fwrite(a->siguiente_entrante, sizeof(int), a->num, f) == (size_t)a->num &&
+             fwrite(a->activo, sizeof(uint64_t), (a->num + 63) / 64, f) == (size_t)((a->num + 63) / 64);
+    }
+    grupos = (uint32_t)grafo->srlg.num;
+    ok = ok && fwrite(&grupos, sizeof(grupos), 1, f) == 1;
+    for (i = 0; ok && i < grafo->srlg.num; ++i)
+    {
+        len = (uint32_t)strlen(grafo->srlg.nombre[i]);
+        ok = fwrite(&len, sizeof(len), 1, f) == 1 &&
+             fwrite(grafo->srlg.nombre[i], 1, len, f) == len &&
+             fwrite(grafo->srlg.miembros[i], sizeof(uint64_t), (a->num + 63) / 64, f) == (size_t)((a->num + 63) / 64);
+    }
+    INSTR_BYTES_ARCHIVO(bytes_escritos, f);
+    if (fclose(f) != 0)
+        ok = 0;
+    return ok ? 0 : -1;
+}
+
+#define INDICE_VALIDO(x, lim) ((x) >= -1 && (x) < (lim))
+
+/*
+ * Una instantánea truncada o corrupta no debe llevar a lecturas fuera de las
+ * columnas ni a bucles sin fin: todo índice ha de ser -1 o caer en su rango,
+ * y cada arista puede aparecer una sola vez entre las listas de salida y la
+ * de ranuras libres (y una sola vez entre las de entrada), siempre en la lista
+ * del vértice que dicen sus columnas. Así cada recorrido acaba en num pasos
+ * y las aristas vivas están todas enlazadas.
+ */
+static int validar_instantanea(const GRAFO *grafo, int libre)
+{
+    const ARISTAS *a = &grafo->aristas;
+    int n, num, u, e, ok;
+    unsigned char *visto;
+
+    n = grafo->num_vertices;
+    num = a->num;
+    if (!INDICE_VALIDO(libre, num))
+        return -1;
+    for (u = 0; u < n; ++u)
+        if (!INDICE_VALIDO(grafo->vertices[u].primera_arista, num) || !INDICE_VALIDO(grafo->vertices[u].primera_entrante, num) ||
+            grafo->vertices[u].tipo > D_DEFAULT || grafo->vertices[u].activo > 1)
+            return -1;
+    for (e = 0; e < num; ++e)
+        if (!INDICE_VALIDO(a->destino[e], n) || !INDICE_VALIDO(a->origen[e], n) || !INDICE_VALIDO(a->siguiente[e], num) ||
+            !INDICE_VALIDO(a->siguiente_entrante[e], num) || (a->destino[e] == -1) != (a->origen[e] == -1))
+            return -1;
+
+    visto = calloc(num + 1, 1);
+    if (!visto)
+        return -1;
+    ok = 1;
+    for (u = 0; ok && u < n; ++u)
+        for (e = grafo->vertices[u].primera_arista; ok && e != -1; e = a->siguiente[e])
+        {
+            ok = !visto[e] && a->origen[e] == u;
+            visto[e] = 1;
+        }
+    for (e = libre; ok && e != -1; e = a->siguiente[e])
+    {
+        ok = !visto[e] && a->destino[e] == -1;
+        visto[e] = 1;
+    }
+    for (e = 0; ok && e < num; ++e)
+        ok = visto[e] || a->destino[e] == -1; /* toda arista viva está en la lista de su origen */
+    memset(visto, 0, num + 1);
+    for (u = 0; ok && u < n; ++u)
+        for (e = grafo->vertices[u].primera_entrante; ok && e != -1; e = a->siguiente_entrante[e])
+        {
+            ok = !visto[e] && a->destino[e] == u;
+            visto[e] = 1;
+        }
+    for (e = 0; ok && e < num; ++e)
+        ok = visto[e] || a->destino[e] == -1;
+    free(visto);
+    return ok ? 0 : -1;
+}
+
+/* Devuelve un grafo nuevo con el contenido de la instantánea, o NULL */
+GRAFO *cargar_instantanea(const char *filename)
+{
+    FILE *f;
+    GRAFO *grafo;
+    ARISTAS *a;
+    VERTICE *v;
+    DATOS_VERTICE *d;
+    char magia[8], *nombre;
+    uint32_t orden, len, grupos;
+    int n, num, libre, i, u, e, j, ok;
+    uint64_t clave;
+
+    if (!filename)
+        return NULL;
+    f = fopen(filename, "rb");
+    if (!f)
+        return NULL;
+
+    ok = fread(magia, 1, 8, f) == 8 && memcmp(magia, INSTANTANEA_MAGIA, 8) == 0 &&
+         fread(&orden, sizeof(orden), 1, f) == 1 && orden == INSTANTANEA_ORDEN &&
+         fread(&n, sizeof(int), 1, f) == 1 && fread(&num, sizeof(int), 1, f) == 1 &&
+         fread(&libre, sizeof(int), 1, f) == 1 && n >= 0 && num >= 0;
+    grafo = ok ? crear_grafo(n) : NULL;
+    if (!grafo)
+    {
+        fclose(f);
+        return NULL;
+    }
+
+    /* los nombres se reinsertan para reconstruir el pool y su tabla hash */
+    nombre = NULL;
+    for (i = 0; ok && i < n; ++i)
+    {
+        v = &grafo->vertices[i];
+        d = &grafo->datos[i];
+        ok = fread(&v->primera_arista, sizeof(int), 1, f) == 1 &&
+             fread(&v->primera_entrante, sizeof(int), 1, f) == 1 &&
+             fread(&v->tipo, 1, 1, f) == 1 &&
+             fread(&v->activo, 1, 1, f) == 1 &&
+             fread(&d->ip, sizeof(uint32_t), 1, f) == 1 &&
+             fread(&d->capacidad_procesamiento, sizeof(int), 1, f) == 1 &&
+             fread(&len, sizeof(len), 1, f) == 1;
+        if (!ok)
+            break;
+        free(nombre);
+        nombre = malloc((size_t)len + 1);
+        ok = nombre && fread(nombre, 1, len, f) == len;
+        if (!ok)
+            break;
+        nombre[len] = '\0';
+        ok = asegurar_tabla_nombres(grafo) == 0 && (d->nombre = internar_nombre(grafo, nombre)) != NULL;
+        if (!ok)
+            break;
+        j = (int)(hash_nombre(nombre) & (uint32_t)(grafo->nombres.capacidad_tabla - 1));
+        while (grafo->nombres.tabla[j] != -1)
+            j = (j + 1) & (grafo->nombres.capacidad_tabla - 1);
+        grafo->nombres.tabla[j] = i;
+        grafo->num_vertices = i + 1;
+    }
+    free(nombre);
+
+    a = &grafo->aristas;
+    while (ok && a->capacidad < num)
+    {
+        a->num = a->capacidad;
+        ok = asegurar_capacidad_aristas(grafo) == 0;
+    }
+    if (ok && num > 0)
+    {
+        ok = fread(a->destino, sizeof(int), num, f) == (size_t)num &&
+             fread(a->latencia_ms, sizeof(int), num, f) == (size_t)num &&
+             fread(a->ancho_banda_mbps, sizeof(int), num, f) == (size_t)num &&
+             fread(a->fiabilidad, sizeof(float), num, f) == (size_t)num &&
+             fread(a->siguiente, sizeof(int), num, f) == (size_t)num &&
+             fread(a->origen, sizeof(int), num, f) == (size_t)num &&
+             fread(a->siguiente_entrante, sizeof(int), num, f) == (size_t)num &&
+             fread(a->activo, sizeof(uint64_t), (num + 63) / 64, f) == (size_t)((num + 63) / 64);
+    }
+    a->num = num;
+    a->libre = libre;
+    /* sin trailer de grupos: instantánea anterior, se carga sin ellos */
+    if (ok && fread(&grupos, sizeof(grupos), 1, f) == 1)
+    {
+        nombre = NULL;
+        for (j = 0; ok && j < (int)grupos; ++j)
+        {
+            ok = fread(&len, sizeof(len), 1, f) == 1 && (nombre = malloc((size_t)len + 1)) != NULL &&
+                 fread(nombre, 1, len, f) == len;
+            if (ok)
+            {
+                nombre[len] = '\0';
+                u = agregar_grupo_riesgo(grafo, nombre);
+                ok = u != -1 && fread(grafo->srlg.miembros[u], sizeof(uint64_t), (num + 63) / 64, f) == (size_t)((num + 63) / 64);
+            }
+            free(nombre);
+            nombre = NULL;
+        }
+    }
+    INSTR_BYTES_ARCHIVO(bytes_leidos, f);
+    fclose(f);
+    ok = ok && grafo->num_vertices == n && validar_instantanea(grafo, libre) == 0;
+    if (!ok)
+    {
+        liberar_grafo(grafo);
+        return NULL;
+    }
+
+    /* el índice (u, v) es derivado: la primera aparición en la lista es la más reciente */
+    for (u = 0; u < n; ++u)
+    {
+        for (e = grafo->vertices[u].primera_arista; e != -1; e = a->siguiente[e])
+        {
+            if (buscar_arista(grafo, u, a->destino[e]) != -1)
+                continue;
+            clave = ((uint64_t)u << 32) | (uint32_t)a->destino[e];
+            if (indice_aristas_poner(&grafo->indice, clave, e) != 0)
+            {
+                liberar_grafo(grafo);
+                return NULL;
+            }
+        }
+    }
+    return grafo;
+}
+
 #endif
\ No newline at end of file
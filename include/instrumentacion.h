@@ -0,0 +1,323 @@
+#ifndef INSTRUMENTACION_H
+#define INSTRUMENTACION_H
+
+/*
+ * Instrumentacion de bajo coste: tiempos por comando de la CLI y contadores
+ * de los algoritmos. Solo existe si se compila con -DINSTRUMENTACION (el
+ * makefile lo activa por defecto; make INSTRUMENTACION=0 lo quita): sin la
+ * macro todo lo de abajo desaparece y las macros INSTR_* no generan codigo.
+ *
+ * Los contadores se acumulan en variables locales dentro de los bucles
+ * calientes (INSTR_LOCAL / INSTR_CONTAR) y se vuelcan una vez por llamada con
+ * una suma atomica relajada (INSTR_SUMAR), asi que los kernels que corren en
+ * varios hilos no comparten lineas de cache en el bucle.
+ *
+ * Cada comando tiene un histograma log-lineal al estilo HDR: valores en ns,
+ * 16 sub-cubetas por potencia de dos (error relativo < 6,25 %) y cubetas
+ * exactas por debajo de 32 ns.
+ */
+#ifdef INSTRUMENTACION
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define HISTO_BITS_SUB 5                        /* 2^5 = 32 valores exactos, 16 sub-cubetas por octava */
+#define HISTO_MAX_BIT 47                        /* ~39 h en ns; lo que pase se guarda en la ultima cubeta */
+#define HISTO_CUBETAS ((HISTO_MAX_BIT - HISTO_BITS_SUB + 2) * (1 << (HISTO_BITS_SUB - 1)) + (1 << (HISTO_BITS_SUB - 1)))
+#define MAX_COMANDOS_INSTR 48
+#define MAX_NOMBRE_COMANDO 32
+
+typedef struct HISTOGRAMA
+{
+    uint64_t cuenta[HISTO_CUBETAS];
+    uint64_t total;
+    uint64_t suma_ns;
+    uint64_t minimo_ns;
+    uint64_t maximo_ns;
+} HISTOGRAMA;
+
+typedef struct CONTADORES_INSTR
+{
+    unsigned long long vertices_asentados;    /* extraidos del monticulo / seleccionados en Dijkstra */
+    unsigned long long aristas_relajadas;     /* aristas examinadas desde un vertice asentado */
+    unsigned long long operaciones_monticulo; /* inserciones + extracciones */
+    unsigned long long visitas_bfs;           /* vertices encolados en recorridos de alcanzabilidad */
+    unsigned long long resoluciones_nombre;   /* busquedas nombre -> indice */
+    unsigned long long bytes_leidos;          /* topologias e instantaneas */
+    unsigned long long bytes_escritos;
+} CONTADORES_INSTR;
+
+typedef struct ESTADISTICA_COMANDO
+{
+    char nombre[MAX_NOMBRE_COMANDO];
+    HISTOGRAMA histograma;
+} ESTADISTICA_COMANDO;
+
+typedef struct INSTRUMENTOS
+{
+    CONTADORES_INSTR contadores;
+    ESTADISTICA_COMANDO comandos[MAX_COMANDOS_INSTR];
+    int num_comandos;
+    int en_curso; /* comando que se esta midiendo, -1 = ninguno */
+    struct timespec inicio;
+} INSTRUMENTOS;
+
+INSTRUMENTOS instrumentos = {.en_curso = -1};
+
+#define INSTR_LOCAL(var) unsigned long long var = 0
+#define INSTR_CONTAR(var, n) ((var) += (unsigned long long)(n))
+#define INSTR_SUMAR(campo, n) __atomic_fetch_add(&instrumentos.contadores.campo, (unsigned long long)(n), __ATOMIC_RELAXED)
+#define INSTR_BYTES_ARCHIVO(campo, f)        \
+    do                                       \
+    {                                        \
+        long instr_pos_ = ftell(f);          \
+        if (instr_pos_ > 0)                  \
+            INSTR_SUMAR(campo, instr_pos_);  \
+    } while (0)
+#define INSTR_INICIO_COMANDO(nombre) instr_inicio_comando(nombre)
+#define INSTR_FIN_COMANDO() instr_fin_comando()
+#define INSTR_DESCARTAR_COMANDO() (instrumentos.en_curso = -1)
+
+void histograma_registrar(HISTOGRAMA *h, uint64_t valor_ns);
+uint64_t histograma_percentil(const HISTOGRAMA *h, double percentil);
+void instr_inicio_comando(const char *nombre);
+void instr_fin_comando(void);
+void reiniciar_estadisticas(void);
+void imprimir_estadisticas(FILE *f);
+void volcar_estadisticas_json(FILE *f);
+void volcar_estadisticas_prometheus(FILE *f);
+
+// Implementaciones
+
+static int histograma_cubeta(uint64_t v)
+{
+    int bit, desplazamiento;
+
+    if (v < (1u << HISTO_BITS_SUB))
+        return (int)v;
+    bit = 63 - __builtin_clzll(v);
+    if (bit > HISTO_MAX_BIT)
+        return HISTO_CUBETAS - 1;
+    desplazamiento = bit - (HISTO_BITS_SUB - 1);
+    return (desplazamiento << (HISTO_BITS_SUB - 1)) + (int)(v >> desplazamiento);
+}
+
+/* Mayor valor que cae en la cubeta (lo que HDR llama valor equivalente mas alto) */
+static uint64_t histograma_techo(int cubeta)
+{
+    int desplazamiento;
+    uint64_t mantisa;
+
+    if (cubeta < (1 << HISTO_BITS_SUB))
+        return (uint64_t)cubeta;
+    desplazamiento = (cubeta >> (HISTO_BITS_SUB - 1)) - 1;
+    mantisa = (uint64_t)(cubeta - (desplazamiento << (HISTO_BITS_SUB - 1)));
+    return ((mantisa + 1) << desplazamiento) - 1;
+}
+
+void histograma_registrar(HISTOGRAMA *h, uint64_t valor_ns)
+{
+    h->cuenta[histograma_cubeta(valor_ns)]++;
+    if (h->total == 0 || valor_ns < h->minimo_ns)
+        h->minimo_ns = valor_ns;
+    if (valor_ns > h->maximo_ns)
+        h->maximo_ns = valor_ns;
+    h->total++;
+    h->suma_ns += valor_ns;
+}
+
+/* percentil en [0, 100]; el resultado no pasa del maximo registrado */
+uint64_t histograma_percentil(const HISTOGRAMA *h, double percentil)
+{
+    uint64_t objetivo, acumulado, techo;
+    int i;
+
+    if (h->total == 0)
+        return 0;
+    objetivo = (uint64_t)(percentil / 100.0 * (double)h->total + 0.5);
+    if (objetivo < 1)
+        objetivo = 1;
+    acumulado = 0;
+    for (i = 0; i < HISTO_CUBETAS; ++i)
+    {
+        acumulado += h->cuenta[i];
+        if (acumulado >= objetivo)
+        {
+            techo = histograma_techo(i);
+            return techo < h->maximo_ns ? (techo > h->minimo_ns ? techo : h->minimo_ns) : h->maximo_ns;
+        }
+    }
+    return h->maximo_ns;
+}
+
+void instr_inicio_comando(const char *nombre)
+{
+    int i;
+
+    for (i = 0; i < instrumentos.num_comandos; ++i)
+        if (strcmp(instrumentos.comandos[i].nombre, nombre) == 0)
+            break;
+    if (i == instrumentos.num_comandos)
+    {
+        if (i == MAX_COMANDOS_INSTR)
+        {
+            instrumentos.en_curso = -1;
+            return;
+        }
+        snprintf(instrumentos.comandos[i].nombre, MAX_NOMBRE_COMANDO, "%s", nombre);
+        instrumentos.num_comandos++;
+    }
+    instrumentos.en_curso = i;
+    clock_gettime(CLOCK_MONOTONIC, &instrumentos.inicio);
+}
+
+void instr_fin_comando(void)
+{
+    struct timespec fin;
+    int64_t ns;
+
+    if (instrumentos.en_curso < 0)
+        return;
+    clock_gettime(CLOCK_MONOTONIC, &fin);
+    ns = (int64_t)(fin.tv_sec - instrumentos.inicio.tv_sec) * 1000000000LL + (fin.tv_nsec - instrumentos.inicio.tv_nsec);
+    histograma_registrar(&instrumentos.comandos[instrumentos.en_curso].histograma, ns > 0 ? (uint64_t)ns : 0);
+    instrumentos.en_curso = -1;
+}
+
+void reiniciar_estadisticas(void)
+{
+    memset(&instrumentos.contadores, 0, sizeof(instrumentos.contadores));
+    memset(instrumentos.comandos, 0, sizeof(instrumentos.comandos));
+    instrumentos.num_comandos = 0;
+    instrumentos.en_curso = -1;
+}
+
+/* X-macro con los campos de CONTADORES_INSTR, en el orden en que se muestran */
+#define CONTADORES_INSTR_LISTA(X)                 \
+    X(vertices_asentados)                         \
+    X(aristas_relajadas)                          \
+    X(operaciones_monticulo)                      \
+    X(visitas_bfs)                                \
+    X(resoluciones_nombre)                        \
+    X(bytes_leidos)                               \
+    X(bytes_escritos)
+
+void imprimir_estadisticas(FILE *f)
+{
+    const HISTOGRAMA *h;
+    int i;
+
+    fprintf(f, "Contadores:\n");
+#define IMPRIMIR_CONTADOR(c) fprintf(f, "  %-22s %llu\n", #c, instrumentos.contadores.c);
+    CONTADORES_INSTR_LISTA(IMPRIMIR_CONTADOR)
+#undef IMPRIMIR_CONTADOR
+    if (instrumentos.num_comandos == 0)
+    {
+        fprintf(f, "Sin comandos medidos.\n");
+        return;
+    }
+    fprintf(f, "Latencia por comando (ms):\n");
+    fprintf(f, "  %-22s %8s %10s %10s %10s %10s %10s %10s\n", "comando", "n", "min", "p50", "p90", "p99", "p99.9", "max");
+    for (i = 0; i < instrumentos.num_comandos; ++i)
+    {
+        h = &instrumentos.comandos[i].histograma;
+        if (h->total == 0)
+            continue;
+        fprintf(f, "  %-22s %8llu %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n", instrumentos.comandos[i].nombre,
+                (unsigned long long)h->total, h->minimo_ns / 1e6, histograma_percentil(h, 50) / 1e6,
+                histograma_percentil(h, 90) / 1e6, histograma_percentil(h, 99) / 1e6,
+                histograma_percentil(h, 99.9) / 1e6, h->maximo_ns / 1e6);
+    }
+}
+
+void volcar_estadisticas_json(FILE *f)
+{
+    const HISTOGRAMA *h;
+    const char *separador;
+    int i, j, primera;
+
+    fprintf(f, "{\n  \"contadores\": {");
+    primera = 1;
+#define JSON_CONTADOR(c)                                                             \
+    fprintf(f, "%s\n    \"%s\": %llu", primera ? "" : ",", #c, instrumentos.contadores.c); \
+    primera = 0;
+    CONTADORES_INSTR_LISTA(JSON_CONTADOR)
+#undef JSON_CONTADOR
+    fprintf(f, "\n  },\n  \"comandos\": {");
+    primera = 1;
+    for (i = 0; i < instrumentos.num_comandos; ++i)
+    {
+        h = &instrumentos.comandos[i].histograma;
+        if (h->total == 0)
+            continue;
+        fprintf(f, "%s\n    \"%s\": {\"n\": %llu, \"suma_ns\": %llu, \"min_ns\": %llu, \"max_ns\": %llu, "
+                   "\"p50_ns\": %llu, \"p90_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"cubetas\": [",
+                primera ? "" : ",", instrumentos.comandos[i].nombre, (unsigned long long)h->total,
+                (unsigned long long)h->suma_ns, (unsigned long long)h->minimo_ns, (unsigned long long)h->maximo_ns,
+                (unsigned long long)histograma_percentil(h, 50), (unsigned long long)histograma_percentil(h, 90),
+                (unsigned long long)histograma_percentil(h, 99), (unsigned long long)histograma_percentil(h, 99.9));
+        primera = 0;
+        /* solo las cubetas no vacias: [techo_ns, cuenta] */
+        separador = "";
+        for (j = 0; j < HISTO_CUBETAS; ++j)
+        {
+            if (!h->cuenta[j])
+                continue;
+            fprintf(f, "%s[%llu, %llu]", separador, (unsigned long long)histograma_techo(j), (unsigned long long)h->cuenta[j]);
+            separador = ", ";
+        }
+        fprintf(f, "]}");
+    }
+    fprintf(f, "\n  }\n}\n");
+}
+
+/* Formato de texto de Prometheus: un contador por metrica y un histograma por comando */
+void volcar_estadisticas_prometheus(FILE *f)
+{
+    const HISTOGRAMA *h;
+    uint64_t acumulado;
+    int i, j;
+
+#define PROM_CONTADOR(c)                                 \
+    fprintf(f, "# TYPE net_%s_total counter\n", #c);     \
+    fprintf(f, "net_%s_total %llu\n", #c, instrumentos.contadores.c);
+    CONTADORES_INSTR_LISTA(PROM_CONTADOR)
+#undef PROM_CONTADOR
+    fprintf(f, "# TYPE net_comando_segundos histogram\n");
+    for (i = 0; i < instrumentos.num_comandos; ++i)
+    {
+        h = &instrumentos.comandos[i].histograma;
+        if (h->total == 0)
+            continue;
+        acumulado = 0;
+        for (j = 0; j < HISTO_CUBETAS; ++j)
+        {
+            if (!h->cuenta[j])
+                continue;
+            acumulado += h->cuenta[j];
+            fprintf(f, "net_comando_segundos_bucket{comando=\"%s\",le=\"%.9g\"} %llu\n", instrumentos.comandos[i].nombre,
+                    histograma_techo(j) / 1e9, (unsigned long long)acumulado);
+        }
+        fprintf(f, "net_comando_segundos_bucket{comando=\"%s\",le=\"+Inf\"} %llu\n", instrumentos.comandos[i].nombre,
+                (unsigned long long)h->total);
+        fprintf(f, "net_comando_segundos_sum{comando=\"%s\"} %.9f\n", instrumentos.comandos[i].nombre, h->suma_ns / 1e9);
+        fprintf(f, "net_comando_segundos_count{comando=\"%s\"} %llu\n", instrumentos.comandos[i].nombre,
+                (unsigned long long)h->total);
+    }
+}
+
+#else
+
+#define INSTR_LOCAL(var)
+#define INSTR_CONTAR(var, n)
+#define INSTR_SUMAR(campo, n)
+#define INSTR_BYTES_ARCHIVO(campo, f)
+#define INSTR_INICIO_COMANDO(nombre)
+#define INSTR_FIN_COMANDO()
+#define INSTR_DESCARTAR_COMANDO()
+
+#endif
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef OPTIMIZACION_H
+#define OPTIMIZACION_H
+
+#include "grafos.h"
+#include "dijkstra.h"
+
+/* Enlace hipotetico evaluado */
+typedef struct CANDIDATO_ENLACE
+{
+    int origen;
+    int destino;
+    double mejora;         /* ms ahorrados sumando todas las demandas ya conectadas */
+    int pares_mejorados;   /* demandas cuya latencia baja */
+    int nuevas_conexiones; /* demandas hoy sin camino que pasarian a tenerlo */
+} CANDIDATO_ENLACE;
+
+/*
+ * Motor de evaluacion de enlaces candidatos.
+ * Las demandas son el producto fuentes x destinos. Se calcula un arbol directo
+ * por fuente y uno inverso por destino; con ellos, la latencia de la demanda
+ * (s, t) usando un enlace nuevo a -> b de latencia L es
+ *     min(d(s, t), d(s, a) + L + d(b, t))
+ * asi que cada candidato se puntua en O(1) por demanda y el grafo no se toca.
+ */
+typedef struct EVALUADOR_ENLACES
+{
+    int num_vertices;
+    int num_fuentes;
+    int num_destinos;
+    int *fuentes;
+    int *destinos;
+    double *desde; /* desde[x * num_fuentes + i] = d(fuentes[i], x) */
+    double *hacia; /* hacia[x * num_destinos + j] = d(x, destinos[j]) */
+    double *base;  /* base[i * num_destinos + j] = d(fuentes[i], destinos[j]) */
+} EVALUADOR_ENLACES;
+
+int preparar_evaluador_enlaces(GRAFO *grafo, const int *fuentes, int num_fuentes, const int *destinos, int num_destinos, EVALUADOR_ENLACES *ev);
+void liberar_evaluador_enlaces(EVALUADOR_ENLACES *ev);
+void puntuar_enlace(const EVALUADOR_ENLACES *ev, int a, int b, double latencia_ms, CANDIDATO_ENLACE *c);
+/* candidatos = NULL evalua todos los pares a -> b sin arista; devuelve cuantos mejores se rellenaron */
+int mejores_enlaces_candidatos(GRAFO *grafo, const EVALUADOR_ENLACES *ev, double latencia_ms, const int (*candidatos)[2], int num_candidatos, CANDIDATO_ENLACE *mejores, int top);
+
+// Implementaciones
+
+int preparar_evaluador_enlaces(GRAFO *grafo, const int *fuentes, int num_fuentes, const int *destinos, int num_destinos, EVALUADOR_ENLACES *ev)
+{
+    int n, i, j, x, *anterior;
+    double *distancia;
+    VISTA_latencia directa, inversa;
+    MONTICULO m;
+
+    if (!grafo || !fuentes || !destinos || !ev || num_fuentes <= 0 || num_destinos <= 0)
+        return -1;
+    memset(ev, 0, sizeof(*ev));
+    n = grafo->num_vertices;
+    ev->num_vertices = n;
+    ev->num_fuentes = num_fuentes;
+    ev->num_destinos = num_destinos;
+    ev->fuentes = malloc(sizeof(int) * num_fuentes);
+    ev->destinos = malloc(sizeof(int) * num_destinos);
+    ev->desde = malloc(sizeof(double) * (size_t)n * num_fuentes);
+    ev->hacia = malloc(sizeof(double) * (size_t)n * num_destinos);
+    ev->base = malloc(sizeof(double) * (size_t)num_fuentes * num_destinos);
+    anterior = malloc(sizeof(int) * n);
+    distancia = malloc(sizeof(double) * n);
+    if (!ev->fuentes || !ev->destinos || !ev->desde || !ev->hacia || !ev->base || !anterior || !distancia)
+    {
+        free(anterior);
+        free(distancia);
+        liberar_evaluador_enlaces(ev);
+        return -1;
+    }
+    memcpy(ev->fuentes, fuentes, sizeof(int) * num_fuentes);
+    memcpy(ev->destinos, destinos, sizeof(int) * num_destinos);
+
+    if (construir_vista_latencia(grafo, &directa) != 0)
+    {
+        free(anterior);
+        free(distancia);
+        liberar_evaluador_enlaces(ev);
+        return -1;
+    }
+    if (construir_vista_inversa_latencia(grafo, &inversa) != 0)
+    {
+        liberar_vista_latencia(&directa);
+        free(anterior);
+        free(distancia);
+        liberar_evaluador_enlaces(ev);
+        return -1;
+    }
+    monticulo_iniciar(&m, directa.num_aristas + 1);
+
+    for (i = 0; i < num_fuentes; ++i)
+    {
+        dijkstra_latencia(&directa, fuentes[i], -1, &m, anterior, distancia);
+        for (x = 0; x < n; ++x)
+            ev->desde[(size_t)x * num_fuentes + i] = distancia[x];
+        for (j = 0; j < num_destinos; ++j)
+            ev->base[(size_t)i * num_destinos + j] = distancia[destinos[j]];
+    }
+    for (j = 0; j < num_destinos; ++j)
+    {
+        dijkstra_latencia(&inversa, destinos[j], -1, &m, anterior, distancia);
+        for (x = 0; x < n; ++x)
+            ev->hacia[(size_t)x * num_destinos + j] = distancia[x];
+    }
+
+    monticulo_liberar(&m);
+    liberar_vista_latencia(&directa);
+    liberar_vista_latencia(&inversa);
+    free(anterior);
+    free(distancia);
+    return 0;
+}
+
+void liberar_evaluador_enlaces(EVALUADOR_ENLACES *ev)
+{
+    if (!ev)
+        return;
+    free(ev->fuentes);
+    free(ev->destinos);
+    free(ev->desde);
+    free(ev->hacia);
+    free(ev->base);
+    memset(ev, 0, sizeof(*ev));
+}
+
+void puntuar_enlace(const EVALUADOR_ENLACES *ev, int a, int b, double latencia_ms, CANDIDATO_ENLACE *c)
+{
+    int i, j, nf, nd;
+    const double *da, *hb, *base;
+    double nueva, actual;
+
+    nf = ev->num_fuentes;
+    nd = ev->num_destinos;
+    da = ev->desde + (size_t)a * nf;
+    hb = ev->hacia + (size_t)b * nd;
+    c->origen = a;
+    c->destino = b;
+    c->mejora = 0.0;
+    c->pares_mejorados = 0;
+    c->nuevas_conexiones = 0;
+    for (i = 0; i < nf; ++i)
+    {
+        if (da[i] >= DBL_MAX / 2)
+            continue;
+        base = ev->base + (size_t)i * nd;
+        for (j = 0; j < nd; ++j)
+        {
+            if (ev->fuentes[i] == ev->destinos[j] || hb[j] >= DBL_MAX / 2)
+                continue;
+            nueva = da[i] + latencia_ms + hb[j];
+            actual = base[j];
+            if (actual >= DBL_MAX / 2)
+            {
+                c->nuevas_conexiones++;
+            }
+            else if (nueva < actual)
+            {
+                c->mejora += actual - nueva;
+                c->pares_mejorados++;
+            }
+        }
+    }
+}
+
+/* Orden: primero las nuevas conexiones, despues la mejora total */
+static int candidato_mejor(const CANDIDATO_ENLACE *x, const CANDIDATO_ENLACE *y)
+{
+    if (x->nuevas_conexiones != y->nuevas_conexiones)
+        return x->nuevas_conexiones > y->nuevas_conexiones;
+    return x->mejora > y->mejora;
+}
+
+int mejores_enlaces_candidatos(GRAFO *grafo, const EVALUADOR_ENLACES *ev, double latencia_ms, const int (*candidatos)[2], int num_candidatos, CANDIDATO_ENLACE *mejores, int top)
+{
+    int n, a, b, p, usados;
+    long long k, total;
+    CANDIDATO_ENLACE c;
+
+    if (!grafo || !ev || !mejores || top <= 0)
+        return 0;
+    n = ev->num_vertices;
+    usados = 0;
+    total = candidatos ? num_candidatos : (long long)n * n;
+    for (k = 0; k < total; ++k)
+    {
+        a = candidatos ? candidatos[k][0] : (int)(k / n);
+        b = candidatos ? candidatos[k][1] : (int)(k % n);
+        if (a == b || a < 0 || b < 0 || a >= n || b >= n)
+            continue;
+        /* un enlace desde un vertice fallido no se recorre */
+        if (grafo->vertices[a].activo == 0 || buscar_arista(grafo, a, b) != -1)
+            continue;
+        puntuar_enlace(ev, a, b, latencia_ms, &c);
+        if (c.nuevas_conexiones == 0 && c.mejora <= 0.0)
+            continue;
+        if (usados == top && !candidato_mejor(&c, &mejores[top - 1]))
+            continue;
+        /* insercion ordenada en el top */
+        if (usados < top)
+            usados++;
+        for (p = usados - 1; p > 0 && candidato_mejor(&c, &mejores[p - 1]); --p)
+            mejores[p] = mejores[p - 1];
+        mejores[p] = c;
+    }
+    return usados;
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef RESILIENCIA_H
+#define RESILIENCIA_H
+
+#include "grafos.h"
+#include "bfs.h"
+
+/*
+ * Alcanzabilidad por BFS sobre vertices y enlaces activos, y barrido de
+ * fallos de un vertice (analizar-resiliencia). El barrido hace un BFS por
+ * vertice con el motor de bfs.h (CSR construida una vez, hilos y pasos
+ * arriba-abajo / abajo-arriba). Una consulta suelta no amortiza la CSR, asi
+ * que contar_alcanzables recorre las listas del GRAFO: los buffers se
+ * reservan una vez (RECORRIDO) y las marcas de visitado llevan un sello por
+ * recorrido: empezar otro BFS es incrementar el sello, no limpiar n
+ * entradas. Para muchas consultas sobre el mismo grafo, recorrer_bfs con un
+ * MOTOR_BFS que se conserve entre ellas.
+ */
+typedef struct RECORRIDO
+{
+    int num_vertices;
+    int *cola;
+    unsigned *marca; /* marca[v] == sello si v se visito en el recorrido actual */
+    unsigned sello;
+} RECORRIDO;
+
+int iniciar_recorrido(RECORRIDO *r, int num_vertices);
+void liberar_recorrido(RECORRIDO *r);
+/* Vertices alcanzables desde indice (incluido); 0 si esta fallido */
+int contar_alcanzables_desde(GRAFO *grafo, RECORRIDO *r, int indice);
+int contar_alcanzables(GRAFO *grafo, int indice);
+/*
+ * Para cada vertice i, impacto[i] = alcanzables desde inicio que se pierden
+ * si falla i (si i es el propio inicio se cuenta desde otro vertice).
+ * Devuelve los alcanzables desde inicio sin fallos, -1 sin memoria.
+ */
+int analizar_impacto_fallos(GRAFO *grafo, int inicio, int *impacto);
+
+// Implementaciones
+
+int iniciar_recorrido(RECORRIDO *r, int num_vertices)
+{
+    r->num_vertices = num_vertices;
+    r->sello = 0;
+    r->cola = malloc(sizeof(int) * (num_vertices + 1));
+    r->marca = calloc(num_vertices + 1, sizeof(unsigned));
+    if (!r->cola || !r->marca)
+    {
+        liberar_recorrido(r);
+        return -1;
+    }
+    return 0;
+}
+
+void liberar_recorrido(RECORRIDO *r)
+{
+    free(r->cola);
+    free(r->marca);
+    r->cola = NULL;
+    r->marca = NULL;
+    r->num_vertices = 0;
+}
+
+int contar_alcanzables_desde(GRAFO *grafo, RECORRIDO *r, int indice)
+{
+    int cabeza, fin, u, v, ar;
+
+    if (!grafo || indice < 0 || indice >= grafo->num_vertices || indice >= r->num_vertices)
+        return 0;
+    if (grafo->vertices[indice].activo == 0)
+        return 0;
+    if (++r->sello == 0)
+    {
+        /* el sello dio la vuelta: una limpieza cada 2^32 recorridos */
+        memset(r->marca, 0, sizeof(unsigned) * r->num_vertices);
+        r->sello = 1;
+    }
+
+    cabeza = 0;
+    fin = 0;
+    r->cola[fin++] = indice;
+    r->marca[indice] = r->sello;
+    while (cabeza < fin)
+    {
+        u = r->cola[cabeza++];
+        for (ar = grafo->vertices[u].primera_arista; ar != -1; ar = grafo->aristas.siguiente[ar])
+        {
+            if (!ARISTA_ACTIVA(grafo, ar))
+                continue;
+            v = grafo->aristas.destino[ar];
+            if (r->marca[v] != r->sello && grafo->vertices[v].activo)
+            {
+                r->marca[v] = r->sello;
+                r->cola[fin++] = v;
+            }
+        }
+    }
+    INSTR_SUMAR(visitas_bfs, fin);
+    return fin;
+}
+
+/* BFS simple para contar alcanzables */
+int contar_alcanzables(GRAFO *grafo, int indice)
+{
+    RECORRIDO r;
+    int total;
+
+    if (!grafo || iniciar_recorrido(&r, grafo->num_vertices) != 0)
+        return 0;
+    total = contar_alcanzables_desde(grafo, &r, indice);
+    liberar_recorrido(&r);
+    return total;
+}
+
+int analizar_impacto_fallos(GRAFO *grafo, int inicio, int *impacto)
+{
+    MOTOR_BFS motor;
+    int alcanzables;
+
+    if (!grafo || !impacto)
+        return -1;
+    iniciar_motor_bfs(&motor, 0);
+    alcanzables = barrido_fallos_bfs(grafo, &motor, inicio, impacto);
+    liberar_motor_bfs(&motor);
+    return alcanzables;
+}
+
+#endif
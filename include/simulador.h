@@ -0,0 +1,567 @@
+#ifndef SIMULADOR_H
+#define SIMULADOR_H
+
+#include "grafos.h"
+#include "fib.h"
+#include "trafico.h"
+#include <math.h>
+
+/*
+ * Simulador de paquetes por eventos discretos.
+ * El tiempo es entero, en nanosegundos. Cada paquete que llega a un
+ * dispositivo es un evento: el dispositivo consulta su FIB (fib.h), y si no es
+ * el destino lo pone en la cola de salida del enlace. El enlace transmite en
+ * orden de llegada: el paquete empieza cuando el transmisor queda libre, tarda
+ * bytes * 8 / ancho_banda en serializarse y llega al otro extremo latencia_ms
+ * despues. La cola es finita en bytes (lo que falta por transmitir cuando
+ * llega el paquete), se descarta por cola llena y cada transmision se pierde
+ * con probabilidad 1 - fiabilidad.
+ *
+ * Como la cola se deduce del instante en que el transmisor queda libre, un
+ * salto cuesta un solo evento. Los eventos se guardan en una rueda de tiempos
+ * jerarquica: 8 niveles de 64 ranuras (6 bits de tiempo por nivel, 2^48 ns de
+ * horizonte) con un mapa de bits de ranuras ocupadas por nivel. Insertar es
+ * O(1), y el siguiente evento se encuentra con un ctz; un evento baja como
+ * mucho un nivel cada vez que su ranura llega al frente.
+ *
+ * Sobre el mismo motor van las sondas de ping (eco y respuesta) y de
+ * traceroute (TTL creciente y "tiempo excedido" del router que lo agota), que
+ * comparten la red con el trafico de fondo de la matriz de demandas.
+ */
+#define RUEDA_NIVELES 8
+#define RUEDA_BITS 6
+#define RUEDA_RANURAS (1 << RUEDA_BITS)
+#define SIM_NS_POR_MS 1000000ULL
+#define SIM_TTL_INICIAL 64
+
+typedef enum
+{
+    PAQUETE_DATOS,
+    PAQUETE_ECO,
+    PAQUETE_RESPUESTA_ECO,
+    PAQUETE_TTL_EXCEDIDO
+} TipoPaquete;
+
+typedef enum
+{
+    EVENTO_LLEGADA, /* objeto = paquete */
+    EVENTO_GENERAR  /* objeto = demanda */
+} TipoEvento;
+
+typedef struct PARAMETROS_SIMULACION
+{
+    int bytes_paquete;       /* tamano de los paquetes de datos y sondas */
+    int cola_bytes;          /* buffer de salida de cada enlace */
+    double duracion_s;       /* tiempo simulado con trafico de fondo */
+    int poisson;             /* 1: llegadas de Poisson; 0: tasa constante */
+    uint64_t semilla;
+} PARAMETROS_SIMULACION;
+
+typedef struct ESTADISTICAS_SIMULACION
+{
+    long long generados;
+    long long entregados;
+    long long perdidos_enlace; /* por fiabilidad */
+    long long perdidos_cola;
+    long long sin_ruta;        /* FIB sin entrada o enlace/vecino inutilizable */
+    long long ttl_agotado;
+    long long eventos;
+    double retardo_total_ms;   /* datos entregados */
+    double retardo_max_ms;
+    double bytes_entregados;
+} ESTADISTICAS_SIMULACION;
+
+typedef struct EVENTO_SIM
+{
+    uint64_t tiempo;
+    int siguiente;
+    int tipo;
+    int objeto;
+} EVENTO_SIM;
+
+typedef struct PAQUETE_SIM
+{
+    uint64_t creado;
+    uint32_t ip_destino;
+    int origen;  /* dispositivo que lo emitio */
+    int nodo;    /* dispositivo al que llega */
+    int sonda;   /* -1 en los de datos */
+    uint16_t bytes;
+    unsigned char tipo;
+    unsigned char ttl;
+} PAQUETE_SIM;
+
+typedef struct RUEDA_TIEMPOS
+{
+    uint64_t ahora;
+    uint64_t ocupadas[RUEDA_NIVELES];
+    int cabeza[RUEDA_NIVELES][RUEDA_RANURAS];
+    int cola[RUEDA_NIVELES][RUEDA_RANURAS];
+    int pendientes;
+} RUEDA_TIEMPOS;
+
+typedef struct SIMULADOR
+{
+    GRAFO *grafo;
+    PARAMETROS_SIMULACION p;
+    TABLAS_REENVIO tablas;
+    RUEDA_TIEMPOS rueda;
+    uint64_t *libre; /* por arista: instante en que su transmisor queda libre */
+    uint64_t aleatorio;
+    /* eventos y paquetes: arreglos que crecen, con lista de libres */
+    EVENTO_SIM *eventos;
+    int num_eventos, capacidad_eventos, eventos_libres;
+    PAQUETE_SIM *paquetes;
+    int num_paquetes, capacidad_paquetes, paquetes_libres;
+    /* trafico de fondo: una fuente por demanda */
+    const MATRIZ_DEMANDAS *demandas;
+    uint64_t fin_demandas;
+    /* sondas: envio, respuesta (UINT64_MAX si no llego) y quien respondio */
+    uint64_t *sonda_envio, *sonda_respuesta;
+    int *sonda_respondio;
+    int num_sondas, capacidad_sondas;
+    ESTADISTICAS_SIMULACION est;
+} SIMULADOR;
+
+void parametros_simulacion_por_defecto(PARAMETROS_SIMULACION *p);
+int iniciar_simulador(SIMULADOR *sim, GRAFO *grafo, const PARAMETROS_SIMULACION *p);
+void liberar_simulador(SIMULADOR *sim);
+/* Trafico de fondo: paquetes de cada demanda a su tasa hasta p.duracion_s */
+int programar_demandas(SIMULADOR *sim, const MATRIZ_DEMANDAS *dem);
+/* Sonda de eco (ping) o con ttl limitado (traceroute) en el instante dado; devuelve su numero o -1 */
+int enviar_sonda(SIMULADOR *sim, int origen, uint32_t ip_destino, int ttl, uint64_t instante_ns);
+/* Procesa eventos hasta vaciar la rueda o alcanzar hasta_ns */
+int ejecutar_simulacion(SIMULADOR *sim, uint64_t hasta_ns);
+
+// Implementaciones
+
+void parametros_simulacion_por_defecto(PARAMETROS_SIMULACION *p)
+{
+    p->bytes_paquete = 1500;
+    p->cola_bytes = 64 * 1500;
+    p->duracion_s = 1.0;
+    p->poisson = 1;
+    p->semilla = 0x2545F4914F6CDD1DULL;
+}
+
+/* xorshift64*: uniforme en [0, 1) */
+static double aleatorio_sim(SIMULADOR *sim)
+{
+    uint64_t x = sim->aleatorio;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    sim->aleatorio = x;
+    return (double)((x * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void rueda_iniciar(RUEDA_TIEMPOS *r)
+{
+    int k, j;
+
+    memset(r, 0, sizeof(*r));
+    for (k = 0; k < RUEDA_NIVELES; ++k)
+        for (j = 0; j < RUEDA_RANURAS; ++j)
+            r->cabeza[k][j] = r->cola[k][j] = -1;
+}
+
+/* Nivel: el del bit mas alto en que el instante difiere de ahora */
+static void rueda_colocar(RUEDA_TIEMPOS *r, EVENTO_SIM *eventos, int ev)
+{
+    uint64_t t = eventos[ev].tiempo, dif;
+    int nivel, ranura;
+
+    if (t < r->ahora)
+        t = eventos[ev].tiempo = r->ahora;
+    dif = t ^ r->ahora;
+    nivel = dif ? (63 - __builtin_clzll(dif)) / RUEDA_BITS : 0;
+    if (nivel >= RUEDA_NIVELES)
+        nivel = RUEDA_NIVELES - 1; /* mas alla del horizonte: se recoloca al llegar */
+    ranura = (int)((t >> (RUEDA_BITS * nivel)) & (RUEDA_RANURAS - 1));
+    eventos[ev].siguiente = -1;
+    if (r->cola[nivel][ranura] == -1)
+        r->cabeza[nivel][ranura] = ev;
+    else
+        eventos[r->cola[nivel][ranura]].siguiente = ev;
+    r->cola[nivel][ranura] = ev;
+    r->ocupadas[nivel] |= 1ULL << ranura;
+}
+
+/*
+ * Siguiente evento en orden de tiempo (a igual tiempo, en orden de llegada).
+ * Si el nivel 0 esta vacio se adelanta el reloj al principio de la primera
+ * ranura ocupada del nivel mas bajo y sus eventos bajan de nivel.
+ */
+static int rueda_extraer(RUEDA_TIEMPOS *r, EVENTO_SIM *eventos)
+{
+    int nivel, ranura, ev, sig;
+    uint64_t mascara;
+
+    if (r->pendientes == 0)
+        return -1;
+    for (;;)
+    {
+        if (r->ocupadas[0])
+        {
+            ranura = __builtin_ctzll(r->ocupadas[0]);
+            ev = r->cabeza[0][ranura];
+            r->cabeza[0][ranura] = eventos[ev].siguiente;
+            if (r->cabeza[0][ranura] == -1)
+            {
+                r->cola[0][ranura] = -1;
+                r->ocupadas[0] &= ~(1ULL << ranura);
+            }
+            r->ahora = eventos[ev].tiempo;
+            r->pendientes--;
+            return ev;
+        }
+        for (nivel = 1; nivel < RUEDA_NIVELES && !r->ocupadas[nivel]; ++nivel)
+            ;
+        if (nivel == RUEDA_NIVELES)
+            return -1;
+        ranura = __builtin_ctzll(r->ocupadas[nivel]);
+        if (nivel == RUEDA_NIVELES - 1)
+        {
+            /* el ultimo nivel tambien guarda lo que cae fuera del horizonte: manda la ranura del minimo */
+            uint64_t minimo = UINT64_MAX;
+            for (mascara = r->ocupadas[nivel]; mascara; mascara &= mascara - 1)
+                for (ev = r->cabeza[nivel][__builtin_ctzll(mascara)]; ev != -1; ev = eventos[ev].siguiente)
+                    if (eventos[ev].tiempo < minimo)
+                    {
+                        minimo = eventos[ev].tiempo;
+                        ranura = __builtin_ctzll(mascara);
+                    }
+            r->ahora = minimo & ~((1ULL << (RUEDA_BITS * nivel)) - 1);
+        }
+        else
+        {
+            mascara = (1ULL << (RUEDA_BITS * (nivel + 1))) - 1;
+            r->ahora = (r->ahora & ~mascara) | ((uint64_t)ranura << (RUEDA_BITS * nivel));
+        }
+        ev = r->cabeza[nivel][ranura];
+        r->cabeza[nivel][ranura] = r->cola[nivel][ranura] = -1;
+        r->ocupadas[nivel] &= ~(1ULL << ranura);
+        for (; ev != -1; ev = sig)
+        {
+            sig = eventos[ev].siguiente;
+            rueda_colocar(r, eventos, ev);
+        }
+    }
+}
+
+static int nuevo_evento_sim(SIMULADOR *sim, uint64_t tiempo, int tipo, int objeto)
+{
+    int ev, nueva;
+    EVENTO_SIM *tmp;
+
+    if (sim->eventos_libres != -1)
+    {
+        ev = sim->eventos_libres;
+        sim->eventos_libres = sim->eventos[ev].siguiente;
+    }
+    else
+    {
+        if (sim->num_eventos == sim->capacidad_eventos)
+        {
+            nueva = sim->capacidad_eventos ? sim->capacidad_eventos * 2 : 1024;
+            tmp = realloc(sim->eventos, sizeof(EVENTO_SIM) * (size_t)nueva);
+            if (!tmp)
+                return -1;
+            sim->eventos = tmp;
+            sim->capacidad_eventos = nueva;
+        }
+        ev = sim->num_eventos++;
+    }
+    sim->eventos[ev].tiempo = tiempo;
+    sim->eventos[ev].tipo = tipo;
+    sim->eventos[ev].objeto = objeto;
+    rueda_colocar(&sim->rueda, sim->eventos, ev);
+    sim->rueda.pendientes++;
+    return ev;
+}
+
+static int nuevo_paquete_sim(SIMULADOR *sim)
+{
+    int pq, nueva;
+    PAQUETE_SIM *tmp;
+
+    if (sim->paquetes_libres != -1)
+    {
+        pq = sim->paquetes_libres;
+        sim->paquetes_libres = sim->paquetes[pq].sonda;
+        return pq;
+    }
+    if (sim->num_paquetes == sim->capacidad_paquetes)
+    {
+        nueva = sim->capacidad_paquetes ? sim->capacidad_paquetes * 2 : 1024;
+        tmp = realloc(sim->paquetes, sizeof(PAQUETE_SIM) * (size_t)nueva);
+        if (!tmp)
+            return -1;
+        sim->paquetes = tmp;
+        sim->capacidad_paquetes = nueva;
+    }
+    return sim->num_paquetes++;
+}
+
+/* En la lista de libres el campo sonda hace de enlace */
+static void liberar_paquete_sim(SIMULADOR *sim, int pq)
+{
+    sim->paquetes[pq].sonda = sim->paquetes_libres;
+    sim->paquetes_libres = pq;
+}
+
+int iniciar_simulador(SIMULADOR *sim, GRAFO *grafo, const PARAMETROS_SIMULACION *p)
+{
+    if (!sim || !grafo)
+        return -1;
+    memset(sim, 0, sizeof(*sim));
+    sim->grafo = grafo;
+    if (p)
+        sim->p = *p;
+    else
+        parametros_simulacion_por_defecto(&sim->p);
+    if (sim->p.bytes_paquete <= 0 || sim->p.bytes_paquete > 65535)
+        sim->p.bytes_paquete = 1500;
+    sim->aleatorio = sim->p.semilla ? sim->p.semilla : 0x2545F4914F6CDD1DULL;
+    sim->eventos_libres = -1;
+    sim->paquetes_libres = -1;
+    rueda_iniciar(&sim->rueda);
+    sim->libre = calloc(grafo->aristas.num + 1, sizeof(uint64_t));
+    if (!sim->libre || construir_tablas_reenvio(grafo, &sim->tablas) != 0)
+    {
+        liberar_simulador(sim);
+        return -1;
+    }
+    return 0;
+}
+
+void liberar_simulador(SIMULADOR *sim)
+{
+    if (!sim)
+        return;
+    liberar_tablas_reenvio(&sim->tablas);
+    free(sim->libre);
+    free(sim->eventos);
+    free(sim->paquetes);
+    free(sim->sonda_envio);
+    free(sim->sonda_respuesta);
+    free(sim->sonda_respondio);
+    memset(sim, 0, sizeof(*sim));
+}
+
+/* Intervalo hasta el siguiente paquete de una demanda */
+static uint64_t intervalo_demanda(SIMULADOR *sim, double mbps)
+{
+    double media_ns = (double)sim->p.bytes_paquete * 8.0 * 1000.0 / mbps;
+
+    if (sim->p.poisson)
+        media_ns *= -log(1.0 - aleatorio_sim(sim));
+    return (uint64_t)media_ns + 1;
+}
+
+int programar_demandas(SIMULADOR *sim, const MATRIZ_DEMANDAS *dem)
+{
+    int i;
+
+    if (!sim || !dem)
+        return -1;
+    sim->demandas = dem;
+    sim->fin_demandas = sim->rueda.ahora + (uint64_t)(sim->p.duracion_s * 1e9);
+    for (i = 0; i < dem->num; ++i)
+    {
+        if (dem->mbps[i] <= 0.0 || dem->origen[i] == dem->destino[i])
+            continue;
+        if (nuevo_evento_sim(sim, sim->rueda.ahora + intervalo_demanda(sim, dem->mbps[i]), EVENTO_GENERAR, i) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/* Crea un paquete en el dispositivo origen y lo procesa alli en el instante dado */
+static int emitir_paquete_sim(SIMULADOR *sim, int origen, uint32_t ip_destino, int tipo, int sonda, int ttl, uint64_t instante)
+{
+    int pq;
+    PAQUETE_SIM *q;
+
+    pq = nuevo_paquete_sim(sim);
+    if (pq < 0)
+        return -1;
+    q = &sim->paquetes[pq];
+    q->creado = instante;
+    q->ip_destino = ip_destino;
+    q->origen = origen;
+    q->nodo = origen;
+    q->sonda = sonda;
+    q->bytes = (uint16_t)sim->p.bytes_paquete;
+    q->tipo = (unsigned char)tipo;
+    q->ttl = (unsigned char)ttl;
+    if (nuevo_evento_sim(sim, instante, EVENTO_LLEGADA, pq) < 0)
+    {
+        liberar_paquete_sim(sim, pq);
+        return -1;
+    }
+    return pq;
+}
+
+int enviar_sonda(SIMULADOR *sim, int origen, uint32_t ip_destino, int ttl, uint64_t instante_ns)
+{
+    int nueva, s;
+    uint64_t *envio, *respuesta;
+    int *respondio;
+
+    if (!sim || origen < 0 || origen >= sim->grafo->num_vertices)
+        return -1;
+    if (sim->num_sondas == sim->capacidad_sondas)
+    {
+        nueva = sim->capacidad_sondas ? sim->capacidad_sondas * 2 : 16;
+        envio = realloc(sim->sonda_envio, sizeof(uint64_t) * nueva);
+        if (envio)
+            sim->sonda_envio = envio;
+        respuesta = realloc(sim->sonda_respuesta, sizeof(uint64_t) * nueva);
+        if (respuesta)
+            sim->sonda_respuesta = respuesta;
+        respondio = realloc(sim->sonda_respondio, sizeof(int) * nueva);
+        if (respondio)
+            sim->sonda_respondio = respondio;
+        if (!envio || !respuesta || !respondio)
+            return -1;
+        sim->capacidad_sondas = nueva;
+    }
+    s = sim->num_sondas;
+    if (ttl <= 0 || ttl > 255)
+        ttl = SIM_TTL_INICIAL;
+    if (emitir_paquete_sim(sim, origen, ip_destino, PAQUETE_ECO, s, ttl, instante_ns) < 0)
+        return -1;
+    sim->sonda_envio[s] = instante_ns;
+    sim->sonda_respuesta[s] = UINT64_MAX;
+    sim->sonda_respondio[s] = -1;
+    sim->num_sondas++;
+    return s;
+}
+
+/* El paquete ha llegado a su destino */
+static void entregar_paquete_sim(SIMULADOR *sim, int pq)
+{
+    PAQUETE_SIM q = sim->paquetes[pq];
+    double retardo;
+
+    liberar_paquete_sim(sim, pq);
+    switch (q.tipo)
+    {
+    case PAQUETE_DATOS:
+        retardo = (double)(sim->rueda.ahora - q.creado) / (double)SIM_NS_POR_MS;
+        sim->est.entregados++;
+        sim->est.retardo_total_ms += retardo;
+        if (retardo > sim->est.retardo_max_ms)
+            sim->est.retardo_max_ms = retardo;
+        sim->est.bytes_entregados += q.bytes;
+        break;
+    case PAQUETE_ECO:
+        emitir_paquete_sim(sim, q.nodo, sim->grafo->datos[q.origen].ip, PAQUETE_RESPUESTA_ECO, q.sonda, SIM_TTL_INICIAL, sim->rueda.ahora);
+        break;
+    default:
+        if (q.sonda >= 0 && q.sonda < sim->num_sondas && sim->sonda_respuesta[q.sonda] == UINT64_MAX)
+        {
+            sim->sonda_respuesta[q.sonda] = sim->rueda.ahora;
+            sim->sonda_respondio[q.sonda] = q.origen;
+        }
+        break;
+    }
+}
+
+/* Llegada a un dispositivo: entrega local o salida por el enlace del siguiente salto */
+static void procesar_llegada_sim(SIMULADOR *sim, int pq)
+{
+    GRAFO *grafo = sim->grafo;
+    PAQUETE_SIM *q = &sim->paquetes[pq];
+    int u = q->nodo, v, e, bw;
+    uint64_t ahora = sim->rueda.ahora, inicio, serializacion;
+
+    if (!grafo->vertices[u].activo)
+    {
+        sim->est.sin_ruta++;
+        liberar_paquete_sim(sim, pq);
+        return;
+    }
+    v = fib_buscar(&sim->tablas.fib[u], q->ip_destino);
+    if (v == u)
+    {
+        entregar_paquete_sim(sim, pq);
+        return;
+    }
+    /* los routers de paso restan uno al TTL; el que lo agota avisa al emisor de las sondas */
+    if (u != q->origen && --q->ttl == 0)
+    {
+        sim->est.ttl_agotado++;
+        if (q->tipo == PAQUETE_ECO)
+            emitir_paquete_sim(sim, u, grafo->datos[q->origen].ip, PAQUETE_TTL_EXCEDIDO, q->sonda, SIM_TTL_INICIAL, ahora);
+        liberar_paquete_sim(sim, pq);
+        return;
+    }
+    e = v >= 0 ? buscar_arista_activa(grafo, u, v) : -1;
+    bw = e >= 0 ? grafo->aristas.ancho_banda_mbps[e] : 0;
+    if (bw <= 0)
+    {
+        sim->est.sin_ruta++;
+        liberar_paquete_sim(sim, pq);
+        return;
+    }
+    /* lo que queda por transmitir delante de el, en bytes, contra el buffer */
+    inicio = sim->libre[e] > ahora ? sim->libre[e] : ahora;
+    if ((double)(inicio - ahora) * (double)bw / 8000.0 > (double)sim->p.cola_bytes)
+    {
+        sim->est.perdidos_cola++;
+        liberar_paquete_sim(sim, pq);
+        return;
+    }
+    serializacion = (uint64_t)q->bytes * 8000ULL / (uint64_t)bw;
+    sim->libre[e] = inicio + serializacion;
+    if (aleatorio_sim(sim) >= (double)grafo->aristas.fiabilidad[e])
+    {
+        sim->est.perdidos_enlace++;
+        liberar_paquete_sim(sim, pq);
+        return;
+    }
+    q->nodo = v;
+    if (nuevo_evento_sim(sim, sim->libre[e] + (uint64_t)grafo->aristas.latencia_ms[e] * SIM_NS_POR_MS, EVENTO_LLEGADA, pq) < 0)
+        liberar_paquete_sim(sim, pq);
+}
+
+int ejecutar_simulacion(SIMULADOR *sim, uint64_t hasta_ns)
+{
+    int ev, tipo, objeto;
+    const MATRIZ_DEMANDAS *dem;
+
+    if (!sim)
+        return -1;
+    while ((ev = rueda_extraer(&sim->rueda, sim->eventos)) != -1)
+    {
+        if (sim->eventos[ev].tiempo > hasta_ns)
+        {
+            /* se devuelve a la rueda para poder continuar despues */
+            rueda_colocar(&sim->rueda, sim->eventos, ev);
+            sim->rueda.pendientes++;
+            break;
+        }
+        tipo = sim->eventos[ev].tipo;
+        objeto = sim->eventos[ev].objeto;
+        sim->eventos[ev].siguiente = sim->eventos_libres;
+        sim->eventos_libres = ev;
+        sim->est.eventos++;
+        if (tipo == EVENTO_LLEGADA)
+        {
+            procesar_llegada_sim(sim, objeto);
+        }
+        else
+        {
+            dem = sim->demandas;
+            sim->est.generados++;
+            emitir_paquete_sim(sim, dem->origen[objeto], sim->grafo->datos[dem->destino[objeto]].ip, PAQUETE_DATOS, -1, SIM_TTL_INICIAL, sim->rueda.ahora);
+            if (sim->rueda.ahora < sim->fin_demandas)
+                nuevo_evento_sim(sim, sim->rueda.ahora + intervalo_demanda(sim, dem->mbps[objeto]), EVENTO_GENERAR, objeto);
+        }
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,796 @@
+#ifndef SRLG_H
+#define SRLG_H
+
+#include <float.h>
+#include "grafos.h"
+#include "dijkstra.h"
+#include "flujo.h"
+#include "resiliencia.h"
+#include "trafico.h"
+
+#define MAX_GRUPOS_COMBINACION 3
+#define MAX_ESCENARIOS_SRLG 1000000
+#define MAX_MEMORIA_SRLG ((size_t)256 << 20)
+
+/*
+ * Fallos correlados por grupos de riesgo compartido (SRLG).
+ * Un escenario tira a la vez todos los enlaces de uno o varios grupos: su
+ * estado es aristas.activo AND NOT (miembros de cada grupo), palabra a
+ * palabra, sin tocar arista por arista. Los recorridos leen el estado a
+ * través de aristas.activo, así que durante el escenario se sustituye por la
+ * copia enmascarada y al terminar se devuelve el original.
+ *
+ * El barrido recorre primero los grupos de uno en uno y después las
+ * combinaciones de 2, 3... grupos; una demanda que ya se quedó sin camino con
+ * una combinación más pequeña no se vuelve a comprobar, así que cada demanda
+ * cortada guarda un corte mínimo (ninguna combinación menor la corta).
+ * Además, un escenario solo repite el BFS (bidireccional) de las demandas
+ * pendientes que puede cortar según los caminos guardados (ver CAMINOS_SRLG);
+ * el resto se descarta con operaciones sobre bitsets de demandas.
+ */
+typedef struct INFORME_SRLG
+{
+    int num_demandas;
+    int *disjuntos;    /* caminos disjuntos por enlaces sin fallos */
+    int *tam_corte;    /* grupos del corte mínimo, 0 = ningún escenario la corta, -1 = ya sin camino */
+    int (*corte)[MAX_GRUPOS_COMBINACION];
+    int *cortes_grupo; /* por grupo: demandas que deja sin camino él solo */
+    long long escenarios;
+    int truncado;      /* se alcanzó MAX_ESCENARIOS_SRLG */
+} INFORME_SRLG;
+
+/* Marca (o desmarca) los dos sentidos del enlace u-v; devuelve cuántas aristas tocó */
+int asignar_srlg_enlace(GRAFO *grafo, int grupo, int u, int v, int miembro);
+/* mascara = activo sin los enlaces de los grupos; devuelve 1 si el escenario tira algún enlace activo */
+int mascara_grupos(const GRAFO *grafo, const int *grupos, int num, uint64_t *mascara);
+/* max_grupos: tamaño máximo de las combinaciones (1..MAX_GRUPOS_COMBINACION); -1 sin memoria */
+int analizar_srlg(GRAFO *grafo, const MATRIZ_DEMANDAS *dem, int max_grupos, INFORME_SRLG *informe);
+void liberar_informe_srlg(INFORME_SRLG *informe);
+/*
+ * Hasta K rutas de menor latencia que no comparten enlace (en ningún sentido)
+ * ni grupo de riesgo: tras cada ruta se enmascaran sus enlaces y todos los
+ * grupos a los que pertenecen. Es voraz; puede encontrar menos rutas de las
+ * que existen si la primera bloquea a las demás.
+ */
+int rutas_disjuntas_srlg(GRAFO *grafo, int indice_origen, int indice_destino, int K, int caminos[][256], int longitudes[], int longitud_maxima);
+
+// Implementaciones
+
+int asignar_srlg_enlace(GRAFO *grafo, int grupo, int u, int v, int miembro)
+{
+    int e, tocadas;
+
+    if (!grafo || grupo < 0 || grupo >= grafo->srlg.num || u < 0 || v < 0 || u >= grafo->num_vertices || v >= grafo->num_vertices)
+        return 0;
+    tocadas = 0;
+    for (e = grafo->vertices[u].primera_arista; e != -1; e = grafo->aristas.siguiente[e])
+        if (grafo->aristas.destino[e] == v && asignar_grupo_arista(grafo, grupo, e, miembro) == 0)
+            tocadas++;
+    for (e = grafo->vertices[v].primera_arista; u != v && e != -1; e = grafo->aristas.siguiente[e])
+        if (grafo->aristas.destino[e] == u && asignar_grupo_arista(grafo, grupo, e, miembro) == 0)
+            tocadas++;
+    return tocadas;
+}
+
+int mascara_grupos(const GRAFO *grafo, const int *grupos, int num, uint64_t *mascara)
+{
+    int palabras, w, k;
+    uint64_t caidas, tira;
+
+    palabras = (grafo->aristas.num + 63) / 64;
+    tira = 0;
+    for (w = 0; w < palabras; ++w)
+    {
+        caidas = 0;
+        for (k = 0; k < num; ++k)
+            caidas |= grafo->srlg.miembros[grupos[k]][w];
+        tira |= grafo->aristas.activo[w] & caidas;
+        mascara[w] = grafo->aristas.activo[w] & ~caidas;
+    }
+    return tira != 0;
+}
+
+void liberar_informe_srlg(INFORME_SRLG *informe)
+{
+    if (!informe)
+        return;
+    free(informe->disjuntos);
+    free(informe->tam_corte);
+    free(informe->corte);
+    free(informe->cortes_grupo);
+    memset(informe, 0, sizeof(*informe));
+}
+
+static const MATRIZ_DEMANDAS *demandas_orden_srlg;
+
+static int comparar_demanda_origen(const void *pa, const void *pb)
+{
+    int a = *(const int *)pa, b = *(const int *)pb;
+    return demandas_orden_srlg->origen[a] - demandas_orden_srlg->origen[b];
+}
+
+/* Caminos disjuntos por enlaces de cada demanda: flujo máximo con capacidad 1 por arista */
+static int contar_disjuntos(GRAFO *grafo, const MATRIZ_DEMANDAS *dem, int *disjuntos)
+{
+    RED_FLUJO red;
+    int i, a;
+
+    if (construir_red_flujo(grafo, &red) != 0)
+        return -1;
+    for (a = 0; a < red.num_arcos; ++a)
+        red.capacidad[a] = red.arista[a] != -1 ? 1 : 0;
+    for (i = 0; i < dem->num; ++i)
+        disjuntos[i] = (int)flujo_maximo(&red, dem->origen[i], dem->destino[i]);
+    liberar_red_flujo(&red);
+    return 0;
+}
+
+/*
+ * Caminos que prueban que una demanda sigue conectada, en un almacén común:
+ * el de su árbol BFS sin fallos y, para cada grupo que lo corta, el que queda
+ * cuando cae solo ese grupo. Una combinación solo puede cortar la demanda si,
+ * para cada grupo x de la combinación, los demás tiran alguna arista del
+ * camino que queda con x caído (si no, ese camino sobrevive).
+ *
+ * La condición se evalúa con bitsets sobre las demandas: toca_base[y] tiene
+ * las demandas cuyo camino base pasa por el grupo y, y toca[x][y] aquellas
+ * cuyo camino con x caído pasa por y. Las candidatas de {a, b, c} son
+ * (toca[a][b] | toca[a][c]) & (toca[b][a] | toca[b][c]) & (toca[c][a] | toca[c][b]),
+ * palabra a palabra, y solo ellas repiten el BFS. Si toca no cabe en
+ * MAX_MEMORIA_SRLG se filtra con toca_base y se miran los caminos de cada
+ * candidata. Con tres grupos se guardan también los caminos que sobreviven a
+ * cada pareja: {a, b, c} debe tirar además el que deja {a, b}, el de {a, c}
+ * y el de {b, c}.
+ */
+typedef struct CAMINOS_SRLG
+{
+    int *arista; /* almacén de aristas de todos los caminos */
+    int num;
+    int capacidad;
+    int *inicio; /* camino base de d: arista[inicio[d] .. fin[d]) */
+    int *fin;
+    /* alternativas del grupo k: entradas alt_grupo[k] .. alt_grupo[k + 1], crecientes en demanda */
+    int *alt_grupo;
+    int *alt_par;     /* igual para la pareja de rango indice_par(a, b); NULL si no se guardan */
+    int *alt_demanda;
+    int *alt_inicio;
+    int *alt_fin;
+    int alt_num;
+    int alt_capacidad;
+    /* grupos de la arista e: grupos_arista[grupos_inicio[e] .. grupos_inicio[e + 1]) */
+    int *grupos_inicio;
+    int *grupos_arista;
+    int palabras;         /* palabras de un bitset de demandas */
+    uint64_t *toca_base;  /* fila y */
+    uint64_t *toca;       /* fila x * num_grupos + y; NULL si no cabe */
+    uint64_t *vivas;      /* demandas con camino sin fallos */
+    uint64_t *pendientes; /* vivas que todavía no corta ninguna combinación */
+    uint64_t *candidatas;
+    int *padre;  /* arista por la que el BFS llegó a cada vértice */
+    /* lado inverso de la búsqueda bidireccional (marca con el sello del RECORRIDO) */
+    int *cola_inv;
+    unsigned *marca_inv;
+    int *padre_inv; /* arista por la que se sale de cada vértice hacia el destino */
+} CAMINOS_SRLG;
+
+static void liberar_caminos_srlg(CAMINOS_SRLG *c)
+{
+    free(c->arista);
+    free(c->inicio);
+    free(c->fin);
+    free(c->alt_grupo);
+    free(c->alt_par);
+    free(c->alt_demanda);
+    free(c->alt_inicio);
+    free(c->alt_fin);
+    free(c->grupos_inicio);
+    free(c->grupos_arista);
+    free(c->toca_base);
+    free(c->toca);
+    free(c->vivas);
+    free(c->pendientes);
+    free(c->candidatas);
+    free(c->padre);
+    free(c->cola_inv);
+    free(c->marca_inv);
+    free(c->padre_inv);
+    memset(c, 0, sizeof(*c));
+}
+
+static void nuevo_sello_srlg(RECORRIDO *r, CAMINOS_SRLG *c)
+{
+    if (++r->sello == 0)
+    {
+        memset(r->marca, 0, sizeof(unsigned) * r->num_vertices);
+        memset(c->marca_inv, 0, sizeof(unsigned) * r->num_vertices);
+        r->sello = 1;
+    }
+}
+
+/* BFS como contar_alcanzables_desde, guardando la arista de llegada */
+static void arbol_alcance(GRAFO *grafo, RECORRIDO *r, int origen, CAMINOS_SRLG *c)
+{
+    int cabeza, fin, u, v, ar, *padre = c->padre;
+
+    nuevo_sello_srlg(r, c);
+    if (!grafo->vertices[origen].activo)
+        return;
+    cabeza = 0;
+    fin = 0;
+    r->cola[fin++] = origen;
+    r->marca[origen] = r->sello;
+    padre[origen] = -1;
+    while (cabeza < fin)
+    {
+        u = r->cola[cabeza++];
+        for (ar = grafo->vertices[u].primera_arista; ar != -1; ar = grafo->aristas.siguiente[ar])
+        {
+            v = grafo->aristas.destino[ar];
+            if (!ARISTA_ACTIVA(grafo, ar) || r->marca[v] == r->sello || !grafo->vertices[v].activo)
+                continue;
+            r->marca[v] = r->sello;
+            padre[v] = ar;
+            r->cola[fin++] = v;
+        }
+    }
+    INSTR_SUMAR(visitas_bfs, fin);
+}
+
+/*
+ * BFS bidireccional s -> t por las listas de salida y de entrada: cada paso
+ * expande un vértice del lado con menos pendientes. Para en cuanto los lados
+ * se tocan o uno se agota, así que un corte que aísla una zona pequeña se
+ * detecta sin recorrer el resto de la red. Devuelve el vértice de encuentro
+ * (padre lleva hasta s, padre_inv hasta t) o -1 si no hay camino.
+ */
+static int encuentro_bidireccional(GRAFO *grafo, RECORRIDO *r, CAMINOS_SRLG *c, int s, int t)
+{
+    const ARISTAS *a = &grafo->aristas;
+    int cabeza, fin, cabeza_inv, fin_inv, u, v, ar, encuentro;
+
+    nuevo_sello_srlg(r, c);
+    if (!grafo->vertices[s].activo || !grafo->vertices[t].activo)
+        return -1;
+    cabeza = fin = cabeza_inv = fin_inv = 0;
+    r->cola[fin++] = s;
+    r->marca[s] = r->sello;
+    c->padre[s] = -1;
+    c->cola_inv[fin_inv++] = t;
+    c->marca_inv[t] = r->sello;
+    c->padre_inv[t] = -1;
+    encuentro = s == t ? s : -1;
+    while (encuentro == -1 && cabeza < fin && cabeza_inv < fin_inv)
+    {
+        if (fin - cabeza <= fin_inv - cabeza_inv)
+        {
+            u = r->cola[cabeza++];
+            for (ar = grafo->vertices[u].primera_arista; ar != -1 && encuentro == -1; ar = a->siguiente[ar])
+            {
+                v = a->destino[ar];
+                if (!ARISTA_ACTIVA(grafo, ar) || r->marca[v] == r->sello || !grafo->vertices[v].activo)
+                    continue;
+                r->marca[v] = r->sello;
+                c->padre[v] = ar;
+                r->cola[fin++] = v;
+                if (c->marca_inv[v] == r->sello)
+                    encuentro = v;
+            }
+        }
+        else
+        {
+            u = c->cola_inv[cabeza_inv++];
+            for (ar = grafo->vertices[u].primera_entrante; ar != -1 && encuentro == -1; ar = a->siguiente_entrante[ar])
+            {
+                v = a->origen[ar];
+                if (!ARISTA_ACTIVA(grafo, ar) || c->marca_inv[v] == r->sello || !grafo->vertices[v].activo)
+                    continue;
+                c->marca_inv[v] = r->sello;
+                c->padre_inv[v] = ar;
+                c->cola_inv[fin_inv++] = v;
+                if (r->marca[v] == r->sello)
+                    encuentro = v;
+            }
+        }
+    }
+    INSTR_SUMAR(visitas_bfs, fin + fin_inv);
+    return encuentro;
+}
+
+static int anotar_arista_camino(CAMINOS_SRLG *c, int e)
+{
+    void *tmp;
+
+    if (c->num == c->capacidad)
+    {
+        c->capacidad = c->capacidad ? c->capacidad * 2 : 1024;
+        tmp = realloc(c->arista, sizeof(int) * c->capacidad);
+        if (!tmp)
+            return -1;
+        c->arista = tmp;
+    }
+    c->arista[c->num++] = e;
+    return 0;
+}
+
+/*
+ * Copia al almacén el camino origen -> destino que pasa por encuentro: la
+ * parte de padre (BFS directo) y, si la hay, la de padre_inv; -1 sin memoria.
+ */
+static int guardar_camino(const GRAFO *grafo, CAMINOS_SRLG *c, int origen, int encuentro, int destino, int *inicio, int *fin)
+{
+    int v;
+
+    *inicio = c->num;
+    for (v = encuentro; v != origen; v = grafo->aristas.origen[c->padre[v]])
+        if (anotar_arista_camino(c, c->padre[v]) != 0)
+            return -1;
+    for (v = encuentro; v != destino; v = grafo->aristas.destino[c->padre_inv[v]])
+        if (anotar_arista_camino(c, c->padre_inv[v]) != 0)
+            return -1;
+    *fin = c->num;
+    return 0;
+}
+
+static int guardar_alternativa(const GRAFO *grafo, CAMINOS_SRLG *c, int origen, int encuentro, int destino, int d)
+{
+    void *tmp;
+    int nueva;
+
+    if (c->alt_num == c->alt_capacidad)
+    {
+        nueva = c->alt_capacidad ? c->alt_capacidad * 2 : 256;
+        if (!(tmp = realloc(c->alt_demanda, sizeof(int) * nueva)))
+            return -1;
+        c->alt_demanda = tmp;
+        if (!(tmp = realloc(c->alt_inicio, sizeof(int) * nueva)))
+            return -1;
+        c->alt_inicio = tmp;
+        if (!(tmp = realloc(c->alt_fin, sizeof(int) * nueva)))
+            return -1;
+        c->alt_fin = tmp;
+        c->alt_capacidad = nueva;
+    }
+    c->alt_demanda[c->alt_num] = d;
+    if (guardar_camino(grafo, c, origen, encuentro, destino, &c->alt_inicio[c->alt_num], &c->alt_fin[c->alt_num]) != 0)
+        return -1;
+    c->alt_num++;
+    return 0;
+}
+
+/* Índice arista -> grupos a partir de los bitsets de miembros; -1 sin memoria */
+static int indexar_grupos_arista(const GRAFO *grafo, CAMINOS_SRLG *c)
+{
+    int palabras, k, w, e, total;
+    uint64_t bits;
+
+    palabras = (grafo->aristas.num + 63) / 64;
+    c->grupos_inicio = calloc(grafo->aristas.num + 2, sizeof(int));
+    if (!c->grupos_inicio)
+        return -1;
+    for (k = 0; k < grafo->srlg.num; ++k)
+        for (w = 0; w < palabras; ++w)
+            for (bits = grafo->srlg.miembros[k][w]; bits; bits &= bits - 1)
+                c->grupos_inicio[w * 64 + __builtin_ctzll(bits) + 1]++;
+    for (e = 0; e < grafo->aristas.num; ++e)
+        c->grupos_inicio[e + 1] += c->grupos_inicio[e];
+    total = c->grupos_inicio[grafo->aristas.num];
+    c->grupos_arista = malloc(sizeof(int) * (total + 1));
+    if (!c->grupos_arista)
+        return -1;
+    /* relleno con grupos_inicio desplazado una posición y vuelta atrás */
+    for (k = 0; k < grafo->srlg.num; ++k)
+        for (w = 0; w < palabras; ++w)
+            for (bits = grafo->srlg.miembros[k][w]; bits; bits &= bits - 1)
+            {
+                e = w * 64 + __builtin_ctzll(bits);
+                c->grupos_arista[c->grupos_inicio[e]++] = k;
+            }
+    for (e = grafo->aristas.num; e > 0; --e)
+        c->grupos_inicio[e] = c->grupos_inicio[e - 1];
+    c->grupos_inicio[0] = 0;
+    return 0;
+}
+
+/* Pone el bit d en la fila de cada grupo por el que pasa arista[inicio .. fin) */
+static void marcar_grupos_camino(const CAMINOS_SRLG *c, int inicio, int fin, uint64_t *filas, int d)
+{
+    int k, j, e;
+
+    for (k = inicio; k < fin; ++k)
+    {
+        e = c->arista[k];
+        for (j = c->grupos_inicio[e]; j < c->grupos_inicio[e + 1]; ++j)
+            filas[(size_t)c->grupos_arista[j] * c->palabras + (d >> 6)] |= UINT64_C(1) << (d & 63);
+    }
+}
+
+/* toca[x][y]: toca_base[y] con los caminos base sustituidos por las alternativas de x */
+static void construir_toca(CAMINOS_SRLG *c, int num_grupos)
+{
+    uint64_t *filas;
+    int x, y, j, d;
+
+    for (x = 0; x < num_grupos; ++x)
+    {
+        filas = c->toca + (size_t)x * num_grupos * c->palabras;
+        memcpy(filas, c->toca_base, sizeof(uint64_t) * num_grupos * c->palabras);
+        for (j = c->alt_grupo[x]; j < c->alt_grupo[x + 1]; ++j)
+        {
+            d = c->alt_demanda[j];
+            for (y = 0; y < num_grupos; ++y)
+                filas[(size_t)y * c->palabras + (d >> 6)] &= ~(UINT64_C(1) << (d & 63));
+            marcar_grupos_camino(c, c->alt_inicio[j], c->alt_fin[j], filas, d);
+        }
+    }
+}
+
+/* 1 si la máscara tira alguna arista de arista[inicio .. fin) */
+static int camino_tocado(const CAMINOS_SRLG *c, int inicio, int fin, const uint64_t *mascara)
+{
+    int k, e;
+
+    for (k = inicio; k < fin; ++k)
+    {
+        e = c->arista[k];
+        if (!((mascara[e >> 6] >> (e & 63)) & 1u))
+            return 1;
+    }
+    return 0;
+}
+
+/* Posición de a < b en el orden lexicográfico de las parejas */
+static int indice_par(int a, int b, int num_grupos)
+{
+    return a * num_grupos - a * (a + 1) / 2 + (b - a - 1);
+}
+
+/* Alternativa de d entre las entradas desde .. hasta (búsqueda binaria), -1 si no tiene */
+static int buscar_alternativa(const CAMINOS_SRLG *c, int desde, int hasta, int d)
+{
+    int lo, hi, mid;
+
+    lo = desde;
+    hi = hasta;
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (c->alt_demanda[mid] < d)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < hasta && c->alt_demanda[lo] == d ? lo : -1;
+}
+
+/*
+ * La combinación (ya aplicada como estado) tira los caminos guardados que
+ * no mira toca: el que deja cada grupo si no hay toca y, con tres grupos, el
+ * que deja cada pareja.
+ */
+static int corte_posible(const CAMINOS_SRLG *c, int d, const int *combinacion, int tam, int num_grupos, const uint64_t *mascara)
+{
+    int k, j;
+
+    for (k = 0; !c->toca && k < tam; ++k)
+    {
+        j = buscar_alternativa(c, c->alt_grupo[combinacion[k]], c->alt_grupo[combinacion[k] + 1], d);
+        if (j != -1 ? !camino_tocado(c, c->alt_inicio[j], c->alt_fin[j], mascara) : !camino_tocado(c, c->inicio[d], c->fin[d], mascara))
+            return 0;
+    }
+    for (k = 0; tam == 3 && c->alt_par && k < tam; ++k)
+    {
+        /* la pareja sin combinacion[k] */
+        j = indice_par(combinacion[k == 0], combinacion[k == 2 ? 1 : 2], num_grupos);
+        j = buscar_alternativa(c, c->alt_par[j], c->alt_par[j + 1], d);
+        if (j != -1 && !camino_tocado(c, c->alt_inicio[j], c->alt_fin[j], mascara))
+            return 0;
+    }
+    return 1;
+}
+
+/* Rellena candidatas para la combinación; devuelve 1 si hay alguna */
+static int demandas_candidatas(const CAMINOS_SRLG *c, int num_grupos, const int *combinacion, int tam)
+{
+    const uint64_t *base = tam == 1 ? c->vivas : c->pendientes;
+    uint64_t v, alguna;
+    int w, x, y, hay;
+
+    hay = 0;
+    for (w = 0; w < c->palabras; ++w)
+    {
+        v = base[w];
+        if (tam == 1 || !c->toca)
+        {
+            alguna = 0;
+            for (x = 0; x < tam; ++x)
+                alguna |= c->toca_base[(size_t)combinacion[x] * c->palabras + w];
+            v &= alguna;
+        }
+        else
+            for (x = 0; x < tam && v; ++x)
+            {
+                alguna = 0;
+                for (y = 0; y < tam; ++y)
+                    if (y != x)
+                        alguna |= c->toca[((size_t)combinacion[x] * num_grupos + combinacion[y]) * c->palabras + w];
+                v &= alguna;
+            }
+        c->candidatas[w] = v;
+        hay |= v != 0;
+    }
+    return hay;
+}
+
+/*
+ * Caminos sin fallos: marca con tam_corte = -1 las demandas que ya no tienen
+ * camino y guarda el de las demás (un BFS por origen, en el orden por
+ * origen); -1 sin memoria.
+ */
+static int caminos_base(GRAFO *grafo, const MATRIZ_DEMANDAS *dem, const int *orden, RECORRIDO *r, CAMINOS_SRLG *c, int *tam_corte)
+{
+    int i, k, d;
+
+    for (i = 0; i < dem->num; i = k)
+    {
+        arbol_alcance(grafo, r, dem->origen[orden[i]], c);
+        for (k = i; k < dem->num && dem->origen[orden[k]] == dem->origen[orden[i]]; ++k)
+        {
+            d = orden[k];
+            c->inicio[d] = c->fin[d] = c->num;
+            if (r->marca[dem->destino[d]] != r->sello)
+                tam_corte[d] = -1;
+            else if (guardar_camino(grafo, c, dem->origen[d], dem->destino[d], dem->destino[d], &c->inicio[d], &c->fin[d]) != 0)
+                return -1;
+        }
+    }
+    for (d = 0; d < dem->num; ++d)
+        if (tam_corte[d] == 0)
+        {
+            c->vivas[d >> 6] |= UINT64_C(1) << (d & 63);
+            marcar_grupos_camino(c, c->inicio[d], c->fin[d], c->toca_base, d);
+        }
+    memcpy(c->pendientes, c->vivas, sizeof(uint64_t) * c->palabras);
+    return 0;
+}
+
+/*
+ * Repite el BFS, con el estado actual (la máscara de la combinación), para
+ * las candidatas; con un solo grupo guarda además los caminos alternativos.
+ * Devuelve cuántas demandas quedaron cortadas por primera vez, -1 sin memoria.
+ */
+static int comprobar_demandas(GRAFO *grafo, const MATRIZ_DEMANDAS *dem, RECORRIDO *r, CAMINOS_SRLG *c,
+                              const int *combinacion, int tam, int num_grupos, INFORME_SRLG *informe)
+{
+    uint64_t bits;
+    int w, d, encuentro, cortadas, guardar;
+
+    cortadas = 0;
+    guardar = tam == 1 || (tam == 2 && c->alt_par);
+    for (w = 0; w < c->palabras; ++w)
+        for (bits = c->candidatas[w]; bits; bits &= bits - 1)
+        {
+            d = w * 64 + __builtin_ctzll(bits);
+            if (tam > 1 && !corte_posible(c, d, combinacion, tam, num_grupos, grafo->aristas.activo))
+                continue;
+            encuentro = encuentro_bidireccional(grafo, r, c, dem->origen[d], dem->destino[d]);
+            if (encuentro != -1)
+            {
+                if (guardar && guardar_alternativa(grafo, c, dem->origen[d], encuentro, dem->destino[d], d) != 0)
+                    return -1;
+                continue;
+            }
+            if (tam == 1)
+                informe->cortes_grupo[combinacion[0]]++;
+            if (informe->tam_corte[d] == 0)
+            {
+                informe->tam_corte[d] = tam;
+                memcpy(informe->corte[d], combinacion, sizeof(int) * tam);
+                c->pendientes[w] &= ~(UINT64_C(1) << (d & 63));
+                cortadas++;
+            }
+        }
+    return cortadas;
+}
+
+int analizar_srlg(GRAFO *grafo, const MATRIZ_DEMANDAS *dem, int max_grupos, INFORME_SRLG *informe)
+{
+    RECORRIDO r;
+    CAMINOS_SRLG caminos;
+    uint64_t *mascara, *original;
+    int *orden, combinacion[MAX_GRUPOS_COMBINACION], num_grupos, tam, i, k, pendientes, cortadas, par, ok;
+
+    memset(informe, 0, sizeof(*informe));
+    if (!grafo || !dem)
+        return -1;
+    if (max_grupos < 1)
+        max_grupos = 1;
+    if (max_grupos > MAX_GRUPOS_COMBINACION)
+        max_grupos = MAX_GRUPOS_COMBINACION;
+    num_grupos = grafo->srlg.num;
+    informe->num_demandas = dem->num;
+    informe->disjuntos = calloc(dem->num + 1, sizeof(int));
+    informe->tam_corte = calloc(dem->num + 1, sizeof(int));
+    informe->corte = calloc(dem->num + 1, sizeof(*informe->corte));
+    informe->cortes_grupo = calloc(num_grupos + 1, sizeof(int));
+    orden = malloc(sizeof(int) * (dem->num + 1));
+    mascara = malloc(sizeof(uint64_t) * ((grafo->aristas.num + 63) / 64 + 1));
+    memset(&caminos, 0, sizeof(caminos));
+    caminos.palabras = (dem->num + 63) / 64;
+    caminos.inicio = malloc(sizeof(int) * (dem->num + 1));
+    caminos.fin = malloc(sizeof(int) * (dem->num + 1));
+    caminos.alt_grupo = calloc(num_grupos + 1, sizeof(int));
+    caminos.toca_base = calloc((size_t)num_grupos * caminos.palabras + 1, sizeof(uint64_t));
+    caminos.vivas = calloc(caminos.palabras + 1, sizeof(uint64_t));
+    caminos.pendientes = calloc(caminos.palabras + 1, sizeof(uint64_t));
+    caminos.candidatas = calloc(caminos.palabras + 1, sizeof(uint64_t));
+    caminos.padre = malloc(sizeof(int) * (grafo->num_vertices + 1));
+    caminos.cola_inv = malloc(sizeof(int) * (grafo->num_vertices + 1));
+    caminos.marca_inv = calloc(grafo->num_vertices + 1, sizeof(unsigned));
+    caminos.padre_inv = malloc(sizeof(int) * (grafo->num_vertices + 1));
+    ok = informe->disjuntos && informe->tam_corte && informe->corte && informe->cortes_grupo && orden && mascara &&
+         caminos.inicio && caminos.fin && caminos.alt_grupo && caminos.toca_base && caminos.vivas &&
+         caminos.pendientes && caminos.candidatas && caminos.padre && caminos.cola_inv && caminos.marca_inv &&
+         caminos.padre_inv && indexar_grupos_arista(grafo, &caminos) == 0 &&
+         iniciar_recorrido(&r, grafo->num_vertices) == 0;
+    if (ok)
+    {
+        for (i = 0; i < dem->num; ++i)
+            orden[i] = i;
+        demandas_orden_srlg = dem;
+        qsort(orden, dem->num, sizeof(int), comparar_demanda_origen);
+        /* las que ya no tienen camino sin fallos no cuentan como cortadas */
+        ok = contar_disjuntos(grafo, dem, informe->disjuntos) == 0 && caminos_base(grafo, dem, orden, &r, &caminos, informe->tam_corte) == 0;
+        if (!ok)
+            liberar_recorrido(&r);
+    }
+    if (!ok)
+    {
+        free(orden);
+        free(mascara);
+        liberar_caminos_srlg(&caminos);
+        liberar_informe_srlg(informe);
+        return -1;
+    }
+    pendientes = 0;
+    for (i = 0; i < dem->num; ++i)
+        pendientes += informe->tam_corte[i] == 0;
+
+    original = grafo->aristas.activo;
+    for (tam = 1; ok && tam <= max_grupos && tam <= num_grupos && pendientes > 0 && !informe->truncado; ++tam)
+    {
+        /* sin toca (no cabe o no hay memoria) se sigue con el filtro por caminos */
+        if (tam == 2 && (size_t)num_grupos * num_grupos * caminos.palabras <= MAX_MEMORIA_SRLG / sizeof(uint64_t) &&
+            (caminos.toca = malloc(sizeof(uint64_t) * ((size_t)num_grupos * num_grupos * caminos.palabras + 1))))
+            construir_toca(&caminos, num_grupos);
+        if (tam == 2 && max_grupos > 2 && (size_t)num_grupos * num_grupos <= MAX_MEMORIA_SRLG / sizeof(int))
+            caminos.alt_par = calloc((size_t)num_grupos * (num_grupos - 1) / 2 + 1, sizeof(int));
+        par = 0;
+        for (k = 0; k < tam; ++k)
+            combinacion[k] = k;
+        while (1)
+        {
+            if (informe->escenarios >= MAX_ESCENARIOS_SRLG)
+            {
+                informe->truncado = 1;
+                break;
+            }
+            informe->escenarios++;
+            if (tam == 1)
+                caminos.alt_grupo[combinacion[0]] = caminos.alt_num;
+            else if (tam == 2 && caminos.alt_par)
+                caminos.alt_par[par] = caminos.alt_num;
+            if (demandas_candidatas(&caminos, num_grupos, combinacion, tam) && mascara_grupos(grafo, combinacion, tam, mascara))
+            {
+                grafo->aristas.activo = mascara;
+                cortadas = comprobar_demandas(grafo, dem, &r, &caminos, combinacion, tam, num_grupos, informe);
+                grafo->aristas.activo = original;
+                if (cortadas < 0)
+                {
+                    ok = 0;
+                    break;
+                }
+                pendientes -= cortadas;
+            }
+            if (tam == 1)
+                caminos.alt_grupo[combinacion[0] + 1] = caminos.alt_num;
+            else if (tam == 2 && caminos.alt_par)
+                caminos.alt_par[++par] = caminos.alt_num;
+            if (pendientes == 0 && tam > 1)
+                break;
+            /* siguiente combinación en orden lexicográfico */
+            for (k = tam - 1; k >= 0 && combinacion[k] == num_grupos - tam + k; --k)
+                ;
+            if (k < 0)
+                break;
+            combinacion[k]++;
+            for (i = k + 1; i < tam; ++i)
+                combinacion[i] = combinacion[i - 1] + 1;
+        }
+    }
+
+    free(orden);
+    free(mascara);
+    liberar_caminos_srlg(&caminos);
+    liberar_recorrido(&r);
+    if (!ok)
+    {
+        liberar_informe_srlg(informe);
+        return -1;
+    }
+    return 0;
+}
+
+
+/* Quita de la máscara los enlaces u-v (ambos sentidos, paralelos incluidos) y sus grupos */
+static void excluir_enlace_srlg(const GRAFO *grafo, int u, int v, uint64_t *mascara, int palabras)
+{
+    int lado, x, y, e, k, w;
+
+    for (lado = 0; lado < 2; ++lado)
+    {
+        x = lado ? v : u;
+        y = lado ? u : v;
+        for (e = grafo->vertices[x].primera_arista; e != -1; e = grafo->aristas.siguiente[e])
+        {
+            if (grafo->aristas.destino[e] != y)
+                continue;
+            mascara[e >> 6] &= ~(UINT64_C(1) << (e & 63));
+            for (k = 0; k < grafo->srlg.num; ++k)
+                if (ARISTA_EN_GRUPO(grafo, k, e))
+                    for (w = 0; w < palabras; ++w)
+                        mascara[w] &= ~grafo->srlg.miembros[k][w];
+        }
+    }
+}
+
+int rutas_disjuntas_srlg(GRAFO *grafo, int indice_origen, int indice_destino, int K, int caminos[][256], int longitudes[], int longitud_maxima)
+{
+    VISTA_latencia vista;
+    uint64_t *mascara, *original;
+    int *anterior, encontrados, palabras, len, i;
+    double *distancia;
+
+    if (!grafo || K <= 0 || longitud_maxima <= 1 || indice_origen < 0 || indice_destino < 0 ||
+        indice_origen >= grafo->num_vertices || indice_destino >= grafo->num_vertices)
+        return 0;
+    palabras = (grafo->aristas.num + 63) / 64;
+    mascara = malloc(sizeof(uint64_t) * (palabras + 1));
+    anterior = malloc(sizeof(int) * grafo->num_vertices);
+    distancia = malloc(sizeof(double) * grafo->num_vertices);
+    if (!mascara || !anterior || !distancia)
+    {
+        free(mascara);
+        free(anterior);
+        free(distancia);
+        return 0;
+    }
+    memcpy(mascara, grafo->aristas.activo, sizeof(uint64_t) * palabras);
+
+    original = grafo->aristas.activo;
+    encontrados = 0;
+    while (encontrados < K)
+    {
+        grafo->aristas.activo = mascara;
+        i = construir_vista_latencia(grafo, &vista);
+        grafo->aristas.activo = original;
+        if (i != 0)
+            break;
+        dijkstra_latencia(&vista, indice_origen, indice_destino, NULL, anterior, distancia);
+        liberar_vista_latencia(&vista);
+        if (distancia[indice_destino] >= DBL_MAX / 2)
+            break;
+        len = reconstruir_camino(anterior, indice_destino, caminos[encontrados], longitud_maxima);
+        if (len <= 1)
+            break;
+        longitudes[encontrados++] = len;
+        for (i = 0; i + 1 < len; ++i)
+            excluir_enlace_srlg(grafo, caminos[encontrados - 1][i], caminos[encontrados - 1][i + 1], mascara, palabras);
+    }
+
+    free(mascara);
+    free(anterior);
+    free(distancia);
+    return encontrados;
+}
+
+#endif
@@ -0,0 +1,498 @@
+#ifndef TODOS_PARES_H
+#define TODOS_PARES_H
+
+#include "grafos.h"
+#include "dijkstra.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+/*
+ * Siguiente salto para todos los pares (latencia).
+ * Un Dijkstra por origen sobre la vista CSR compartida; los origenes se
+ * reparten en bloques entre un pool de hilos que los toman de un contador
+ * comun, y cada hilo tiene su propio monticulo y buffers. El resultado es una
+ * matriz n x n de siguientes saltos con entradas de 16 bits (n < 65535) o
+ * 32 bits, de modo que cualquier ruta se lee en O(saltos) sin volver a
+ * calcular nada.
+ *
+ * Opcionalmente cada fila se comprime por tramos: destinos consecutivos con el
+ * mismo siguiente salto ocupan un solo tramo (primer destino, salto), en una
+ * palabra de 32 bits si las entradas son de 16 o en dos si no. Es lo
+ * habitual en un router con pocas salidas y destinos numerados por zonas; la
+ * consulta pasa a ser una busqueda binaria dentro de la fila.
+ *
+ * Si n^2 no cabe en memoria, las filas se vuelcan a un archivo segun se
+ * calculan (cabecera + matriz densa, orden de bytes de la maquina) y las
+ * rutas se leen luego del archivo con una lectura por salto.
+ */
+#define MAX_HILOS_SALTOS 8
+#define SALTOS_FIRMA 0x5341544Eu /* "NTAS" */
+#define SALTOS_BLOQUE_BYTES (4u << 20) /* filas por bloque: las que quepan en ~4 MB */
+
+typedef struct MATRIZ_SALTOS
+{
+    int num_vertices;
+    int bytes_entrada; /* 2 o 4 */
+    int comprimida;
+    void *densa;       /* n * n entradas (uint16_t o uint32_t) si no esta comprimida */
+    uint32_t **tramos; /* comprimida: tramos[s][0] = numero de tramos, luego los tramos */
+    size_t bytes;      /* memoria de la matriz */
+} MATRIZ_SALTOS;
+
+/* Tamano de entrada con el que se guardaria una matriz de n vertices */
+int bytes_por_salto(int n);
+/* Memoria de la matriz densa (salvo al volcar) mas los buffers de trabajo de los hilos */
+size_t estimar_memoria_saltos(GRAFO *grafo, int hilos, int volcar);
+/* hilos = 0 usa los procesadores disponibles */
+int calcular_todos_pares(GRAFO *grafo, int hilos, int comprimir, MATRIZ_SALTOS *saltos);
+/* Igual, pero escribiendo cada fila en archivo en lugar de guardarla */
+int volcar_todos_pares(GRAFO *grafo, int hilos, const char *archivo);
+void liberar_matriz_saltos(MATRIZ_SALTOS *saltos);
+/* Siguiente salto de s hacia d (s si s == d), -1 si no hay ruta */
+int siguiente_salto(const MATRIZ_SALTOS *saltos, int s, int d);
+/* Ruta s -> d en vertices; 0 si no hay */
+int ruta_por_saltos(const MATRIZ_SALTOS *saltos, int s, int d, int *camino, int max_camino);
+int ruta_desde_archivo_saltos(const char *archivo, int s, int d, int *camino, int max_camino);
+
+// Implementaciones
+
+int bytes_por_salto(int n)
+{
+    return n < 0xFFFF ? 2 : 4;
+}
+
+/* Filas que un hilo calcula seguidas: al volcar, las que quepan en un bloque de escritura */
+static int filas_bloque_saltos(int n, int volcar)
+{
+    size_t fila = (size_t)n * (size_t)bytes_por_salto(n);
+    size_t filas = fila > SALTOS_BLOQUE_BYTES ? 1 : SALTOS_BLOQUE_BYTES / (fila ? fila : 1);
+
+    /* en memoria basta un bloque pequeno para repartir bien */
+    if (!volcar)
+        filas = 16;
+    return filas > (size_t)n ? (n > 0 ? n : 1) : (int)filas;
+}
+
+/* monticulo (aristas + 1 entradas) y 4 arreglos de n por hilo, mas el bloque de filas al volcar */
+static size_t memoria_hilo_saltos(int n, int m, int volcar)
+{
+    size_t base = (size_t)(m + 1) * (sizeof(double) + sizeof(int)) + (size_t)n * (3 * sizeof(int) + sizeof(double));
+
+    if (!volcar)
+        return base;
+    return base + (size_t)filas_bloque_saltos(n, 1) * (size_t)n * (size_t)bytes_por_salto(n);
+}
+
+static int hilos_saltos(int hilos, int n)
+{
+    long procesadores;
+
+    if (hilos <= 0)
+    {
+        procesadores = sysconf(_SC_NPROCESSORS_ONLN);
+        hilos = procesadores > 0 ? (int)procesadores : 1;
+    }
+    if (hilos > MAX_HILOS_SALTOS)
+        hilos = MAX_HILOS_SALTOS;
+    if (hilos > n)
+        hilos = n > 0 ? n : 1;
+    return hilos;
+}
+
+size_t estimar_memoria_saltos(GRAFO *grafo, int hilos, int volcar)
+{
+    int n;
+    size_t matriz;
+
+    if (!grafo)
+        return 0;
+    n = grafo->num_vertices;
+    hilos = hilos_saltos(hilos, n);
+    matriz = volcar ? 0 : (size_t)n * (size_t)n * (size_t)bytes_por_salto(n);
+    return matriz + (size_t)hilos * memoria_hilo_saltos(n, grafo->aristas.num, volcar);
+}
+
+/* Estado compartido del pool */
+typedef struct POOL_SALTOS
+{
+    GRAFO *grafo;
+    const VISTA_latencia *vista;
+    MATRIZ_SALTOS *saltos; /* NULL al volcar a archivo */
+    int descriptor;        /* archivo de volcado, -1 si no */
+    int filas_bloque;
+    int siguiente_origen;  /* contador comun: se avanza de filas_bloque en filas_bloque */
+    int error;
+} POOL_SALTOS;
+
+/* Palabras por tramo: (inicio << 16 | salto) con entradas de 16 bits, inicio y salto si no */
+#define PALABRAS_TRAMO(bytes) ((bytes) == 2 ? 1 : 2)
+
+/* Fila s en tramos: devuelve el arreglo ya reservado o NULL */
+static uint32_t *comprimir_fila_saltos(const int *primero, int n)
+{
+    int d, num, palabras;
+    uint32_t *tramos;
+
+    palabras = PALABRAS_TRAMO(bytes_por_salto(n));
+    num = 0;
+    for (d = 0; d < n; ++d)
+        if (d == 0 || primero[d] != primero[d - 1])
+            num++;
+    tramos = malloc(sizeof(uint32_t) * (1 + (size_t)palabras * num));
+    if (!tramos)
+        return NULL;
+    tramos[0] = (uint32_t)num;
+    num = 0;
+    for (d = 0; d < n; ++d)
+    {
+        if (d != 0 && primero[d] == primero[d - 1])
+            continue;
+        if (palabras == 1)
+        {
+            tramos[1 + num] = ((uint32_t)d << 16) | ((uint32_t)primero[d] & 0xFFFF);
+        }
+        else
+        {
+            tramos[1 + 2 * num] = (uint32_t)d;
+            tramos[2 + 2 * num] = (uint32_t)primero[d];
+        }
+        num++;
+    }
+    return tramos;
+}
+
+static void *resolver_trabajo_saltos(void *arg)
+{
+    POOL_SALTOS *pool = arg;
+    GRAFO *grafo = pool->grafo;
+    MATRIZ_SALTOS *saltos = pool->saltos;
+    int n, bytes, s, d, inicio, fin, *anterior, *primero, *pila;
+    double *distancia;
+    unsigned char *bloque;
+    size_t fila, desplazamiento;
+    MONTICULO m;
+
+    n = pool->vista->num_vertices;
+    bytes = bytes_por_salto(n);
+    fila = (size_t)n * (size_t)bytes;
+    anterior = malloc(sizeof(int) * n);
+    primero = malloc(sizeof(int) * n);
+    pila = malloc(sizeof(int) * n);
+    distancia = malloc(sizeof(double) * n);
+    bloque = pool->descriptor >= 0 ? malloc(fila * (size_t)pool->filas_bloque) : NULL;
+    if (!anterior || !primero || !pila || !distancia || (pool->descriptor >= 0 && !bloque) || monticulo_iniciar(&m, pool->vista->num_aristas + 1) != 0)
+    {
+        __atomic_store_n(&pool->error, 1, __ATOMIC_RELAXED);
+        free(anterior);
+        free(primero);
+        free(pila);
+        free(distancia);
+        free(bloque);
+        return NULL;
+    }
+
+    while (!__atomic_load_n(&pool->error, __ATOMIC_RELAXED))
+    {
+        inicio = __atomic_fetch_add(&pool->siguiente_origen, pool->filas_bloque, __ATOMIC_RELAXED);
+        if (inicio >= n)
+            break;
+        fin = inicio + pool->filas_bloque < n ? inicio + pool->filas_bloque : n;
+        for (s = inicio; s < fin; ++s)
+        {
+            if (grafo->vertices[s].activo)
+            {
+                dijkstra_latencia(pool->vista, s, -1, &m, anterior, distancia);
+                primeros_saltos(anterior, distancia, n, s, primero, pila);
+                for (d = 0; d < n; ++d)
+                    if (!grafo->vertices[d].activo)
+                        primero[d] = -1;
+            }
+            else
+            {
+                for (d = 0; d < n; ++d)
+                    primero[d] = -1;
+            }
+
+            if (saltos && saltos->comprimida)
+            {
+                saltos->tramos[s] = comprimir_fila_saltos(primero, n);
+                if (!saltos->tramos[s])
+                    __atomic_store_n(&pool->error, 1, __ATOMIC_RELAXED);
+                continue;
+            }
+            /* -1 queda como todo unos en ambos anchos */
+            desplazamiento = (size_t)s * (size_t)n;
+            if (bytes == 2)
+            {
+                uint16_t *f = saltos ? (uint16_t *)saltos->densa + desplazamiento : (uint16_t *)(bloque + (size_t)(s - inicio) * fila);
+                for (d = 0; d < n; ++d)
+                    f[d] = (uint16_t)primero[d];
+            }
+            else
+            {
+                uint32_t *f = saltos ? (uint32_t *)saltos->densa + desplazamiento : (uint32_t *)(bloque + (size_t)(s - inicio) * fila);
+                for (d = 0; d < n; ++d)
+                    f[d] = (uint32_t)primero[d];
+            }
+        }
+        if (pool->descriptor >= 0)
+        {
+            /* cada bloque va a su posicion: los hilos no necesitan coordinarse al escribir */
+            size_t total = fila * (size_t)(fin - inicio), hecho = 0;
+            off_t pos = (off_t)(4 * sizeof(uint32_t)) + (off_t)fila * inicio;
+            ssize_t w;
+            while (hecho < total)
+            {
+                w = pwrite(pool->descriptor, bloque + hecho, total - hecho, pos + (off_t)hecho);
+                if (w <= 0)
+                {
+                    __atomic_store_n(&pool->error, 1, __ATOMIC_RELAXED);
+                    break;
+                }
+                hecho += (size_t)w;
+            }
+        }
+    }
+
+    monticulo_liberar(&m);
+    free(anterior);
+    free(primero);
+    free(pila);
+    free(distancia);
+    free(bloque);
+    return NULL;
+}
+
+static int ejecutar_pool_saltos(GRAFO *grafo, int hilos, MATRIZ_SALTOS *saltos, int descriptor)
+{
+    int h, n;
+    VISTA_latencia vista;
+    POOL_SALTOS pool;
+    pthread_t *hilo;
+    unsigned char *lanzado;
+
+    n = grafo->num_vertices;
+    if (construir_vista_latencia(grafo, &vista) != 0)
+        return -1;
+    hilos = hilos_saltos(hilos, n);
+    memset(&pool, 0, sizeof(pool));
+    pool.grafo = grafo;
+    pool.vista = &vista;
+    pool.saltos = saltos;
+    pool.descriptor = descriptor;
+    pool.filas_bloque = filas_bloque_saltos(n, descriptor >= 0);
+
+    hilo = malloc(sizeof(pthread_t) * hilos);
+    lanzado = calloc(hilos, 1);
+    if (!hilo || !lanzado)
+    {
+        free(hilo);
+        free(lanzado);
+        liberar_vista_latencia(&vista);
+        return -1;
+    }
+    for (h = 1; h < hilos; ++h)
+        lanzado[h] = pthread_create(&hilo[h], NULL, resolver_trabajo_saltos, &pool) == 0;
+    /* el hilo llamante tambien trabaja; si un hilo no arranca, los demas se quedan su parte */
+    resolver_trabajo_saltos(&pool);
+    for (h = 1; h < hilos; ++h)
+        if (lanzado[h])
+            pthread_join(hilo[h], NULL);
+    free(hilo);
+    free(lanzado);
+    liberar_vista_latencia(&vista);
+    return pool.error ? -1 : 0;
+}
+
+int calcular_todos_pares(GRAFO *grafo, int hilos, int comprimir, MATRIZ_SALTOS *saltos)
+{
+    int n, s;
+
+    if (!grafo || !saltos)
+        return -1;
+    memset(saltos, 0, sizeof(*saltos));
+    n = grafo->num_vertices;
+    saltos->num_vertices = n;
+    saltos->bytes_entrada = bytes_por_salto(n);
+    saltos->comprimida = comprimir != 0;
+    if (saltos->comprimida)
+        saltos->tramos = calloc(n + 1, sizeof(uint32_t *));
+    else
+        saltos->densa = malloc((size_t)n * (size_t)n * (size_t)saltos->bytes_entrada + 1);
+    if ((saltos->comprimida && !saltos->tramos) || (!saltos->comprimida && !saltos->densa))
+    {
+        liberar_matriz_saltos(saltos);
+        return -1;
+    }
+    if (n > 0 && ejecutar_pool_saltos(grafo, hilos, saltos, -1) != 0)
+    {
+        liberar_matriz_saltos(saltos);
+        return -1;
+    }
+    if (saltos->comprimida)
+    {
+        saltos->bytes = sizeof(uint32_t *) * (size_t)n;
+        for (s = 0; s < n; ++s)
+            saltos->bytes += sizeof(uint32_t) * (1 + (size_t)PALABRAS_TRAMO(saltos->bytes_entrada) * saltos->tramos[s][0]);
+    }
+    else
+    {
+        saltos->bytes = (size_t)n * (size_t)n * (size_t)saltos->bytes_entrada;
+    }
+    return 0;
+}
+
+int volcar_todos_pares(GRAFO *grafo, int hilos, const char *archivo)
+{
+    int descriptor, r;
+    uint32_t cabecera[4];
+
+    if (!grafo || !archivo)
+        return -1;
+    descriptor = open(archivo, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (descriptor < 0)
+        return -1;
+    cabecera[0] = SALTOS_FIRMA;
+    cabecera[1] = (uint32_t)grafo->num_vertices;
+    cabecera[2] = (uint32_t)bytes_por_salto(grafo->num_vertices);
+    cabecera[3] = 0;
+    r = pwrite(descriptor, cabecera, sizeof(cabecera), 0) == (ssize_t)sizeof(cabecera) ? 0 : -1;
+    if (r == 0 && grafo->num_vertices > 0)
+        r = ejecutar_pool_saltos(grafo, hilos, NULL, descriptor);
+    if (close(descriptor) != 0)
+        r = -1;
+    return r;
+}
+
+void liberar_matriz_saltos(MATRIZ_SALTOS *saltos)
+{
+    int s;
+
+    if (!saltos)
+        return;
+    if (saltos->tramos)
+        for (s = 0; s < saltos->num_vertices; ++s)
+            free(saltos->tramos[s]);
+    free(saltos->tramos);
+    free(saltos->densa);
+    memset(saltos, 0, sizeof(*saltos));
+}
+
+int siguiente_salto(const MATRIZ_SALTOS *saltos, int s, int d)
+{
+    size_t pos;
+    uint32_t valor, izq, der, med;
+    const uint32_t *tramos;
+
+    if (!saltos || s < 0 || d < 0 || s >= saltos->num_vertices || d >= saltos->num_vertices)
+        return -1;
+    if (saltos->comprimida)
+    {
+        tramos = saltos->tramos[s];
+        /* ultimo tramo que empieza en d o antes; el primero siempre empieza en 0 */
+        izq = 0;
+        der = tramos[0];
+        if (saltos->bytes_entrada == 2)
+        {
+            while (der - izq > 1)
+            {
+                med = (izq + der) / 2;
+                if ((tramos[1 + med] >> 16) <= (uint32_t)d)
+                    izq = med;
+                else
+                    der = med;
+            }
+            valor = tramos[1 + izq] & 0xFFFF;
+            return valor == 0xFFFF ? -1 : (int)valor;
+        }
+        while (der - izq > 1)
+        {
+            med = (izq + der) / 2;
+            if (tramos[1 + 2 * med] <= (uint32_t)d)
+                izq = med;
+            else
+                der = med;
+        }
+        valor = tramos[2 + 2 * izq];
+        return valor == UINT32_MAX ? -1 : (int)valor;
+    }
+    pos = (size_t)s * (size_t)saltos->num_vertices + (size_t)d;
+    if (saltos->bytes_entrada == 2)
+    {
+        valor = ((const uint16_t *)saltos->densa)[pos];
+        return valor == 0xFFFF ? -1 : (int)valor;
+    }
+    valor = ((const uint32_t *)saltos->densa)[pos];
+    return valor == UINT32_MAX ? -1 : (int)valor;
+}
+
+int ruta_por_saltos(const MATRIZ_SALTOS *saltos, int s, int d, int *camino, int max_camino)
+{
+    int u, len;
+
+    if (!saltos || !camino || max_camino <= 0 || siguiente_salto(saltos, s, d) < 0)
+        return 0;
+    u = s;
+    len = 0;
+    camino[len++] = u;
+    while (u != d)
+    {
+        u = siguiente_salto(saltos, u, d);
+        if (u < 0 || len == max_camino)
+            return 0;
+        camino[len++] = u;
+    }
+    return len;
+}
+
+int ruta_desde_archivo_saltos(const char *archivo, int s, int d, int *camino, int max_camino)
+{
+    int descriptor, u, len, n, bytes;
+    uint32_t cabecera[4], valor;
+    uint16_t corto;
+    off_t pos;
+
+    if (!archivo || !camino || max_camino <= 0)
+        return 0;
+    descriptor = open(archivo, O_RDONLY);
+    if (descriptor < 0)
+        return 0;
+    len = 0;
+    if (pread(descriptor, cabecera, sizeof(cabecera), 0) != (ssize_t)sizeof(cabecera) || cabecera[0] != SALTOS_FIRMA)
+    {
+        close(descriptor);
+        return 0;
+    }
+    n = (int)cabecera[1];
+    bytes = (int)cabecera[2];
+    if (s < 0 || d < 0 || s >= n || d >= n || (bytes != 2 && bytes != 4))
+    {
+        close(descriptor);
+        return 0;
+    }
+    u = s;
+    camino[len++] = u;
+    while (u != d)
+    {
+        pos = (off_t)sizeof(cabecera) + ((off_t)u * n + d) * bytes;
+        if (bytes == 2)
+        {
+            if (pread(descriptor, &corto, 2, pos) != 2)
+                break;
+            valor = corto == 0xFFFF ? UINT32_MAX : corto;
+        }
+        else if (pread(descriptor, &valor, 4, pos) != 4)
+        {
+            break;
+        }
+        if (valor == UINT32_MAX || valor >= (uint32_t)n || len == max_camino)
+            break;
+        u = (int)valor;
+        camino[len++] = u;
+    }
+    close(descriptor);
+    return u == d ? len : 0;
+}
+
+#endif
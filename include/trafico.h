@@ -0,0 +1,608 @@
+#ifndef TRAFICO_H
+#define TRAFICO_H
+
+#include <pthread.h>
+#include <unistd.h>
+#include "grafos.h"
+#include "dijkstra.h"
+
+#define MAX_HILOS_TRAFICO 8
+
+/*
+ * Matriz de demandas (origen, destino, Mbps) y motor de asignacion.
+ * Las demandas se agrupan por destino: un Dijkstra inverso desde t da la
+ * distancia de todos los origenes hacia t, y el reparto ECMP por salto (cada
+ * router divide a partes iguales entre sus siguientes saltos de coste minimo
+ * hacia t) solo esta definido por destino. Asi un arbol sirve a todas las
+ * demandas que llegan a t, y los destinos se reparten entre hilos, cada uno
+ * con su propio vector de carga que se suma al final.
+ */
+typedef struct MATRIZ_DEMANDAS
+{
+    int num;
+    int capacidad;
+    int *origen;
+    int *destino;
+    double *mbps;
+    /* agrupacion por destino (CSR), la rehace agrupar_demandas */
+    int num_vertices;
+    int *inicio; /* n + 1 */
+    int *orden;  /* indices de demanda ordenados por destino */
+} MATRIZ_DEMANDAS;
+
+typedef enum
+{
+    REPARTO_CAMINO_UNICO, /* todo por el arbol de caminos minimos */
+    REPARTO_ECMP          /* a partes iguales entre siguientes saltos de igual coste */
+} ModoReparto;
+
+/* Topologia activa en CSR directa e inversa, con el id de arista de cada arco */
+typedef struct RED_TRAFICO
+{
+    int num_vertices;
+    int num_arcos;
+    int *inicio;     /* arcos salientes de u */
+    int *destino;
+    int *arista;
+    int *inicio_inv; /* arcos entrantes de v */
+    int *origen_inv;
+    int *arista_inv;
+} RED_TRAFICO;
+
+typedef struct CARGA_ENLACES
+{
+    int num_aristas;         /* igual a grafo->aristas.num */
+    double *mbps;            /* carga por arista */
+    double enrutado;         /* Mbps con camino */
+    double sin_camino;       /* Mbps sin camino */
+    int demandas_sin_camino;
+} CARGA_ENLACES;
+
+void iniciar_demandas(MATRIZ_DEMANDAS *dem);
+void liberar_demandas(MATRIZ_DEMANDAS *dem);
+int agregar_demanda(MATRIZ_DEMANDAS *dem, int origen, int destino, double mbps);
+/* Formato: "origen destino mbps" por linea, '#' comenta; devuelve -1 si no se abre el archivo */
+int cargar_demandas(GRAFO *grafo, const char *archivo, MATRIZ_DEMANDAS *dem, int *descartadas);
+int agrupar_demandas(MATRIZ_DEMANDAS *dem, int num_vertices);
+
+int construir_red_trafico(GRAFO *grafo, RED_TRAFICO *red);
+void liberar_red_trafico(RED_TRAFICO *red);
+/* Dijkstra inverso hacia t con coste por arista; arco_siguiente[u] = arista hacia el siguiente salto */
+int distancias_hacia(const RED_TRAFICO *red, const double *coste, int t, MONTICULO *m, double *distancia, int *arco_siguiente);
+
+/* coste = NULL usa latencia_ms; hilos <= 0 usa los procesadores disponibles */
+int enrutar_demandas(GRAFO *grafo, const RED_TRAFICO *red, MATRIZ_DEMANDAS *dem, const double *coste, ModoReparto modo, int hilos, CARGA_ENLACES *carga);
+void liberar_carga_enlaces(CARGA_ENLACES *carga);
+/* Las top aristas de mayor utilizacion (carga / ancho de banda), de mayor a menor; devuelve cuantas */
+int enlaces_mas_cargados(GRAFO *grafo, const CARGA_ENLACES *carga, int *aristas, int top);
+
+// Implementaciones
+
+void iniciar_demandas(MATRIZ_DEMANDAS *dem)
+{
+    memset(dem, 0, sizeof(*dem));
+}
+
+void liberar_demandas(MATRIZ_DEMANDAS *dem)
+{
+    if (!dem)
+        return;
+    free(dem->origen);
+    free(dem->destino);
+    free(dem->mbps);
+    free(dem->inicio);
+    free(dem->orden);
+    memset(dem, 0, sizeof(*dem));
+}
+
+int agregar_demanda(MATRIZ_DEMANDAS *dem, int origen, int destino, double mbps)
+{
+    int nueva, *to, *td;
+    double *tm;
+
+    if (dem->num == dem->capacidad)
+    {
+        nueva = dem->capacidad ? dem->capacidad * 2 : 64;
+        to = realloc(dem->origen, sizeof(int) * nueva);
+        if (!to)
+            return -1;
+        dem->origen = to;
+        td = realloc(dem->destino, sizeof(int) * nueva);
+        if (!td)
+            return -1;
+        dem->destino = td;
+        tm = realloc(dem->mbps, sizeof(double) * nueva);
+        if (!tm)
+            return -1;
+        dem->mbps = tm;
+        dem->capacidad = nueva;
+    }
+    dem->origen[dem->num] = origen;
+    dem->destino[dem->num] = destino;
+    dem->mbps[dem->num] = mbps;
+    dem->num++;
+    /* la agrupacion queda obsoleta */
+    dem->num_vertices = 0;
+    return 0;
+}
+
+int cargar_demandas(GRAFO *grafo, const char *archivo, MATRIZ_DEMANDAS *dem, int *descartadas)
+{
+    FILE *f;
+    char linea[MAX_LINEA], *o, *d, *m, *fin;
+    int io, id, malas;
+    double mbps;
+
+    f = fopen(archivo, "r");
+    if (!f)
+        return -1;
+    malas = 0;
+    while (fgets(linea, sizeof(linea), f))
+    {
+        o = strtok(linea, " \t\r\n");
+        if (!o || o[0] == '#')
+            continue;
+        d = strtok(NULL, " \t\r\n");
+        m = strtok(NULL, " \t\r\n");
+        if (!d || !m)
+        {
+            malas++;
+            continue;
+        }
+        io = indice_por_nombre(grafo, o);
+        id = indice_por_nombre(grafo, d);
+        mbps = strtod(m, &fin);
+        if (io == -1 || id == -1 || io == id || fin == m || mbps <= 0.0)
+        {
+            malas++;
+            continue;
+        }
+        if (agregar_demanda(dem, io, id, mbps) != 0)
+        {
+            fclose(f);
+            return -1;
+        }
+    }
+    fclose(f);
+    if (descartadas)
+        *descartadas = malas;
+    return 0;
+}
+
+int agrupar_demandas(MATRIZ_DEMANDAS *dem, int num_vertices)
+{
+    int i, v, *pos;
+
+    free(dem->inicio);
+    free(dem->orden);
+    dem->inicio = calloc(num_vertices + 1, sizeof(int));
+    dem->orden = malloc(sizeof(int) * (dem->num + 1));
+    pos = malloc(sizeof(int) * (num_vertices + 1));
+    if (!dem->inicio || !dem->orden || !pos)
+    {
+        free(pos);
+        free(dem->inicio);
+        free(dem->orden);
+        dem->inicio = NULL;
+        dem->orden = NULL;
+        dem->num_vertices = 0;
+        return -1;
+    }
+    for (i = 0; i < dem->num; ++i)
+        dem->inicio[dem->destino[i] + 1]++;
+    for (v = 0; v < num_vertices; ++v)
+        dem->inicio[v + 1] += dem->inicio[v];
+    memcpy(pos, dem->inicio, sizeof(int) * (num_vertices + 1));
+    for (i = 0; i < dem->num; ++i)
+        dem->orden[pos[dem->destino[i]]++] = i;
+    dem->num_vertices = num_vertices;
+    free(pos);
+    return 0;
+}
+
+int construir_red_trafico(GRAFO *grafo, RED_TRAFICO *red)
+{
+    int n, m, u, v, e, *pos;
+
+    if (!grafo || !red)
+        return -1;
+    memset(red, 0, sizeof(*red));
+    n = grafo->num_vertices;
+    red->num_vertices = n;
+    red->inicio = calloc(n + 1, sizeof(int));
+    red->inicio_inv = calloc(n + 1, sizeof(int));
+    pos = malloc(sizeof(int) * (n + 1));
+    if (!red->inicio || !red->inicio_inv || !pos)
+    {
+        free(pos);
+        liberar_red_trafico(red);
+        return -1;
+    }
+    m = 0;
+    for (e = 0; e < grafo->aristas.num; ++e)
+    {
+        v = grafo->aristas.destino[e];
+        if (v < 0 || !ARISTA_ACTIVA(grafo, e))
+            continue;
+        u = grafo->aristas.origen[e];
+        if (!grafo->vertices[u].activo || !grafo->vertices[v].activo)
+            continue;
+        red->inicio[u + 1]++;
+        red->inicio_inv[v + 1]++;
+        m++;
+    }
+    for (u = 0; u < n; ++u)
+    {
+        red->inicio[u + 1] += red->inicio[u];
+        red->inicio_inv[u + 1] += red->inicio_inv[u];
+    }
+    red->num_arcos = m;
+    red->destino = malloc(sizeof(int) * (m + 1));
+    red->arista = malloc(sizeof(int) * (m + 1));
+    red->origen_inv = malloc(sizeof(int) * (m + 1));
+    red->arista_inv = malloc(sizeof(int) * (m + 1));
+    if (!red->destino || !red->arista || !red->origen_inv || !red->arista_inv)
+    {
+        free(pos);
+        liberar_red_trafico(red);
+        return -1;
+    }
+    memcpy(pos, red->inicio, sizeof(int) * (n + 1));
+    for (e = 0; e < grafo->aristas.num; ++e)
+    {
+        v = grafo->aristas.destino[e];
+        if (v < 0 || !ARISTA_ACTIVA(grafo, e))
+            continue;
+        u = grafo->aristas.origen[e];
+        if (!grafo->vertices[u].activo || !grafo->vertices[v].activo)
+            continue;
+        red->destino[pos[u]] = v;
+        red->arista[pos[u]++] = e;
+    }
+    memcpy(pos, red->inicio_inv, sizeof(int) * (n + 1));
+    for (e = 0; e < grafo->aristas.num; ++e)
+    {
+        v = grafo->aristas.destino[e];
+        if (v < 0 || !ARISTA_ACTIVA(grafo, e))
+            continue;
+        u = grafo->aristas.origen[e];
+        if (!grafo->vertices[u].activo || !grafo->vertices[v].activo)
+            continue;
+        red->origen_inv[pos[v]] = u;
+        red->arista_inv[pos[v]++] = e;
+    }
+    free(pos);
+    return 0;
+}
+
+void liberar_red_trafico(RED_TRAFICO *red)
+{
+    if (!red)
+        return;
+    free(red->inicio);
+    free(red->destino);
+    free(red->arista);
+    free(red->inicio_inv);
+    free(red->origen_inv);
+    free(red->arista_inv);
+    memset(red, 0, sizeof(*red));
+}
+
+int distancias_hacia(const RED_TRAFICO *red, const double *coste, int t, MONTICULO *m, double *distancia, int *arco_siguiente)
+{
+    int i, u, v, e;
+    double d, nd;
+
+    for (i = 0; i < red->num_vertices; ++i)
+    {
+        distancia[i] = DBL_MAX;
+        arco_siguiente[i] = -1;
+    }
+    m->tam = 0;
+    distancia[t] = 0.0;
+    monticulo_insertar(m, 0.0, t);
+    while (monticulo_extraer(m, &d, &v) == 0)
+    {
+        if (d > distancia[v])
+            continue;
+        for (i = red->inicio_inv[v]; i < red->inicio_inv[v + 1]; ++i)
+        {
+            u = red->origen_inv[i];
+            e = red->arista_inv[i];
+            nd = d + coste[e];
+            if (nd < distancia[u])
+            {
+                distancia[u] = nd;
+                arco_siguiente[u] = e;
+                monticulo_insertar(m, nd, u);
+            }
+        }
+    }
+    return 0;
+}
+
+/* Estado de un hilo: buffers propios y su parte de la carga */
+typedef struct TRABAJO_TRAFICO
+{
+    GRAFO *grafo;
+    const RED_TRAFICO *red;
+    const MATRIZ_DEMANDAS *dem;
+    const double *coste;
+    ModoReparto modo;
+    int primero, paso; /* destinos primero, primero + paso, ... */
+    double *carga;
+    double enrutado, sin_camino;
+    int demandas_sin_camino;
+    int error;
+} TRABAJO_TRAFICO;
+
+/* Arco usable por el reparto: el del arbol, o (ECMP) cualquiera sobre un camino minimo */
+#define ARCO_AJUSTADO(dist, coste, u, v, e, sig) \
+    ((e) == (sig) || ((coste)[e] > 1e-9 * (1.0 + (dist)[u]) && (coste)[e] + (dist)[v] <= (dist)[u] + 1e-9 * (1.0 + (dist)[u])))
+
+static void *resolver_trabajo_trafico(void *arg)
+{
+    TRABAJO_TRAFICO *tr = arg;
+    const RED_TRAFICO *red = tr->red;
+    const MATRIZ_DEMANDAS *dem = tr->dem;
+    const double *coste = tr->coste;
+    int n, t, i, k, u, v, e, a, cab, fin, salidas, *sig, *grado, *cola;
+    double *dist, *flujo, parte;
+    MONTICULO m;
+
+    n = red->num_vertices;
+    dist = malloc(sizeof(double) * n);
+    flujo = calloc(n, sizeof(double));
+    sig = malloc(sizeof(int) * n);
+    grado = calloc(n, sizeof(int));
+    cola = malloc(sizeof(int) * n);
+    if (!dist || !flujo || !sig || !grado || !cola || monticulo_iniciar(&m, red->num_arcos + 1) != 0)
+    {
+        free(dist);
+        free(flujo);
+        free(sig);
+        free(grado);
+        free(cola);
+        tr->error = 1;
+        return NULL;
+    }
+
+    for (t = tr->primero; t < n; t += tr->paso)
+    {
+        if (dem->inicio[t] == dem->inicio[t + 1])
+            continue;
+        distancias_hacia(red, coste, t, &m, dist, sig);
+
+        /* demanda que nace en cada origen; la que no tiene camino se descuenta */
+        salidas = 0;
+        for (k = dem->inicio[t]; k < dem->inicio[t + 1]; ++k)
+        {
+            i = dem->orden[k];
+            u = dem->origen[i];
+            if (dist[u] >= DBL_MAX / 2 || !tr->grafo->vertices[t].activo)
+            {
+                tr->sin_camino += dem->mbps[i];
+                tr->demandas_sin_camino++;
+                continue;
+            }
+            flujo[u] += dem->mbps[i];
+            tr->enrutado += dem->mbps[i];
+            salidas++;
+        }
+        if (salidas == 0)
+            continue;
+
+        /* grados de entrada del DAG de reparto (solo vertices alcanzables) */
+        for (u = 0; u < n; ++u)
+        {
+            if (dist[u] >= DBL_MAX / 2 || u == t)
+                continue;
+            for (a = red->inicio[u]; a < red->inicio[u + 1]; ++a)
+            {
+                e = red->arista[a];
+                v = red->destino[a];
+                if (tr->modo == REPARTO_CAMINO_UNICO ? e == sig[u] : ARCO_AJUSTADO(dist, coste, u, v, e, sig[u]))
+                    grado[v]++;
+            }
+        }
+        /* Kahn: se parte de todos los vertices sin entradas, tengan demanda o no */
+        fin = 0;
+        for (u = 0; u < n; ++u)
+            if (dist[u] < DBL_MAX / 2 && grado[u] == 0)
+                cola[fin++] = u;
+        for (cab = 0; cab < fin; ++cab)
+        {
+            u = cola[cab];
+            if (u == t)
+                continue;
+            salidas = 0;
+            if (tr->modo == REPARTO_ECMP)
+            {
+                for (a = red->inicio[u]; a < red->inicio[u + 1]; ++a)
+                    if (ARCO_AJUSTADO(dist, coste, u, red->destino[a], red->arista[a], sig[u]))
+                        salidas++;
+            }
+            else
+            {
+                salidas = 1;
+            }
+            parte = flujo[u] / salidas;
+            for (a = red->inicio[u]; a < red->inicio[u + 1]; ++a)
+            {
+                e = red->arista[a];
+                v = red->destino[a];
+                if (tr->modo == REPARTO_CAMINO_UNICO ? e != sig[u] : !ARCO_AJUSTADO(dist, coste, u, v, e, sig[u]))
+                    continue;
+                tr->carga[e] += parte;
+                flujo[v] += parte;
+                if (--grado[v] == 0)
+                    cola[fin++] = v;
+            }
+            flujo[u] = 0.0;
+        }
+        flujo[t] = 0.0;
+    }
+
+    monticulo_liberar(&m);
+    free(dist);
+    free(flujo);
+    free(sig);
+    free(grado);
+    free(cola);
+    return NULL;
+}
+
+int enrutar_demandas(GRAFO *grafo, const RED_TRAFICO *red, MATRIZ_DEMANDAS *dem, const double *coste, ModoReparto modo, int hilos, CARGA_ENLACES *carga)
+{
+    int h, e, num_aristas, destinos, v;
+    long procesadores;
+    double *latencia;
+    TRABAJO_TRAFICO *tr;
+    pthread_t *hilo;
+    unsigned char *lanzado;
+
+    if (!grafo || !red || !dem || !carga)
+        return -1;
+    memset(carga, 0, sizeof(*carga));
+    num_aristas = grafo->aristas.num;
+    carga->num_aristas = num_aristas;
+    carga->mbps = calloc(num_aristas + 1, sizeof(double));
+    if (!carga->mbps)
+        return -1;
+    if (dem->num_vertices != grafo->num_vertices && agrupar_demandas(dem, grafo->num_vertices) != 0)
+    {
+        liberar_carga_enlaces(carga);
+        return -1;
+    }
+
+    latencia = NULL;
+    if (!coste)
+    {
+        latencia = malloc(sizeof(double) * (num_aristas + 1));
+        if (!latencia)
+        {
+            liberar_carga_enlaces(carga);
+            return -1;
+        }
+        for (e = 0; e < num_aristas; ++e)
+            latencia[e] = (double)grafo->aristas.latencia_ms[e];
+        coste = latencia;
+    }
+
+    destinos = 0;
+    for (v = 0; v < grafo->num_vertices; ++v)
+        if (dem->inicio[v] != dem->inicio[v + 1])
+            destinos++;
+    if (hilos <= 0)
+    {
+        procesadores = sysconf(_SC_NPROCESSORS_ONLN);
+        hilos = procesadores > 0 ? (int)procesadores : 1;
+    }
+    if (hilos > MAX_HILOS_TRAFICO)
+        hilos = MAX_HILOS_TRAFICO;
+    if (hilos > destinos)
+        hilos = destinos > 0 ? destinos : 1;
+
+    tr = calloc(hilos, sizeof(TRABAJO_TRAFICO));
+    hilo = malloc(sizeof(pthread_t) * hilos);
+    lanzado = calloc(hilos, 1);
+    if (!tr || !hilo || !lanzado)
+    {
+        free(tr);
+        free(hilo);
+        free(lanzado);
+        free(latencia);
+        liberar_carga_enlaces(carga);
+        return -1;
+    }
+    for (h = 0; h < hilos; ++h)
+    {
+        tr[h].grafo = grafo;
+        tr[h].red = red;
+        tr[h].dem = dem;
+        tr[h].coste = coste;
+        tr[h].modo = modo;
+        tr[h].primero = h;
+        tr[h].paso = hilos;
+        /* el hilo 0 escribe directamente en el resultado */
+        tr[h].carga = h == 0 ? carga->mbps : calloc(num_aristas + 1, sizeof(double));
+        if (!tr[h].carga)
+            tr[h].error = 1;
+    }
+    for (h = 1; h < hilos; ++h)
+        if (!tr[h].error)
+            lanzado[h] = pthread_create(&hilo[h], NULL, resolver_trabajo_trafico, &tr[h]) == 0;
+    resolver_trabajo_trafico(&tr[0]);
+    for (h = 1; h < hilos; ++h)
+    {
+        if (lanzado[h])
+            pthread_join(hilo[h], NULL);
+        else if (!tr[h].error)
+            resolver_trabajo_trafico(&tr[h]);
+    }
+
+    for (h = 0; h < hilos; ++h)
+    {
+        if (tr[h].error)
+            carga->demandas_sin_camino = -1;
+        if (h > 0 && tr[h].carga)
+        {
+            for (e = 0; e < num_aristas; ++e)
+                carga->mbps[e] += tr[h].carga[e];
+            free(tr[h].carga);
+        }
+        carga->enrutado += tr[h].enrutado;
+        carga->sin_camino += tr[h].sin_camino;
+        if (carga->demandas_sin_camino >= 0)
+            carga->demandas_sin_camino += tr[h].demandas_sin_camino;
+    }
+    free(tr);
+    free(hilo);
+    free(lanzado);
+    free(latencia);
+    if (carga->demandas_sin_camino < 0)
+    {
+        liberar_carga_enlaces(carga);
+        return -1;
+    }
+    return 0;
+}
+
+void liberar_carga_enlaces(CARGA_ENLACES *carga)
+{
+    if (!carga)
+        return;
+    free(carga->mbps);
+    memset(carga, 0, sizeof(*carga));
+}
+
+static double utilizacion_enlace(GRAFO *grafo, const CARGA_ENLACES *carga, int e)
+{
+    if (grafo->aristas.ancho_banda_mbps[e] <= 0)
+        return carga->mbps[e] > 0.0 ? DBL_MAX : 0.0;
+    return carga->mbps[e] / grafo->aristas.ancho_banda_mbps[e];
+}
+
+int enlaces_mas_cargados(GRAFO *grafo, const CARGA_ENLACES *carga, int *aristas, int top)
+{
+    int e, p, usados;
+    double u;
+
+    usados = 0;
+    for (e = 0; e < carga->num_aristas; ++e)
+    {
+        if (carga->mbps[e] <= 0.0)
+            continue;
+        u = utilizacion_enlace(grafo, carga, e);
+        if (usados == top && u <= utilizacion_enlace(grafo, carga, aristas[top - 1]))
+            continue;
+        if (usados < top)
+            usados++;
+        for (p = usados - 1; p > 0 && u > utilizacion_enlace(grafo, carga, aristas[p - 1]); --p)
+            aristas[p] = aristas[p - 1];
+        aristas[p] = e;
+    }
+    return usados;
+}
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef VISOR_H
+#define VISOR_H
+
+#include "grafos.h"
+#include "disposicion.h"
+#include <unistd.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/*
+ * Canal de cambios hacia el visualizador (src/verGrafoL.py --stdin).
+ * La CLI lanza el visor con una tuberia en su entrada estandar y le manda
+ * lineas de texto cortas en lugar de obligarle a releer txt/topologia.txt:
+ *   R                                        reinicio: se descarta todo
+ *   N <nombre> <ip> <tipo> <cap> <activo>    vertice nuevo
+ *   A <id> <origen> <destino> <lat> <bw> <fiab> <activo>   arista nueva
+ *   E <id> <activo>                          cambio de estado de una arista
+ *   V <nombre> <activo>                      cambio de estado de un vertice
+ *   P <nombre> <x> <y>                       posicion calculada (disposicion.h)
+ *   F                                        fin de lote: el visor redibuja
+ * Los ids de arista son los del grafo. Si el visor se cierra, la primera
+ * escritura fallida cierra el canal y la CLI sigue sin el.
+ */
+typedef struct CANAL_VISOR
+{
+    pid_t pid;
+    FILE *f; /* NULL si no hay visor */
+} CANAL_VISOR;
+
+void iniciar_canal_visor(CANAL_VISOR *canal);
+/* Lanza el visor y le manda la topologia completa */
+int abrir_visor(CANAL_VISOR *canal, GRAFO *grafo, const char *script);
+void cerrar_visor(CANAL_VISOR *canal);
+int visor_activo(CANAL_VISOR *canal);
+void visor_vertice(CANAL_VISOR *canal, GRAFO *grafo, int indice);
+void visor_arista(CANAL_VISOR *canal, GRAFO *grafo, int arista);
+void visor_estado_arista(CANAL_VISOR *canal, GRAFO *grafo, int arista);
+void visor_estado_vertice(CANAL_VISOR *canal, GRAFO *grafo, int indice);
+/* Posiciones de los vertices que movio el ultimo calculo, o de todos */
+void visor_posiciones(CANAL_VISOR *canal, GRAFO *grafo, const DISPOSICION *disp, int todos);
+/* Manda R y la topologia entera (tras cargar otro grafo) */
+void visor_reiniciar(CANAL_VISOR *canal, GRAFO *grafo);
+/* Cierra el lote en curso y lo empuja por la tuberia */
+void visor_fin_lote(CANAL_VISOR *canal);
+
+// Implementaciones
+
+void iniciar_canal_visor(CANAL_VISOR *canal)
+{
+    canal->pid = -1;
+    canal->f = NULL;
+}
+
+/* Un visor que ya termino (ventana cerrada) deja de recibir cambios */
+int visor_activo(CANAL_VISOR *canal)
+{
+    if (!canal->f)
+        return 0;
+    if (ferror(canal->f) || waitpid(canal->pid, NULL, WNOHANG) == canal->pid)
+    {
+        fclose(canal->f);
+        canal->f = NULL;
+        canal->pid = -1;
+        return 0;
+    }
+    return 1;
+}
+
+void visor_vertice(CANAL_VISOR *canal, GRAFO *grafo, int indice)
+{
+    char ip[MAX_IP];
+
+    if (!canal->f)
+        return;
+    fprintf(canal->f, "N %s %s %d %d %d\n", grafo->datos[indice].nombre, ip_a_cadena(grafo->datos[indice].ip, ip),
+            (int)grafo->vertices[indice].tipo, grafo->datos[indice].capacidad_procesamiento, (int)grafo->vertices[indice].activo);
+}
+
+void visor_arista(CANAL_VISOR *canal, GRAFO *grafo, int arista)
+{
+    ARISTAS *a = &grafo->aristas;
+
+    if (!canal->f)
+        return;
+    fprintf(canal->f, "A %d %s %s %d %d %.6f %d\n", arista, grafo->datos[a->origen[arista]].nombre, grafo->datos[a->destino[arista]].nombre,
+            a->latencia_ms[arista], a->ancho_banda_mbps[arista], (double)a->fiabilidad[arista], ARISTA_ACTIVA(grafo, arista) ? 1 : 0);
+}
+
+void visor_estado_arista(CANAL_VISOR *canal, GRAFO *grafo, int arista)
+{
+    if (!canal->f || arista < 0)
+        return;
+    fprintf(canal->f, "E %d %d\n", arista, ARISTA_ACTIVA(grafo, arista) ? 1 : 0);
+}
+
+void visor_estado_vertice(CANAL_VISOR *canal, GRAFO *grafo, int indice)
+{
+    if (!canal->f || indice < 0)
+        return;
+    fprintf(canal->f, "V %s %d\n", grafo->datos[indice].nombre, (int)grafo->vertices[indice].activo);
+}
+
+void visor_posiciones(CANAL_VISOR *canal, GRAFO *grafo, const DISPOSICION *disp, int todos)
+{
+    int i, v, num;
+
+    if (!canal->f)
+        return;
+    num = todos ? disp->num_vertices : disp->num_movidos;
+    for (i = 0; i < num; ++i)
+    {
+        v = todos ? i : disp->movidos[i];
+        if (v < grafo->num_vertices)
+            fprintf(canal->f, "P %s %.3f %.3f\n", grafo->datos[v].nombre, disp->x[v], disp->y[v]);
+    }
+}
+
+void visor_reiniciar(CANAL_VISOR *canal, GRAFO *grafo)
+{
+    int i, e;
+
+    if (!visor_activo(canal))
+        return;
+    fputs("R\n", canal->f);
+    for (i = 0; i < grafo->num_vertices; ++i)
+        visor_vertice(canal, grafo, i);
+    for (i = 0; i < grafo->num_vertices; ++i)
+        for (e = grafo->vertices[i].primera_arista; e != -1; e = grafo->aristas.siguiente[e])
+            visor_arista(canal, grafo, e);
+    visor_fin_lote(canal);
+}
+
+void visor_fin_lote(CANAL_VISOR *canal)
+{
+    if (!canal->f)
+        return;
+    fputs("F\n", canal->f);
+    if (fflush(canal->f) != 0)
+        visor_activo(canal);
+}
+
+int abrir_visor(CANAL_VISOR *canal, GRAFO *grafo, const char *script)
+{
+    int tubo[2];
+    pid_t pid;
+
+    if (visor_activo(canal))
+        return 0;
+    if (pipe(tubo) != 0)
+        return -1;
+    pid = fork();
+    if (pid < 0)
+    {
+        close(tubo[0]);
+        close(tubo[1]);
+        return -1;
+    }
+    if (pid == 0)
+    {
+        dup2(tubo[0], STDIN_FILENO);
+        close(tubo[0]);
+        close(tubo[1]);
+        execlp("python3", "python3", script, "--stdin", (char *)NULL);
+        _exit(127);
+    }
+    close(tubo[0]);
+    canal->f = fdopen(tubo[1], "w");
+    if (!canal->f)
+    {
+        close(tubo[1]);
+        kill(pid, SIGTERM);
+        waitpid(pid, NULL, 0);
+        return -1;
+    }
+    /* escribir en una tuberia sin lector no debe matar a la CLI: el error llega por ferror */
+    signal(SIGPIPE, SIG_IGN);
+    canal->pid = pid;
+    visor_reiniciar(canal, grafo);
+    return 0;
+}
+
+void cerrar_visor(CANAL_VISOR *canal)
+{
+    if (canal->f)
+    {
+        fclose(canal->f);
+        canal->f = NULL;
+    }
+    if (canal->pid > 0)
+    {
+        /* al cerrar la tuberia el visor ve fin de entrada; SIGTERM por si esta bloqueado en la ventana */
+        kill(canal->pid, SIGTERM);
+        waitpid(canal->pid, NULL, 0);
+        canal->pid = -1;
+    }
+}
+
+#endif
@@ -6,6 +6,25 @@
 #include <math.h>
 #include "grafos.h"
 #include "dijkstra.h"
+#include "optimizacion.h"
+#include "biconexion.h"
+#include "flujo.h"
+#include "conectividad.h"
+#include "trafico.h"
+#include "equilibrio.h"
+#include "ecmp.h"
+#include "fib.h"
+#include "todos_pares.h"
+#include "simulador.h"
+#include "disposicion.h"
+#include "generador.h"
+#include "resiliencia.h"
+#include "escenario.h"
+#include "srlg.h"
+#include "centralidad.h"
+#include "alcance.h"
+#include "bfs.h"
+#include "visor.h"
 #include "colors.h"
 
 #ifdef _WIN32
@@ -20,30 +39,74 @@
 #endif
 
 /* Declaraciones de funciones auxiliares */
-double costo_por_latencia(const ARISTA *);
+double costo_por_latencia(const GRAFO *, int);
 void imprimir_ayuda();
 void imprimir_camino_por_indices(GRAFO *, const int *, int);
-void resolver_ping(GRAFO *, const char *, const char *, int);
-void comando_traceroute(GRAFO *, const char *, const char *, int);
-int contar_alcanzables(GRAFO *, int);
-void comando_analizar_resiliencia(GRAFO *);
-void comando_optimizar_ruta(GRAFO *, const char *, const char *);
-
-int main(void)
+void resolver_ping(GRAFO *, INDICE_ALCANCE *, const char *, const char *, int);
+void comando_traceroute(GRAFO *, const char *, const char *, int, int);
+void resolver_ping_simulado(GRAFO *, const MATRIZ_DEMANDAS *, const char *, const char *, int);
+void comando_traceroute_simulado(GRAFO *, const MATRIZ_DEMANDAS *, const char *, const char *);
+void comando_simular(GRAFO *, const MATRIZ_DEMANDAS *, double, int, int);
+void comando_analizar_resiliencia(GRAFO *, INDICE_ALCANCE *, MOTOR_BFS *);
+void imprimir_componentes_fuertes(GRAFO *, INDICE_ALCANCE *);
+void imprimir_plan_redundancia(GRAFO *, ModoBiconexion);
+void imprimir_tolerancia_enlaces(GRAFO *);
+void comando_optimizar_ruta(GRAFO *, const char *, const char *, int, int);
+void comando_latencia_hacia(GRAFO *, const char *);
+void comando_capacidad(GRAFO *, const char *, const char *);
+void comando_utilizacion(GRAFO *, MATRIZ_DEMANDAS *, ModoReparto, int);
+void comando_equilibrio(GRAFO *, MATRIZ_DEMANDAS *, int, double);
+void comando_ecmp(GRAFO *, const char *, const char *, int);
+void comando_reenviar(GRAFO *, TABLAS_REENVIO *, const char *, const char *);
+void comando_benchmark_fib(GRAFO *, int);
+void comando_todos_pares(GRAFO *, MATRIZ_SALTOS *, int, int, const char *);
+void comando_ruta_precalculada(GRAFO *, const MATRIZ_SALTOS *, const char *, const char *, const char *);
+void comando_disposicion(GRAFO *, DISPOSICION *, CANAL_VISOR *, int, int, const char *);
+GRAFO *comando_generar_topologia(int, char **);
+void comando_estadisticas(const char *, const char *, const char *);
+void comando_escenario(GRAFO *, CANAL_VISOR *, const char *, double, int);
+void comando_asignar_srlg(GRAFO *, const char *, const char *, const char *, int);
+void comando_analizar_srlg(GRAFO *, const MATRIZ_DEMANDAS *, int);
+void comando_centralidad(GRAFO *, int, int, int, uint64_t);
+void comando_saltos(GRAFO *, MOTOR_BFS *, const char *, int);
+
+int main(int argc, char **argv)
 {
     srand((unsigned)time(NULL));
     GRAFO *grafo;
     bool ejecutar_cli;
-    char linea[512], *token, *archivo_nombre, *nombre, *ip_cadena, *tipo_str, *cap_str, *origen_str, *destino_str, *lat_str, *bw_str, *fi_str, *ct_str, *ks_str;
+    GRAFO *cargado;
+    char linea[512], *argumentos[12], *token, *archivo_nombre, *nombre, *ip_cadena, *tipo_str, *cap_str, *origen_str, *destino_str, *lat_str, *bw_str, *fi_str, *ct_str, *ks_str;
     int indice, indice_origen, indice_destino, contador, k;
     Tipo_Dispositivo tipo_disp;
-    pid_t pidPython = -1, pid;
+    MATRIZ_DEMANDAS demandas;
+    MATRIZ_SALTOS saltos;
+    CANAL_VISOR visor;
+    DISPOSICION disposicion;
+    INDICE_ALCANCE alcance;
+    MOTOR_BFS bfs;
+    TABLAS_REENVIO tablas_reenvio;
 
     const char *archivo_default = "txt/topologia.txt";
 
+    /* modo sin CLI: ./main generar-topologia <tipo> <tamano> ... */
+    if (argc > 1 && strcmp(argv[1], "generar-topologia") == 0)
+    {
+        cargado = comando_generar_topologia(argc - 2, argv + 2);
+        liberar_grafo(cargado);
+        return cargado ? 0 : 1;
+    }
+
     LIMPIAR;
 
     grafo = crear_grafo(20);
+    iniciar_demandas(&demandas);
+    memset(&saltos, 0, sizeof(saltos));
+    memset(&alcance, 0, sizeof(alcance));
+    memset(&tablas_reenvio, 0, sizeof(tablas_reenvio));
+    iniciar_motor_bfs(&bfs, 0);
+    iniciar_canal_visor(&visor);
+    iniciar_disposicion(&disposicion);
 
     if (!grafo)
     {
@@ -65,6 +128,8 @@ int main(void)
 
     while (ejecutar_cli)
     {
+        /* cierra la medicion del comando anterior (todos terminan con continue) */
+        INSTR_FIN_COMANDO();
 
         printf(COLOR_CIANO "net> " COLOR_NORMAL);
 
@@ -79,6 +144,7 @@ int main(void)
         {
             continue;
         }
+        INSTR_INICIO_COMANDO(token);
 
         if (strcmp(token, "salir") == 0)
         {
@@ -129,6 +195,8 @@ int main(void)
             if (cargar_grafo(grafo, archivo_nombre) == 0)
             {
                 printf("[OK] Cargado %s\n", archivo_nombre);
+                liberar_disposicion(&disposicion);
+                visor_reiniciar(&visor, grafo);
             }
             else
             {
@@ -138,6 +206,76 @@ int main(void)
             continue;
         }
 
+        if (strcmp(token, "guardar-instantanea") == 0)
+        {
+            archivo_nombre = strtok(NULL, " \n");
+            if (!archivo_nombre)
+            {
+                printf("[ERROR] Uso: guardar-instantanea <nombre_archivo>\n");
+                continue;
+            }
+            if (guardar_instantanea(grafo, archivo_nombre) == 0)
+            {
+                printf("[OK] Instantanea guardada en %s\n", archivo_nombre);
+            }
+            else
+            {
+                printf("[ERROR] Fallo guardar instantanea.\n");
+            }
+            continue;
+        }
+
+        if (strcmp(token, "cargar-instantanea") == 0)
+        {
+            archivo_nombre = strtok(NULL, " \n");
+            if (!archivo_nombre)
+            {
+                printf("[ERROR] Uso: cargar-instantanea <nombre_archivo>\n");
+                continue;
+            }
+            cargado = cargar_instantanea(archivo_nombre);
+            if (cargado)
+            {
+                liberar_grafo(grafo);
+                grafo = cargado;
+                /* las demandas guardan indices del grafo anterior */
+                liberar_demandas(&demandas);
+                liberar_matriz_saltos(&saltos);
+                liberar_disposicion(&disposicion);
+                liberar_indice_alcance(&alcance);
+                liberar_motor_bfs(&bfs);
+                liberar_tablas_reenvio(&tablas_reenvio);
+                visor_reiniciar(&visor, grafo);
+                printf("[OK] Instantanea cargada desde %s (%d vertices)\n", archivo_nombre, grafo->num_vertices);
+            }
+            else
+            {
+                printf("[ERROR] Fallo cargar instantanea %s\n", archivo_nombre);
+            }
+            continue;
+        }
+
+        if (strcmp(token, "generar-topologia") == 0)
+        {
+            contador = 0;
+            while (contador < 12 && (argumentos[contador] = strtok(NULL, " \n")) != NULL)
+                contador++;
+            cargado = comando_generar_topologia(contador, argumentos);
+            if (cargado)
+            {
+                liberar_grafo(grafo);
+                grafo = cargado;
+                liberar_demandas(&demandas);
+                liberar_matriz_saltos(&saltos);
+                liberar_disposicion(&disposicion);
+                liberar_indice_alcance(&alcance);
+                liberar_motor_bfs(&bfs);
+                liberar_tablas_reenvio(&tablas_reenvio);
+                visor_reiniciar(&visor, grafo);
+            }
+            continue;
+        }
+
         if (strcmp(token, "nuevo-disp") == 0)
         {
             nombre = strtok(NULL, " \n");
@@ -175,6 +313,11 @@ int main(void)
             if (indice != -1)
             {
                 printf("[OK] Dispositivo agregado: %s\n", nombre);
+                visor_vertice(&visor, grafo, indice);
+                /* con una disposicion calculada, el nuevo se coloca sin mover el resto */
+                if (disposicion.num_vertices > 0 && calcular_disposicion(grafo, &disposicion, 0, 0) == 0)
+                    visor_posiciones(&visor, grafo, &disposicion, 0);
+                visor_fin_lote(&visor);
             }
             else
             {
@@ -212,6 +355,15 @@ int main(void)
             if (agregar_arista(grafo, indice_origen, indice_destino, atoi(lat_str), atoi(bw_str), atof(fi_str), 1) == 0)
             {
                 printf("[OK] Conexion agregada: %s -> %s\n", origen_str, destino_str);
+                visor_arista(&visor, grafo, buscar_arista(grafo, indice_origen, indice_destino));
+                if (disposicion.num_vertices > 0)
+                {
+                    marcar_disposicion(&disposicion, indice_origen);
+                    marcar_disposicion(&disposicion, indice_destino);
+                    if (calcular_disposicion(grafo, &disposicion, 0, 0) == 0)
+                        visor_posiciones(&visor, grafo, &disposicion, 0);
+                }
+                visor_fin_lote(&visor);
             }
             else
             {
@@ -228,19 +380,32 @@ int main(void)
             origen_str = strtok(NULL, " \n");
             destino_str = strtok(NULL, " \n");
             ct_str = strtok(NULL, " \n");
+            tipo_str = NULL;
             contador = 4;
 
+            if (ct_str && strcmp(ct_str, "sim") == 0)
+            {
+                tipo_str = ct_str;
+                ct_str = NULL;
+            }
+            else
+            {
+                tipo_str = strtok(NULL, " \n");
+            }
             if (ct_str)
             {
                 contador = atoi(ct_str);
             }
-            if (!origen_str || !destino_str)
+            if (!origen_str || !destino_str || (tipo_str && strcmp(tipo_str, "sim") != 0))
             {
-                printf("[ERROR] Uso: ping <origen> <destino> [count]\n");
+                printf("[ERROR] Uso: ping <origen> <destino> [count] [sim]\n");
                 continue;
             }
 
-            resolver_ping(grafo, origen_str, destino_str, contador);
+            if (tipo_str)
+                resolver_ping_simulado(grafo, &demandas, origen_str, destino_str, contador);
+            else
+                resolver_ping(grafo, &alcance, origen_str, destino_str, contador);
             continue;
         }
 
@@ -249,21 +414,37 @@ int main(void)
             origen_str = strtok(NULL, " \n");
             destino_str = strtok(NULL, " \n");
             ks_str = strtok(NULL, " \n");
+            tipo_str = strtok(NULL, " \n");
 
             k = 3;
 
+            /* traceroute A B srlg equivale a traceroute A B 3 srlg */
+            if (ks_str && strcmp(ks_str, "srlg") == 0)
+            {
+                tipo_str = ks_str;
+                ks_str = NULL;
+            }
             if (ks_str)
             {
                 k = atoi(ks_str);
             }
 
-            if (!origen_str || !destino_str)
+            if (!origen_str || !destino_str || (tipo_str && strcmp(tipo_str, "srlg") != 0))
+            {
+                printf("[ERROR] Uso: traceroute <origen> <destino> [K|sim] [srlg]\n");
+                continue;
+            }
+            /* el traceroute simulado sigue las FIB paquete a paquete: no hay rutas disjuntas que elegir */
+            if (ks_str && strcmp(ks_str, "sim") == 0 && tipo_str)
             {
-                printf("[ERROR] Uso: traceroute <origen> <destino> [K]\n");
+                printf("[ERROR] 'sim' y 'srlg' no se pueden combinar. Uso: traceroute <origen> <destino> [K|sim] [srlg]\n");
                 continue;
             }
 
-            comando_traceroute(grafo, origen_str, destino_str, k);
+            if (ks_str && strcmp(ks_str, "sim") == 0)
+                comando_traceroute_simulado(grafo, &demandas, origen_str, destino_str);
+            else
+                comando_traceroute(grafo, origen_str, destino_str, k, tipo_str != NULL);
             continue;
         }
         /*
@@ -309,313 +490,633 @@ int main(void)
             }
             establecer_estado_arista(grafo, indice_origen, indice_destino, 0);
             printf("[OK] Enlace %s -> %s desactivado.\n", origen_str, destino_str);
+            visor_estado_arista(&visor, grafo, buscar_arista(grafo, indice_origen, indice_destino));
+            visor_fin_lote(&visor);
             guardar_grafo(grafo, archivo_default);
             continue;
         }
 
-        if (strcmp(token, "analizar-resiliencia") == 0)
-        {
-            comando_analizar_resiliencia(grafo);
-            continue;
-        }
-
-        if (strcmp(token, "optimizar-ruta") == 0)
+        if (strcmp(token, "restaurar-enlace") == 0)
         {
             origen_str = strtok(NULL, " \n");
             destino_str = strtok(NULL, " \n");
 
             if (!origen_str || !destino_str)
             {
-                printf("[ERROR] Uso: optimizar-ruta <origen> <destino>\n");
+                printf("[ERROR] Uso: restaurar-enlace <origen> <destino>\n");
+                continue;
+            }
+
+            indice_origen = indice_por_nombre(grafo, origen_str);
+            indice_destino = indice_por_nombre(grafo, destino_str);
+            if (indice_origen == -1 || indice_destino == -1)
+            {
+                printf("[ERROR] Dispositivo origen/destino no existe.\n");
+                continue;
+            }
+            if (establecer_estado_arista(grafo, indice_origen, indice_destino, 1) != 0)
+            {
+                printf("[ERROR] No existe el enlace %s -> %s.\n", origen_str, destino_str);
                 continue;
             }
-            comando_optimizar_ruta(grafo, origen_str, destino_str);
+            printf("[OK] Enlace %s -> %s activado.\n", origen_str, destino_str);
+            visor_estado_arista(&visor, grafo, buscar_arista(grafo, indice_origen, indice_destino));
+            visor_fin_lote(&visor);
+            guardar_grafo(grafo, archivo_default);
             continue;
         }
 
-        if (strcmp(token, "visualizar-grafo") == 0)
+        if (strcmp(token, "escenario") == 0)
         {
-            // Llamar a la función de visualización aquí fork()
-            pid = fork();
-
-            if (pid < 0)
-            {
-                printf("[ERROR] No se pudo abrir el visualizador grafico.\n");
-            }
-            else if (pid == 0)
+            /* escenario <archivo> [intervalo <segundos>] [mantener] */
+            archivo_nombre = strtok(NULL, " \n");
+            lat_str = NULL;
+            contador = 0;
+            k = archivo_nombre != NULL;
+            while (k && (tipo_str = strtok(NULL, " \n")) != NULL)
             {
-                execlp("python3", "python3", "src/verGrafoL.py", (char *)NULL);
+                if (strcmp(tipo_str, "intervalo") == 0)
+                    k = (lat_str = strtok(NULL, " \n")) != NULL && atof(lat_str) > 0;
+                else if (strcmp(tipo_str, "mantener") == 0)
+                    contador = 1;
+                else
+                    k = 0;
             }
-            else
+            if (!k)
             {
-                pidPython = pid;
-                printf("[OK] Visualizador grafico iniciado.\n");
+                printf("[ERROR] Uso: escenario <archivo> [intervalo <segundos>] [mantener]\n");
+                continue;
             }
-
+            comando_escenario(grafo, &visor, archivo_nombre, lat_str ? atof(lat_str) : 0.0, contador);
+            if (contador)
+                guardar_grafo(grafo, archivo_default);
             continue;
         }
 
-        if (strcmp(token, "limpiar") == 0)
+        if (strcmp(token, "asignar-srlg") == 0 || strcmp(token, "quitar-srlg") == 0)
         {
-            LIMPIAR;
+            nombre = strtok(NULL, " \n");
+            origen_str = strtok(NULL, " \n");
+            destino_str = strtok(NULL, " \n");
+            if (!nombre || !origen_str || !destino_str)
+            {
+                printf("[ERROR] Uso: %s <grupo> <origen> <destino>\n", token);
+                continue;
+            }
+            comando_asignar_srlg(grafo, nombre, origen_str, destino_str, strcmp(token, "asignar-srlg") == 0);
+            guardar_grafo(grafo, archivo_default);
             continue;
         }
 
-        printf("[ERROR] Comando no reconocido. Escribe 'ayuda'.\n");
-    }
-
-    if (pidPython > 0)
-    {
-        if (kill(pidPython, SIGTERM) == 0)
+        if (strcmp(token, "analizar-srlg") == 0)
         {
-            waitpid(pidPython, NULL, 0);
-            printf("[OK] Visualizador grafico terminado.\n");
+            ks_str = strtok(NULL, " \n");
+            comando_analizar_srlg(grafo, &demandas, ks_str ? atoi(ks_str) : 2);
+            continue;
         }
-        else
+
+        if (strcmp(token, "centralidad") == 0)
         {
-            if (errno == ESRCH)
+            /* centralidad [N] [muestras <k>] [hilos <h>] [semilla <n>] */
+            ks_str = lat_str = ct_str = cap_str = NULL;
+            k = 1;
+            while (k && (tipo_str = strtok(NULL, " \n")) != NULL)
             {
-                printf("[INFO] Visualizador grafico ya habia terminado.\n");
+                if (strcmp(tipo_str, "muestras") == 0)
+                    k = (lat_str = strtok(NULL, " \n")) != NULL;
+                else if (strcmp(tipo_str, "hilos") == 0)
+                    k = (ct_str = strtok(NULL, " \n")) != NULL;
+                else if (strcmp(tipo_str, "semilla") == 0)
+                    k = (cap_str = strtok(NULL, " \n")) != NULL;
+                else if (!ks_str)
+                    ks_str = tipo_str;
+                else
+                    k = 0;
             }
-            else
+            if (!k)
             {
-                printf("[ERROR] No se pudo terminar el visualizador grafico.\n");
+                printf("[ERROR] Uso: centralidad [N] [muestras <k>] [hilos <h>] [semilla <n>]\n");
+                continue;
             }
+            comando_centralidad(grafo, ks_str ? atoi(ks_str) : 10, lat_str ? atoi(lat_str) : 0, ct_str ? atoi(ct_str) : 0, cap_str ? strtoull(cap_str, NULL, 10) : 1);
+            continue;
         }
-    }
-
-    liberar_grafo(grafo);
-    return 0;
-}
-
-/* Funcion de coste por latencia */
-double costo_por_latencia(const ARISTA *ar)
-{
-    return (double)ar->latencia_ms;
-}
-
-/* impresion de ayuda */
-void imprimir_ayuda()
-{
-    printf("Comandos y Usos:\n\n");
-    printf("nuevo-disp <nombre> <ip> <tipo> <cap>\n");
-    printf("conectar-dispositivo <origen> <destino> <lat> <bw> <fiab>\n");
-    printf("guardar <nombre_archivo>\n");
-    printf("ping <origen> <destino> [count]\n");
-    printf("traceroute <origen> <destino> [K]\n");
-    printf("fallar-enlace <origen> <destino>\n");
-    printf("analizar-resiliencia\n");
-    printf("optimizar-ruta <origen> <destino>\n");
-    printf("ver-grafo\n");
-    printf("visualizar-grafo\n");
-    printf("limpiar\n");
-    printf("ayuda\n");
-    printf("salir\n\n");
-}
-
-/* Imprimir camino a partir de índices */
-void imprimir_camino_por_indices(GRAFO *grafo, const int *camino, int len)
-{
-    int i;
-    if (!grafo || !camino || len <= 0)
-        return;
-
-    i = 0;
-    for (i = 0; i < len; ++i)
-    {
-        printf("%s", grafo->vertices[camino[i]].nombre);
-        if (i + 1 < len)
-            printf(" -> ");
-    }
-    printf("\n");
-}
-
-/* PING con simulacion de pérdida */
-void resolver_ping(GRAFO *grafo, const char *origen_nombre, const char *dest_nombre, int cuenta)
-{
-    int indice_origen, indice_destino, anterior[256], i, u, v, perdido, camino[256], enviados, recibidos, prueba;
-    double distancia[256], acumulada_lat, r, rtt_min, rtt_max, rtt_sum;
-    int longitud_camino;
-    ARISTA *ar, *ar_seleccionada;
 
-    if (cuenta <= 0)
-        cuenta = 4;
+        if (strcmp(token, "analizar-resiliencia") == 0)
+        {
+            comando_analizar_resiliencia(grafo, &alcance, &bfs);
+            continue;
+        }
 
-    indice_origen = indice_por_nombre(grafo, origen_nombre);
-    indice_destino = indice_por_nombre(grafo, dest_nombre);
+        if (strcmp(token, "saltos") == 0)
+        {
+            /* saltos <origen> [hilos <h>] */
+            origen_str = strtok(NULL, " \n");
+            tipo_str = strtok(NULL, " \n");
+            ct_str = tipo_str ? strtok(NULL, " \n") : NULL;
+            if (!origen_str || (tipo_str && (strcmp(tipo_str, "hilos") != 0 || !ct_str)))
+            {
+                printf("[ERROR] Uso: saltos <origen> [hilos <h>]\n");
+                continue;
+            }
+            comando_saltos(grafo, &bfs, origen_str, ct_str ? atoi(ct_str) : 0);
+            continue;
+        }
 
-    if (indice_origen == -1 || indice_destino == -1)
-    {
-        printf("[ERROR] Nodo no encontrado.\n");
-        return;
-    }
+        if (strcmp(token, "plan-redundancia") == 0)
+        {
+            tipo_str = strtok(NULL, " \n");
+            imprimir_plan_redundancia(grafo, (tipo_str && strcmp(tipo_str, "enlaces") == 0) ? BICONEXION_ARISTAS : BICONEXION_VERTICES);
+            continue;
+        }
 
-    dijkstra_camino_minimo(grafo, indice_origen, indice_destino, costo_por_latencia, anterior, distancia);
-    if (distancia[indice_destino] >= DBL_MAX / 2)
-    {
-        printf("[PING] No hay camino entre %s y %s.\n", origen_nombre, dest_nombre);
-        return;
-    }
-    longitud_camino = reconstruir_camino(anterior, indice_destino, camino, 256);
-    if (longitud_camino <= 0)
-    {
-        printf("[PING] Error reconstruyendo ruta.\n");
-        return;
-    }
+        if (strcmp(token, "optimizar-ruta") == 0)
+        {
+            origen_str = strtok(NULL, " \n");
+            destino_str = strtok(NULL, " \n");
+            ks_str = strtok(NULL, " \n");
+            lat_str = strtok(NULL, " \n");
 
-    printf("[PING] Ruta seleccionada: ");
-    imprimir_camino_por_indices(grafo, camino, longitud_camino);
+            if (!origen_str || !destino_str)
+            {
+                printf("[ERROR] Uso: optimizar-ruta <origen|*> <destino|*> [N] [lat]\n");
+                continue;
+            }
+            comando_optimizar_ruta(grafo, origen_str, destino_str, ks_str ? atoi(ks_str) : 5, lat_str ? atoi(lat_str) : 10);
+            continue;
+        }
 
-    enviados = 0;
-    recibidos = 0;
-    rtt_min = 1e9;
-    rtt_max = 0;
-    rtt_sum = 0;
+        if (strcmp(token, "latencia-hacia") == 0)
+        {
+            destino_str = strtok(NULL, " \n");
+            if (!destino_str)
+            {
+                printf("[ERROR] Uso: latencia-hacia <destino>\n");
+                continue;
+            }
+            comando_latencia_hacia(grafo, destino_str);
+            continue;
+        }
 
-    prueba = 0;
-    for (prueba = 0; prueba < cuenta; ++prueba)
-    {
-        enviados++;
-        acumulada_lat = 0.0;
-        perdido = 0;
+        if (strcmp(token, "capacidad") == 0)
+        {
+            origen_str = strtok(NULL, " \n");
+            destino_str = strtok(NULL, " \n");
+            if (!origen_str || !destino_str)
+            {
+                printf("[ERROR] Uso: capacidad <origen> <destino>\n");
+                continue;
+            }
+            comando_capacidad(grafo, origen_str, destino_str);
+            continue;
+        }
 
-        i = 0;
-        for (i = 0; i < longitud_camino - 1; ++i)
+        if (strcmp(token, "cargar-demandas") == 0)
         {
-            u = camino[i];
-            v = camino[i + 1];
-            ar = grafo->vertices[u].lista_adyacencia;
-            ar_seleccionada = NULL;
-            while (ar)
+            archivo_nombre = strtok(NULL, " \n");
+            if (!archivo_nombre)
             {
-                if (ar->destino == v && ar->activo)
-                {
-                    ar_seleccionada = ar;
-                    break;
-                }
-                ar = ar->siguiente;
+                printf("[ERROR] Uso: cargar-demandas <nombre_archivo>\n");
+                continue;
             }
-            if (!ar_seleccionada)
+            liberar_demandas(&demandas);
+            if (cargar_demandas(grafo, archivo_nombre, &demandas, &contador) != 0)
             {
-                perdido = 1;
-                break;
+                printf("[ERROR] Fallo cargar demandas %s\n", archivo_nombre);
+                liberar_demandas(&demandas);
+                continue;
             }
+            printf("[OK] %d demandas cargadas desde %s (%d lineas descartadas)\n", demandas.num, archivo_nombre, contador);
+            continue;
+        }
 
-            r = ((double)rand()) / ((double)RAND_MAX);
-            if (r > ar_seleccionada->fiabilidad)
+        if (strcmp(token, "utilizacion") == 0)
+        {
+            tipo_str = strtok(NULL, " \n");
+            ks_str = NULL;
+            if (tipo_str && strcmp(tipo_str, "ecmp") != 0)
+            {
+                ks_str = tipo_str;
+                tipo_str = NULL;
+            }
+            else
             {
-                perdido = 1;
-                break;
+                ks_str = strtok(NULL, " \n");
             }
-            acumulada_lat += (double)ar_seleccionada->latencia_ms;
+            comando_utilizacion(grafo, &demandas, tipo_str ? REPARTO_ECMP : REPARTO_CAMINO_UNICO, ks_str ? atoi(ks_str) : 10);
+            continue;
         }
-        if (!perdido)
-        {
-            recibidos++;
-            rtt_sum += acumulada_lat;
 
-            if (acumulada_lat < rtt_min)
-                rtt_min = acumulada_lat;
-            if (acumulada_lat > rtt_max)
-                rtt_max = acumulada_lat;
-            printf("[prueba %d] Respuesta de %s: tiempo=%.2f ms\n", prueba + 1, dest_nombre, acumulada_lat);
-        }
-        else
+        if (strcmp(token, "equilibrio") == 0)
         {
-            printf("[prueba %d] Tiempo de espera agotado.\n", prueba + 1);
+            ks_str = strtok(NULL, " \n");
+            lat_str = strtok(NULL, " \n");
+            comando_equilibrio(grafo, &demandas, ks_str ? atoi(ks_str) : 0, lat_str ? atof(lat_str) : 0.0);
+            continue;
         }
-    }
-    printf("ESTADISTICAS DE PING\n");
-    printf("%d paquetes transmitidos, %d recibidos, %.1f%% de pérdida\n", enviados, recibidos, 100.0 * (double)(enviados - recibidos) / (double)enviados);
-    if (recibidos > 0)
-    {
-        printf("rtt min/prom/max = %.2f/%.2f/%.2f ms\n", rtt_min, rtt_sum / recibidos, rtt_max);
-    }
+
+        if (strcmp(token, "ecmp") == 0)
+        {
+            origen_str = strtok(NULL, " \n");
+            destino_str = strtok(NULL, " \n");
+            ct_str = strtok(NULL, " \n");
+            if (!origen_str || !destino_str)
+            {
+                printf("[ERROR] Uso: ecmp <origen> <destino> [flujos]\n");
+                continue;
+            }
+            comando_ecmp(grafo, origen_str, destino_str, ct_str ? atoi(ct_str) : 10000);
+            continue;
+        }
+
+        if (strcmp(token, "reenviar") == 0)
+        {
+            origen_str = strtok(NULL, " \n");
+            destino_str = strtok(NULL, " \n");
+            if (!origen_str || !destino_str)
+            {
+                printf("[ERROR] Uso: reenviar <origen> <ip_destino>\n");
+                continue;
+            }
+            comando_reenviar(grafo, &tablas_reenvio, origen_str, destino_str);
+            continue;
+        }
+
+        if (strcmp(token, "benchmark-fib") == 0)
+        {
+            ct_str = strtok(NULL, " \n");
+            comando_benchmark_fib(grafo, ct_str ? atoi(ct_str) : 10);
+            continue;
+        }
+
+        if (strcmp(token, "simular") == 0)
+        {
+            lat_str = strtok(NULL, " \n");
+            bw_str = strtok(NULL, " \n");
+            ct_str = strtok(NULL, " \n");
+            comando_simular(grafo, &demandas, lat_str ? atof(lat_str) : 1.0, bw_str ? atoi(bw_str) : 1500, ct_str ? atoi(ct_str) : 64);
+            continue;
+        }
+
+        if (strcmp(token, "todos-pares") == 0)
+        {
+            /* todos-pares [hilos] [comprimir | archivo <nombre>] */
+            ct_str = strtok(NULL, " \n");
+            tipo_str = NULL;
+            if (ct_str && (ct_str[0] < '0' || ct_str[0] > '9'))
+            {
+                tipo_str = ct_str;
+                ct_str = NULL;
+            }
+            else
+            {
+                tipo_str = strtok(NULL, " \n");
+            }
+            archivo_nombre = NULL;
+            if (tipo_str && strcmp(tipo_str, "archivo") == 0)
+            {
+                archivo_nombre = strtok(NULL, " \n");
+                if (!archivo_nombre)
+                {
+                    printf("[ERROR] Uso: todos-pares [hilos] [comprimir | archivo <nombre>]\n");
+                    continue;
+                }
+            }
+            else if (tipo_str && strcmp(tipo_str, "comprimir") != 0)
+            {
+                printf("[ERROR] Uso: todos-pares [hilos] [comprimir | archivo <nombre>]\n");
+                continue;
+            }
+            comando_todos_pares(grafo, &saltos, ct_str ? atoi(ct_str) : 0, tipo_str && !archivo_nombre, archivo_nombre);
+            continue;
+        }
+
+        if (strcmp(token, "ruta-precalculada") == 0)
+        {
+            origen_str = strtok(NULL, " \n");
+            destino_str = strtok(NULL, " \n");
+            archivo_nombre = strtok(NULL, " \n");
+            if (!origen_str || !destino_str)
+            {
+                printf("[ERROR] Uso: ruta-precalculada <origen> <destino> [archivo]\n");
+                continue;
+            }
+            comando_ruta_precalculada(grafo, &saltos, origen_str, destino_str, archivo_nombre);
+            continue;
+        }
+
+        if (strcmp(token, "disposicion") == 0)
+        {
+            /* disposicion [iteraciones] [hilos] [archivo <nombre>] */
+            lat_str = ct_str = archivo_nombre = NULL;
+            k = 1;
+            while (k && (tipo_str = strtok(NULL, " \n")) != NULL)
+            {
+                if (strcmp(tipo_str, "archivo") == 0)
+                    k = (archivo_nombre = strtok(NULL, " \n")) != NULL;
+                else if (!lat_str)
+                    lat_str = tipo_str;
+                else if (!ct_str)
+                    ct_str = tipo_str;
+                else
+                    k = 0;
+            }
+            if (!k)
+            {
+                printf("[ERROR] Uso: disposicion [iteraciones] [hilos] [archivo <nombre>]\n");
+                continue;
+            }
+            comando_disposicion(grafo, &disposicion, &visor, lat_str ? atoi(lat_str) : 0, ct_str ? atoi(ct_str) : 0, archivo_nombre);
+            continue;
+        }
+
+        if (strcmp(token, "visualizar-grafo") == 0)
+        {
+            if (visor_activo(&visor))
+            {
+                printf("[INFO] El visualizador grafico ya esta abierto.\n");
+            }
+            else if (abrir_visor(&visor, grafo, "src/verGrafoL.py") != 0)
+            {
+                printf("[ERROR] No se pudo abrir el visualizador grafico.\n");
+            }
+            else
+            {
+                if (disposicion.num_vertices > 0)
+                {
+                    visor_posiciones(&visor, grafo, &disposicion, 1);
+                    visor_fin_lote(&visor);
+                }
+                printf("[OK] Visualizador grafico iniciado.\n");
+            }
+
+            continue;
+        }
+
+        if (strcmp(token, "estadisticas") == 0)
+        {
+            /* estadisticas [reiniciar | volcar <json|prometheus> <archivo>] */
+            tipo_str = strtok(NULL, " \n");
+            ks_str = tipo_str ? strtok(NULL, " \n") : NULL;
+            archivo_nombre = ks_str ? strtok(NULL, " \n") : NULL;
+            comando_estadisticas(tipo_str, ks_str, archivo_nombre);
+            continue;
+        }
+
+        if (strcmp(token, "limpiar") == 0)
+        {
+            LIMPIAR;
+            continue;
+        }
+
+        INSTR_DESCARTAR_COMANDO();
+        printf("[ERROR] Comando no reconocido. Escribe 'ayuda'.\n");
+    }
+
+    if (visor.pid > 0)
+    {
+        if (visor_activo(&visor))
+        {
+            cerrar_visor(&visor);
+            printf("[OK] Visualizador grafico terminado.\n");
+        }
+        else
+        {
+            printf("[INFO] Visualizador grafico ya habia terminado.\n");
+        }
+    }
+
+    liberar_demandas(&demandas);
+    liberar_matriz_saltos(&saltos);
+    liberar_disposicion(&disposicion);
+    liberar_indice_alcance(&alcance);
+    liberar_motor_bfs(&bfs);
+    liberar_tablas_reenvio(&tablas_reenvio);
+    liberar_grafo(grafo);
+    return 0;
 }
 
-/* TRACEROUTE (K rutas aproximadas) */
-void comando_traceroute(GRAFO *grafo, const char *origen_nombre, const char *dest_nombre, int K)
+/* Funcion de coste por latencia */
+double costo_por_latencia(const GRAFO *grafo, int arista)
 {
-    int indice_origen, indice_destino, caminos[10][256], longitudes[10], bwmin, i;
-    double lat, fiab;
+    return (double)grafo->aristas.latencia_ms[arista];
+}
+
+/* impresion de ayuda */
+void imprimir_ayuda()
+{
+    printf("Comandos y Usos:\n\n");
+    printf("nuevo-disp <nombre> <ip> <tipo> <cap>\n");
+    printf("conectar-dispositivo <origen> <destino> <lat> <bw> <fiab>\n");
+    printf("guardar <nombre_archivo>\n");
+    printf("ping <origen> <destino> [count] [sim]\n");
+    printf("traceroute <origen> <destino> [K|sim] [srlg]\n");
+    printf("fallar-enlace <origen> <destino>\n");
+    printf("restaurar-enlace <origen> <destino>\n");
+    printf("escenario <archivo> [intervalo <segundos>] [mantener]\n");
+    printf("asignar-srlg <grupo> <origen> <destino>\n");
+    printf("quitar-srlg <grupo> <origen> <destino>\n");
+    printf("analizar-srlg [max_grupos]\n");
+    printf("analizar-resiliencia\n");
+    printf("centralidad [N] [muestras <k>] [hilos <h>] [semilla <n>]\n");
+    printf("saltos <origen> [hilos <h>]\n");
+    printf("plan-redundancia [nodos|enlaces]\n");
+    printf("optimizar-ruta <origen|*> <destino|*> [N] [lat]\n");
+    printf("latencia-hacia <destino>\n");
+    printf("capacidad <origen> <destino>\n");
+    printf("cargar-demandas <nombre_archivo>\n");
+    printf("utilizacion [ecmp] [N]\n");
+    printf("equilibrio [iteraciones] [gap]\n");
+    printf("ecmp <origen> <destino> [flujos]\n");
+    printf("reenviar <origen> <ip_destino>\n");
+    printf("benchmark-fib [millones]\n");
+    printf("simular [segundos] [bytes] [cola_paquetes]\n");
+    printf("todos-pares [hilos] [comprimir | archivo <nombre>]\n");
+    printf("ruta-precalculada <origen> <destino> [archivo]\n");
+    printf("guardar-instantanea <nombre_archivo>\n");
+    printf("cargar-instantanea <nombre_archivo>\n");
+    printf("ver-grafo\n");
+    printf("disposicion [iteraciones] [hilos] [archivo <nombre>]\n");
+    printf("generar-topologia <fat-tree|hoja-espina|waxman|barabasi|anillo|malla> <tamano> [grado] [semilla <n>] [archivo <nombre> | instantanea <nombre>]\n");
+    printf("visualizar-grafo\n");
+    printf("estadisticas [reiniciar | volcar <json|prometheus> <archivo>]\n");
+    printf("limpiar\n");
+    printf("ayuda\n");
+    printf("salir\n\n");
+}
+
+/* Imprimir camino a partir de índices */
+void imprimir_camino_por_indices(GRAFO *grafo, const int *camino, int len)
+{
+    int i;
+    if (!grafo || !camino || len <= 0)
+        return;
+
+    i = 0;
+    for (i = 0; i < len; ++i)
+    {
+        printf("%s", grafo->datos[camino[i]].nombre);
+        if (i + 1 < len)
+            printf(" -> ");
+    }
+    printf("\n");
+}
+
+/* PING con simulacion de pérdida */
+void resolver_ping(GRAFO *grafo, INDICE_ALCANCE *alcance, const char *origen_nombre, const char *dest_nombre, int cuenta)
+{
+    int indice_origen, indice_destino, *anterior, camino[256], enviados, recibidos, prueba;
+    double *distancia, acumulada_lat, rtt_min, rtt_max, rtt_sum;
+    int longitud_camino;
+    VISTA_latencia vista;
+
+    if (cuenta <= 0)
+        cuenta = 4;
 
-    if (K <= 0)
-        K = 3;
     indice_origen = indice_por_nombre(grafo, origen_nombre);
     indice_destino = indice_por_nombre(grafo, dest_nombre);
+
     if (indice_origen == -1 || indice_destino == -1)
     {
         printf("[ERROR] Nodo no encontrado.\n");
         return;
     }
+    /* sin camino no hace falta el Dijkstra (si falta memoria para el índice, se intenta igual) */
+    if (alcanza(grafo, alcance, indice_origen, indice_destino) == 0)
+    {
+        printf("[PING] No hay camino entre %s y %s.\n", origen_nombre, dest_nombre);
+        return;
+    }
 
-    int encontrados = encontrar_k_rutas_aproximadas(grafo, indice_origen, indice_destino, costo_por_latencia, K, caminos, longitudes, 256);
-    if (encontrados == 0)
+    anterior = malloc(sizeof(int) * grafo->num_vertices);
+    distancia = malloc(sizeof(double) * grafo->num_vertices);
+    if (!anterior || !distancia || construir_vista_latencia(grafo, &vista) != 0)
     {
-        printf("[TRACEROUTE] No se encontraron rutas.\n");
+        free(anterior);
+        free(distancia);
+        printf("[ERROR] Memoria insuficiente.\n");
         return;
     }
-    printf("[TRACEROUTE] Se encontraron %d rutas:\n", encontrados);
-    i = 0;
-    for (i = 0; i < encontrados; ++i)
+    dijkstra_latencia(&vista, indice_origen, indice_destino, NULL, anterior, distancia);
+    liberar_vista_latencia(&vista);
+    longitud_camino = 0;
+    if (distancia[indice_destino] < DBL_MAX / 2)
+        longitud_camino = reconstruir_camino(anterior, indice_destino, camino, 256);
+    free(anterior);
+    free(distancia);
+    if (longitud_camino == 0)
     {
-        if (calcular_metricas_ruta(grafo, caminos[i], longitudes[i], &lat, &bwmin, &fiab) == 0)
+        printf("[PING] No hay camino entre %s y %s.\n", origen_nombre, dest_nombre);
+        return;
+    }
+    if (longitud_camino < 0)
+    {
+        printf("[PING] Error reconstruyendo ruta.\n");
+        return;
+    }
+
+    printf("[PING] Ruta seleccionada: ");
+    imprimir_camino_por_indices(grafo, camino, longitud_camino);
+
+    enviados = 0;
+    recibidos = 0;
+    rtt_min = 1e9;
+    rtt_max = 0;
+    rtt_sum = 0;
+
+    prueba = 0;
+    for (prueba = 0; prueba < cuenta; ++prueba)
+    {
+        enviados++;
+        if (sondear_camino(grafo, camino, longitud_camino, &acumulada_lat))
         {
-            printf(" Ruta %d: saltos=%d lat=%.2fms bw_min=%dMbps fiab=%.4f\n", i + 1, longitudes[i] - 1, lat, bwmin, fiab);
-            imprimir_camino_por_indices(grafo, caminos[i], longitudes[i]);
+            recibidos++;
+            rtt_sum += acumulada_lat;
+
+            if (acumulada_lat < rtt_min)
+                rtt_min = acumulada_lat;
+            if (acumulada_lat > rtt_max)
+                rtt_max = acumulada_lat;
+            printf("[prueba %d] Respuesta de %s: tiempo=%.2f ms\n", prueba + 1, dest_nombre, acumulada_lat);
         }
         else
         {
-            printf(" Ruta %d: (error al calcular métricas)\n", i + 1);
+            printf("[prueba %d] Tiempo de espera agotado.\n", prueba + 1);
         }
     }
+    printf("ESTADISTICAS DE PING\n");
+    printf("%d paquetes transmitidos, %d recibidos, %.1f%% de pérdida\n", enviados, recibidos, 100.0 * (double)(enviados - recibidos) / (double)enviados);
+    if (recibidos > 0)
+    {
+        printf("rtt min/prom/max = %.2f/%.2f/%.2f ms\n", rtt_min, rtt_sum / recibidos, rtt_max);
+    }
 }
 
-/* BFS simple para contar alcanzables */
-int contar_alcanzables(GRAFO *grafo, int indice)
+/* TRACEROUTE (K rutas aproximadas) */
+void comando_traceroute(GRAFO *grafo, const char *origen_nombre, const char *dest_nombre, int K, int srlg)
 {
-    int visitado[256] = {0}, cola[256], cabeza, cola_tail, u, v;
-    ARISTA *ar;
-
-    if (!grafo || indice < 0 || indice >= grafo->num_vertices)
-        return 0;
-
-    cabeza = 0;
-    cola_tail = 0;
-
-    if (grafo->vertices[indice].activo == 0)
-        return 0;
+    int indice_origen, indice_destino, caminos[10][256], longitudes[10], bwmin, i, j, e, g, encontrados;
+    char separador;
+    double lat, fiab;
 
-    cola[cola_tail++] = indice;
-    visitado[indice] = 1;
+    if (K <= 0)
+        K = 3;
+    if (K > 10)
+        K = 10;
+    indice_origen = indice_por_nombre(grafo, origen_nombre);
+    indice_destino = indice_por_nombre(grafo, dest_nombre);
+    if (indice_origen == -1 || indice_destino == -1)
+    {
+        printf("[ERROR] Nodo no encontrado.\n");
+        return;
+    }
 
-    while (cabeza < cola_tail)
+    if (srlg)
+        encontrados = rutas_disjuntas_srlg(grafo, indice_origen, indice_destino, K, caminos, longitudes, 256);
+    else
+        encontrados = encontrar_k_rutas_aproximadas(grafo, indice_origen, indice_destino, costo_por_latencia, K, caminos, longitudes, 256);
+    if (encontrados == 0)
+    {
+        printf("[TRACEROUTE] No se encontraron rutas.\n");
+        return;
+    }
+    printf("[TRACEROUTE] Se encontraron %d rutas%s:\n", encontrados, srlg ? " sin enlaces ni grupos de riesgo comunes" : "");
+    i = 0;
+    for (i = 0; i < encontrados; ++i)
     {
-        u = cola[cabeza++];
-        ar = grafo->vertices[u].lista_adyacencia;
-        while (ar)
+        if (calcular_metricas_ruta(grafo, caminos[i], longitudes[i], &lat, &bwmin, &fiab) == 0)
         {
-            if (ar->activo)
+            printf(" Ruta %d: saltos=%d lat=%.2fms bw_min=%dMbps fiab=%.4f", i + 1, longitudes[i] - 1, lat, bwmin, fiab);
+            /* grupos de riesgo que atraviesa la ruta */
+            separador = '=';
+            for (g = 0; srlg && g < grafo->srlg.num; ++g)
             {
-                v = ar->destino;
-                if (!visitado[v] && grafo->vertices[v].activo)
+                for (j = 0; j + 1 < longitudes[i]; ++j)
+                {
+                    e = buscar_arista_activa(grafo, caminos[i][j], caminos[i][j + 1]);
+                    if (e != -1 && ARISTA_EN_GRUPO(grafo, g, e))
+                        break;
+                }
+                if (j + 1 < longitudes[i])
                 {
-                    visitado[v] = 1;
-                    cola[cola_tail++] = v;
+                    printf("%s%c%s", separador == '=' ? " srlg" : "", separador, grafo->srlg.nombre[g]);
+                    separador = ',';
                 }
             }
-            ar = ar->siguiente;
+            printf("\n");
+            imprimir_camino_por_indices(grafo, caminos[i], longitudes[i]);
+        }
+        else
+        {
+            printf(" Ruta %d: (error al calcular métricas)\n", i + 1);
         }
     }
-    return cola_tail;
 }
 
 /* ANALIZAR RESILIENCIA */
-void comando_analizar_resiliencia(GRAFO *grafo)
+void comando_analizar_resiliencia(GRAFO *grafo, INDICE_ALCANCE *alcance, MOTOR_BFS *bfs)
 {
-    int n, i, inicio, alcanzables, peor_indice, peor_impacto, saved, r, impacto, nb, j, A, B, existe;
-    int vecinos[256];
-    ARISTA *ar, *aa;
+    int n, i, inicio, alcanzables, activos, peor_indice, peor_impacto, *impacto;
 
     if (!grafo)
         return;
@@ -641,134 +1142,1315 @@ void comando_analizar_resiliencia(GRAFO *grafo)
         printf("Todos los nodos están fallidos.\n");
         return;
     }
-    alcanzables = contar_alcanzables(grafo, inicio);
+    impacto = malloc(sizeof(int) * n);
+    alcanzables = impacto ? barrido_fallos_bfs(grafo, bfs, inicio, impacto) : -1;
+    if (alcanzables < 0)
+    {
+        free(impacto);
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
 
-    printf("[RESILIENCE] Nodos totales: %d. Alcanzables desde %s: %d\n", n, grafo->vertices[inicio].nombre, alcanzables);
+    printf("[RESILIENCE] Nodos totales: %d. Alcanzables desde %s: %d\n", n, grafo->datos[inicio].nombre, alcanzables);
     peor_indice = -1;
     peor_impacto = -1;
 
     i = 0;
     for (i = 0; i < n; ++i)
     {
-        saved = grafo->vertices[i].activo;
-        grafo->vertices[i].activo = 0;
-        r = contar_alcanzables(grafo, inicio == i ? ((inicio == 0 && n > 1) ? 1 : 0) : inicio);
-        impacto = alcanzables - r;
-        grafo->vertices[i].activo = saved;
-        printf(" - Si falla %s -> impacto: %d nodos no alcanzables\n", grafo->vertices[i].nombre, impacto);
-        if (impacto > peor_impacto)
+        printf(" - Si falla %s -> impacto: %d nodos no alcanzables\n", grafo->datos[i].nombre, impacto[i]);
+        if (impacto[i] > peor_impacto)
         {
-            peor_impacto = impacto;
+            peor_impacto = impacto[i];
             peor_indice = i;
         }
     }
+    free(impacto);
     if (peor_indice != -1)
     {
-        printf("[RESILIENCE] Nodo crítico identificado: %s (impacto=%d)\n", grafo->vertices[peor_indice].nombre, peor_impacto);
-        nb = 0;
-        ar = grafo->vertices[peor_indice].lista_adyacencia;
-        while (ar)
-        {
-            vecinos[nb++] = ar->destino;
-            ar = ar->siguiente;
-        }
-        printf("[RECOMENDACION] Considerar añadir enlaces redundantes entre los vecinos del nodo crítico.\n");
-        if (nb >= 2)
-        {
-            i = 0;
-            for (i = 0; i < nb; ++i)
-            {
-                j = 0;
-                for (j = i + 1; j < nb; ++j)
-                {
-                    A = vecinos[i];
-                    B = vecinos[j];
-                    existe = 0;
-                    aa = grafo->vertices[A].lista_adyacencia;
-                    while (aa)
-                    {
-                        if (aa->destino == B)
-                        {
-                            existe = 1;
-                            break;
-                        }
-                        aa = aa->siguiente;
-                    }
-                    if (!existe)
-                        printf(" - Sugerencia: conectar %s <--> %s\n", grafo->vertices[A].nombre, grafo->vertices[B].nombre);
-                }
-            }
-        }
-        else
-            printf(" - No se encontraron suficientes vecinos para sugerir enlaces.\n");
+        printf("[RESILIENCE] Nodo crítico identificado: %s (impacto=%d)\n", grafo->datos[peor_indice].nombre, peor_impacto);
     }
+    /* el impacto solo ve desconexiones; la intermediación muestra por dónde pasa el tráfico */
+    activos = 0;
+    for (i = 0; i < n; ++i)
+        activos += grafo->vertices[i].activo != 0;
+    comando_centralidad(grafo, 5, activos > MAX_FUENTES_EXACTAS_CENTRALIDAD ? MUESTRAS_CENTRALIDAD : 0, 0, 1);
+    imprimir_componentes_fuertes(grafo, alcance);
+    imprimir_tolerancia_enlaces(grafo);
+    imprimir_plan_redundancia(grafo, BICONEXION_VERTICES);
 }
 
-/* OPTIMIZE-ROUTE heurística simple */
-void comando_optimizar_ruta(GRAFO *grafo, const char *origen_nombre, const char *dest_nombre)
+/* Componentes fuertemente conexas: los enlaces son dirigidos y el alcance no es simetrico */
+void imprimir_componentes_fuertes(GRAFO *grafo, INDICE_ALCANCE *alcance)
 {
-    int indice_origen, indice_destino, anterior[256], try_lat, try_bw;
-    double distancia[256], actual, try_f, mejorado;
-    ARISTA *ar, *p, *prevp;
-
-    indice_origen = indice_por_nombre(grafo, origen_nombre);
-    indice_destino = indice_por_nombre(grafo, dest_nombre);
+    int c, v, mayor, unitarias, fuentes, sumideros, listadas, mostrados;
 
-    if (indice_origen == -1 || indice_destino == -1)
+    if (actualizar_indice_alcance(grafo, alcance) != 0)
     {
-        printf("[ERROR] Nodo no encontrado.\n");
+        printf("[ERROR] Memoria insuficiente.\n");
         return;
     }
-
-    ar = grafo->vertices[indice_origen].lista_adyacencia;
-    while (ar)
+    mayor = -1;
+    unitarias = 0;
+    for (c = 0; c < alcance->num_componentes; ++c)
     {
-        if (ar->destino == indice_destino && ar->activo)
-        {
-            printf("[OPT] Ya existe enlace directo %s -> %s\n", origen_nombre, dest_nombre);
-            return;
+        if (mayor == -1 || alcance->tam[c] > alcance->tam[mayor])
+            mayor = c;
+        unitarias += alcance->tam[c] == 1;
+    }
+    if (mayor == -1)
+        return;
+    printf("[RESILIENCE] Componentes fuertemente conexas: %d (la mayor con %d nodos, %d de un solo nodo)\n", alcance->num_componentes, alcance->tam[mayor], unitarias);
+    if (alcance->num_componentes == 1)
+        return;
+    extremos_condensacion(alcance, &fuentes, &sumideros);
+    printf("[RESILIENCE] Condensacion: %d componente(s) sin entradas y %d sin salidas; hacen falta al menos %d enlace(s) dirigido(s) para que todos alcancen a todos.\n", fuentes, sumideros,
+           fuentes > sumideros ? fuentes : sumideros);
+    listadas = 0;
+    for (c = 0; c < alcance->num_componentes && listadas < 10; ++c)
+    {
+        if (c == mayor)
+            continue;
+        printf(" - {");
+        mostrados = 0;
+        for (v = alcance->representante[c]; v < grafo->num_vertices && mostrados < 5; ++v)
+            if (alcance->componente[v] == c)
+                printf("%s%s", mostrados++ ? ", " : "", grafo->datos[v].nombre);
+        printf("%s} %s\n", alcance->tam[c] > mostrados ? ", ..." : "",
+               alcanza(grafo, alcance, alcance->representante[c], alcance->representante[mayor]) == 1
+                   ? (alcanza(grafo, alcance, alcance->representante[mayor], alcance->representante[c]) == 1 ? "" : "llega a la mayor pero no se la alcanza desde ella")
+                   : (alcanza(grafo, alcance, alcance->representante[mayor], alcance->representante[c]) == 1 ? "se alcanza desde la mayor pero no llega a ella" : "sin camino con la mayor en ningun sentido"));
+        listadas++;
+    }
+    if (alcance->num_componentes - 1 > listadas)
+        printf(" ... y %d mas\n", alcance->num_componentes - 1 - listadas);
+}
+
+/* Fallos de enlace que aguanta cada par (arbol de Gomory-Hu) */
+void imprimir_tolerancia_enlaces(GRAFO *grafo)
+{
+    ARBOL_CORTES arbol;
+    int i, j, k, num, enlaces[16][2];
+    long long pares, total_pares;
+
+    if (construir_arbol_cortes(grafo, &arbol, 0) != 0)
+    {
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    if (arbol.corte_global < 0)
+    {
+        liberar_arbol_cortes(&arbol);
+        return;
+    }
+    printf("[RESILIENCE] Corte minimo global: %d enlace(s); la red aguanta %d fallo(s) de enlace sin partirse.\n", arbol.corte_global, arbol.corte_global > 0 ? arbol.corte_global - 1 : 0);
+    num = enlaces_corte_global(grafo, &arbol, enlaces, 16);
+    for (i = 0; i < num && i < 16; ++i)
+        printf(" - Enlace del corte: %s <--> %s\n", grafo->datos[enlaces[i][0]].nombre, grafo->datos[enlaces[i][1]].nombre);
+
+    /* los nodos del arbol de Kruskal ya vienen agrupados de mayor a menor corte */
+    printf("[RESILIENCE] Tolerancia por pares (fallos de enlace que aguanta el par sin separarse):\n");
+    total_pares = (long long)arbol.num_activos * (arbol.num_activos - 1) / 2;
+    for (k = 0; k < arbol.num_activos - 1; k = j)
+    {
+        pares = 0;
+        for (j = k; j < arbol.num_activos - 1 && arbol.valor[j] == arbol.valor[k]; ++j)
+            pares += arbol.pares[j];
+        if (arbol.valor[k] == 0)
+            printf(" - sin conexion: %lld de %lld pares\n", pares, total_pares);
+        else
+            printf(" - %d fallo(s): %lld de %lld pares\n", arbol.valor[k] - 1, pares, total_pares);
+    }
+    if (total_pares <= 200)
+    {
+        for (i = 0; i < grafo->num_vertices; ++i)
+        {
+            if (!grafo->vertices[i].activo)
+                continue;
+            for (j = i + 1; j < grafo->num_vertices; ++j)
+            {
+                if (!grafo->vertices[j].activo)
+                    continue;
+                k = conectividad_par(&arbol, i, j);
+                printf("   %s <-> %s: %d enlace(s) en el corte, tolera %d\n", grafo->datos[i].nombre, grafo->datos[j].nombre, k, k > 0 ? k - 1 : 0);
+            }
         }
-        ar = ar->siguiente;
     }
+    liberar_arbol_cortes(&arbol);
+}
 
-    dijkstra_camino_minimo(grafo, indice_origen, indice_destino, costo_por_latencia, anterior, distancia);
-    if (distancia[indice_destino] >= DBL_MAX / 2)
+/* Plan de enlaces nuevos para eliminar puntos de corte (o puentes) */
+void imprimir_plan_redundancia(GRAFO *grafo, ModoBiconexion modo)
+{
+    PLAN_AUMENTO plan;
+    int i, a, b, restantes;
+
+    if (planificar_aumento(grafo, modo, &plan) != 0)
     {
-        printf("[OPT] No hay camino actual entre ambos nodos.\n");
+        printf("[ERROR] Memoria insuficiente.\n");
         return;
     }
+    printf("[RESILIENCE] Componentes: %d, puntos de articulacion: %d, puentes: %d\n", plan.componentes, plan.puntos_corte, plan.puentes);
+    restantes = modo == BICONEXION_VERTICES ? plan.cortes_restantes : plan.puentes_restantes;
+    if (plan.num_enlaces == 0 && restantes == 0)
+    {
+        printf("[RECOMENDACION] La topologia ya es 2-%s-conexa; no hacen falta enlaces redundantes.\n", modo == BICONEXION_VERTICES ? "vertice" : "arista");
+    }
+    else if (plan.num_enlaces > 0)
+    {
+        printf("[RECOMENDACION] Añadir %d enlace(s) (coste estimado %.1f) para que la topologia sea 2-%s-conexa:\n", plan.num_enlaces, plan.coste_total, modo == BICONEXION_VERTICES ? "vertice" : "arista");
+        for (i = 0; i < plan.num_enlaces; ++i)
+        {
+            a = plan.enlaces[i][0];
+            b = plan.enlaces[i][1];
+            printf(" - Sugerencia: conectar %s <--> %s\n", grafo->datos[a].nombre, grafo->datos[b].nombre);
+        }
+    }
+    if (restantes > 0)
+        printf("[AVISO] Tras el plan quedan %d %s que no se pueden eliminar sin enlaces paralelos.\n", restantes, modo == BICONEXION_VERTICES ? "punto(s) de articulacion" : "puente(s)");
+    liberar_plan_aumento(&plan);
+}
 
-    actual = distancia[indice_destino];
-    try_lat = 10;
-    try_bw = 100;
-    try_f = 0.99;
-    agregar_arista(grafo, indice_origen, indice_destino, try_lat, try_bw, try_f, 1);
-    dijkstra_camino_minimo(grafo, indice_origen, indice_destino, costo_por_latencia, anterior, distancia);
-    mejorado = distancia[indice_destino];
-    p = grafo->vertices[indice_origen].lista_adyacencia;
-    prevp = NULL;
+/* OPTIMIZE-ROUTE: ranking de enlaces candidatos para un conjunto de demandas ("*" = todos) */
+void comando_optimizar_ruta(GRAFO *grafo, const char *origen_nombre, const char *dest_nombre, int top, int try_lat)
+{
+    int n, i, j, nf, nd, *fuentes, *destinos, encontrados, conectadas;
+    double actual;
+    EVALUADOR_ENLACES ev;
+    CANDIDATO_ENLACE *mejores;
 
-    while (p)
+    n = grafo->num_vertices;
+    if (top <= 0)
+        top = 5;
+    if (try_lat < 0)
+        try_lat = 10;
+
+    fuentes = malloc(sizeof(int) * (n > 0 ? n : 1));
+    destinos = malloc(sizeof(int) * (n > 0 ? n : 1));
+    mejores = malloc(sizeof(CANDIDATO_ENLACE) * top);
+    if (!fuentes || !destinos || !mejores)
+    {
+        free(fuentes);
+        free(destinos);
+        free(mejores);
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+
+    nf = 0;
+    nd = 0;
+    for (i = 0; i < n; ++i)
+    {
+        if (!grafo->vertices[i].activo)
+            continue;
+        if (strcmp(origen_nombre, "*") == 0 || strcmp(origen_nombre, grafo->datos[i].nombre) == 0)
+            fuentes[nf++] = i;
+        if (strcmp(dest_nombre, "*") == 0 || strcmp(dest_nombre, grafo->datos[i].nombre) == 0)
+            destinos[nd++] = i;
+    }
+    if (nf == 0 || nd == 0)
     {
-        if (p->destino == indice_destino && p->latencia_ms == try_lat && p->ancho_banda_mbps == try_bw && p->fiabilidad == try_f)
+        free(fuentes);
+        free(destinos);
+        free(mejores);
+        printf("[ERROR] Nodo no encontrado.\n");
+        return;
+    }
+
+    if (preparar_evaluador_enlaces(grafo, fuentes, nf, destinos, nd, &ev) != 0)
+    {
+        free(fuentes);
+        free(destinos);
+        free(mejores);
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+
+    actual = 0.0;
+    conectadas = 0;
+    for (i = 0; i < nf; ++i)
+        for (j = 0; j < nd; ++j)
+            if (fuentes[i] != destinos[j] && ev.base[(size_t)i * nd + j] < DBL_MAX / 2)
+            {
+                actual += ev.base[(size_t)i * nd + j];
+                conectadas++;
+            }
+    printf("[OPT] Demandas: %d origen(es) x %d destino(s), %d con camino. Latencia total actual: %.2f ms\n", nf, nd, conectadas, actual);
+
+    encontrados = mejores_enlaces_candidatos(grafo, &ev, (double)try_lat, NULL, 0, mejores, top);
+    if (encontrados == 0)
+    {
+        printf("[OPT] Ningun enlace nuevo de %d ms mejora las demandas.\n", try_lat);
+    }
+    for (i = 0; i < encontrados; ++i)
+    {
+        printf("[OPT] %d. %s -> %s: mejora total %.2f ms en %d par(es)", i + 1, grafo->datos[mejores[i].origen].nombre, grafo->datos[mejores[i].destino].nombre, mejores[i].mejora, mejores[i].pares_mejorados);
+        if (mejores[i].nuevas_conexiones > 0)
+            printf(", %d nueva(s) conexion(es)", mejores[i].nuevas_conexiones);
+        printf("\n");
+    }
+    if (encontrados > 0 && (mejores[0].nuevas_conexiones > 0 || mejores[0].mejora >= 0.2 * actual))
+    {
+        printf("[OPT] Recomendacion: añadir enlace %s -> %s (lat=%d ms)\n", grafo->datos[mejores[0].origen].nombre, grafo->datos[mejores[0].destino].nombre, try_lat);
+    }
+    else
+    {
+        printf("[OPT] No se recomienda añadir enlaces; mejora insuficiente.\n");
+    }
+
+    liberar_evaluador_enlaces(&ev);
+    free(fuentes);
+    free(destinos);
+    free(mejores);
+}
+
+/* LATENCIA-HACIA: arbol inverso de caminos minimos hacia un destino en una pasada */
+void comando_latencia_hacia(GRAFO *grafo, const char *dest_nombre)
+{
+    int indice_destino, *siguiente, i, alcanzan;
+    double *distancia;
+    VISTA_latencia vista;
+
+    indice_destino = indice_por_nombre(grafo, dest_nombre);
+    if (indice_destino == -1)
+    {
+        printf("[ERROR] Nodo no encontrado.\n");
+        return;
+    }
+
+    siguiente = malloc(sizeof(int) * grafo->num_vertices);
+    distancia = malloc(sizeof(double) * grafo->num_vertices);
+    if (!siguiente || !distancia || construir_vista_inversa_latencia(grafo, &vista) != 0)
+    {
+        free(siguiente);
+        free(distancia);
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    dijkstra_latencia(&vista, indice_destino, -1, NULL, siguiente, distancia);
+    liberar_vista_latencia(&vista);
+
+    printf("[LATENCIA] Hacia %s (grado de entrada: %d)\n", dest_nombre, grado_entrada(grafo, indice_destino));
+    alcanzan = 0;
+    for (i = 0; i < grafo->num_vertices; ++i)
+    {
+        if (i == indice_destino)
+            continue;
+        if (distancia[i] >= DBL_MAX / 2)
         {
-            if (prevp)
-                prevp->siguiente = p->siguiente;
-            else
-                grafo->vertices[indice_origen].lista_adyacencia = p->siguiente;
-            free(p);
+            printf(" - %s: sin camino\n", grafo->datos[i].nombre);
+            continue;
+        }
+        ++alcanzan;
+        printf(" - %s: %.2f ms (siguiente salto %s)\n", grafo->datos[i].nombre, distancia[i], grafo->datos[siguiente[i]].nombre);
+    }
+    printf("[LATENCIA] %d de %d dispositivos alcanzan %s\n", alcanzan, grafo->num_vertices - 1, dest_nombre);
+    free(siguiente);
+    free(distancia);
+}
+
+/* CAPACITY: flujo maximo entre dos dispositivos y enlaces del corte minimo */
+void comando_capacidad(GRAFO *grafo, const char *origen_nombre, const char *dest_nombre)
+{
+    int indice_origen, indice_destino, num_corte, i, e, *corte;
+    long long flujo;
+    RED_FLUJO red;
+
+    indice_origen = indice_por_nombre(grafo, origen_nombre);
+    indice_destino = indice_por_nombre(grafo, dest_nombre);
+    if (indice_origen == -1 || indice_destino == -1)
+    {
+        printf("[ERROR] Nodo no encontrado.\n");
+        return;
+    }
+    if (indice_origen == indice_destino)
+    {
+        printf("[ERROR] Origen y destino deben ser distintos.\n");
+        return;
+    }
+    if (construir_red_flujo(grafo, &red) != 0)
+    {
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+
+    flujo = flujo_maximo(&red, indice_origen, indice_destino);
+    printf("[CAPACIDAD] Throughput maximo %s -> %s: %lld Mbps\n", origen_nombre, dest_nombre, flujo);
+    if (flujo == 0)
+    {
+        printf("[CAPACIDAD] No hay camino activo entre ambos dispositivos.\n");
+        liberar_red_flujo(&red);
+        return;
+    }
+
+    num_corte = aristas_corte_minimo(&red, indice_origen, NULL, 0);
+    corte = num_corte > 0 ? malloc(sizeof(int) * num_corte) : NULL;
+    if (corte)
+    {
+        aristas_corte_minimo(&red, indice_origen, corte, num_corte);
+        printf("[CAPACIDAD] Corte minimo (%d enlace(s)):\n", num_corte);
+        for (i = 0; i < num_corte; ++i)
+        {
+            e = corte[i];
+            printf(" - %s -> %s (%d Mbps)\n", grafo->datos[grafo->aristas.origen[e]].nombre, grafo->datos[grafo->aristas.destino[e]].nombre, grafo->aristas.ancho_banda_mbps[e]);
+        }
+        free(corte);
+    }
+    liberar_red_flujo(&red);
+}
+
+/* UTILIZATION: asigna la matriz de demandas y muestra los enlaces mas cargados */
+void comando_utilizacion(GRAFO *grafo, MATRIZ_DEMANDAS *demandas, ModoReparto modo, int top)
+{
+    int i, e, num, sobrecargados, *mas_cargados;
+    double uso;
+    RED_TRAFICO red;
+    CARGA_ENLACES carga;
+
+    if (demandas->num == 0)
+    {
+        printf("[ERROR] No hay demandas cargadas (use cargar-demandas).\n");
+        return;
+    }
+    if (top <= 0)
+        top = 10;
+    if (construir_red_trafico(grafo, &red) != 0 || enrutar_demandas(grafo, &red, demandas, NULL, modo, 0, &carga) != 0)
+    {
+        liberar_red_trafico(&red);
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    liberar_red_trafico(&red);
+
+    printf("[UTILIZACION] %d demandas (%s): %.1f Mbps enrutados, %.1f Mbps sin camino (%d demandas)\n", demandas->num, modo == REPARTO_ECMP ? "ECMP" : "camino unico", carga.enrutado, carga.sin_camino, carga.demandas_sin_camino);
+    sobrecargados = 0;
+    for (e = 0; e < carga.num_aristas; ++e)
+        if (carga.mbps[e] > grafo->aristas.ancho_banda_mbps[e] && grafo->aristas.destino[e] >= 0)
+            sobrecargados++;
+    printf("[UTILIZACION] Enlaces sobrecargados: %d\n", sobrecargados);
+
+    mas_cargados = malloc(sizeof(int) * top);
+    if (mas_cargados)
+    {
+        num = enlaces_mas_cargados(grafo, &carga, mas_cargados, top);
+        for (i = 0; i < num; ++i)
+        {
+            e = mas_cargados[i];
+            uso = grafo->aristas.ancho_banda_mbps[e] > 0 ? 100.0 * carga.mbps[e] / grafo->aristas.ancho_banda_mbps[e] : 0.0;
+            printf(" - %s -> %s: %.1f / %d Mbps (%.1f%%)%s\n", grafo->datos[grafo->aristas.origen[e]].nombre, grafo->datos[grafo->aristas.destino[e]].nombre, carga.mbps[e], grafo->aristas.ancho_banda_mbps[e], uso, carga.mbps[e] > grafo->aristas.ancho_banda_mbps[e] ? " [SOBRECARGA]" : "");
+        }
+        free(mas_cargados);
+    }
+    liberar_carga_enlaces(&carga);
+}
+
+static void informar_iteracion_equilibrio(int iteracion, double gap, double latencia_media, double ms, void *contexto)
+{
+    (void)contexto;
+    printf(" - Iteracion %d: gap=%.2e latencia media=%.2f ms (%.1f ms)\n", iteracion, gap, latencia_media, ms);
+}
+
+/* EQUILIBRIUM: latencias con carga (enlaces y procesado de los dispositivos) */
+void comando_equilibrio(GRAFO *grafo, MATRIZ_DEMANDAS *demandas, int iteraciones, double gap)
+{
+    int i, e, v, num, *mas_cargados;
+    PARAMETROS_EQUILIBRIO p;
+    RESULTADO_EQUILIBRIO res;
+    CARGA_ENLACES carga;
+
+    if (demandas->num == 0)
+    {
+        printf("[ERROR] No hay demandas cargadas (use cargar-demandas).\n");
+        return;
+    }
+    parametros_equilibrio_por_defecto(&p);
+    if (iteraciones > 0)
+        p.max_iteraciones = iteraciones;
+    if (gap > 0.0)
+        p.gap_objetivo = gap;
+
+    printf("[EQUILIBRIO] Frank-Wolfe conjugado, hasta %d iteraciones o gap %.1e\n", p.max_iteraciones, p.gap_objetivo);
+    if (resolver_equilibrio(grafo, demandas, &p, informar_iteracion_equilibrio, NULL, &res) != 0)
+    {
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    printf("[EQUILIBRIO] %d iteraciones en %.1f ms (%.1f ms/iteracion), gap final %.2e\n", res.iteraciones, res.tiempo_ms, res.iteraciones > 0 ? res.tiempo_ms / res.iteraciones : 0.0, res.gap);
+    printf("[EQUILIBRIO] Latencia media por Mbps: %.2f ms con carga, %.2f ms con la red vacia (%.1f Mbps sin camino)\n", res.latencia_media, res.latencia_libre, res.sin_camino);
+
+    /* enlaces mas cargados, con su latencia con carga */
+    carga.num_aristas = grafo->aristas.num;
+    carga.mbps = res.flujo;
+    mas_cargados = malloc(sizeof(int) * 5);
+    if (mas_cargados)
+    {
+        num = enlaces_mas_cargados(grafo, &carga, mas_cargados, 5);
+        for (i = 0; i < num; ++i)
+        {
+            e = mas_cargados[i];
+            printf(" - %s -> %s: %.1f / %d Mbps, %.2f ms (sin carga %d ms)\n", grafo->datos[grafo->aristas.origen[e]].nombre, grafo->datos[grafo->aristas.destino[e]].nombre, res.flujo[e], grafo->aristas.ancho_banda_mbps[e], res.coste[e], grafo->aristas.latencia_ms[e]);
+        }
+        free(mas_cargados);
+    }
+    for (v = 0; v < grafo->num_vertices; ++v)
+    {
+        if (grafo->datos[v].capacidad_procesamiento > 0 && res.carga_nodo[v] > grafo->datos[v].capacidad_procesamiento)
+            printf(" - Dispositivo %s saturado: %.1f Mbps entrantes, capacidad %d\n", grafo->datos[v].nombre, res.carga_nodo[v], grafo->datos[v].capacidad_procesamiento);
+    }
+    liberar_resultado_equilibrio(&res);
+}
+
+/* ECMP: caminos de igual coste, muestras uniformes y reparto por hash de flujos */
+void comando_ecmp(GRAFO *grafo, const char *origen_nombre, const char *dest_nombre, int flujos)
+{
+    int indice_origen, indice_destino, i, j, e, len, num, *camino, *mostrar;
+    double *uniforme, *hash;
+    RED_TRAFICO red;
+    DAG_CAMINOS dag;
+
+    indice_origen = indice_por_nombre(grafo, origen_nombre);
+    indice_destino = indice_por_nombre(grafo, dest_nombre);
+    if (indice_origen == -1 || indice_destino == -1 || indice_origen == indice_destino)
+    {
+        printf("[ERROR] Nodo no encontrado.\n");
+        return;
+    }
+    if (flujos <= 0)
+        flujos = 10000;
+    if (construir_red_trafico(grafo, &red) != 0)
+    {
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    if (construir_dag_caminos(grafo, &red, NULL, indice_destino, &dag) != 0)
+    {
+        liberar_red_trafico(&red);
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    if (dag.caminos[indice_origen] <= 0.0)
+    {
+        printf("[ECMP] No hay camino de %s a %s.\n", origen_nombre, dest_nombre);
+        liberar_dag_caminos(&dag);
+        liberar_red_trafico(&red);
+        return;
+    }
+    printf("[ECMP] %s -> %s: latencia minima %.2f ms, %.0f camino(s) de igual coste\n", origen_nombre, dest_nombre, dag.distancia[indice_origen], dag.caminos[indice_origen]);
+
+    camino = malloc(sizeof(int) * grafo->num_vertices);
+    uniforme = calloc(grafo->aristas.num + 1, sizeof(double));
+    hash = calloc(grafo->aristas.num + 1, sizeof(double));
+    mostrar = malloc(sizeof(int) * 20);
+    if (camino && uniforme && hash && mostrar)
+    {
+        printf("[ECMP] Muestras uniformes:\n");
+        for (i = 0; i < 3 && i < dag.caminos[indice_origen]; ++i)
+        {
+            len = muestrear_camino(&red, &dag, indice_origen, camino, grafo->num_vertices);
+            if (len > 0)
+                imprimir_camino_por_indices(grafo, camino, len);
+        }
+
+        reparto_uniforme_caminos(&red, &dag, indice_origen, uniforme);
+        simular_hash_ecmp(grafo, &red, &dag, indice_origen, flujos, (uint64_t)rand(), hash);
+        /* los 20 enlaces con mas trafico simulado */
+        num = 0;
+        for (e = 0; e < grafo->aristas.num; ++e)
+        {
+            if (hash[e] <= 0.0 && uniforme[e] <= 0.0)
+                continue;
+            if (num == 20 && hash[e] <= hash[mostrar[19]])
+                continue;
+            if (num < 20)
+                num++;
+            for (j = num - 1; j > 0 && hash[e] > hash[mostrar[j - 1]]; --j)
+                mostrar[j] = mostrar[j - 1];
+            mostrar[j] = e;
+        }
+        printf("[ECMP] Reparto por enlace con %d flujos (hash por salto / uniforme por caminos):\n", flujos);
+        for (i = 0; i < num; ++i)
+        {
+            e = mostrar[i];
+            printf(" - %s -> %s: %.1f%% / %.1f%%\n", grafo->datos[grafo->aristas.origen[e]].nombre, grafo->datos[grafo->aristas.destino[e]].nombre, 100.0 * hash[e], 100.0 * uniforme[e]);
+        }
+    }
+    else
+    {
+        printf("[ERROR] Memoria insuficiente.\n");
+    }
+    free(camino);
+    free(uniforme);
+    free(hash);
+    free(mostrar);
+    liberar_dag_caminos(&dag);
+    liberar_red_trafico(&red);
+}
+
+/* REENVIAR: las tablas se conservan entre llamadas y solo se rehacen si cambia el grafo */
+void comando_reenviar(GRAFO *grafo, TABLAS_REENVIO *tablas, const char *origen_nombre, const char *ip_destino)
+{
+    int u, siguiente, saltos, e;
+    uint32_t ip;
+    double latencia;
+    char buf[16];
+
+    u = indice_por_nombre(grafo, origen_nombre);
+    if (u == -1)
+    {
+        printf("[ERROR] Nodo no encontrado.\n");
+        return;
+    }
+    if (!ip_parsear(ip_destino, &ip))
+    {
+        printf("[ERROR] IP invalida: %s\n", ip_destino);
+        return;
+    }
+    if (!grafo->vertices[u].activo)
+    {
+        printf("[REENVIAR] %s esta fallido.\n", origen_nombre);
+        return;
+    }
+    if (actualizar_tablas_reenvio(grafo, tablas) != 0)
+    {
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    printf("[REENVIAR] %s -> %s (FIB de %s: %d rutas, %d prefijos, %d KB)\n", origen_nombre, ip_a_cadena(ip, buf), origen_nombre,
+           tablas->fib[u].num_rutas, tablas->fib[u].num_prefijos, tablas->fib[u].num_nodos);
+    latencia = 0.0;
+    /* TTL como en IP: corta bucles si las tablas fueran incoherentes */
+    for (saltos = 0; saltos < 64; ++saltos)
+    {
+        siguiente = fib_buscar(&tablas->fib[u], ip);
+        if (siguiente < 0)
+        {
+            printf(" - %s: sin ruta hacia %s, paquete descartado\n", grafo->datos[u].nombre, buf);
+            break;
+        }
+        if (siguiente == u)
+        {
+            printf(" - %s: entrega local tras %d salto(s), %.2f ms\n", grafo->datos[u].nombre, saltos, latencia);
             break;
         }
-        prevp = p;
-        p = p->siguiente;
+        e = buscar_arista_activa(grafo, u, siguiente);
+        if (e >= 0)
+            latencia += grafo->aristas.latencia_ms[e];
+        printf(" - %s -> %s\n", grafo->datos[u].nombre, grafo->datos[siguiente].nombre);
+        u = siguiente;
     }
-    printf("[OPT] Latencia actual: %.2f ms. Latencia con enlace hipotético: %.2f ms\n", actual, mejorado);
-    if (mejorado < 0.8 * actual)
+    if (saltos == 64)
+        printf("[REENVIAR] TTL agotado.\n");
+}
+
+void comando_benchmark_fib(GRAFO *grafo, int millones)
+{
+    int i, j, n, num_ips, *routers, *activos, total_nodos, sin_ruta;
+    uint32_t *ips, x;
+    long long consultas;
+    double t0, ms;
+    size_t suma;
+    TABLAS_REENVIO tablas;
+
+    if (millones <= 0)
+        millones = 10;
+    n = grafo->num_vertices;
+    t0 = ms_actuales();
+    if (construir_tablas_reenvio(grafo, &tablas) != 0)
     {
-        printf("[OPT] Recomendacion: añadir enlace directo %s -> %s (lat=%d ms, bw=%d Mbps, fiab=%.2f)\n", origen_nombre, dest_nombre, try_lat, try_bw, try_f);
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    ms = ms_actuales() - t0;
+    total_nodos = 0;
+    for (i = 0; i < n; ++i)
+        total_nodos += tablas.fib[i].num_nodos;
+    printf("[FIB] %d tablas construidas en %.1f ms, %d KB en total\n", n, ms, total_nodos);
+
+    /* lote de consultas: router y destino aleatorios, con un 1/8 de ips desconocidas */
+    num_ips = 1 << 16;
+    routers = malloc(sizeof(int) * num_ips);
+    ips = malloc(sizeof(uint32_t) * num_ips);
+    activos = malloc(sizeof(int) * (n + 1));
+    if (!routers || !ips || !activos)
+    {
+        free(routers);
+        free(ips);
+        free(activos);
+        liberar_tablas_reenvio(&tablas);
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    j = 0;
+    for (i = 0; i < n; ++i)
+        if (grafo->vertices[i].activo)
+            activos[j++] = i;
+    if (j == 0)
+    {
+        printf("[FIB] No hay dispositivos activos.\n");
+        free(routers);
+        free(ips);
+        free(activos);
+        liberar_tablas_reenvio(&tablas);
+        return;
     }
+    for (i = 0; i < num_ips; ++i)
+    {
+        routers[i] = activos[rand() % j];
+        x = (uint32_t)rand() ^ ((uint32_t)rand() << 16);
+        ips[i] = (i & 7) ? grafo->datos[rand() % n].ip : x;
+    }
+
+    consultas = (long long)millones * 1000000LL;
+    suma = 0;
+    sin_ruta = 0;
+    t0 = ms_actuales();
+    for (i = 0; (long long)i * num_ips < consultas; ++i)
+        for (j = 0; j < num_ips; ++j)
+            suma += (size_t)(fib_buscar(&tablas.fib[routers[j]], ips[j]) + 1);
+    ms = ms_actuales() - t0;
+    for (j = 0; j < num_ips; ++j)
+        sin_ruta += fib_buscar(&tablas.fib[routers[j]], ips[j]) < 0;
+    consultas = (long long)i * num_ips;
+    printf("[FIB] %lld busquedas en %.1f ms: %.1f millones/s (%.1f%% sin ruta, control %zu)\n", consultas, ms,
+           ms > 0.0 ? consultas / (ms * 1000.0) : 0.0, 100.0 * sin_ruta / num_ips, suma);
+    free(routers);
+    free(ips);
+    free(activos);
+    liberar_tablas_reenvio(&tablas);
+}
+
+void comando_todos_pares(GRAFO *grafo, MATRIZ_SALTOS *saltos, int hilos, int comprimir, const char *archivo)
+{
+    int n;
+    size_t estimada, densa;
+    long paginas, tam_pagina;
+    double t0, ms;
+
+    n = grafo->num_vertices;
+    estimada = estimar_memoria_saltos(grafo, hilos, archivo != NULL);
+    densa = (size_t)n * (size_t)n * (size_t)bytes_por_salto(n);
+    printf("[TODOS-PARES] %d vertices, entradas de %d bits: matriz de %.1f MB (%s), %.1f MB de memoria estimada\n", n, 8 * bytes_por_salto(n),
+           densa / 1048576.0, archivo ? "en disco" : comprimir ? "sin comprimir" : "en memoria", estimada / 1048576.0);
+    if (!archivo && !comprimir)
+    {
+        paginas = sysconf(_SC_PHYS_PAGES);
+        tam_pagina = sysconf(_SC_PAGE_SIZE);
+        if (paginas > 0 && tam_pagina > 0 && estimada > (size_t)paginas * (size_t)tam_pagina / 2)
+        {
+            printf("[TODOS-PARES] No cabe en la mitad de la memoria fisica; use 'archivo <nombre>' o 'comprimir'.\n");
+            return;
+        }
+    }
+
+    t0 = ms_actuales();
+    if (archivo)
+    {
+        if (volcar_todos_pares(grafo, hilos, archivo) != 0)
+        {
+            printf("[ERROR] Fallo volcar la matriz en %s\n", archivo);
+            return;
+        }
+        ms = ms_actuales() - t0;
+        printf("[TODOS-PARES] %d filas volcadas en %s en %.1f ms\n", n, archivo, ms);
+        return;
+    }
+    liberar_matriz_saltos(saltos);
+    if (calcular_todos_pares(grafo, hilos, comprimir, saltos) != 0)
+    {
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    ms = ms_actuales() - t0;
+    printf("[TODOS-PARES] %d origenes en %.1f ms; matriz %s de %.1f KB", n, ms, comprimir ? "comprimida" : "densa", saltos->bytes / 1024.0);
+    if (comprimir && densa > 0)
+        printf(" (%.1f%% de la densa)", 100.0 * saltos->bytes / densa);
+    printf("\n[TODOS-PARES] Use ruta-precalculada <origen> <destino>; refleja la topologia de este momento.\n");
+}
+
+void comando_ruta_precalculada(GRAFO *grafo, const MATRIZ_SALTOS *saltos, const char *origen_nombre, const char *dest_nombre, const char *archivo)
+{
+    int indice_origen, indice_destino, len, *camino;
+
+    indice_origen = indice_por_nombre(grafo, origen_nombre);
+    indice_destino = indice_por_nombre(grafo, dest_nombre);
+    if (indice_origen == -1 || indice_destino == -1)
+    {
+        printf("[ERROR] Nodo no encontrado.\n");
+        return;
+    }
+    if (!archivo && saltos->num_vertices == 0)
+    {
+        printf("[ERROR] No hay matriz calculada (use todos-pares).\n");
+        return;
+    }
+    if (!archivo && saltos->num_vertices != grafo->num_vertices)
+        printf("[AVISO] La matriz es de una topologia con %d vertices; recalcule con todos-pares.\n", saltos->num_vertices);
+    camino = malloc(sizeof(int) * (grafo->num_vertices + 1));
+    if (!camino)
+    {
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    if (archivo)
+        len = ruta_desde_archivo_saltos(archivo, indice_origen, indice_destino, camino, grafo->num_vertices + 1);
+    else
+        len = ruta_por_saltos(saltos, indice_origen, indice_destino, camino, grafo->num_vertices + 1);
+    if (len == 0)
+        printf("[RUTA] No hay ruta de %s a %s.\n", origen_nombre, dest_nombre);
+    else
+    {
+        printf("[RUTA] %s -> %s (%d saltos):\n", origen_nombre, dest_nombre, len - 1);
+        imprimir_camino_por_indices(grafo, camino, len);
+    }
+    free(camino);
+}
+
+/* Carga de fondo de la matriz de demandas durante las sondas, si hay una cargada */
+static void programar_fondo_simulacion(SIMULADOR *sim, const MATRIZ_DEMANDAS *demandas, double segundos, const char *etiqueta)
+{
+    if (demandas->num == 0)
+        return;
+    sim->p.duracion_s = segundos;
+    if (programar_demandas(sim, demandas) == 0)
+        printf("[%s] Con trafico de fondo: %d demandas cargadas.\n", etiqueta, demandas->num);
+}
+
+/* PING sobre el simulador de eventos: una sonda por segundo simulado */
+void resolver_ping_simulado(GRAFO *grafo, const MATRIZ_DEMANDAS *demandas, const char *origen_nombre, const char *dest_nombre, int cuenta)
+{
+    int indice_origen, indice_destino, i, recibidos;
+    double rtt, rtt_min, rtt_max, rtt_sum;
+    SIMULADOR sim;
+
+    if (cuenta <= 0)
+        cuenta = 4;
+    indice_origen = indice_por_nombre(grafo, origen_nombre);
+    indice_destino = indice_por_nombre(grafo, dest_nombre);
+    if (indice_origen == -1 || indice_destino == -1)
+    {
+        printf("[ERROR] Nodo no encontrado.\n");
+        return;
+    }
+    if (iniciar_simulador(&sim, grafo, NULL) != 0)
+    {
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    sim.aleatorio ^= (uint64_t)rand() << 20;
+    programar_fondo_simulacion(&sim, demandas, (double)cuenta, "PING");
+    for (i = 0; i < cuenta; ++i)
+        enviar_sonda(&sim, indice_origen, grafo->datos[indice_destino].ip, SIM_TTL_INICIAL, (uint64_t)i * 1000 * SIM_NS_POR_MS);
+    /* 2 s de espera tras la ultima sonda, como el timeout de ping */
+    ejecutar_simulacion(&sim, (uint64_t)(cuenta + 1) * 1000 * SIM_NS_POR_MS);
+
+    recibidos = 0;
+    rtt_min = 1e9;
+    rtt_max = 0;
+    rtt_sum = 0;
+    for (i = 0; i < sim.num_sondas; ++i)
+    {
+        if (sim.sonda_respuesta[i] == UINT64_MAX || sim.sonda_respondio[i] != indice_destino)
+        {
+            printf("[prueba %d] Tiempo de espera agotado.\n", i + 1);
+            continue;
+        }
+        rtt = (double)(sim.sonda_respuesta[i] - sim.sonda_envio[i]) / (double)SIM_NS_POR_MS;
+        recibidos++;
+        rtt_sum += rtt;
+        if (rtt < rtt_min)
+            rtt_min = rtt;
+        if (rtt > rtt_max)
+            rtt_max = rtt;
+        printf("[prueba %d] Respuesta de %s: tiempo=%.3f ms (ida y vuelta)\n", i + 1, dest_nombre, rtt);
+    }
+    printf("ESTADISTICAS DE PING\n");
+    printf("%d paquetes transmitidos, %d recibidos, %.1f%% de pérdida\n", cuenta, recibidos, 100.0 * (double)(cuenta - recibidos) / (double)cuenta);
+    if (recibidos > 0)
+        printf("rtt min/prom/max = %.3f/%.3f/%.3f ms\n", rtt_min, rtt_sum / recibidos, rtt_max);
+    liberar_simulador(&sim);
+}
+
+/* TRACEROUTE sobre el simulador: 3 sondas por TTL (1, 2, ...) y respuesta de quien lo agota */
+void comando_traceroute_simulado(GRAFO *grafo, const MATRIZ_DEMANDAS *demandas, const char *origen_nombre, const char *dest_nombre)
+{
+    int indice_origen, indice_destino, ttl, max_ttl, s, k, respondio, llegado;
+    SIMULADOR sim;
+
+    indice_origen = indice_por_nombre(grafo, origen_nombre);
+    indice_destino = indice_por_nombre(grafo, dest_nombre);
+    if (indice_origen == -1 || indice_destino == -1)
+    {
+        printf("[ERROR] Nodo no encontrado.\n");
+        return;
+    }
+    if (iniciar_simulador(&sim, grafo, NULL) != 0)
+    {
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    sim.aleatorio ^= (uint64_t)rand() << 20;
+    max_ttl = grafo->num_vertices < 30 ? grafo->num_vertices : 30;
+    programar_fondo_simulacion(&sim, demandas, max_ttl * 0.3 + 1.0, "TRACEROUTE");
+    /* una sonda cada 100 ms simulados para que no compitan entre ellas */
+    for (ttl = 1; ttl <= max_ttl; ++ttl)
+        for (k = 0; k < 3; ++k)
+            enviar_sonda(&sim, indice_origen, grafo->datos[indice_destino].ip, ttl, (uint64_t)(3 * (ttl - 1) + k) * 100 * SIM_NS_POR_MS);
+    ejecutar_simulacion(&sim, (uint64_t)(max_ttl * 300 + 2000) * SIM_NS_POR_MS);
+
+    printf("[TRACEROUTE] %s -> %s, como mucho %d saltos:\n", origen_nombre, dest_nombre, max_ttl);
+    llegado = 0;
+    for (ttl = 1; ttl <= max_ttl && !llegado; ++ttl)
+    {
+        printf(" %2d ", ttl);
+        respondio = -1;
+        for (k = 0; k < 3; ++k)
+        {
+            s = 3 * (ttl - 1) + k;
+            if (sim.sonda_respuesta[s] == UINT64_MAX)
+            {
+                printf(" *");
+                continue;
+            }
+            /* distinto respondedor en la misma fila: se nombra cada uno, como traceroute */
+            if (sim.sonda_respondio[s] != respondio)
+            {
+                respondio = sim.sonda_respondio[s];
+                printf(" %s", grafo->datos[respondio].nombre);
+            }
+            printf(" %.3f ms", (double)(sim.sonda_respuesta[s] - sim.sonda_envio[s]) / (double)SIM_NS_POR_MS);
+            if (respondio == indice_destino)
+                llegado = 1;
+        }
+        printf("\n");
+    }
+    liberar_simulador(&sim);
+}
+
+/* SIMULAR: la matriz de demandas como paquetes durante unos segundos simulados */
+void comando_simular(GRAFO *grafo, const MATRIZ_DEMANDAS *demandas, double segundos, int bytes, int cola_paquetes)
+{
+    PARAMETROS_SIMULACION p;
+    SIMULADOR sim;
+    ESTADISTICAS_SIMULACION *est;
+    double t0, ms, perdidos;
+
+    if (demandas->num == 0)
+    {
+        printf("[ERROR] No hay demandas cargadas (use cargar-demandas).\n");
+        return;
+    }
+    parametros_simulacion_por_defecto(&p);
+    p.duracion_s = segundos > 0.0 ? segundos : 1.0;
+    p.bytes_paquete = bytes > 0 && bytes <= 65535 ? bytes : 1500;
+    p.cola_bytes = (cola_paquetes > 0 ? cola_paquetes : 64) * p.bytes_paquete;
+    p.semilla ^= (uint64_t)rand() << 20;
+    if (iniciar_simulador(&sim, grafo, &p) != 0 || programar_demandas(&sim, demandas) != 0)
+    {
+        liberar_simulador(&sim);
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    t0 = ms_actuales();
+    ejecutar_simulacion(&sim, UINT64_MAX);
+    ms = ms_actuales() - t0;
+    est = &sim.est;
+
+    perdidos = (double)(est->perdidos_enlace + est->perdidos_cola + est->sin_ruta + est->ttl_agotado);
+    printf("[SIMULAR] %.2f s simulados, paquetes de %d B, colas de %d B por enlace\n", p.duracion_s, p.bytes_paquete, p.cola_bytes);
+    printf("[SIMULAR] %lld paquetes generados, %lld entregados (%.1f Mbps de media)\n", est->generados, est->entregados,
+           est->bytes_entregados * 8.0 / 1e6 / p.duracion_s);
+    printf("[SIMULAR] Perdidos: %lld por fiabilidad, %lld por cola llena, %lld sin ruta, %lld por TTL (%.2f%%)\n", est->perdidos_enlace,
+           est->perdidos_cola, est->sin_ruta, est->ttl_agotado, est->generados > 0 ? 100.0 * perdidos / (double)est->generados : 0.0);
+    if (est->entregados > 0)
+        printf("[SIMULAR] Retardo extremo a extremo: medio %.3f ms, maximo %.3f ms\n", est->retardo_total_ms / (double)est->entregados, est->retardo_max_ms);
+    printf("[SIMULAR] %lld eventos en %.1f ms de reloj: %.2f millones de eventos/s, %.2f millones de paquetes/s\n", est->eventos, ms,
+           ms > 0.0 ? est->eventos / (ms * 1000.0) : 0.0, ms > 0.0 ? est->generados / (ms * 1000.0) : 0.0);
+    liberar_simulador(&sim);
+}
+
+void comando_disposicion(GRAFO *grafo, DISPOSICION *disp, CANAL_VISOR *visor, int iteraciones, int hilos, const char *archivo)
+{
+    double t0, ms;
+
+    if (grafo->num_vertices == 0)
+    {
+        printf("[ERROR] Grafo vacio.\n");
+        return;
+    }
+    /* el comando siempre recalcula desde cero; los reajustes los hacen nuevo-disp y conectar-dispositivo */
+    liberar_disposicion(disp);
+    t0 = ms_actuales();
+    if (calcular_disposicion(grafo, disp, iteraciones, hilos) != 0)
+    {
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    ms = ms_actuales() - t0;
+    printf("[DISPOSICION] %d vertices colocados en %.1f ms (%d iteraciones)\n", grafo->num_vertices, ms,
+           iteraciones > 0 ? iteraciones : DISPOSICION_ITERACIONES);
+    if (visor_activo(visor))
+    {
+        visor_posiciones(visor, grafo, disp, 1);
+        visor_fin_lote(visor);
+        printf("[DISPOSICION] Posiciones enviadas al visualizador.\n");
+    }
+    if (archivo)
+    {
+        if (guardar_disposicion(disp, grafo, archivo) == 0)
+            printf("[DISPOSICION] Posiciones guardadas en %s\n", archivo);
+        else
+            printf("[ERROR] No se pudo escribir %s\n", archivo);
+    }
+}
+
+/* Devuelve el grafo generado (ya guardado si se pidio) o NULL; los argumentos son los que siguen al comando */
+GRAFO *comando_generar_topologia(int argc, char **argv)
+{
+    PARAMETROS_GENERADOR p;
+    GRAFO *grafo;
+    const char *archivo = NULL;
+    int i, binario = 0;
+    double t0, ms;
+
+    memset(&p, 0, sizeof(p));
+    p.tipo = argc >= 2 ? generador_desde_cadena(argv[0]) : GEN_DESCONOCIDO;
+    p.tamano = argc >= 2 ? atoi(argv[1]) : 0;
+    p.semilla = 1;
+    for (i = 2; i < argc && p.tipo != GEN_DESCONOCIDO; ++i)
+    {
+        if (strcmp(argv[i], "semilla") == 0 && i + 1 < argc)
+            p.semilla = strtoull(argv[++i], NULL, 10);
+        else if ((strcmp(argv[i], "archivo") == 0 || strcmp(argv[i], "instantanea") == 0) && i + 1 < argc)
+        {
+            binario = argv[i][0] == 'i';
+            archivo = argv[++i];
+        }
+        else if (i == 2 && argv[i][0] >= '0' && argv[i][0] <= '9')
+            p.grado = atoi(argv[i]);
+        else
+            p.tipo = GEN_DESCONOCIDO;
+    }
+    if (p.tipo == GEN_DESCONOCIDO || p.tamano <= 0)
+    {
+        printf("[ERROR] Uso: generar-topologia <fat-tree|hoja-espina|waxman|barabasi|anillo|malla> <tamano> [grado] [semilla <n>] [archivo <nombre> | instantanea <nombre>]\n");
+        return NULL;
+    }
+
+    t0 = ms_actuales();
+    grafo = generar_topologia(&p);
+    if (!grafo)
+    {
+        printf("[ERROR] No se pudo generar %s %d (fat-tree exige k par <= 254; maximo 2^24 vertices).\n", generador_a_cadena(p.tipo), p.tamano);
+        return NULL;
+    }
+    ms = ms_actuales() - t0;
+    printf("[GENERAR] %s %d: %d vertices, %d aristas en %.1f ms (semilla %llu)\n", generador_a_cadena(p.tipo), p.tamano, grafo->num_vertices,
+           grafo->aristas.num, ms, (unsigned long long)p.semilla);
+    if (archivo)
+    {
+        t0 = ms_actuales();
+        if ((binario ? guardar_instantanea(grafo, archivo) : guardar_grafo(grafo, archivo)) != 0)
+        {
+            printf("[ERROR] No se pudo escribir %s\n", archivo);
+            liberar_grafo(grafo);
+            return NULL;
+        }
+        printf("[GENERAR] Guardado en %s (%s) en %.1f ms\n", archivo, binario ? "instantanea" : "texto", ms_actuales() - t0);
+    }
+    return grafo;
+}
+
+/* ESCENARIO: reproduce un archivo de eventos con sondas y puntos de control */
+void comando_escenario(GRAFO *grafo, CANAL_VISOR *visor, const char *archivo, double intervalo, int mantener)
+{
+    ESCENARIO esc;
+    RESUMEN_ESCENARIO resumen;
+    int descartadas;
+
+    iniciar_escenario(&esc);
+    if (cargar_escenario(grafo, archivo, &esc, &descartadas) != 0)
+    {
+        printf("[ERROR] No se pudo abrir %s\n", archivo);
+        return;
+    }
+    if (descartadas > 0)
+        printf("[INFO] %d lineas descartadas (formato, dispositivo o enlace desconocido).\n", descartadas);
+    if (esc.num_sondas == 0)
+        printf("[INFO] El escenario no registra sondas: solo se aplicaran los eventos.\n");
+    if (reproducir_escenario(grafo, &esc, intervalo, mantener, visor, stdout, &resumen) != 0)
+    {
+        printf("[ERROR] Memoria insuficiente.\n");
+        liberar_escenario(&esc);
+        return;
+    }
+    printf("[ESCENARIO] %d eventos en %d controles: %d rutas recalculadas con %d Dijkstra, %d cambios de ruta (%.1f ms)\n",
+           resumen.eventos, resumen.controles, resumen.rutas_evaluadas, resumen.dijkstras, resumen.cambios_ruta, resumen.ms);
+    printf("[ESCENARIO] %s\n", mantener ? "Se mantiene el estado final." : "Estado inicial restaurado.");
+    liberar_escenario(&esc);
+}
+
+/* SRLG: asigna (o quita) el grupo a los dos sentidos del enlace */
+void comando_asignar_srlg(GRAFO *grafo, const char *grupo, const char *origen_nombre, const char *dest_nombre, int miembro)
+{
+    int u, v, k, tocadas;
+
+    u = indice_por_nombre(grafo, origen_nombre);
+    v = indice_por_nombre(grafo, dest_nombre);
+    if (u == -1 || v == -1)
+    {
+        printf("[ERROR] Dispositivo origen/destino no existe.\n");
+        return;
+    }
+    if (strchr(grupo, ','))
+    {
+        printf("[ERROR] El nombre del grupo no puede contener comas.\n");
+        return;
+    }
+    if (buscar_arista(grafo, u, v) == -1 && buscar_arista(grafo, v, u) == -1)
+    {
+        printf("[ERROR] No hay enlace entre %s y %s.\n", origen_nombre, dest_nombre);
+        return;
+    }
+    k = miembro ? agregar_grupo_riesgo(grafo, grupo) : grupo_por_nombre(grafo, grupo);
+    if (k == -1)
+    {
+        printf(miembro ? "[ERROR] Memoria insuficiente.\n" : "[ERROR] Grupo no existe.\n");
+        return;
+    }
+    tocadas = asignar_srlg_enlace(grafo, k, u, v, miembro);
+    printf("[OK] Enlace %s - %s (%d aristas) %s grupo %s.\n", origen_nombre, dest_nombre, tocadas, miembro ? "añadido al" : "quitado del", grupo);
+}
+
+/* SRLG: demandas que se quedan sin camino al caer grupos enteros */
+void comando_analizar_srlg(GRAFO *grafo, const MATRIZ_DEMANDAS *demandas, int max_grupos)
+{
+    INFORME_SRLG informe;
+    struct timespec t0, t1;
+    int i, k, w, enlaces, cortadas, diversas, sin_camino, listadas;
+
+    if (demandas->num == 0)
+    {
+        printf("[ERROR] No hay demandas cargadas (use cargar-demandas).\n");
+        return;
+    }
+    if (grafo->srlg.num == 0)
+    {
+        printf("[ERROR] No hay grupos de riesgo (use asignar-srlg).\n");
+        return;
+    }
+    if (max_grupos < 1 || max_grupos > MAX_GRUPOS_COMBINACION)
+        max_grupos = max_grupos < 1 ? 1 : MAX_GRUPOS_COMBINACION;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (analizar_srlg(grafo, demandas, max_grupos, &informe) != 0)
+    {
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    printf("[SRLG] %d grupos, %d demandas, combinaciones de hasta %d grupos: %lld escenarios (%.1f ms)%s\n", grafo->srlg.num, demandas->num, max_grupos, informe.escenarios,
+           (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6, informe.truncado ? " [TRUNCADO]" : "");
+    printf("[SRLG] Fallos de un solo grupo:\n");
+    for (k = 0; k < grafo->srlg.num; ++k)
+    {
+        enlaces = 0;
+        for (w = 0; w < (grafo->aristas.num + 63) / 64; ++w)
+            enlaces += __builtin_popcountll(grafo->srlg.miembros[k][w]);
+        printf(" - %s (%d aristas): %d demandas sin camino\n", grafo->srlg.nombre[k], enlaces, informe.cortes_grupo[k]);
+    }
+
+    cortadas = 0;
+    diversas = 0;
+    sin_camino = 0;
+    for (i = 0; i < informe.num_demandas; ++i)
+    {
+        sin_camino += informe.tam_corte[i] == -1;
+        cortadas += informe.tam_corte[i] > 0;
+        diversas += informe.tam_corte[i] > 0 && informe.disjuntos[i] > 1;
+    }
+    printf("[SRLG] Demandas que pierden todos sus caminos disjuntos: %d (%d tenian 2 o mas caminos disjuntos por enlaces)\n", cortadas, diversas);
+    listadas = 0;
+    for (i = 0; i < informe.num_demandas && listadas < 50; ++i)
+    {
+        if (informe.tam_corte[i] <= 0)
+            continue;
+        printf(" - %s -> %s: %d camino%s disjunto%s, sin camino si cae", grafo->datos[demandas->origen[i]].nombre, grafo->datos[demandas->destino[i]].nombre, informe.disjuntos[i],
+               informe.disjuntos[i] == 1 ? "" : "s", informe.disjuntos[i] == 1 ? "" : "s");
+        for (k = 0; k < informe.tam_corte[i]; ++k)
+            printf("%s %s", k ? " +" : "", grafo->srlg.nombre[informe.corte[i][k]]);
+        printf("\n");
+        listadas++;
+    }
+    if (cortadas > listadas)
+        printf(" ... y %d mas\n", cortadas - listadas);
+    if (sin_camino > 0)
+        printf("[SRLG] %d demandas ya no tienen camino sin fallos.\n", sin_camino);
+    liberar_informe_srlg(&informe);
+}
+
+/* Intermediación por latencia: los top dispositivos y enlaces */
+void comando_centralidad(GRAFO *grafo, int top, int muestras, int hilos, uint64_t semilla)
+{
+    CENTRALIDAD c;
+    struct timespec t0, t1;
+    int i, num, *indices;
+
+    if (top <= 0)
+        top = 10;
+    indices = malloc(sizeof(int) * top);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (!indices || calcular_centralidad(grafo, muestras, hilos, semilla, &c) != 0)
+    {
+        free(indices);
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    if (c.muestreada)
+        printf("[CENTRALIDAD] Intermediacion por latencia estimada con %d de %d origenes (%.1f ms); error maximo %.4f en nodos y %.4f en enlaces con %.0f%% de confianza\n", c.fuentes, c.activos,
+               (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6, c.error_nodo, c.error_arista, 100.0 * (1.0 - CONFIANZA_CENTRALIDAD));
     else
+        printf("[CENTRALIDAD] Intermediacion por latencia exacta, %d origenes (%.1f ms)\n", c.fuentes, (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
+    printf("[CENTRALIDAD] Dispositivos por los que pasan mas caminos minimos (fraccion de pares):\n");
+    num = mas_centrales(c.nodo, c.num_vertices, indices, top);
+    for (i = 0; i < num; ++i)
+        printf(" - %s: %.4f\n", grafo->datos[indices[i]].nombre, centralidad_nodo(&c, indices[i]));
+    if (num == 0)
+        printf(" - ninguno: no hay caminos de mas de un salto\n");
+    printf("[CENTRALIDAD] Enlaces por los que pasan mas caminos minimos:\n");
+    num = mas_centrales(c.arista, c.num_aristas, indices, top);
+    for (i = 0; i < num; ++i)
+        printf(" - %s -> %s: %.4f\n", grafo->datos[grafo->aristas.origen[indices[i]]].nombre, grafo->datos[grafo->aristas.destino[indices[i]]].nombre, centralidad_arista(&c, indices[i]));
+    free(indices);
+    liberar_centralidad(&c);
+}
+
+/* Distancias en saltos desde un dispositivo (BFS de bfs.h) */
+void comando_saltos(GRAFO *grafo, MOTOR_BFS *bfs, const char *origen_nombre, int hilos)
+{
+    struct timespec t0, t1;
+    int origen, alcanzados, maximo, v, d, filas, ancho, mostrados, guardado, *distancia, *cuenta;
+    double suma;
+
+    origen = indice_por_nombre(grafo, origen_nombre);
+    if (origen == -1)
+    {
+        printf("[ERROR] Nodo no encontrado.\n");
+        return;
+    }
+    distancia = malloc(sizeof(int) * (grafo->num_vertices + 1));
+    if (!distancia)
+    {
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    guardado = bfs->hilos;
+    if (hilos > 0)
+        bfs->hilos = hilos > MAX_HILOS_BFS ? MAX_HILOS_BFS : hilos;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    alcanzados = recorrer_bfs(grafo, bfs, origen, -1, distancia);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    bfs->hilos = guardado;
+    if (alcanzados < 0)
+    {
+        free(distancia);
+        printf("[ERROR] Memoria insuficiente.\n");
+        return;
+    }
+    if (alcanzados == 0)
+    {
+        free(distancia);
+        printf("[SALTOS] %s esta fallido.\n", origen_nombre);
+        return;
+    }
+
+    maximo = 0;
+    suma = 0.0;
+    for (v = 0; v < grafo->num_vertices; ++v)
+        if (distancia[v] > 0)
+        {
+            suma += distancia[v];
+            if (distancia[v] > maximo)
+                maximo = distancia[v];
+        }
+    printf("[SALTOS] Desde %s se alcanzan %d de %d dispositivos (%.3f ms)\n", origen_nombre, alcanzados, grafo->num_vertices,
+           (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
+    if (alcanzados == 1)
+    {
+        free(distancia);
+        return;
+    }
+    printf("[SALTOS] Maximo %d salto(s), media %.2f\n", maximo, suma / (alcanzados - 1));
+
+    /* como mucho 20 filas: con mas niveles cada fila junta varios */
+    ancho = (maximo + 19) / 20;
+    filas = (maximo + ancho - 1) / ancho;
+    cuenta = calloc(filas, sizeof(int));
+    if (cuenta)
     {
-        printf("[OPT] No se recomienda añadir enlace directo; mejora insuficiente.\n");
+        for (v = 0; v < grafo->num_vertices; ++v)
+            if (distancia[v] > 0)
+                cuenta[(distancia[v] - 1) / ancho]++;
+        for (d = 0; d < filas; ++d)
+        {
+            if (ancho == 1)
+                printf(" - %d salto(s): %d\n", d + 1, cuenta[d]);
+            else
+                printf(" - %d-%d saltos: %d\n", d * ancho + 1, (d + 1) * ancho < maximo ? (d + 1) * ancho : maximo, cuenta[d]);
+        }
+        free(cuenta);
     }
+    printf("[SALTOS] Mas lejanos:");
+    mostrados = 0;
+    for (v = 0; v < grafo->num_vertices && mostrados < 5; ++v)
+        if (distancia[v] == maximo)
+            printf("%s %s", mostrados++ ? "," : "", grafo->datos[v].nombre);
+    printf("\n");
+    free(distancia);
+}
+
+/* ESTADISTICAS: tiempos por comando y contadores de los algoritmos */
+void comando_estadisticas(const char *accion, const char *formato, const char *archivo)
+{
+#ifdef INSTRUMENTACION
+    FILE *f;
+
+    if (!accion)
+    {
+        imprimir_estadisticas(stdout);
+        return;
+    }
+    if (strcmp(accion, "reiniciar") == 0)
+    {
+        reiniciar_estadisticas();
+        printf("[OK] Estadisticas reiniciadas.\n");
+        return;
+    }
+    if (strcmp(accion, "volcar") != 0 || !formato || !archivo ||
+        (strcmp(formato, "json") != 0 && strcmp(formato, "prometheus") != 0))
+    {
+        printf("[ERROR] Uso: estadisticas [reiniciar | volcar <json|prometheus> <archivo>]\n");
+        return;
+    }
+    f = fopen(archivo, "w");
+    if (!f)
+    {
+        printf("[ERROR] No se pudo escribir %s\n", archivo);
+        return;
+    }
+    if (strcmp(formato, "json") == 0)
+        volcar_estadisticas_json(f);
+    else
+        volcar_estadisticas_prometheus(f);
+    if (fclose(f) != 0)
+        printf("[ERROR] No se pudo escribir %s\n", archivo);
+    else
+        printf("[OK] Estadisticas volcadas en %s (%s)\n", archivo, formato);
+#else
+    (void)accion;
+    (void)formato;
+    (void)archivo;
+    printf("[INFO] Instrumentacion desactivada en esta compilacion (make INSTRUMENTACION=1).\n");
+#endif
 }
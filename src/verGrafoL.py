@@ -5,9 +5,7 @@
 #  N <nombre> <ip> <tipo_int> <cap>
 #  AS <num>
 #  A <origen> <destino> <lat> <bw> <fiab> <activo>
-# Opcionalmente acepta líneas de estado de vértice (no producido por guardar_grafo,
-# pero útiles para marcar manualmente nodos caídos):
-#  V <nombre> <activo>    donde activo es 0 o 1
+#  V <nombre> <activo>    donde activo es 0 o 1 (guardar_grafo solo escribe los caídos)
 #
 # En la visualización se muestran solo:
 #  - los nodos (con el texto de su IP)
@@ -22,12 +20,27 @@
 #  - Enlaces activos -> blanco, enlaces caídos -> rojo
 #
 # Uso: ajustar la variable FILENAME o pasar ruta como primer argumento.
+#
+# Modo tubería (python3 src/verGrafoL.py --stdin), el que usa visualizar-grafo:
+# la CLI manda por la entrada estándar solo los cambios, en lotes terminados
+# por una línea F (ver include/visor.h):
+#  R | N <nombre> <ip> <tipo> <cap> <activo> | A <id> <origen> <destino> <lat> <bw> <fiab> <activo>
+#  E <id> <activo> | V <nombre> <activo> | P <nombre> <x> <y> | F
+# Las líneas P traen posiciones de la disposición por fuerzas de la CLI
+# (comando disposicion, include/disposicion.h); cuando todos los nodos
+# tienen una, se usan escaladas a la ventana en lugar del círculo, y con
+# muchos nodos se reduce el radio y se omiten las etiquetas.
+# No se relee el archivo. Cada cambio marca como sucia la zona de pantalla
+# que toca; solo se repinta esa zona. Añadir nodos recoloca el círculo y
+# repinta todo.
 
 import pygame
 import math
 import sys
 import time
 import os
+import threading
+import queue
 
 # --- Configuración de la ventana / estilo ---
 WIDTH, HEIGHT = 1000, 700
@@ -174,7 +187,214 @@ def color_for_vertex(tipo, activo):
         return COLOR_SERVIDOR
     return COLOR_DEFAULT
 
+class Topologia:
+    """Estado que mantiene el visor en modo tubería, indexado como en la CLI."""
+
+    def __init__(self):
+        self.reiniciar()
+
+    def reiniciar(self):
+        self.vertices = []
+        self.name_to_index = {}
+        self.aristas = {}  # id -> dict
+        self.positions = []
+        self.disposicion = {}  # nombre -> (x, y) en coordenadas de la CLI
+        self.radio = RADIUS
+        self.pendiente = False  # hay que recolocar antes de dibujar
+
+    def recolocar(self):
+        n = len(self.vertices)
+        self.pendiente = False
+        self.radio = RADIUS if n <= 40 else max(3, min(RADIUS, int(min(WIDTH, HEIGHT) / (2.5 * math.sqrt(n)))))
+        if n == 0 or any(v["name"] not in self.disposicion for v in self.vertices):
+            self.positions = get_vertex_positions(n, WIDTH, HEIGHT)
+            return
+        xs = [self.disposicion[v["name"]][0] for v in self.vertices]
+        ys = [self.disposicion[v["name"]][1] for v in self.vertices]
+        margen = self.radio + 10
+        ancho = max(max(xs) - min(xs), max(ys) - min(ys), 1e-6)
+        escala = min(WIDTH, HEIGHT) - 2 * margen
+        ox = margen + (WIDTH - 2 * margen - escala * (max(xs) - min(xs)) / ancho) / 2
+        oy = margen + (HEIGHT - 2 * margen - escala * (max(ys) - min(ys)) / ancho) / 2
+        self.positions = [(int(ox + (x - min(xs)) * escala / ancho), int(oy + (y - min(ys)) * escala / ancho)) for x, y in zip(xs, ys)]
+
+    def rect_vertice(self, i):
+        if self.pendiente:
+            return pygame.Rect(0, 0, WIDTH, HEIGHT)
+        x, y = self.positions[i]
+        return pygame.Rect(x - self.radio - 2, y - self.radio - 2, 2 * self.radio + 4, 2 * self.radio + 4)
+
+    def aplicar(self, parts):
+        """Aplica un evento. Devuelve (rects sucios, hay que repintar todo)."""
+        tag = parts[0]
+        if tag == "R":
+            self.reiniciar()
+            return [], True
+        if tag == "N" and len(parts) >= 6:
+            v = {"name": parts[1], "ip": parts[2], "tipo": int(parts[3]), "cap": int(parts[4]), "activo": 1 if parts[5] != "0" else 0}
+            self.name_to_index[v["name"]] = len(self.vertices)
+            self.vertices.append(v)
+            self.pendiente = True
+            return [], True
+        if tag == "P" and len(parts) >= 4:
+            self.disposicion[parts[1]] = (float(parts[2]), float(parts[3]))
+            self.pendiente = True
+            return [], True
+        if tag == "A" and len(parts) >= 8:
+            ar = {"origen": parts[2], "destino": parts[3], "lat": int(parts[4]), "bw": int(parts[5]),
+                  "fiab": float(parts[6]), "activo": 1 if parts[7] != "0" else 0}
+            self.aristas[int(parts[1])] = ar
+            return [self.rect_arista(ar)], False
+        if tag == "E" and len(parts) >= 3:
+            ar = self.aristas.get(int(parts[1]))
+            if ar is None:
+                return [], False
+            ar["activo"] = 1 if parts[2] != "0" else 0
+            return [self.rect_arista(ar)], False
+        if tag == "V" and len(parts) >= 3:
+            i = self.name_to_index.get(parts[1])
+            if i is None:
+                return [], False
+            self.vertices[i]["activo"] = 1 if parts[2] != "0" else 0
+            return [self.rect_vertice(i)], False
+        return [], False
+
+    def rect_arista(self, ar):
+        i = self.name_to_index.get(ar["origen"])
+        j = self.name_to_index.get(ar["destino"])
+        if i is None or j is None:
+            return pygame.Rect(0, 0, 0, 0)
+        if self.pendiente:
+            return pygame.Rect(0, 0, WIDTH, HEIGHT)
+        (x1, y1), (x2, y2) = self.positions[i], self.positions[j]
+        margen = ARROW_SIZE + EDGE_WIDTH + self.radio
+        return pygame.Rect(min(x1, x2) - margen, min(y1, y2) - margen, abs(x2 - x1) + 2 * margen, abs(y2 - y1) + 2 * margen)
+
+def draw_edge(surface, ar, positions, name_to_index, radio=RADIUS):
+    origen_name = ar["origen"]
+    destino_name = ar["destino"]
+    activo_ar = ar.get("activo", 1)
+    # si alguno de los nodos no existe, ignorar la arista
+    if origen_name not in name_to_index or destino_name not in name_to_index:
+        return
+    orig_pos = positions[name_to_index[origen_name]]
+    dest_pos = positions[name_to_index[destino_name]]
+
+    # calcular puntos de inicio/fin desplazados por el radio
+    dx, dy = dest_pos[0] - orig_pos[0], dest_pos[1] - orig_pos[1]
+    dist = math.hypot(dx, dy)
+    color = COLOR_EDGE_ACTIVE if activo_ar else COLOR_EDGE_DOWN
+    if dist == 0:
+        # self-loop: dibujar arco
+        loop_rect = pygame.Rect(orig_pos[0] + radio//2, orig_pos[1] - radio//2, radio, radio)
+        pygame.draw.arc(surface, color, loop_rect, math.pi*0.2, math.pi*1.7, EDGE_WIDTH)
+        return
+    start = (orig_pos[0] + (radio * dx / dist), orig_pos[1] + (radio * dy / dist))
+    end = (dest_pos[0] - (radio * dx / dist), dest_pos[1] - (radio * dy / dist))
+    if radio < RADIUS // 2:
+        # nodos pequeños: la cabeza de flecha taparía el dibujo
+        pygame.draw.line(surface, color, start, end, 1)
+        return
+    draw_arrow(surface, start, end, color=color, width=EDGE_WIDTH)
+
+def draw_vertex(surface, font, v, pos, radio=RADIUS):
+    x, y = pos
+    tipo = v.get("tipo", 4)
+    activo_v = v.get("activo", 1)
+    fill_color = color_for_vertex(tipo, activo_v)
+    border_color = (60, 60, 60) if activo_v else COLOR_DOWN
+    # círculo de fondo y borde
+    pygame.draw.circle(surface, fill_color, (x, y), radio)
+    if radio < RADIUS // 2:
+        return
+    pygame.draw.circle(surface, border_color, (x, y), radio, 3)
+    # mostrar solo la IP centrada
+    text_surf = font.render(v.get("ip", ""), True, TEXT_COLOR)
+    surface.blit(text_surf, text_surf.get_rect(center=(x, y)))
+
+def draw_region(surface, font, topo, rect):
+    """Repinta solo lo que cae dentro de rect (None = toda la ventana)."""
+    if topo.pendiente:
+        topo.recolocar()
+    surface.set_clip(rect)
+    surface.fill(BACKGROUND, rect)
+    for ar in topo.aristas.values():
+        if rect is None or topo.rect_arista(ar).colliderect(rect):
+            draw_edge(surface, ar, topo.positions, topo.name_to_index, topo.radio)
+    for idx, v in enumerate(topo.vertices):
+        if rect is None or rect.colliderect(topo.rect_vertice(idx)):
+            draw_vertex(surface, font, v, topo.positions[idx], topo.radio)
+    surface.set_clip(None)
+
+def leer_entrada(cola):
+    # hilo lector: la tubería se bloquea, la ventana no
+    for linea in sys.stdin:
+        cola.put(linea)
+    cola.put(None)
+
+def main_tuberia():
+    pygame.init()
+    screen = pygame.display.set_mode((WIDTH, HEIGHT))
+    pygame.display.set_caption("Visualizador de Grafo (en vivo)")
+    base_font = pygame.font.SysFont(None, FONT_SIZE)
+    clock = pygame.time.Clock()
+
+    cola = queue.Queue()
+    threading.Thread(target=leer_entrada, args=(cola,), daemon=True).start()
+    topo = Topologia()
+    pendientes = []   # eventos del lote en curso
+    sucios = []
+    todo = True
+    running = True
+    while running:
+        # aplicar solo lotes completos: la CLI cierra cada comando con F
+        try:
+            while True:
+                linea = cola.get_nowait()
+                if linea is None:
+                    running = False
+                    break
+                parts = linea.split()
+                if not parts:
+                    continue
+                if parts[0] != "F":
+                    pendientes.append(parts)
+                    continue
+                for ev in pendientes:
+                    try:
+                        rects, completo = topo.aplicar(ev)
+                    except (ValueError, IndexError):
+                        continue
+                    sucios.extend(rects)
+                    todo = todo or completo
+                pendientes = []
+        except queue.Empty:
+            pass
+
+        for event in pygame.event.get():
+            if event.type == pygame.QUIT:
+                running = False
+            elif event.type == pygame.VIDEOEXPOSE:
+                todo = True
+
+        if todo:
+            draw_region(screen, base_font, topo, None)
+            pygame.display.flip()
+        elif sucios:
+            for rect in sucios:
+                draw_region(screen, base_font, topo, rect)
+            pygame.display.update(sucios)
+        todo = False
+        sucios = []
+        clock.tick(30)
+
+    pygame.quit()
+    sys.exit()
+
 def main():
+    if len(sys.argv) > 1 and sys.argv[1] == "--stdin":
+        main_tuberia()
+        return
     pygame.init()
     screen = pygame.display.set_mode((WIDTH, HEIGHT))
     pygame.display.set_caption("Visualizador de Grafo (formato guardar_grafo/cargar_grafo)")
@@ -214,52 +434,11 @@ def main():
 
         # dibujar aristas (primero para que queden debajo de nodos)
         for ar in aristas:
-            origen_name = ar["origen"]
-            destino_name = ar["destino"]
-            activo_ar = ar.get("activo", 1)
-            # si alguno de los nodos no existe, ignorar la arista (mensaje en consola)
-            if origen_name not in name_to_index or destino_name not in name_to_index:
-                # Ignorar arista no válidas
-                continue
-            i = name_to_index[origen_name]
-            j = name_to_index[destino_name]
-            orig_pos = positions[i]
-            dest_pos = positions[j]
-
-            # calcular puntos de inicio/fin desplazados por el radio
-            dx, dy = dest_pos[0] - orig_pos[0], dest_pos[1] - orig_pos[1]
-            dist = math.hypot(dx, dy)
-            if dist == 0:
-                # self-loop: dibujar arco
-                loop_rect = pygame.Rect(orig_pos[0] + RADIUS//2, orig_pos[1] - RADIUS//2, RADIUS, RADIUS)
-                color = COLOR_EDGE_ACTIVE if activo_ar else COLOR_EDGE_DOWN
-                pygame.draw.arc(screen, color, loop_rect, math.pi*0.2, math.pi*1.7, EDGE_WIDTH)
-                continue
-            start = (orig_pos[0] + (RADIUS * dx / dist), orig_pos[1] + (RADIUS * dy / dist))
-            end = (dest_pos[0] - (RADIUS * dx / dist), dest_pos[1] - (RADIUS * dy / dist))
-
-            color = COLOR_EDGE_ACTIVE if activo_ar else COLOR_EDGE_DOWN
-            draw_arrow(screen, start, end, color=color, width=EDGE_WIDTH)
+            draw_edge(screen, ar, positions, name_to_index)
 
         # dibujar nodos encima de aristas
         for idx, v in enumerate(vertices):
-            x, y = positions[idx]
-            tipo = v.get("tipo", 4)
-            activo_v = v.get("activo", 1)
-
-            fill_color = color_for_vertex(tipo, activo_v)
-            border_color = (60, 60, 60) if activo_v else COLOR_DOWN
-
-            # círculo de fondo
-            pygame.draw.circle(screen, fill_color, (x, y), RADIUS)
-            # borde
-            pygame.draw.circle(screen, border_color, (x, y), RADIUS, 3)
-
-            # mostrar solo la IP centrada
-            ip_text = v.get("ip", "")
-            text_surf = base_font.render(ip_text, True, TEXT_COLOR)
-            text_rect = text_surf.get_rect(center=(x, y))
-            screen.blit(text_surf, text_rect)
+            draw_vertex(screen, base_font, v, positions[idx])
 
         # eventos
         for event in pygame.event.get():